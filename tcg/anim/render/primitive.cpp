@@ -89,6 +89,7 @@ VOID tcg::prim::SetBuffers( vertex *V, INT *I, INT NoofV, INT NoofI )
   if (VABuf == 0)
     return;
 
+  this->NoofV = NoofV;
   this->NoofI = NoofI;
 
   glGenBuffers(1, &VBuf);
@@ -129,6 +130,46 @@ VOID tcg::prim::SetBuffers( vertex *V, INT *I, INT NoofV, INT NoofI )
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 } /* End of 'tcg::prim::SetBuffers' function */
 
+/* Update part of vertex buffer function.
+ * ARGUMENTS:
+ *   - vertices array:
+ *       vertex *V;
+ *   - first vertex to update and number of vertices:
+ *       INT Start, NoofV;
+ * RETURNS:
+ *   (BOOL) TRUE if vertices fit buffer, FALSE otherwise.
+ */
+BOOL tcg::prim::UpdateVertices( vertex *V, INT Start, INT NoofV )
+{
+  if (Start < 0 || Start + NoofV > this->NoofV)
+    return FALSE;
+
+  glBindBuffer(GL_ARRAY_BUFFER, VBuf);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(vertex) * Start, sizeof(vertex) * NoofV, V);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return TRUE;
+} /* End of 'tcg::prim::UpdateVertices' function */
+
+/* Update part of index buffer function.
+ * ARGUMENTS:
+ *   - indices array:
+ *       INT *I;
+ *   - first index to update and number of indices:
+ *       INT Start, NoofI;
+ * RETURNS:
+ *   (BOOL) TRUE if indices fit buffer, FALSE otherwise.
+ */
+BOOL tcg::prim::UpdateIndices( INT *I, INT Start, INT NoofI )
+{
+  if (Start < 0 || Start + NoofI > this->NoofI)
+    return FALSE;
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBuf);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(INT) * Start, sizeof(INT) * NoofI, I);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  return TRUE;
+} /* End of 'tcg::prim::UpdateIndices' function */
+
 tcg::prim & tcg::prim::operator=( const prim &P )
 {
   return *this;
@@ -125,6 +125,28 @@ namespace tcg
      */
     virtual VOID SetBuffers( vertex *V, INT *I, INT NoofV, INT NoofI );
 
+    /* Update part of vertex buffer function.
+     * ARGUMENTS:
+     *   - vertices array:
+     *       vertex *V;
+     *   - first vertex to update and number of vertices:
+     *       INT Start, NoofV;
+     * RETURNS:
+     *   (BOOL) TRUE if vertices fit buffer, FALSE otherwise.
+     */
+    BOOL UpdateVertices( vertex *V, INT Start, INT NoofV );
+
+    /* Update part of index buffer function.
+     * ARGUMENTS:
+     *   - indices array:
+     *       INT *I;
+     *   - first index to update and number of indices:
+     *       INT Start, NoofI;
+     * RETURNS:
+     *   (BOOL) TRUE if indices fit buffer, FALSE otherwise.
+     */
+    BOOL UpdateIndices( INT *I, INT Start, INT NoofI );
+
     /* Delete buffers function.
      * ARGUMENTS: None.
      * RETURNS: None.
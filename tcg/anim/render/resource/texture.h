@@ -18,10 +18,12 @@
 #define __texture_h_
 
 #include <cstdio>
+#include <vector>
 
 #include "../../../def.h"
 
 #include "../../../support/soil/soil.h"
+#include "../../../support/map_pyramid.h"
 #include "../render.h"
 
 /* Computational geometry project namespace */
@@ -52,7 +54,8 @@ namespace tcg
       CHAR Path[MAX_STR] = "bin/textures/";
       strcat(Path, FileName);
 
-      if (!LoadG24(Path, TexNo) && !LoadPFF(Path, TexNo) && !LoadFloat(Path, TexNo) && !LoadShort(Path, TexNo))
+      if (!LoadG24(Path, TexNo) && !LoadPFF(Path, TexNo) && !LoadPyramid(Path, TexNo) &&
+          !LoadFloat(Path, TexNo) && !LoadShort(Path, TexNo))
       {
         glDeleteTextures(1, &TexNo);
         return 0;
@@ -102,6 +105,8 @@ namespace tcg
     } /* End of 'LoadG24' function */
 
     /* Load texture from *.float file function.
+     * File is memory mapped; float maps are uploaded in place, 16-bit
+     * encoded ones are decoded first (see 'map_file').
      * ARGUMENTS:
      *   - file name:
      *       const CHAR *FileName;
@@ -110,41 +115,77 @@ namespace tcg
      */
     static BOOL LoadFloat( const CHAR *FileName, int TexNo )
     {
-      BOOL isok = FALSE;
+      map_file F;
 
-      FILE *F = fopen(FileName, "rb");
-      if (F != NULL)
+      if (!F.Open(FileName, MAP_FLOAT) || !F.Verify())
+        return FALSE;
+
+      std::vector<FLOAT> Heights;
+      const FLOAT *Data = F.GetData<FLOAT>();
+
+      if (F.GetType() != MAP_FLOAT)
       {
-        INT w = 0, h = 0;
+        Heights.resize((size_t)F.GetW() * F.GetH());
+        F.Decode(0, Heights.size(), &Heights[0]);
+        Data = &Heights[0];
+      }
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTextureParameteri(TexNo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTextureParameteri(TexNo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTextureParameteri(TexNo, GL_TEXTURE_WRAP_S, GL_CLAMP);
+      glTextureParameteri(TexNo, GL_TEXTURE_WRAP_T, GL_CLAMP);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA_FLOAT32_ATI, F.GetW(), F.GetH(), 0, GL_ALPHA, GL_FLOAT, Data);
+      glGenerateMipmap(GL_TEXTURE_2D);
+      return TRUE;
+    } /* End of 'LoadFloat' function */
 
-        fread(&w, sizeof(INT), 1, F);
-        fread(&h, sizeof(INT), 1, F);
+    /* Load texture from *.pyr (tiled height map pyramid) file function.
+     * Every stored level is uploaded tile by tile from mapped file,
+     * encoded tiles are decoded to scratch buffer first.
+     * ARGUMENTS:
+     *   - file name:
+     *       const CHAR *FileName;
+     * RETURNS:
+     *   (BOOL) TRUE if successfull, FALSE otherwise.
+     */
+    static BOOL LoadPyramid( const CHAR *FileName, int TexNo )
+    {
+      map_pyramid P;
 
-        fseek(F, 0, SEEK_END);
-        INT len;
-        if ((len = ftell(F)) == (w * h * sizeof(FLOAT) + sizeof(INT) * 2))
-        {
-          FLOAT *pix = new FLOAT[w * h];
-          fseek(F, sizeof(INT) * 2, SEEK_SET);
-          fread(pix, sizeof(float), w * h, F);
+      if (!P.Open(FileName) || P.GetType() != MAP_FLOAT || !P.Verify())
+        return FALSE;
 
-          glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-          glTextureParameteri(TexNo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-          glTextureParameteri(TexNo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-          glTextureParameteri(TexNo, GL_TEXTURE_WRAP_S, GL_CLAMP);
-          glTextureParameteri(TexNo, GL_TEXTURE_WRAP_T, GL_CLAMP);
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA_FLOAT32_ATI, w, h, 0, GL_ALPHA, GL_FLOAT, pix);
-          glGenerateMipmap(GL_TEXTURE_2D);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTextureParameteri(TexNo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTextureParameteri(TexNo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTextureParameteri(TexNo, GL_TEXTURE_WRAP_S, GL_CLAMP);
+      glTextureParameteri(TexNo, GL_TEXTURE_WRAP_T, GL_CLAMP);
+      glTextureParameteri(TexNo, GL_TEXTURE_MAX_LEVEL, P.GetLevels() - 1);
+      std::vector<FLOAT> Tile((size_t)P.GetTileSize() * P.GetTileSize());
 
-          delete[] pix;
-          isok = TRUE;
-        }
-        fclose(F);
+      for (INT l = 0; l < P.GetLevels(); l++)
+      {
+        glTexImage2D(GL_TEXTURE_2D, l, GL_ALPHA_FLOAT32_ATI, P.GetLevelW(l), P.GetLevelH(l), 0, GL_ALPHA, GL_FLOAT, NULL);
+        for (INT y = 0; y < P.GetTilesY(l); y++)
+          for (INT x = 0; x < P.GetTilesX(l); x++)
+          {
+            const FLOAT *Data = P.GetTile<FLOAT>(l, x, y);
+
+            if (P.GetEntry(l, x, y).Codec != PYRAMID_RAW)
+            {
+              P.DecodeTile(l, x, y, &Tile[0]);
+              Data = &Tile[0];
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, l, x * P.GetTileSize(), y * P.GetTileSize(),
+              P.GetTileW(l, x), P.GetTileH(l, y), GL_ALPHA, GL_FLOAT, Data);
+          }
       }
-      return isok;
-    } /* End of 'LoadFloat' function */
+      return TRUE;
+    } /* End of 'LoadPyramid' function */
 
     /* Load texture from *.short file function.
+     * File is memory mapped; SHORT[3] maps are uploaded in place,
+     * octahedral ones are decoded first (see 'map_file').
      * ARGUMENTS:
      *   - file name:
      *       const CHAR *FileName;
@@ -153,38 +194,28 @@ namespace tcg
      */
     static BOOL LoadShort( const CHAR *FileName, int TexNo )
     {
-      BOOL isok = FALSE;
+      map_file F;
 
-      FILE *F = fopen(FileName, "rb");
-      if (F != NULL)
-      {
-        INT w = 0, h = 0;
-
-        fread(&w, sizeof(INT), 1, F);
-        fread(&h, sizeof(INT), 1, F);
-
-        fseek(F, 0, SEEK_END);
-        INT len;
-        if ((len = ftell(F)) == (w * h * sizeof(SHORT) * 3 + 2 * sizeof(INT)))
-        {
-          SHORT *pix = new SHORT[w * h * 3];
-          fseek(F, sizeof(INT) * 2, SEEK_SET);
-          fread(pix, sizeof(SHORT) * 3, w * h, F);
+      if (!F.Open(FileName, MAP_SHORT3) || !F.Verify())
+        return FALSE;
 
-          glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-          glTextureParameteri(TexNo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-          glTextureParameteri(TexNo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-          glTextureParameteri(TexNo, GL_TEXTURE_WRAP_S, GL_CLAMP);
-          glTextureParameteri(TexNo, GL_TEXTURE_WRAP_T, GL_CLAMP);
-          glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_SHORT, pix);
-          glGenerateMipmap(GL_TEXTURE_2D);
+      std::vector<SHORT> Normals;
+      const SHORT *Data = F.GetData<SHORT>();
 
-          delete[] pix;
-          isok = TRUE;
-        }
-        fclose(F);
+      if (F.GetType() != MAP_SHORT3)
+      {
+        Normals.resize((size_t)F.GetW() * F.GetH() * 3);
+        F.DecodeNormals(0, (size_t)F.GetW() * F.GetH(), &Normals[0]);
+        Data = &Normals[0];
       }
-      return isok;
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTextureParameteri(TexNo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTextureParameteri(TexNo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTextureParameteri(TexNo, GL_TEXTURE_WRAP_S, GL_CLAMP);
+      glTextureParameteri(TexNo, GL_TEXTURE_WRAP_T, GL_CLAMP);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, F.GetW(), F.GetH(), 0, GL_RGB, GL_SHORT, Data);
+      glGenerateMipmap(GL_TEXTURE_2D);
+      return TRUE;
     } /* End of 'LoadShort' function */
 
     /* Load texture from *.BMP, *.PNG, *.JPG, *.TGA, *.DDS, *.PSD, or *.HDR file function.
@@ -24,31 +24,46 @@ namespace tcg
    *   - animation:
    *       anim *Ani;
    */
-  unit_hm_preview::unit_hm_preview( anim *Ani ) : unit(Ani), Quad(Ani),
+  unit_hm_preview::unit_hm_preview( anim *Ani ) : unit(Ani), Quad(Ani), ErosionIterations(0),
     Interface("Fractal parameters", [this]{Update();},
-              [this]{Gen();})
+              [this]{Gen();}),
+    CpuQuad(Ani), Preview(1024), PreviewSeen(0), IsCpu(true), IsCpuTex(false)
   {
     int r;
     if (r = Load())
     {
       Interface.Begone();
       Rend = false;
-      if (r == 1)
-        Gen();
-      else
+      if (r == 2)
+      {
+        map_pyramid Pyramid;
+
+        /* Maps stored by older versions have no height map pyramid */
+        if (!Pyramid.Open("bin/textures/heightmap1.pyr"))
+          map_pyramid::Build("bin/textures/heightmap1.float", "bin/textures/heightmap1.pyr");
         *Ani << new unit_road(this->Ani, H, Lacunarity, Octaves, Offset, Gain, FSeed);
-      return;
+        return;
+      }
+      /* Canceled generation continues with loaded parameters preview */
+      if (Gen())
+        return;
     }
     N = true;
     Quad.CreateQuad(vec(1, 1, 0), vec(-1, 1, 0), vec(-1, -1, 0), vec(1, -1, 0));
     Quad.Material = Ani->AddMaterial("hm_preview", "fbm");
+    CpuQuad.CreateQuad(vec(1, 1, 0), vec(-1, 1, 0), vec(-1, -1, 0), vec(1, -1, 0));
+    CpuQuad.Material = Ani->AddMaterial("hm_preview_cpu", "hm_cpu");
+    CpuQuad.Material->SetUniform("ISN", 1);
 
-    H = 0.4f;
-    Lacunarity = 6.01f;
-    Octaves = 8;
-    Offset = 1.0f;
-    Gain = 2.0f;
-    FSeed = 30.59;
+    if (r == 0)
+    {
+      H = 0.4f;
+      Lacunarity = 6.01f;
+      Octaves = 8;
+      Offset = 1.0f;
+      Gain = 2.0f;
+      FSeed = 30.59;
+    }
 
     Update();
 
@@ -58,6 +73,7 @@ namespace tcg
     Interface.Push("Octaves", &Octaves);
     Interface.Push("Gain", &Gain);
     Interface.Push("Seed (int)", &FSeed);
+    Interface.Push("Erosion iterations", &ErosionIterations);
 
     Rend = true;
   } /* End of 'unit_hm_preview::unit_hm_preview' constructor */
@@ -25,6 +25,7 @@
 #include "../../win/window_list.h"
 #include "../../math/noise.h"
 #include "../../support/hm_gen.h"
+#include "../../support/hm_preview.h"
 #include "unit_road/unit_road.h"
 
 /* Computational geometry project namespace */
@@ -36,8 +37,14 @@ namespace tcg
   private:
     primitive::trimesh Quad;
     float H, Lacunarity, Octaves, Offset, Gain, FSeed;
+    float ErosionIterations;         // Height map erosion iterations (0 - no erosion)
     window_list Interface;
     bool Rend, N;
+    primitive::trimesh CpuQuad;      // Quad with CPU evaluated heights
+    hm_preview Preview;              // CPU preview engine
+    std::vector<float> PreviewPix;   // Last fetched preview level
+    UINT PreviewSeen;                // Last fetched preview level number
+    bool IsCpu, IsCpuTex;            // CPU preview mode and its texture binding flags
 
     int Load( void )
     {
@@ -83,12 +90,54 @@ namespace tcg
       return 1;
     }
 
-    void Gen( void )
+    /* Generate landscape maps and start road unit function.
+     * Progress (and then erosion speed) is shown in animation window caption, Esc cancels generation.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (bool) true if maps were generated, false if canceled.
+     */
+    bool Gen( void )
     {
-      hm_gen(H, Lacunarity, Gain, Offset, Octaves, (INT)(FSeed * 100));
+      std::string Caption = Ani->GetCaption();
+      int Percent = -1;
+
+      /* Generator needs all processors */
+      Preview.Cancel();
+
+      hm_gen Generator(H, Lacunarity, Gain, Offset, Octaves, (INT)(FSeed * 100), NOISE_VALUE, HM_NORMALS_ANALYTIC,
+        [&]( double Done )
+        {
+          if ((int)(Done * 100) != Percent)
+          {
+            char Buf[100];
+
+            Percent = (int)(Done * 100);
+            sprintf(Buf, "Landscape generation: %d%% (Esc - cancel)", Percent);
+            Ani->SetCaption(Buf);
+          }
+          return (GetAsyncKeyState(VK_ESCAPE) & 0x8000) == 0;
+        }, 1024, 4096, HM_HEIGHTS_FLOAT, HM_NORMAL_SHORT3, false,
+        hm_erosion::params((INT)ErosionIterations, (INT)(FSeed * 100)));
+      /* Measured erosion speed stays in caption */
+      if (Generator.GetErosionRate() > 0)
+      {
+        char Buf[100];
+
+        sprintf(Buf, " (erosion: %.1f Mcells/s per iteration)", Generator.GetErosionRate() / 1e6);
+        Caption += Buf;
+      }
+      Ani->SetCaption(Caption.c_str());
+      if (!Generator.IsComplete())
+      {
+        /* Back to parameters editing */
+        Interface.PopUp();
+        Rend = true;
+        return false;
+      }
       *Ani << new unit_road(this->Ani, H, Lacunarity, Octaves, Offset, Gain, FSeed);
       Rend = false;
-    }
+      return true;
+    } /* End of 'Gen' function */
 
     void Update( void )
     {
@@ -119,6 +168,10 @@ namespace tcg
       Quad.Material->SetUniform("ISN", 0);
       delete[] pix;
 
+      /* Restart CPU preview with new parameters (pending levels are canceled) */
+      hm_preview::params Params = {H, Lacunarity, Gain, Offset, Octaves, (INT)(FSeed * 100), NOISE_VALUE};
+      Preview.Start(Params);
+
       Interface.PopUp();
     }
 
@@ -138,7 +191,25 @@ namespace tcg
     {
       if (!Rend)
         return;
-      Quad.Render();
+      if (!IsCpu)
+      {
+        Quad.Render();
+        return;
+      }
+
+      /* Upload CPU preview level as soon as it is published */
+      INT Side;
+
+      if (Preview.Fetch(PreviewSeen, PreviewPix, Side) != 0)
+      {
+        texture *Tex = Ani->AddTexture("PreviewTex", Side, Side, &PreviewPix[0]);
+
+        if (!IsCpuTex)
+          CpuQuad.Material->AddTexture(Tex);
+        IsCpuTex = true;
+      }
+      if (IsCpuTex)
+        CpuQuad.Render();
     } /* End of 'Render' function */
 
     VOID Response( VOID )
@@ -147,7 +218,11 @@ namespace tcg
       {
         N = !N;
         Quad.Material->SetUniform("ISN", N ? 1 : 0);
+        CpuQuad.Material->SetUniform("ISN", N ? 1 : 0);
       }
+      /* Switch between CPU (generated map) and GPU (shader) previews */
+      if (Ani->KeysClick['C'])
+        IsCpu = !IsCpu;
     }
   }; /* End of 'unit_hm_preview' class */
 } /* end of 'tcg' namespace */
@@ -0,0 +1,737 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : benchmark.cpp
+ * PURPOSE     : Computational geometry project.
+ *               Road unit.
+ *               Benchmarks module.
+ * PROGRAMMER  : MM5.
+ * LAST UPDATE : 25.07.2016.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "../../../def.h"
+
+#include "../../animation.h"
+#include "../../../support/cpu.h"
+#include "../../../support/hm_erosion.h"
+#include "../../../support/map_codec.h"
+#include "unit_road.h"
+
+/* Benchmarks results file name */
+static const CHAR *BenchmarkFileName = "bin/benchmark.txt";
+
+/* Obtain time from benchmark start function.
+ * ARGUMENTS:
+ *   - start time:
+ *       std::chrono::steady_clock::time_point Start;
+ * RETURNS:
+ *   (DOUBLE) time in seconds.
+ */
+static DOUBLE BenchmarkTime( std::chrono::steady_clock::time_point Start )
+{
+  return std::chrono::duration<DOUBLE>(std::chrono::steady_clock::now() - Start).count();
+} /* End of 'BenchmarkTime' function */
+
+/* Write benchmark result line function.
+ * Line is appended to results file and set as window caption.
+ * ARGUMENTS:
+ *   - animation:
+ *       tcg::anim *Ani;
+ *   - line format and arguments:
+ *       const CHAR *Fmt, ...;
+ * RETURNS: None.
+ */
+static VOID BenchmarkLog( tcg::anim *Ani, const CHAR *Fmt, ... )
+{
+  CHAR Buf[512];
+  va_list Args;
+  FILE *F;
+
+  va_start(Args, Fmt);
+  vsprintf(Buf, Fmt, Args);
+  va_end(Args);
+
+  if ((F = fopen(BenchmarkFileName, "a")) != NULL)
+  {
+    fprintf(F, "%s\n", Buf);
+    fclose(F);
+  }
+  Ani->SetCaption(Buf);
+} /* End of 'BenchmarkLog' function */
+
+/* Triangulate set of points by mating points scan function.
+ * This is 'math::Triangulate' before mating point search through grid:
+ * every point is tested for every active edge, so it is O(n^2). Kept as
+ * reference for triangulation benchmark.
+ * ARGUMENTS:
+ *   - set of points:
+ *       const std::vector<tcg::vec> &Points;
+ *   - stock of triangles to fill:
+ *       std::vector<tcg::math::triangle> &Triangles;
+ * RETURNS: None.
+ */
+static VOID TriangulateReference( const std::vector<tcg::vec> &Points, std::vector<tcg::math::triangle> &Triangles )
+{
+  using namespace tcg;
+  using namespace tcg::math;
+
+  Triangles.clear();
+  if (Points.size() < 3)
+    return;
+
+  edge_stock ActiveEdges;
+  std::vector<point> RoundPoints;
+  RoundPoints.reserve(Points.size());
+  for (INT i = 0; i < Points.size(); i++)
+    RoundPoints.push_back(point(Points[i], i));
+
+  // Sort points by X and Z
+  std::sort(RoundPoints.begin(), RoundPoints.end(), []( const point &a, const point &b )
+  {
+    return a.Loc.X < b.Loc.X || a.Loc.X == b.Loc.X && a.Loc.Z < b.Loc.Z;
+  });
+
+  // Build convex hull (bottom and top sides).
+  std::vector<triangle_edge> Hull;
+
+  Hull.push_back(triangle_edge(0, 1));
+  for (INT i = 1; i < RoundPoints.size() - 1; i++)
+  {
+    while (Hull.size() > 0 &&
+           Rotation(RoundPoints[Hull.back().P1].Loc - RoundPoints[Hull.back().P0].Loc, RoundPoints[i + 1].Loc - RoundPoints[Hull.back().P1].Loc) < 0)
+      Hull.pop_back();
+    Hull.push_back(triangle_edge(Hull.size() > 0 ? Hull.back().P1 : 0, i + 1));
+  }
+  Hull.push_back(triangle_edge(Hull.back().P1, Points.size() - 2));
+  for (INT i = RoundPoints.size() - 2; i > 0; i--)
+  {
+    while (Hull.size() > 0 &&
+           Rotation(RoundPoints[Hull.back().P1].Loc - RoundPoints[Hull.back().P0].Loc, RoundPoints[i - 1].Loc - RoundPoints[Hull.back().P1].Loc) < 0)
+      Hull.pop_back();
+    Hull.push_back(triangle_edge(Hull.back().P1, i - 1));
+  }
+  for (INT i = 0; i < Hull.size(); i++)
+    ActiveEdges.add(Hull[i]);
+
+  DOUBLE t, MinT, denom;
+  INT MatingPoint;
+  std::vector<INT> MatingPoints;
+  BOOL MoreMatingPoints;
+  triangle_edge CurrentEdge;
+  vec P0, P1, P01;
+  ray Perp0, Perp1;
+
+  while (ActiveEdges.size() > 0)
+  {
+    MinT = DBL_MAX;
+    MatingPoint = -1;
+    MatingPoints.clear();
+    MoreMatingPoints = FALSE;
+    CurrentEdge = ActiveEdges.last();
+    if (CurrentEdge.FreeSide == FREE_RIGHT)
+      CurrentEdge.swap();
+    P0 = RoundPoints[CurrentEdge.P0].Loc, P1 = RoundPoints[CurrentEdge.P1].Loc, P01 = (P1 - P0).Normalizing();
+    Perp0.Org = (P0 + P1) / 2;
+    Perp0.Dir = vec(P1.Z - P0.Z, 0, P0.X - P1.X).Normalizing();
+
+    // Scan all points for mating point(s).
+    for (INT i = 0; i < Points.size(); i++)
+    {
+      if (i == CurrentEdge.P0 || i == CurrentEdge.P1 || Rotation(P1 - P0, RoundPoints[i].Loc - P1) <= 0)
+        continue;
+      Perp1.Org = (RoundPoints[i].Loc + P1) / 2;
+      Perp1.Dir = vec(RoundPoints[i].Loc.Z - P1.Z, 0, P1.X - RoundPoints[i].Loc.X);
+      denom = Perp0.Dir.Z * Perp1.Dir.X - Perp0.Dir.X * Perp1.Dir.Z;
+      if (fabs(denom) < Threshold)
+        continue;
+      t = (Perp1.Dir.X * (Perp1.Org.Z - Perp0.Org.Z) + Perp1.Dir.Z * (Perp0.Org.X - Perp1.Org.X)) / denom;
+      if (fabs(t - MinT) < Threshold)
+      {
+        if (!MoreMatingPoints)
+        {
+          MoreMatingPoints = TRUE;
+          MatingPoints.clear();
+          MatingPoints.push_back(MatingPoint);
+        }
+        MatingPoints.push_back(i);
+      }
+      else if (t < MinT)
+      {
+        MoreMatingPoints = FALSE;
+        MinT = t;
+        MatingPoint = i;
+      }
+    }
+
+    // Front is broken (no mating point or too many triangles).
+    if (MatingPoint == -1 || Triangles.size() > 2 * Points.size())
+    {
+      Triangles.clear();
+      return;
+    }
+    ActiveEdges.pop_back();
+    if (!MoreMatingPoints)
+    {
+      Triangles.push_back(triangle(RoundPoints[CurrentEdge.P0].Index, RoundPoints[CurrentEdge.P1].Index, RoundPoints[MatingPoint].Index));
+      ActiveEdges.add(triangle_edge(CurrentEdge.P0, MatingPoint));
+      ActiveEdges.add(triangle_edge(MatingPoint, CurrentEdge.P1));
+    }
+    else
+    {
+      std::sort(MatingPoints.begin(), MatingPoints.end(), [&RoundPoints, P0, P01]( INT a, INT b )
+      {
+        return (P01 & (RoundPoints[a].Loc - P0).Normalizing()) > (P01 & (RoundPoints[b].Loc - P0).Normalizing());
+      });
+      Triangles.push_back(triangle(RoundPoints[CurrentEdge.P0].Index, RoundPoints[CurrentEdge.P1].Index, RoundPoints[MatingPoints[0]].Index));
+      ActiveEdges.add(triangle_edge(MatingPoints[0], CurrentEdge.P1));
+      for (INT j = 1; j < MatingPoints.size(); j++)
+      {
+        Triangles.push_back(triangle(RoundPoints[CurrentEdge.P0].Index, RoundPoints[MatingPoints[j - 1]].Index, RoundPoints[MatingPoints[j]].Index));
+        ActiveEdges.add(triangle_edge(MatingPoints[j], MatingPoints[j - 1]));
+      }
+      ActiveEdges.add(triangle_edge(CurrentEdge.P0, MatingPoints.back()));
+    }
+  }
+} /* End of 'TriangulateReference' function */
+
+/* Obtain triangles as sorted points triples function.
+ * ARGUMENTS:
+ *   - triangles:
+ *       const std::vector<tcg::math::triangle> &Triangles;
+ * RETURNS:
+ *   (std::vector<std::array<INT, 3>>) triangles which do not depend on points and triangles order.
+ */
+static std::vector<std::array<INT, 3>> BenchmarkCanonical( const std::vector<tcg::math::triangle> &Triangles )
+{
+  std::vector<std::array<INT, 3>> Res(Triangles.size());
+
+  for (INT i = 0; i < Triangles.size(); i++)
+  {
+    std::array<INT, 3> &T = Res[i];
+
+    T[0] = Triangles[i].P[0], T[1] = Triangles[i].P[1], T[2] = Triangles[i].P[2];
+    std::sort(T.begin(), T.end());
+  }
+  std::sort(Res.begin(), Res.end());
+  return Res;
+} /* End of 'BenchmarkCanonical' function */
+
+/* Evaluate height map by fractal function function.
+ * Rows are evaluated by batch calls as in 'hm_gen', map covers 10x10
+ * noise space square.
+ * ARGUMENTS:
+ *   - fractal function:
+ *       fbm_type &Fbm;
+ *   - map side:
+ *       INT Size;
+ *   - result heights:
+ *       std::vector<DOUBLE> &Heights;
+ * RETURNS:
+ *   (DOUBLE) evaluation time in seconds.
+ */
+template<class fbm_type>
+  static DOUBLE BenchmarkHeights( fbm_type &Fbm, INT Size, std::vector<DOUBLE> &Heights )
+  {
+    std::vector<DOUBLE> X(Size), Y(Size), Z(Size, 0);
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+    Heights.resize((size_t)Size * Size);
+    for (INT j = 0; j < Size; j++)
+      X[j] = j * 10.0 / Size;
+    for (INT i = 0; i < Size; i++)
+    {
+      for (INT j = 0; j < Size; j++)
+        Y[j] = i * 10.0 / Size;
+      Fbm(&X[0], &Y[0], &Z[0], &Heights[(size_t)i * Size], Size);
+    }
+    return BenchmarkTime(Start);
+  } /* End of 'BenchmarkHeights' function */
+
+/* Evaluate fractal by per point calls function.
+ * ARGUMENTS:
+ *   - fractal function (or its octaves specialized evaluator):
+ *       fbm_type &Fbm;
+ *   - points coordinates:
+ *       const std::vector<DOUBLE> &X, &Y, &Z;
+ *   - evaluate with gradient ('fBmD') flag:
+ *       BOOL IsGrad;
+ *   - result values:
+ *       std::vector<DOUBLE> &Res;
+ * RETURNS:
+ *   (DOUBLE) evaluation time in seconds.
+ */
+template<class fbm_type>
+  static DOUBLE BenchmarkPoints( fbm_type &Fbm, const std::vector<DOUBLE> &X, const std::vector<DOUBLE> &Y,
+                                 const std::vector<DOUBLE> &Z, BOOL IsGrad, std::vector<DOUBLE> &Res )
+  {
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    tcg::vec Grad;
+
+    for (size_t i = 0; i < X.size(); i++)
+      Res[i] = IsGrad ? Fbm.fBmD(tcg::vec(X[i], Y[i], Z[i]), Grad) : Fbm(tcg::vec(X[i], Y[i], Z[i]));
+    return BenchmarkTime(Start);
+  } /* End of 'BenchmarkPoints' function */
+
+/* Obtain angle between vectors function.
+ * ARGUMENTS:
+ *   - vectors:
+ *       const tcg::vec &A, &B;
+ * RETURNS:
+ *   (DOUBLE) angle in degrees.
+ */
+static DOUBLE BenchmarkAngle( const tcg::vec &A, const tcg::vec &B )
+{
+  /* Arc tangent keeps precision for small angles */
+  return atan2(!(A % B), A & B) * 57.29577951308232;
+} /* End of 'BenchmarkAngle' function */
+
+/* Ray picking benchmark function.
+ * Random triangles are intersected with random rays by 'cd::triangle'
+ * one by one and by 'cd::triangle_pack' with every supported kernel
+ * and with rays packet. Nearest hits of all ways are compared.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkPicking( VOID )
+{
+  const INT NumOfRays = 4000, Sizes[] = {64, 1024, 4096};
+  const CHAR *Names[] = {"scalar", "sse4", "avx2"};
+  INT Detected = cpu::DetectSimd();
+
+  BenchmarkLog(Ani, "Picking: %d random rays, nearest hit, us per ray", NumOfRays);
+  srand(30);
+  for (INT s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); s++)
+  {
+    std::vector<cd::triangle> Tris(Sizes[s]);
+    cd::triangle_pack Pack;
+    std::vector<ray> Rays(NumOfRays);
+    std::vector<cd::collision> Ref(NumOfRays), Res(NumOfRays);
+    std::chrono::steady_clock::time_point Start;
+    DOUBLE Time;
+    INT Mismatches = 0;
+    CHAR Line[256];
+
+    for (INT i = 0; i < Sizes[s]; i++)
+    {
+      vec P0(rand(0, 60), rand(0, 4), rand(0, 60));
+
+      Tris[i].Set(P0,
+                  P0 + vec(rand(-2, 2), rand(-1, 1), rand(-2, 2)),
+                  P0 + vec(rand(-2, 2), rand(-1, 1), rand(-2, 2)));
+      Pack.Add(Tris[i].P0, Tris[i].P1, Tris[i].P2);
+    }
+    for (INT i = 0; i < NumOfRays; i++)
+    {
+      Rays[i].Org = vec(rand(0, 60), rand(10, 20), rand(0, 60));
+      Rays[i].Dir = (vec(rand(0, 60), rand(0, 4), rand(0, 60)) - Rays[i].Org).Normalizing();
+    }
+
+    // Triangles one by one.
+    Start = std::chrono::steady_clock::now();
+    for (INT i = 0; i < NumOfRays; i++)
+    {
+      Ref[i] = cd::collision(0);
+      for (INT j = 0; j < Sizes[s]; j++)
+      {
+        cd::collision C = Tris[j].Intersect(Rays[i]);
+
+        if (C.IsCollide && (!Ref[i].IsCollide || C.T < Ref[i].T))
+          Ref[i] = C;
+      }
+    }
+    Time = BenchmarkTime(Start);
+    sprintf(Line, "  triangles %5d: cd::triangle %8.2f", Sizes[s], Time * 1e6 / NumOfRays);
+
+    // Pack by every kernel, rays packet by the best one.
+    for (INT k = cpu::SIMD_NONE; k <= Detected + 1; k++)
+    {
+      cpu::SetSimd(COM_MIN(k, Detected));
+      Start = std::chrono::steady_clock::now();
+      if (k <= Detected)
+        for (INT i = 0; i < NumOfRays; i++)
+          Res[i] = Pack.Intersect(Rays[i]);
+      else
+        Pack.Intersect(&Rays[0], NumOfRays, &Res[0]);
+      Time = BenchmarkTime(Start);
+      sprintf(Line + strlen(Line), ", %s %7.2f", k <= Detected ? Names[k] : "packet", Time * 1e6 / NumOfRays);
+
+      for (INT i = 0; i < NumOfRays; i++)
+        if (Res[i].IsCollide != Ref[i].IsCollide ||
+            Res[i].IsCollide && fabs(Res[i].T - Ref[i].T) > 1e-4 * (1 + Ref[i].T))
+          Mismatches++;
+    }
+    BenchmarkLog(Ani, "%s, %d mismatches", Line, Mismatches);
+  }
+  cpu::SetSimd(Detected);
+} /* End of 'tcg::unit_road::BenchmarkPicking' function */
+
+/* Triangulation benchmark function.
+ * 'math::Triangulate' is timed on uniform random points, result is
+ * compared with mating points scan (for sizes it takes seconds on).
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkTriangulation( VOID )
+{
+  const INT Sizes[] = {1000, 10000, 100000, 1000000}, MaxRefSize = 10000;
+  std::mt19937 Rnd(30);
+  std::uniform_real_distribution<DOUBLE> CoordX(0, Width), CoordZ(0, Height);
+
+  BenchmarkLog(Ani, "Triangulation: uniform random points in %gx%g", Width, Height);
+  for (INT s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); s++)
+  {
+    std::vector<vec> Pts(Sizes[s]);
+    std::vector<triangle> Tris, RefTris;
+    std::chrono::steady_clock::time_point Start;
+    DOUBLE Time;
+
+    for (INT i = 0; i < Sizes[s]; i++)
+    {
+      DOUBLE X = CoordX(Rnd);
+
+      Pts[i] = vec(X, 0, CoordZ(Rnd));
+    }
+
+    Start = std::chrono::steady_clock::now();
+    Triangulate(Pts, Tris);
+    Time = BenchmarkTime(Start);
+    if (Sizes[s] > MaxRefSize)
+    {
+      BenchmarkLog(Ani, "  points %7d: %9.1f ms, %d triangles", Sizes[s], Time * 1e3, (INT)Tris.size());
+      continue;
+    }
+
+    Start = std::chrono::steady_clock::now();
+    TriangulateReference(Pts, RefTris);
+    BenchmarkLog(Ani, "  points %7d: %9.1f ms, %d triangles, scan %9.1f ms, %s", Sizes[s], Time * 1e3, (INT)Tris.size(),
+      BenchmarkTime(Start) * 1e3, BenchmarkCanonical(Tris) == BenchmarkCanonical(RefTris) ? "same triangles" : "DIFFERENT TRIANGLES");
+  }
+} /* End of 'tcg::unit_road::BenchmarkTriangulation' function */
+
+/* Roads insertion benchmark function.
+ * Scene is replaced with random terrain of 25k points (about 50k
+ * triangles) and 500-segment road network (4 roads), then landscape is
+ * built by 'CreateLandscape' steps, every step is timed.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkRoads( VOID )
+{
+  const INT NumOfTerrainPoints = 25000, NumOfRoads = 4, NumOfRoadSegments = 125;
+  std::mt19937 Rnd(30);
+  std::uniform_real_distribution<DOUBLE> CoordX(0, Width), CoordZ(0, Height);
+  std::vector<road_segment> RoadSegments;
+  std::chrono::steady_clock::time_point Start;
+  DOUBLE Time;
+
+  // Terrain points with border, as in constructor.
+  Points.clear();
+  Segments.clear();
+  Houses.assign(1, std::vector<INT>());
+  for (INT i = 0; i < NumOfTerrainPoints; i++)
+  {
+    DOUBLE X = CoordX(Rnd);
+
+    Points.push_back(vec(X, 0, CoordZ(Rnd)));
+  }
+  for (INT i = 0; i < 60; i++)
+  {
+    Points.push_back(vec(i,      0, 0));
+    Points.push_back(vec(60,     0, i));
+    Points.push_back(vec(60 - i, 0, 60));
+    Points.push_back(vec(0,      0, 60 - i));
+  }
+  Start = std::chrono::steady_clock::now();
+  Triangulation.Build();
+  Triangulation.GetTriangles(Triangles);
+  Time = BenchmarkTime(Start);
+  BenchmarkLog(Ani, "Roads: %d terrain points, %d triangles, triangulation %.1f ms", (INT)Points.size(), (INT)Triangles.size(), Time * 1e3);
+
+  // Roads are smooth waves across field, segments are shorter than 'MaxRoadLen'.
+  for (INT r = 0; r < NumOfRoads; r++)
+  {
+    DOUBLE Z = Height * (r + 0.5) / NumOfRoads, X0 = Width * 0.1, Step = Width * 0.8 / NumOfRoadSegments;
+
+    Points.push_back(vec(X0, 0, Z + 2 * sin(X0 / 4)));
+    for (INT i = 1; i <= NumOfRoadSegments; i++)
+    {
+      Points.push_back(vec(X0 + Step * i, 0, Z + 2 * sin((X0 + Step * i) / 4)));
+      Segments.push_back(segment(Points.size() - 2, Points.size() - 1));
+    }
+  }
+
+  // Landscape creation steps (see 'CreateLandscape').
+  Start = std::chrono::steady_clock::now();
+  IntersectRoadSegments(RoadSegments);
+  SetRoadSegments(RoadSegments, RoadHalfWidth, RoadShoulderWidth);
+  InterpolateRoadSegments(RoadSegments, RoadHalfWidth, RoadShoulderWidth);
+  SetRoadSegments(RoadSegments, RoadHalfWidth, RoadShoulderWidth);
+  Time = BenchmarkTime(Start);
+  BenchmarkLog(Ani, "  %d segments -> %d road segments: %.1f ms", (INT)Segments.size(), (INT)RoadSegments.size(), Time * 1e3);
+
+  Start = std::chrono::steady_clock::now();
+  InsertRoad(RoadSegments);
+  Time = BenchmarkTime(Start);
+  BenchmarkLog(Ani, "  InsertRoad: %.1f ms, %d triangles left", Time * 1e3, (INT)Triangles.size());
+
+  Start = std::chrono::steady_clock::now();
+  SetTextureCoordinates(RoadSegments, RoadHalfWidth);
+  TriangulateRoad(RoadSegments, RoadHalfWidth);
+  TriangulateRoadShoulder(RoadSegments);
+  BuildHouses();
+  Time = BenchmarkTime(Start);
+  BenchmarkLog(Ani, "  road, shoulders and scene primitives: %.1f ms", Time * 1e3);
+} /* End of 'tcg::unit_road::BenchmarkRoads' function */
+
+/* Batch noise benchmark function.
+ * Value noise and 4-octave 'fBm_multi_ridged' are evaluated on random
+ * points by scalar calls and by batch calls at every supported SIMD
+ * level. Batch results are compared with scalar calls ones. Then
+ * 8-octave fBm per point calls are timed through operator (member
+ * function pointer), 'Visit' evaluator and run time octaves loop.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkNoise( VOID )
+{
+  const INT NumOfPoints = 1 << 20;
+  const CHAR *Names[] = {"scalar", "sse4", "avx2"};
+  INT Detected = cpu::DetectSimd();
+  std::mt19937 Rnd(30);
+  std::uniform_real_distribution<DOUBLE> Coord(-10, 10);
+  std::vector<DOUBLE> X(NumOfPoints), Y(NumOfPoints), Z(NumOfPoints), Ref(NumOfPoints), Res(NumOfPoints);
+  noise Noise;
+  fBm_multi_ridged Fbm(0.4, 2.01, 2, 1, 4);
+
+  for (INT i = 0; i < NumOfPoints; i++)
+  {
+    X[i] = Coord(Rnd);
+    Y[i] = Coord(Rnd);
+    Z[i] = Coord(Rnd);
+  }
+
+  BenchmarkLog(Ani, "Noise: %d random points, Mpts/s (max abs deviation from scalar calls)", NumOfPoints);
+  for (INT f = 0; f < 2; f++)
+  {
+    std::chrono::steady_clock::time_point Start;
+    DOUBLE Time;
+    CHAR Line[256];
+
+    // Scalar calls.
+    Start = std::chrono::steady_clock::now();
+    if (f == 0)
+      for (INT i = 0; i < NumOfPoints; i++)
+        Ref[i] = Noise.Noise(X[i], Y[i], Z[i]);
+    else
+      for (INT i = 0; i < NumOfPoints; i++)
+        Ref[i] = Fbm(vec(X[i], Y[i], Z[i]));
+    Time = BenchmarkTime(Start);
+    sprintf(Line, "  %s: calls %6.2f", f == 0 ? "noise" : "fBm 4 octaves", NumOfPoints / Time * 1e-6);
+
+    // Batch call by every kernel.
+    for (INT k = cpu::SIMD_NONE; k <= Detected; k++)
+    {
+      DOUBLE MaxDev = 0;
+
+      cpu::SetSimd(k);
+      Start = std::chrono::steady_clock::now();
+      if (f == 0)
+        Noise.Noise(&X[0], &Y[0], &Z[0], &Res[0], NumOfPoints);
+      else
+        Fbm(&X[0], &Y[0], &Z[0], &Res[0], NumOfPoints);
+      Time = BenchmarkTime(Start);
+      for (INT i = 0; i < NumOfPoints; i++)
+        MaxDev = COM_MAX(MaxDev, fabs(Res[i] - Ref[i]));
+      sprintf(Line + strlen(Line), ", batch %s %6.2f (%g)", Names[k], NumOfPoints / Time * 1e-6, MaxDev);
+    }
+    BenchmarkLog(Ani, "%s", Line);
+  }
+  cpu::SetSimd(Detected);
+
+  // Octaves number specialization: bound member function pointer, 'Visit' evaluator and run time loop.
+  fBm_multi_ridged Fbm8(0.4, 2.01, 2, 1, 8);
+  fBm_multi_ridged::fixed<8> Fixed8(Fbm8);
+  fBm_multi_ridged::fixed<0> Loop8(Fbm8);
+
+  for (INT g = 0; g < 2; g++)
+  {
+    DOUBLE Bound, Fixed, Loop;
+    BOOL IsSame;
+
+    Bound = BenchmarkPoints(Fbm8, X, Y, Z, g, Ref);
+    Fixed = BenchmarkPoints(Fixed8, X, Y, Z, g, Res);
+    IsSame = Ref == Res;
+    Loop = BenchmarkPoints(Loop8, X, Y, Z, g, Res);
+    IsSame = IsSame && Ref == Res;
+    BenchmarkLog(Ani, "  fBm%s 8 octaves per point: operator %6.2f, fixed<8> %6.2f, run time octaves %6.2f%s",
+      g ? "D" : "", NumOfPoints / Bound * 1e-6, NumOfPoints / Fixed * 1e-6, NumOfPoints / Loop * 1e-6,
+      IsSame ? "" : " (DIFFERENT VALUES)");
+  }
+} /* End of 'tcg::unit_road::BenchmarkNoise' function */
+
+/* Noise engines benchmark function.
+ * Same seed height maps are evaluated by value and simplex noise
+ * 'fBm_multi_ridged' with equal octaves numbers (preview default
+ * parameters), speed and heights statistics are compared.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkNoiseEngines( VOID )
+{
+  const INT Size = 1024, Octaves[] = {4, 8};
+  std::vector<DOUBLE> Heights;
+
+  BenchmarkLog(Ani, "Noise engines: %dx%d height map, H 0.4, lacunarity 6.01, gain 2, offset 1", Size, Size);
+  for (INT o = 0; o < sizeof(Octaves) / sizeof(Octaves[0]); o++)
+    for (INT e = 0; e < 2; e++)
+    {
+      DOUBLE Time, Min = DBL_MAX, Max = -DBL_MAX, Mean = 0, Var = 0;
+
+      if (e == 0)
+      {
+        fBm_multi_ridged Fbm(0.4, 6.01, 2, 1, Octaves[o]);
+
+        Time = BenchmarkHeights(Fbm, Size, Heights);
+      }
+      else
+      {
+        fBm_multi_ridged_simplex Fbm(0.4, 6.01, 2, 1, Octaves[o]);
+
+        Time = BenchmarkHeights(Fbm, Size, Heights);
+      }
+      for (size_t i = 0; i < Heights.size(); i++)
+      {
+        Min = COM_MIN(Min, Heights[i]);
+        Max = COM_MAX(Max, Heights[i]);
+        Mean += Heights[i];
+      }
+      Mean /= Heights.size();
+      for (size_t i = 0; i < Heights.size(); i++)
+        Var += (Heights[i] - Mean) * (Heights[i] - Mean);
+      Var /= Heights.size();
+      BenchmarkLog(Ani, "  %d octaves, %-7s: %6.2f Mpts/s, min %.4f, max %.4f, mean %.4f, variance %.4f",
+        Octaves[o], e == 0 ? "value" : "simplex", Heights.size() / Time * 1e-6, Min, Max, Mean, Var);
+    }
+} /* End of 'tcg::unit_road::BenchmarkNoiseEngines' function */
+
+/* Normal encodings benchmark function.
+ * Terrain (8-octave fBm analytic gradient as in 'hm_gen') and uniform
+ * random normal sets are stored as SHORT[3] and as 16-bit and 8-bit
+ * octahedral codes (encoded from SHORT[3], as 'hm_gen' does), decoded
+ * angles are compared with exact normals and with SHORT[3] ones.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkNormalEncodings( VOID )
+{
+  const INT Size = 512, NumOfNormals = Size * Size;
+  std::vector<vec> Exact(NumOfNormals), Short3(NumOfNormals);
+  std::vector<SHORT> Codes(NumOfNormals * 3), Oct16(NumOfNormals * 2);
+  std::vector<int8_t> Oct8(NumOfNormals * 2);
+  std::mt19937 Rnd(30);
+  std::normal_distribution<DOUBLE> Gauss;
+  fBm_multi_ridged Fbm(0.4, 6.01, 2, 1, 8);
+
+  BenchmarkLog(Ani, "Normal encodings: %d normals per set, angle error in degrees, mean / max", NumOfNormals);
+  for (INT s = 0; s < 2; s++)
+  {
+    FLOAT Reported[2];
+    DOUBLE Sum[5] = {0}, Max[5] = {0};
+
+    for (INT i = 0; i < NumOfNormals; i++)
+    {
+      if (s == 0)
+      {
+        vec g;
+
+        Fbm.fBmD(vec(i % Size * 10.0 / Size, i / Size * 10.0 / Size, 0), g);
+        Exact[i] = vec(-g.X, 1, -g.Y).Normalizing();
+      }
+      else
+        Exact[i] = vec(Gauss(Rnd), Gauss(Rnd), Gauss(Rnd)).Normalizing();
+      Codes[i * 3] = (SHORT)(Exact[i].X * 32767);
+      Codes[i * 3 + 1] = (SHORT)(Exact[i].Y * 32767);
+      Codes[i * 3 + 2] = (SHORT)(Exact[i].Z * 32767);
+      Short3[i] = vec(Codes[i * 3], Codes[i * 3 + 1], Codes[i * 3 + 2]).Normalizing();
+    }
+    Reported[0] = codec::OctEncode(&Codes[0], NumOfNormals, &Oct16[0]);
+    Reported[1] = codec::OctEncode(&Codes[0], NumOfNormals, &Oct8[0]);
+
+    // SHORT[3] against exact, octahedral codes against exact and SHORT[3].
+    for (INT i = 0; i < NumOfNormals; i++)
+    {
+      FLOAT n16[3], n8[3];
+      DOUBLE a[5];
+
+      codec::OctToVector(Oct16[i * 2] / 32767.0f, Oct16[i * 2 + 1] / 32767.0f, n16);
+      codec::OctToVector(Oct8[i * 2] / 127.0f, Oct8[i * 2 + 1] / 127.0f, n8);
+      a[0] = BenchmarkAngle(Short3[i], Exact[i]);
+      a[1] = BenchmarkAngle(vec(n16[0], n16[1], n16[2]), Exact[i]);
+      a[2] = BenchmarkAngle(vec(n16[0], n16[1], n16[2]), Short3[i]);
+      a[3] = BenchmarkAngle(vec(n8[0], n8[1], n8[2]), Exact[i]);
+      a[4] = BenchmarkAngle(vec(n8[0], n8[1], n8[2]), Short3[i]);
+      for (INT k = 0; k < 5; k++)
+      {
+        Sum[k] += a[k];
+        Max[k] = COM_MAX(Max[k], a[k]);
+      }
+    }
+    BenchmarkLog(Ani, "  %s normals: SHORT3 (6 bytes) %.5f / %.5f", s == 0 ? "terrain" : "random", Sum[0] / NumOfNormals, Max[0]);
+    BenchmarkLog(Ani, "    OCT16 (4 bytes) %.5f / %.5f, against SHORT3 %.5f / %.5f (encoder reported max %.5f)",
+      Sum[1] / NumOfNormals, Max[1], Sum[2] / NumOfNormals, Max[2], Reported[0]);
+    BenchmarkLog(Ani, "    OCT8 (2 bytes) %.5f / %.5f, against SHORT3 %.5f / %.5f (encoder reported max %.5f)",
+      Sum[3] / NumOfNormals, Max[3], Sum[4] / NumOfNormals, Max[4], Reported[1]);
+  }
+} /* End of 'tcg::unit_road::BenchmarkNormalEncodings' function */
+
+/* Erosion benchmark function.
+ * Height maps of several sizes (8-octave fBm, preview default
+ * parameters) are eroded by fixed iterations numbers on all pool
+ * threads, speed is measured as grid cells per second per iteration.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BenchmarkErosion( VOID )
+{
+  const INT Sizes[] = {256, 512, 1024}, Iterations[] = {10, 50};
+  fBm_multi_ridged Fbm(0.4, 6.01, 2, 1, 8);
+  std::vector<DOUBLE> Heights;
+  thread_pool Pool;
+
+  BenchmarkLog(Ani, "Erosion: default parameters, %d threads, Mcells/s per iteration", Pool.GetNumOfThreads());
+  for (INT s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); s++)
+  {
+    BenchmarkHeights(Fbm, Sizes[s], Heights);
+    for (INT it = 0; it < sizeof(Iterations) / sizeof(Iterations[0]); it++)
+    {
+      std::vector<FLOAT> Map(Heights.begin(), Heights.end());
+      hm_erosion Eroder(Sizes[s], Sizes[s], 10.0f / Sizes[s], hm_erosion::params(Iterations[it]));
+      std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+      DOUBLE Time;
+
+      Eroder.Run(&Map[0], Pool);
+      Time = BenchmarkTime(Start);
+      BenchmarkLog(Ani, "  %4d^2, %2d iterations: %8.1f ms, %6.2f Mcells/s", Sizes[s], Iterations[it],
+        Time * 1e3, (DOUBLE)Sizes[s] * Sizes[s] * Iterations[it] / Time * 1e-6);
+    }
+  }
+} /* End of 'tcg::unit_road::BenchmarkErosion' function */
+
+/* END OF 'benchmark.cpp' FILE */
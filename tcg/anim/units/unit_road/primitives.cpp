@@ -38,7 +38,7 @@ VOID tcg::unit_road::CreateMountain( tcg::primitive::patch3 &Tri, anim *Ani, con
 
   Tri.Material = Ani->AddMaterial("mountain", "mountain");
   Tri.Material->SetUniform("Height", 4.0f);
-  Tri.Material->AddTexture(Ani->AddTexture("TextureHeight", "heightmap1.float"));
+  Tri.Material->AddTexture(Ani->AddTexture("TextureHeight", "heightmap1.pyr"));
   Tri.Material->AddTexture(Ani->AddTexture("Texture", "sandlines.jpg"));
   Tri.Material->AddTexture(Ani->AddTexture("ColorMap", "cm.g24"));
   Tri.Material->AddTexture(Ani->AddTexture("NormalMap", "normalmap1.short"));
@@ -130,6 +130,71 @@ VOID tcg::unit_road::CreateMountain( tcg::primitive::patch3 &Tri, anim *Ani, con
   delete I;
 } /* End of 'tcg::unit_road::CreateMountain' function */
 
+/* Patch mountain function.
+ * Changed triangulation slots are rewritten in buffers, buffers are
+ * rebuilt with reserve if new points or triangles do not fit them.
+ * ARGUMENTS:
+ *   - points:
+ *       const std::vector<vec> &Points;
+ *   - triangulation with changed slots (they are cleared):
+ *       math::delaunay &Triangulation;
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::PatchMountain( tcg::primitive::patch3 &Tri, const std::vector<vec> &Points, math::delaunay &Triangulation )
+{
+  BOOL IsFit = TRUE;
+
+  for (INT i = 0; IsFit && i < Triangulation.Changed.size(); i++)
+  {
+    const math::triangle &T = Triangulation.Triangles[Triangulation.Changed[i]];
+    INT I[3] = {0, 0, 0};
+
+    // Removed slot is kept as degenerate triangle.
+    if (T.P[0] != -1)
+      for (INT k = 0; IsFit && k < 3; k++)
+      {
+        vertex V;
+
+        V.Pos = Points[I[k] = T.P[k]];
+        V.UV = uv(V.Pos.X / 2, -V.Pos.Z / 2);
+        V.ID = 0;
+        IsFit = Tri.UpdateVertices(&V, I[k], 1);
+      }
+    IsFit = IsFit && Tri.UpdateIndices(I, Triangulation.Changed[i] * 3, 3);
+  }
+  Triangulation.Changed.clear();
+  if (IsFit)
+    return;
+
+  INT
+    NoofV = Points.size() * 2,
+    NoofT = Triangulation.Triangles.size() * 2;
+  vertex *V = new vertex[NoofV];
+  INT *I = new INT[NoofT * 3];
+
+  for (INT i = 0; i < Points.size(); i++)
+  {
+    V[i].Pos = Points[i];
+    V[i].UV = uv(V[i].Pos.X / 2, -V[i].Pos.Z / 2);
+    V[i].ID = 0;
+  }
+  for (INT i = 0; i < NoofT * 3; i++)
+    I[i] = 0;
+  for (INT i = 0; i < Triangulation.Triangles.size(); i++)
+    if (Triangulation.Triangles[i].P[0] != -1)
+    {
+      I[i * 3] =     Triangulation.Triangles[i].P[0];
+      I[i * 3 + 1] = Triangulation.Triangles[i].P[1];
+      I[i * 3 + 2] = Triangulation.Triangles[i].P[2];
+    }
+
+  Tri.DeleteBuffers();
+  Tri.SetBuffers(V, I, NoofV, NoofT * 3);
+
+  delete[] V;
+  delete[] I;
+} /* End of 'tcg::unit_road::PatchMountain' function */
+
 /* Create road function.
  * ARGUMENTS:
  *   - animation:
@@ -198,7 +263,7 @@ VOID tcg::unit_road::CreateRoad( tcg::primitive::trimesh &Tri, anim *Ani, const
   Tri.Material = Ani->AddMaterial("road", "road");
   Tri.Material->AddTexture(Ani->AddTexture("road", "road.jpg"));
   Tri.Material->SetUniform("Height", 4.0f);
-  Tri.Material->AddTexture(Ani->AddTexture("TextureHeight", "heightmap1.float"));
+  Tri.Material->AddTexture(Ani->AddTexture("TextureHeight", "heightmap1.pyr"));
   Tri.Material->AddTexture(Ani->AddTexture("light", "mountain_light.jpg"));
 
   delete V;
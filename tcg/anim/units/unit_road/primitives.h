@@ -31,6 +31,18 @@
       const std::vector<math::triangle> &Triangles, const std::vector<INT> &IDs,
       const std::vector<INT> &P0, const std::vector<INT> &P1, const std::vector<INT> &H0, const std::vector<INT> &H1 );
 
+    /* Patch mountain function.
+     * Changed triangulation slots are rewritten in buffers, buffers are
+     * rebuilt with reserve if new points or triangles do not fit them.
+     * ARGUMENTS:
+     *   - points:
+     *       const std::vector<vec> &Points;
+     *   - triangulation with changed slots (they are cleared):
+     *       math::delaunay &Triangulation;
+     * RETURNS: None.
+     */
+    VOID PatchMountain( tcg::primitive::patch3 &Tri, const std::vector<vec> &Points, math::delaunay &Triangulation );
+
     /* Create road function.
      * ARGUMENTS:
      *   - animation:
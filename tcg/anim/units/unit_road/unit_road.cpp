@@ -31,12 +31,22 @@ tcg::unit_road::unit_road( anim *Ani, float H, float Lacunarity,
                            float Octaves, float Offset,
                            float Gain, float FSeed ) :
   fBm(H, Lacunarity, Gain, Offset, Octaves, FSeed),
-  unit(Ani), Ani(Ani), Mountain(Ani), Road(Ani), Village(Ani), IsLandscape(FALSE), FirstPoint(TRUE),
+  unit(Ani), Ani(Ani), Triangulation(Points), Mountain(Ani), Road(Ani), Village(Ani), IsLandscape(FALSE), FirstPoint(TRUE),
   Plane(vec(1 - 4, 0, 1 - 4), vec(0, 0, 58 + 8), vec(58 + 8, 0, 0)), EditMode(EDIT_TRIANGLES), ScaleY(1)
 {
   Houses.push_back(std::vector<INT>());
   IfTess = 1;
 
+  /* Height map texels centers are samples of landscape (see 'mountain' shader) */
+  if (Terrain.Load("bin/textures/heightmap1.float", "bin/textures/heightmap1.mmt"))
+  {
+    DOUBLE
+      w = Terrain.GetTree().GetW(),
+      h = Terrain.GetTree().GetH();
+
+    Terrain.Place(vec(Width / w / 2, 0, Height / h / 2), vec(Width * (w - 1) / w, 4, Height * (h - 1) / h));
+  }
+
   Ani->Camera.SetDirLocUp(vec(Width / 2,
                               Width * Ani->Camera.ProjDist,
                               Height / 2),
@@ -58,7 +68,8 @@ tcg::unit_road::unit_road( anim *Ani, float H, float Lacunarity,
   AddPoint(vec(60, 0, 60));
   AddPoint(vec(0,  0, 60));
 
-  math::Triangulate(Points, Triangles);
+  Triangulation.Build();
+  Triangulation.GetTriangles(Triangles);
 
   std::vector<INT> IDs;
   for (INT i = 0; i < Points.size(); i++)
@@ -93,6 +104,20 @@ VOID tcg::unit_road::Response( VOID )
     Mountain.Material->SetUniform("IfTess", IfTess);
   }
 
+  /* Benchmarks, results are appended to 'bin/benchmark.txt' (F7 one is run instead of landscape building) */
+  if (Ani->KeysClick[VK_F5])
+    BenchmarkPicking();
+  if (Ani->KeysClick[VK_F6])
+    BenchmarkTriangulation();
+  if (Ani->KeysClick[VK_F8])
+    BenchmarkNoise();
+  if (Ani->KeysClick[VK_F9])
+    BenchmarkNoiseEngines();
+  if (Ani->KeysClick[VK_F11])
+    BenchmarkNormalEncodings();
+  if (Ani->KeysClick[VK_F4])
+    BenchmarkErosion();
+
   if (!IsLandscape)
   {
     if (Ani->KeysClick[VK_LBUTTON])
@@ -106,9 +131,11 @@ VOID tcg::unit_road::Response( VOID )
       Ray.Org = Ani->Camera.Loc + Ray.Dir;
       Ray.Dir.Normalize();
 
-      cd::collision Collision = Plane.Intersect(Ray, 0, 1);
+      cd::collision Collision = Pick(Ray);
       if (Collision.IsCollide)
       {
+        /* Points are kept on base plane, heights come from height map */
+        Collision.Intersection.Location.Y = 0;
         if (EditMode == EDIT_ROAD)
         {
           if (FirstPoint)
@@ -124,8 +151,20 @@ VOID tcg::unit_road::Response( VOID )
         }
         else
         {
-          AddPoint(Collision.Intersection.Location);
-          math::Triangulate(Points, Triangles);
+          /* Houses and roads points added since last edit are landscape points too */
+          Triangulation.Update();
+          if (Ani->Keys[VK_CONTROL])
+          {
+            /* Houses and roads points are kept, removed point place is reused by next insertion */
+            INT V = Triangulation.Find(Collision.Intersection.Location);
+
+            if (V != -1 && !IsPointUsed(V))
+              Triangulation.RemoveIndex(V);
+          }
+          else
+            Triangulation.Insert(Collision.Intersection.Location);
+          if (Triangulation.Changed.size() > 0)
+            PatchMountain(Mountain, Points, Triangulation);
         }
       }
     }
@@ -155,9 +194,17 @@ VOID tcg::unit_road::Response( VOID )
       EditMode = EDIT_ROAD;
       FirstPoint = TRUE;
     }
-    if (Ani->KeysClick['B'])
+    /* F7 replaces scene with roads benchmark one and builds its landscape */
+    if (Ani->KeysClick['B'] || Ani->KeysClick[VK_F7])
     {
-      CreateLandscape(RoadHalfWidth, RoadShoulderWidth);
+      if (Ani->KeysClick[VK_F7])
+        BenchmarkRoads();
+      else
+      {
+        Triangulation.Update();
+        Triangulation.GetTriangles(Triangles);
+        CreateLandscape(RoadHalfWidth, RoadShoulderWidth);
+      }
       IsLandscape = TRUE;
       LookAt = vec(Ani->Camera.Loc.X, 0, Ani->Camera.Loc.Z);
       Dist = Ani->Camera.Loc.Y;
@@ -173,7 +220,7 @@ VOID tcg::unit_road::Response( VOID )
       Ray.Org = Ani->Camera.Loc + Ray.Dir;
       Ray.Dir.Normalize();
 
-      cd::collision Collision = Plane.Intersect(Ray, 0, 1);
+      cd::collision Collision = Pick(Ray);
       if (Collision.IsCollide)
       {
         DOUBLE sd;
@@ -204,15 +251,11 @@ VOID tcg::unit_road::Response( VOID )
       }
     if (Ani->Keys[VK_UP])
       Ani->Camera.SetLookAtLocUp(Ani->Camera.Loc + vec(0, Ani->DeltaTime * 20, 0),
-                                 cd::plane(vec(0, 0, 0),
-                                           vec(1, 0, 0),
-                                           vec(1, 0, -1)).Intersect(ray(Ani->Camera.Loc, Ani->Camera.Dir), 0, 1).Intersection.Location,
+                                 PickScene(ray(Ani->Camera.Loc, Ani->Camera.Dir)).Intersection.Location,
                                  vec(0.0, 1.0, 0.0));
     if (Ani->Keys[VK_DOWN] && Ani->Camera.Loc.Y > 0.2)
       Ani->Camera.SetLookAtLocUp(Ani->Camera.Loc - vec(0, Ani->DeltaTime * 20, 0),
-                                 cd::plane(vec(0, 0, 0),
-                                           vec(1, 0, 0),
-                                           vec(1, 0, -1)).Intersect(ray(Ani->Camera.Loc, Ani->Camera.Dir), 0, 1).Intersection.Location,
+                                 PickScene(ray(Ani->Camera.Loc, Ani->Camera.Dir)).Intersection.Location,
                                  vec(0.0, 1.0, 0.0));
     if (Ani->Keys[VK_LEFT])
       Ani->Camera.MoveRight(-Ani->DeltaTime * 30);
@@ -228,7 +271,12 @@ VOID tcg::unit_road::Response( VOID )
                 Ani->Camera.Up * (Ani->Camera.Height / 2 - Y / H * Ani->Camera.Height);
       Ray.Org = Ani->Camera.Loc + Ray.Dir;
       Ray.Dir.Normalize();
-      Ani->Camera.Translate(vecf(Ray.Dir * Ani->WheelDelta / 70.0));
+
+      /* Camera does not pass through landscape and houses */
+      vec Step = Ray.Dir * Ani->WheelDelta / 70.0;
+
+      if (!Scene.IsOccluded(ray(Ani->Camera.Loc, Step), 1))
+        Ani->Camera.Translate(vecf(Step));
     }
     if (Ani->Keys[VK_LBUTTON] &&
         Ani->MsX >= 0 && Ani->MsX < Ani->GetW() &&
@@ -514,6 +562,25 @@ VOID tcg::unit_road::AddPoint( const vec &Point )
   Points.push_back(Point);
 } /* End of 'tcg::unit_road::AddPoint' function */
 
+/* Test point used by houses or roads function.
+ * ARGUMENTS:
+ *   - point index:
+ *       INT Index;
+ * RETURNS:
+ *   (BOOL) TRUE if point is house or road segment one, FALSE otherwise.
+ */
+BOOL tcg::unit_road::IsPointUsed( INT Index ) const
+{
+  for (INT i = 0; i < Houses.size(); i++)
+    for (INT j = 0; j < Houses[i].size(); j++)
+      if (Houses[i][j] == Index)
+        return TRUE;
+  for (INT i = 0; i < Segments.size(); i++)
+    if (Segments[i].P0 == Index || Segments[i].P1 == Index)
+      return TRUE;
+  return FALSE;
+} /* End of 'tcg::unit_road::IsPointUsed' function */
+
 /* Add segment function.
  * ARGUMENTS:
  *   - segment points:
@@ -745,8 +812,38 @@ VOID tcg::unit_road::BuildHouses( VOID )
     }
   }
   CreateVillage(Village, Ani, Points, HouseTriangles, IDs, TexCoords, Heights);
+  BuildScene(HouseTriangles, Heights);
 } /* End of 'BuildHouses' function */
 
+/* Build landscape scene for picking function.
+ * Points are lifted by 'Terrain' heights as meshes shaders do.
+ * ARGUMENTS:
+ *   - houses triangles and their height points:
+ *       const std::vector<triangle> &HouseTriangles;
+ *       const std::vector<INT> &HouseHeights;
+ * RETURNS: None.
+ */
+VOID tcg::unit_road::BuildScene( const std::vector<triangle> &HouseTriangles, const std::vector<INT> &HouseHeights )
+{
+  std::vector<vec> ScenePoints(Points.size());
+  std::vector<triangle> SceneTriangles(Triangles);
+
+  for (INT i = 0; i < Points.size(); i++)
+    ScenePoints[i] = Points[i] + vec(0, Terrain.GetHeight(Points[i].X, Points[i].Z), 0);
+  SceneTriangles.insert(SceneTriangles.end(), RoadTriangles.begin(), RoadTriangles.end());
+
+  /* House is lifted as whole by height of its point */
+  for (INT i = 0; i < HouseTriangles.size(); i++)
+  {
+    DOUBLE h = Terrain.GetHeight(Points[HouseHeights[i]].X, Points[HouseHeights[i]].Z);
+
+    SceneTriangles.push_back(triangle(ScenePoints.size(), ScenePoints.size() + 1, ScenePoints.size() + 2));
+    for (INT k = 0; k < 3; k++)
+      ScenePoints.push_back(Points[HouseTriangles[i].P[k]] + vec(0, h, 0));
+  }
+  Scene.Build(ScenePoints, SceneTriangles);
+} /* End of 'BuildScene' function */
+
 /* Create landscape function.
  * ARGUMENTS:
  *   - road width and shoulder width:
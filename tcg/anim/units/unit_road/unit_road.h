@@ -55,6 +55,7 @@ namespace tcg
 
     std::vector<vec> Points;
     std::vector<triangle> Triangles;
+    delaunay Triangulation;
     primitive::patch3 Mountain;
 
     BOOL FirstPoint;
@@ -67,6 +68,8 @@ namespace tcg
     primitive::patch3 Village;
 
     cd::plane_finite Plane;
+    cd::heightfield Terrain;
+    cd::bvh Scene;
 
     enum { EDIT_ROAD, EDIT_HOUSE, EDIT_TRIANGLES };
     INT EditMode;
@@ -74,6 +77,42 @@ namespace tcg
 
     DOUBLE ScaleY;
 
+    /* Pick landscape point function.
+     * Ray is intersected with landscape height field, base plane is used
+     * if there is no height map or ray misses it.
+     * ARGUMENTS:
+     *   - pick ray:
+     *       const ray &Ray;
+     * RETURNS:
+     *   (cd::collision) collision information with intersection point.
+     */
+    cd::collision Pick( const ray &Ray ) const
+    {
+      cd::collision Collision = Terrain.Intersect(Ray, 0, 1);
+
+      if (Collision.IsCollide)
+        return Collision;
+      return Plane.Intersect(Ray, 0, 1);
+    } /* End of 'Pick' function */
+
+    /* Pick built landscape point function.
+     * Ray is intersected with landscape, roads and houses triangles,
+     * base plane is used if ray misses them.
+     * ARGUMENTS:
+     *   - pick ray:
+     *       const ray &Ray;
+     * RETURNS:
+     *   (cd::collision) collision information with intersection point.
+     */
+    cd::collision PickScene( const ray &Ray ) const
+    {
+      cd::collision Collision = Scene.Intersect(Ray, 0, 1);
+
+      if (Collision.IsCollide)
+        return Collision;
+      return cd::plane(vec(0, 0, 0), vec(1, 0, 0), vec(1, 0, -1)).Intersect(Ray, 0, 1);
+    } /* End of 'PickScene' function */
+
     /* Test segment intersection function.
      * ARGUMENTS:
      *   - segment points:
@@ -843,412 +882,66 @@ namespace tcg
       RoadSegments = NewRoadSegments;
     } /* End of 'InterpolateRoadSegments' function */
 
-    /* Cut triangle function.
+    /* Test point in road segment function.
+     * ARGUMENTS:
+     *   - road segments:
+     *       std::vector<road_segment> &RoadSegments;
+     *   - road segment index:
+     *       INT rs;
+     *   - point:
+     *       const vec &Point;
+     * RETURNS:
+     *   (BOOL) TRUE if point is inside road segment with shoulders, FALSE otherwise.
+     */
+    BOOL PointTestRoadSegment( std::vector<road_segment> &RoadSegments, INT rs, const vec &Point )
+    {
+      vec
+        P0 = RoadSegments[rs].Neighbour[LEFT][0] == -1 ?
+             (Points[RoadSegments[rs].Shoulder[LEFT][0]] + Points[RoadSegments[rs].Shoulder[RIGHT][0]]) / 2 :
+             Points[RoadSegments[rs].P[0]],
+        P1 = RoadSegments[rs].Neighbour[LEFT][1] == -1 ?
+             (Points[RoadSegments[rs].Shoulder[LEFT][1]] + Points[RoadSegments[rs].Shoulder[RIGHT][1]]) / 2 :
+             Points[RoadSegments[rs].P[1]];
+      return PointTestHexagon(Point,
+                              P0,
+                              Points[RoadSegments[rs].Shoulder[RIGHT][0]],
+                              Points[RoadSegments[rs].Shoulder[RIGHT][1]],
+                              P1,
+                              Points[RoadSegments[rs].Shoulder[LEFT][1]],
+                              Points[RoadSegments[rs].Shoulder[LEFT][0]]);
+    } /* End of 'PointTestRoadSegment' function */
+
+    /* Get road segment shoulder line function.
      * ARGUMENTS:
      *   - road segments:
      *       std::vector<road_segment> &RoadSegments;
-     *   - road segment and triangle indices:
-     *       INT rs, tr;
+     *   - road segment index:
+     *       INT rs;
      *   - road segment side:
      *       INT side;
-     *   - neighbour and neighbour side to fill:
-     *       INT &neighbour, &neighbourside;
+     *   - line points indices to fill:
+     *       INT &A, &B;
      * RETURNS:
-     *   (BOOL) TRUE if intersect, FALSE otherwise.
+     *   (BOOL) TRUE if road segment has such shoulder line, FALSE otherwise.
      */
-    BOOL RoadCutTriangle( std::vector<road_segment> &RoadSegments, INT rs, INT tr, INT side,
-                          BOOL &ToContinue, std::vector<INT> &SidePoints, INT &InSide, INT &OutSide,
-                          std::vector<INT> &RoadPoints )
+    BOOL GetShoulderLine( std::vector<road_segment> &RoadSegments, INT rs, INT side, INT &A, INT &B )
     {
-      ToContinue = TRUE;
-
-      SidePoints.clear();
-      RoadPoints.clear();
-      InSide = OutSide = -1;
-
-      BOOL cross = FALSE;
-      INT niside = -1;
-
-      if (side == END_0 || side == END_1)
+      if (side == LEFT || side == RIGHT)
       {
-        INT sm = 0;
-        for (INT k = 0; k < 3; k++)
-        {
-          if (RoadSegments[rs].Shoulder[LEFT][side - 2] == Triangles[tr].P[k])
-            sm++, niside = k;
-          if (RoadSegments[rs].Shoulder[RIGHT][side - 2] == Triangles[tr].P[k])
-            sm++, niside = k;
-          for (INT j = 0; j < RoadSegments[rs].Intersections[side].size(); j++)
-            if (RoadSegments[rs].Intersections[side][j].Index == Triangles[tr].P[k])
-              sm++, niside = k;
-        }
-        if (sm > 1)
-          return FALSE;
-
-        if (RoadSegments[rs].Neighbour[LEFT][side - END_0] == -1)
-          for (INT k = 0; k < 3; k++)
-          {
-            if (k == niside && !SegmentTestSegment(Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]], Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]],
-                                                   Points[Triangles[tr].P[(niside + 1) % 3]], Points[Triangles[tr].P[(niside + 2) % 3]]))
-              continue;
-            else if ((k + 1) % 3 == niside)
-              continue;
-            if (SegmentTestSegmentInc(Points[Triangles[tr].P[k]], Points[Triangles[tr].P[(k + 1) % 3]],
-                                   Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]], Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]]))
-            {
-              Points.push_back(LineIntersectLine(Points[Triangles[tr].P[k]],
-                                                 Points[Triangles[tr].P[(k + 1) % 3]] - Points[Triangles[tr].P[k]],
-                                                 Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]],
-                                                 Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]] - Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]]));
-              RoadSegments[rs].Intersections[side].push_back(
-                intersection((Points.back() - Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]]).Length2D() /
-                             (Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]] - Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]]).Length2D(), Points.size() - 1)
-              );
-              for (INT n = k + 1; n < 3; n++)
-              {
-                if (n == niside && !SegmentTestSegment(Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]], Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]],
-                                                       Points[Triangles[tr].P[(niside + 1) % 3]], Points[Triangles[tr].P[(niside + 2) % 3]]))
-                  continue;
-                else if ((n + 1) % 3 == niside)
-                  continue;
-                if (SegmentTestSegmentInc(Points[Triangles[tr].P[n]], Points[Triangles[tr].P[(n + 1) % 3]],
-                                       Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]], Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]]))
-                {
-                  Points.push_back(LineIntersectLine(Points[Triangles[tr].P[n]],
-                                                     Points[Triangles[tr].P[(n + 1) % 3]] - Points[Triangles[tr].P[n]],
-                                                     Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]],
-                                                     Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]] - Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]]));
-                  RoadSegments[rs].Intersections[side].push_back(
-                    intersection((Points.back() - Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]]).Length2D() /
-                                 (Points[RoadSegments[rs].Shoulder[RIGHT][side - END_0]] - Points[RoadSegments[rs].Shoulder[LEFT][side - END_0]]).Length2D (), Points.size() - 1)
-                  );
-                  INT p0, p1;
-                  if (RoadSegments[rs].Intersections[side][RoadSegments[rs].Intersections[side].size() - 2].t <
-                      RoadSegments[rs].Intersections[side][RoadSegments[rs].Intersections[side].size() - 1].t)
-                    p0 = side == END_0 ? Points.size() - 1 : Points.size() - 2, p1 = side == END_0 ? Points.size() - 2 : Points.size() - 1;
-                  else
-                    p0 = side == END_0 ? Points.size() - 2 : Points.size() - 1, p1 = side == END_0 ? Points.size() - 1 : Points.size() - 2;
-                  if (Rotation(Points[RoadSegments[rs].Shoulder[side - END_0][side - END_0]] - Points[RoadSegments[rs].Shoulder[!(side - END_0)][side - END_0]],
-                               Points[Triangles[tr].P[k]] - Points[RoadSegments[rs].Shoulder[!(side - END_0)][side - END_0]]) > 0)
-                  {
-                    Triangles.push_back(triangle(p0, p1, Triangles[tr].P[k]));
-                    if (n == k + 1)
-                      Triangles.push_back(triangle(p1, Triangles[tr].P[(n + 1) % 3], Triangles[tr].P[k]));
-                  }
-                  else
-                  {
-                    Triangles.push_back(triangle(p0, p1, Triangles[tr].P[(k + 1) % 3]));
-                    if (n == k + 2)
-                      Triangles.push_back(triangle(p0, Triangles[tr].P[(k + 1) % 3], Triangles[tr].P[n]));
-                  }
-                  return TRUE;
-                }
-              }
-            }
-          }
-        return FALSE;
-      }
-
-      INT sm = 0;
-      for (INT k = 0; k < 3; k++)
-      {
-        if (RoadSegments[rs].Shoulder[side][0] == Triangles[tr].P[k])
-          sm++, niside = k;
-        if (RoadSegments[rs].Shoulder[side][1] == Triangles[tr].P[k])
-          sm++, niside = k;
-        for (INT j = 0; j < RoadSegments[rs].Intersections[side].size(); j++)
-          if (RoadSegments[rs].Intersections[side][j].Index == Triangles[tr].P[k])
-            sm++, niside = k;
+        A = RoadSegments[rs].Shoulder[side][0];
+        B = RoadSegments[rs].Shoulder[side][1];
+        return TRUE;
       }
-      if (sm > 1)
+      if (RoadSegments[rs].Neighbour[LEFT][side - END_0] != -1)
         return FALSE;
-
-      for (INT k = 0; k < 3; k++)
-      {
-        if (k == niside && !SegmentTestSegment(Points[RoadSegments[rs].Shoulder[side][0]], Points[RoadSegments[rs].Shoulder[side][1]],
-                                               Points[Triangles[tr].P[(niside + 1) % 3]], Points[Triangles[tr].P[(niside + 2) % 3]]))
-          continue;
-        else if ((k + 1) % 3 == niside)
-          continue;
-        if (SegmentTestSegmentInc(Points[Triangles[tr].P[k]], Points[Triangles[tr].P[(k + 1) % 3]],
-                                  Points[RoadSegments[rs].Shoulder[side][0]], Points[RoadSegments[rs].Shoulder[side][1]]))
-        {
-          InSide = k;
-          Points.push_back(LineIntersectLine(Points[Triangles[tr].P[k]], Points[Triangles[tr].P[(k + 1) % 3]] - Points[Triangles[tr].P[k]],
-                                             Points[RoadSegments[rs].Shoulder[side][0]], Points[RoadSegments[rs].Shoulder[side][1]] - Points[RoadSegments[rs].Shoulder[side][0]]));
-          RoadSegments[rs].Intersections[side].push_back(
-            intersection((Points.back() - Points[RoadSegments[rs].Shoulder[side][0]]).Length2D() /
-                          (Points[RoadSegments[rs].Shoulder[side][1]] - Points[RoadSegments[rs].Shoulder[side][0]]).Length2D(), Points.size() - 1)
-          );
-          for (INT n = k + 1; n < 3; n++)
-          {
-            if (n == niside && !SegmentTestSegment(Points[RoadSegments[rs].Shoulder[side][0]], Points[RoadSegments[rs].Shoulder[side][1]],
-                                               Points[Triangles[tr].P[(niside + 1) % 3]], Points[Triangles[tr].P[(niside + 2) % 3]]))
-              continue;
-            else if ((n + 1) % 3 == niside)
-              continue;
-            if (SegmentTestSegmentInc(Points[Triangles[tr].P[n]], Points[Triangles[tr].P[(n + 1) % 3]],
-                                      Points[RoadSegments[rs].Shoulder[side][0]], Points[RoadSegments[rs].Shoulder[side][1]]))
-            {
-              Points.push_back(LineIntersectLine(Points[Triangles[tr].P[n]], Points[Triangles[tr].P[(n + 1) % 3]] - Points[Triangles[tr].P[n]],
-                                                 Points[RoadSegments[rs].Shoulder[side][0]], Points[RoadSegments[rs].Shoulder[side][1]] - Points[RoadSegments[rs].Shoulder[side][0]]));
-              RoadSegments[rs].Intersections[side].push_back(
-                intersection((Points.back() - Points[RoadSegments[rs].Shoulder[side][0]]).Length2D() /
-                             (Points[RoadSegments[rs].Shoulder[side][1]] - Points[RoadSegments[rs].Shoulder[side][0]]).Length2D(), Points.size() - 1)
-              );
-              INT p0, p1, s0, s1;
-              if (RoadSegments[rs].Intersections[side][RoadSegments[rs].Intersections[side].size() - 2].t <
-                  RoadSegments[rs].Intersections[side][RoadSegments[rs].Intersections[side].size() - 1].t)
-              {
-                p0 = side == LEFT ? Points.size() - 2 : Points.size() - 1, p1 = side == LEFT ? Points.size() - 1 : Points.size() - 2;
-                s0 = side == LEFT ? k : n, s1 = side == LEFT ? n : k;
-              }
-              else
-              {
-                p0 = side == LEFT ? Points.size() - 1 : Points.size() - 2, p1 = side == LEFT ? Points.size() - 2 : Points.size() - 1;
-                s0 = side == LEFT ? n : k, s1 = side == LEFT ? k : n;
-              }
-              if (Rotation(Points[RoadSegments[rs].Shoulder[side][!side]] - Points[RoadSegments[rs].Shoulder[side][side]],
-                           Points[Triangles[tr].P[k]] - Points[RoadSegments[rs].Shoulder[side][side]]) > 0)
-              {
-                Triangles.push_back(triangle(p0, p1, Triangles[tr].P[k]));
-
-                RoadPoints.push_back(p1);
-                RoadPoints.push_back(p0);
-                RoadPoints.push_back(Triangles[tr].P[(k + 1) % 3]);
-
-                if (n == k + 1)
-                  Triangles.push_back(triangle(p1, Triangles[tr].P[(n + 1) % 3], Triangles[tr].P[k]));
-                else
-                  RoadPoints.push_back(Triangles[tr].P[n]);
-              }
-              else
-              {
-                Triangles.push_back(triangle(p0, p1, Triangles[tr].P[(k + 1) % 3]));
-
-                RoadPoints.push_back(p1);
-                RoadPoints.push_back(p0);
-                RoadPoints.push_back(Triangles[tr].P[(n + 1) % 3]);
-
-                if (n == k + 2)
-                  Triangles.push_back(triangle(p0, Triangles[tr].P[(k + 1) % 3], Triangles[tr].P[n]));
-                else
-                  RoadPoints.push_back(Triangles[tr].P[k]);
-              }
-
-              INT nbno =
-                PointTestTriangle(Points[RoadSegments[rs].Shoulder[side][0]],
-                                  Points[Triangles[tr].P[0]], Points[Triangles[tr].P[1]], Points[Triangles[tr].P[2]]) ? 0 : 1;
-              if (nbno != -1 && PointTestTriangle(Points[RoadSegments[rs].Shoulder[!side][nbno]],
-                                                  Points[Triangles[tr].P[0]],
-                                                  Points[Triangles[tr].P[1]],
-                                                  Points[Triangles[tr].P[2]]))
-              {
-                SidePoints.push_back(side == LEFT ? nbno == 0 ? p0 : p1 : nbno == 0 ? p1 : p0);
-                OutSide = side == LEFT ? nbno == 0 ? s0 : s1 : nbno == 0 ? s1 : s0;
-              }
-              return TRUE;
-            }
-          }
-
-          INT
-            nbno =
-              PointTestTriangle(Points[RoadSegments[rs].Shoulder[side][0]],
-                                Points[Triangles[tr].P[0]], Points[Triangles[tr].P[1]], Points[Triangles[tr].P[2]]) ? 0 : 1,
-            cur = rs, curside = side, curnbno = nbno,
-            next = RoadSegments[cur].Neighbour[curside][curnbno],
-            nextside = next == -1 ? -1 : RoadSegments[cur].P[curnbno] == RoadSegments[next].P[curnbno] ? !curside : curside;
-
-          std::vector<INT> Polygon;
-          Polygon.push_back(Points.size() - 1);
-          Polygon.push_back(RoadSegments[cur].Shoulder[curside][curnbno]);
-
-          if (!cross && RoadSegments[cur].Neighbour[curside][curnbno] != RoadSegments[cur].Neighbour[!curside][curnbno])
-            cross = TRUE;
-
-          if (!cross && !PointTestTriangle(Points[RoadSegments[cur].Shoulder[!curside][curnbno]],
-            Points[Triangles[tr].P[0]], Points[Triangles[tr].P[1]], Points[Triangles[tr].P[2]]))
-            cross = TRUE;
-
-          if (cross)
-            SidePoints.push_back(RoadSegments[cur].Shoulder[curside][curnbno]);
-
-          while (1)
-          {
-            if (next == rs)
-              ToContinue = FALSE;
-            if (next != -1)
-            {
-              for (INT n = 0; n < 3; n++)
-              {
-                if (SegmentTestSegmentInc(Points[Triangles[tr].P[n]], Points[Triangles[tr].P[(n + 1) % 3]],
-                                          Points[RoadSegments[next].Shoulder[nextside][0]],
-                                          Points[RoadSegments[next].Shoulder[nextside][1]]))
-                {
-                  Points.push_back(LineIntersectLine(Points[Triangles[tr].P[n]],
-                                                     Points[Triangles[tr].P[(n + 1) % 3]] - Points[Triangles[tr].P[n]],
-                                                     Points[RoadSegments[next].Shoulder[nextside][0]],
-                                                     Points[RoadSegments[next].Shoulder[nextside][1]] -
-                                                     Points[RoadSegments[next].Shoulder[nextside][0]]));
-                  RoadSegments[next].Intersections[nextside].push_back(
-                    intersection((Points.back() - Points[RoadSegments[next].Shoulder[nextside][0]]).Length2D() /
-                                 (Points[RoadSegments[next].Shoulder[nextside][1]] -
-                                  Points[RoadSegments[next].Shoulder[nextside][0]]).Length2D(), Points.size() - 1));
-                  Polygon.push_back(Points.size() - 1);
-
-                  if (cross || PointTestTriangle(Points[RoadSegments[next].Shoulder[!nextside][nextside == side ? nbno : !nbno]],
-                                                 Points[Triangles[tr].P[0]], Points[Triangles[tr].P[1]], Points[Triangles[tr].P[2]]))
-                  {
-                    SidePoints.push_back(Points.size() - 1);
-                    OutSide = n;
-                  }
-                  RoadPoints = Polygon;
-                  if (n == k)
-                  {
-                    INT nr, fr;
-                    if ((Points[Triangles[tr].P[k]] - Points[Points.size() - 1]).Length2D() <
-                        (Points[Triangles[tr].P[k]] - Points[Points.size() - 2]).Length2D())
-                      nr = Points.size() - 1, fr = nr - 1;
-                    else
-                      nr = Points.size() - 2, fr = nr + 1;
-
-                    if (side == nbno && nr > fr)
-                      for (INT trs = n, i = 0; i < 3; trs = (trs + 3 - 1) % 3, i++)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-                    else if (side != nbno && nr < fr)
-                      for (INT trs = (n + 1) % 3, i = 0; i < 3; trs = (trs + 1) % 3, i++)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-
-                    else if (side == nbno && nr < fr)
-                      for (INT trs = (n + 1) % 3, i = 0; i < 3; trs = (trs + 1) % 3, i++)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                    if (side != nbno && nr > fr)
-                      for (INT trs = n, i = 0; i < 3; trs = (trs + 3 - 1) % 3, i++)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                  }
-                  else
-                  {
-                    if (side == nbno)
-                    {
-                      for (INT trs = n; trs != k; trs = (trs + 3 - 1) % 3)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-                      for (INT trs = (n + 1) % 3; trs != (k + 1) % 3; trs = (trs + 1) % 3)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                    }
-                    else
-                    {
-                      for (INT trs = (n + 1) % 3; trs != (k + 1) % 3; trs = (trs + 1) % 3)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-                      for (INT trs = n; trs != k; trs = (trs + 3 - 1) % 3)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                    }
-                  }
-                  TriangulateConst(Points, Polygon, Triangles);
-                  return TRUE;
-                }
-              }
-              cur = next;
-              curside = nextside;
-              curnbno = curside == side ? nbno : !nbno;
-              next = RoadSegments[cur].Neighbour[curside][curnbno],
-              nextside = next == -1 ? -1 : RoadSegments[cur].P[curnbno] == RoadSegments[next].P[curnbno] ? !curside : curside;
-
-              Polygon.push_back(RoadSegments[cur].Shoulder[curside][curnbno]);
-
-              if (!cross && RoadSegments[cur].Neighbour[curside][curnbno] != RoadSegments[cur].Neighbour[!curside][curnbno])
-                cross = TRUE;
-
-              if (!cross && !PointTestTriangle(Points[RoadSegments[cur].Shoulder[!curside][curnbno]],
-                                              Points[Triangles[tr].P[0]], Points[Triangles[tr].P[1]], Points[Triangles[tr].P[2]]))
-                cross = TRUE;
-
-              if (cross)
-                SidePoints.push_back(RoadSegments[cur].Shoulder[curside][curnbno]);
-            }
-            else
-            {
-              for (INT n = 0; n < 3; n++)
-              {
-                if (SegmentTestSegmentInc(Points[Triangles[tr].P[n]], Points[Triangles[tr].P[(n + 1) % 3]],
-                                          Points[RoadSegments[cur].Shoulder[LEFT][curnbno]],
-                                          Points[RoadSegments[cur].Shoulder[RIGHT][curnbno]]))
-                {
-                  Points.push_back(LineIntersectLine(Points[Triangles[tr].P[n]],
-                                                     Points[Triangles[tr].P[(n + 1) % 3]] - Points[Triangles[tr].P[n]],
-                                                     Points[RoadSegments[cur].Shoulder[LEFT][curnbno]],
-                                                     Points[RoadSegments[cur].Shoulder[RIGHT][curnbno]] -
-                                                     Points[RoadSegments[cur].Shoulder[LEFT][curnbno]]));
-                  RoadSegments[cur].Intersections[curnbno + 2].push_back(
-                    intersection((Points.back() - Points[RoadSegments[cur].Shoulder[LEFT][curnbno]]).Length2D() /
-                                 (Points[RoadSegments[cur].Shoulder[RIGHT][curnbno]] -
-                                  Points[RoadSegments[cur].Shoulder[LEFT][curnbno]]).Length2D(), Points.size() - 1));
-                  Polygon.push_back(Points.size() - 1);
-
-                  if (cross)
-                  {
-                    SidePoints.push_back(Points.size() - 1);
-                    OutSide = n;
-                  }
-                  RoadPoints = Polygon;
-                  if (n == k)
-                  {
-                    INT nr, fr;
-                    if ((Points[Triangles[tr].P[k]] - Points[Points.size() - 1]).Length2D() <
-                      (Points[Triangles[tr].P[k]] - Points[Points.size() - 2]).Length2D())
-                      nr = Points.size() - 1, fr = nr - 1;
-                    else
-                      nr = Points.size() - 2, fr = nr + 1;
-
-                    if (side == nbno && nr > fr)
-                      for (INT trs = n, i = 0; i < 3; trs = (trs + 3 - 1) % 3, i++)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-                    else if (side != nbno && nr < fr)
-                      for (INT trs = (n + 1) % 3, i = 0; i < 3; trs = (trs + 1) % 3, i++)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-
-                    else if (side == nbno && nr < fr)
-                      for (INT trs = (n + 1) % 3, i = 0; i < 3; trs = (trs + 1) % 3, i++)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                    if (side != nbno && nr > fr)
-                      for (INT trs = n, i = 0; i < 3; trs = (trs + 3 - 1) % 3, i++)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                  }
-                  else
-                  {
-                    if (side == nbno)
-                    {
-                      for (INT trs = n; trs != k; trs = (trs + 3 - 1) % 3)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-                      for (INT trs = (n + 1) % 3; trs != (k + 1) % 3; trs = (trs + 1) % 3)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                    }
-                    else
-                    {
-                      for (INT trs = (n + 1) % 3; trs != (k + 1) % 3; trs = (trs + 1) % 3)
-                        Polygon.push_back(Triangles[tr].P[trs]);
-                      for (INT trs = n; trs != k; trs = (trs + 3 - 1) % 3)
-                        RoadPoints.push_back(Triangles[tr].P[trs]);
-                    }
-                  }
-                  TriangulateConst(Points, Polygon, Triangles);
-                  return TRUE;
-                }
-              }
-              next = cur;
-              nextside = !curside;
-
-              Polygon.push_back(RoadSegments[cur].Shoulder[!curside][curnbno]);
-
-              if (cross)
-                SidePoints.push_back(RoadSegments[cur].Shoulder[!curside][curnbno]);
-            }
-          }
-        }
-      }
-      return FALSE;
-    } /* End of 'RoadCutTriangle' function */
+      A = RoadSegments[rs].Shoulder[LEFT][side - END_0];
+      B = RoadSegments[rs].Shoulder[RIGHT][side - END_0];
+      return TRUE;
+    } /* End of 'GetShoulderLine' function */
 
     /* Insert road function.
+     * Shoulders lines are inserted to terrain triangulation as constrained
+     * edges, then triangles bounded by them inside road are removed.
      * ARGUMENTS:
      *   - road segments:
      *       std::vector<road_segment> &RoadSegments;
@@ -1256,109 +949,126 @@ namespace tcg
      */
     VOID InsertRoad( std::vector<road_segment> &RoadSegments )
     {
-      BOOL intersect[4], ToContinue;
-      std::vector<INT> SidePoints[4], RoadPoints[4];
-      INT InSide[4], OutSide[4];
+      delaunay Mesh(Triangulation);
+      std::vector<INT> Map(Points.size(), -2), Splits, OuterSeeds;
+      std::vector<std::pair<INT, INT>> InnerSeeds;
+      INT A, B;
 
-      for (INT i = 0, roadsize = RoadSegments.size(); i < roadsize; i++)
-        for (INT j = 0, size = Triangles.size(); j < size; j++)
-        {
-          ToContinue = TRUE;
-          intersect[LEFT] = intersect[RIGHT] = intersect[END_0] = intersect[END_1] = FALSE;
-          InSide[LEFT] =    InSide[RIGHT] =    OutSide[LEFT] =    OutSide[RIGHT] = -1;
-          SidePoints[LEFT].clear(); SidePoints[RIGHT].clear();
-          RoadPoints[LEFT].clear(); RoadPoints[RIGHT].clear();
-
-          for (INT side = 0; side < 4; side++)
-            if (ToContinue)
-              intersect[side] = RoadCutTriangle(RoadSegments, i, j, side, ToContinue,
-                                                SidePoints[side], InSide[side], OutSide[side], RoadPoints[side]);
-            else
-              break;
-
-          if ((intersect[LEFT] || intersect[RIGHT]) && SidePoints[LEFT].size() > 0 && SidePoints[RIGHT].size() > 0)
+      // Shoulders points (replaced with terrain ones they coincide with).
+      for (INT rs = 0, size = RoadSegments.size(); rs < size; rs++)
+        for (INT side = 0; side < 2; side++)
+          for (INT no = 0; no < 2; no++)
           {
-            INT rotright;
-            if (PointTestTriangle(Points[RoadSegments[i].P[0]], Points[Triangles[j].P[0]], Points[Triangles[j].P[1]], Points[Triangles[j].P[2]]))
-              rotright = LEFT;
-            else
-              rotright = RIGHT;
-
-            if (OutSide[rotright] == OutSide[!rotright])
-            {
-              if ((Points[Triangles[j].P[OutSide[rotright]]] - Points[SidePoints[!rotright].back()]).Length2D() <
-                  (Points[Triangles[j].P[OutSide[rotright]]] - Points[SidePoints[rotright].back()]).Length2D())
-                for (INT trs = (OutSide[rotright] + 1) % 3, i = 0; i < 3; trs = (trs + 1) % 3, i++)
-                  SidePoints[rotright].push_back(Triangles[j].P[trs]);
-            }
-            else
-              for (INT trs = (OutSide[rotright] + 1) % 3; trs != (OutSide[!rotright] + 1) % 3; trs = (trs + 1) % 3)
-                SidePoints[rotright].push_back(Triangles[j].P[trs]);
-
-            std::reverse(SidePoints[!rotright].begin(), SidePoints[!rotright].end());
-            SidePoints[rotright].insert(SidePoints[rotright].end(), SidePoints[!rotright].begin(), SidePoints[!rotright].end());
+            INT &S = RoadSegments[rs].Shoulder[side][no];
 
-            TriangulateConst(Points, SidePoints[rotright], Triangles);
+            if (Map[S] == -2)
+              Map[S] = Mesh.InsertIndex(S);
+            if (Map[S] != -1)
+              S = Map[S];
           }
 
-          else if (RoadPoints[LEFT].size() > 0 != RoadPoints[RIGHT].size() > 0)
-          {
-            INT side = RoadPoints[LEFT].size() > 0 ? LEFT : RIGHT;
-            TriangulateConst(Points, RoadPoints[side], Triangles);
-          }
+      // Shoulders lines with terrain points lying on them.
+      for (INT rs = 0, size = RoadSegments.size(); rs < size; rs++)
+        for (INT side = 0; side < 4; side++)
+        {
+          Splits.clear();
+          if (!GetShoulderLine(RoadSegments, rs, side, A, B) || !Mesh.InsertEdge(A, B, Splits))
+            continue;
+          for (INT i = 0; i < Splits.size(); i++)
+            RoadSegments[rs].Intersections[side].push_back(
+              intersection((Points[Splits[i]] - Points[A]).Length2D() / (Points[B] - Points[A]).Length2D(), Splits[i]));
+        }
 
-          if (intersect[LEFT] || intersect[RIGHT] || intersect[END_0] || intersect[END_1])
+      // Triangles on inner and outer sides of shoulders lines.
+      for (INT rs = 0, size = RoadSegments.size(); rs < size; rs++)
+        for (INT side = 0; side < 4; side++)
+          if (GetShoulderLine(RoadSegments, rs, side, A, B))
           {
-            Triangles.erase(Triangles.begin() + j);
-            j--;
-            size--;
+            vec
+              Dir = Points[B] - Points[A],
+              C = (Points[RoadSegments[rs].P[0]] + Points[RoadSegments[rs].P[1]]) / 2;
+
+            for (INT i = 0; i < 2; i++)
+            {
+              INT tr = i == 0 ? Mesh.FindEdge(A, B) : Mesh.FindEdge(B, A), k;
+
+              if (tr == -1)
+                continue;
+              for (k = 0; Mesh.Triangles[tr].P[k] == A || Mesh.Triangles[tr].P[k] == B; k++)
+                ;
+              if ((Dir % (Points[Mesh.Triangles[tr].P[k]] - Points[A])).Y * (Dir % (C - Points[A])).Y > 0)
+                InnerSeeds.push_back(std::pair<INT, INT>(tr, rs));
+              else
+                OuterSeeds.push_back(tr);
+            }
           }
-        }
-      for (INT i = 0, roadsize = RoadSegments.size(); i < roadsize; i++)
-        for (INT j = 0, size = Triangles.size(); j < size; j++)
-        {
-          intersect[END_0] = intersect[END_1] = FALSE;
 
-          for (INT side = 2; side < 4; side++)
-            intersect[side] = RoadCutTriangle(RoadSegments, i, j, side, ToContinue,
-                                              SidePoints[side], InSide[side], OutSide[side], RoadPoints[side]);
+      // Parts of triangulation bounded by constrained edges, part is road one if has no outer sides.
+      std::vector<INT> Part(Mesh.Triangles.size(), -1), Stack;
+      std::vector<BOOL> IsRoad, IsRemoved(Mesh.Triangles.size(), FALSE);
 
-          if (intersect[END_0] || intersect[END_1])
+      for (INT i = 0; i < InnerSeeds.size(); i++)
+        if (Part[InnerSeeds[i].first] == -1)
+        {
+          Stack.push_back(InnerSeeds[i].first);
+          while (Stack.size() > 0)
           {
-            Triangles.erase(Triangles.begin() + j);
-            j--;
-            size--;
+            INT tr = Stack.back();
+
+            Stack.pop_back();
+            if (tr == -1 || Part[tr] != -1)
+              continue;
+            Part[tr] = IsRoad.size();
+            for (INT k = 0; k < 3; k++)
+              if (!Mesh.IsConstrained(Mesh.Triangles[tr].P[k], Mesh.Triangles[tr].P[(k + 1) % 3]))
+                Stack.push_back(Mesh.GetNeighbour(tr, k));
           }
+          IsRoad.push_back(TRUE);
         }
-      for (INT tr = 0, size = Triangles.size(); tr < size; tr++)
-      {
-        vec in =
-          (Points[Triangles[tr].P[0]] + Points[Triangles[tr].P[1]]) * 0.5 +
-          (Points[Triangles[tr].P[2]] - (Points[Triangles[tr].P[0]] + Points[Triangles[tr].P[1]]) * 0.5) * 0.5;
-        for (INT rs = 0, roadsize = RoadSegments.size(); rs < roadsize; rs++)
+      for (INT i = 0; i < OuterSeeds.size(); i++)
+        if (Part[OuterSeeds[i]] != -1)
+          IsRoad[Part[OuterSeeds[i]]] = FALSE;
+      for (INT tr = 0; tr < Mesh.Triangles.size(); tr++)
+        IsRemoved[tr] = Part[tr] != -1 && IsRoad[Part[tr]];
+
+      // Broken shoulders lines (out of terrain) - remove triangles inside road segment or its neighbours.
+      for (INT i = 0; i < InnerSeeds.size(); i++)
+        if (!IsRoad[Part[InnerSeeds[i].first]])
         {
-          vec
-            P0 = RoadSegments[rs].Neighbour[LEFT][0] == -1 ?
-                 (Points[RoadSegments[rs].Shoulder[LEFT][0]] + Points[RoadSegments[rs].Shoulder[RIGHT][0]]) / 2 :
-                 Points[RoadSegments[rs].P[0]],
-            P1 = RoadSegments[rs].Neighbour[LEFT][1] == -1 ?
-                 (Points[RoadSegments[rs].Shoulder[LEFT][1]] + Points[RoadSegments[rs].Shoulder[RIGHT][1]]) / 2 :
-                 Points[RoadSegments[rs].P[1]];
-          if (PointTestHexagon(in,
-                               P0,
-                               Points[RoadSegments[rs].Shoulder[RIGHT][0]],
-                               Points[RoadSegments[rs].Shoulder[RIGHT][1]],
-                               P1,
-                               Points[RoadSegments[rs].Shoulder[LEFT][1]],
-                               Points[RoadSegments[rs].Shoulder[LEFT][0]]))
+          INT rs = InnerSeeds[i].second;
+
+          Stack.push_back(InnerSeeds[i].first);
+          while (Stack.size() > 0)
           {
-            Triangles.erase(Triangles.begin() + tr);
-            tr--;
-            size--;
-            break;
+            INT tr = Stack.back();
+
+            Stack.pop_back();
+            if (tr == -1 || IsRemoved[tr])
+              continue;
+
+            triangle Tr = Mesh.Triangles[tr];
+            vec in =
+              (Points[Tr.P[0]] + Points[Tr.P[1]]) * 0.5 +
+              (Points[Tr.P[2]] - (Points[Tr.P[0]] + Points[Tr.P[1]]) * 0.5) * 0.5;
+            BOOL IsInside = PointTestRoadSegment(RoadSegments, rs, in);
+
+            for (INT side = 0; side < 2 && !IsInside; side++)
+              for (INT no = 0; no < 2 && !IsInside; no++)
+                if (RoadSegments[rs].Neighbour[side][no] != -1)
+                  IsInside = PointTestRoadSegment(RoadSegments, RoadSegments[rs].Neighbour[side][no], in);
+            if (!IsInside)
+              continue;
+            IsRemoved[tr] = TRUE;
+            for (INT k = 0; k < 3; k++)
+              if (!Mesh.IsConstrained(Tr.P[k], Tr.P[(k + 1) % 3]))
+                Stack.push_back(Mesh.GetNeighbour(tr, k));
           }
         }
-      }
+
+      Triangles.clear();
+      for (INT tr = 0; tr < Mesh.Triangles.size(); tr++)
+        if (Mesh.Triangles[tr].P[0] != -1 && !IsRemoved[tr])
+          Triangles.push_back(Mesh.Triangles[tr]);
     } /* End of 'InsertRoad' function */
 
     /* Set road segment texture coordinates function.
@@ -1869,6 +1579,15 @@ namespace tcg
      */
     VOID BuildHouses( VOID );
 
+    /* Build landscape scene for picking function.
+     * ARGUMENTS:
+     *   - houses triangles and their height points:
+     *       const std::vector<triangle> &HouseTriangles;
+     *       const std::vector<INT> &HouseHeights;
+     * RETURNS: None.
+     */
+    VOID BuildScene( const std::vector<triangle> &HouseTriangles, const std::vector<INT> &HouseHeights );
+
     /* Create landscape function.
      * ARGUMENTS:
      *   - road width and shoulder width:
@@ -1885,6 +1604,15 @@ namespace tcg
      */
     VOID AddPoint( const vec &Point );
 
+    /* Test point used by houses or roads function.
+     * ARGUMENTS:
+     *   - point index:
+     *       INT Index;
+     * RETURNS:
+     *   (BOOL) TRUE if point is house or road segment one, FALSE otherwise.
+     */
+    BOOL IsPointUsed( INT Index ) const;
+
     /* Add segment function.
      * ARGUMENTS:
      *   - segment points:
@@ -1893,6 +1621,48 @@ namespace tcg
      */
     VOID AddSegment( const vec &P0, const vec &P1 );
 
+    /* Ray picking benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkPicking( VOID );
+
+    /* Triangulation benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkTriangulation( VOID );
+
+    /* Roads insertion benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkRoads( VOID );
+
+    /* Batch noise benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkNoise( VOID );
+
+    /* Noise engines benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkNoiseEngines( VOID );
+
+    /* Normal encodings benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkNormalEncodings( VOID );
+
+    /* Erosion benchmark function (see 'benchmark.cpp').
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID BenchmarkErosion( VOID );
+
   public:
     /* Class constructor.
      * ARGUMENTS:
@@ -0,0 +1,31 @@
+#version 420
+
+/* Input */
+in vec2 Tex;
+
+/* Output */
+out vec4 OutCol;
+
+/* Heights evaluated on CPU (see 'hm_preview') */
+uniform sampler2D PreviewTex;
+
+uniform int ISN;
+
+void main( void )
+{
+  float H = texture2D(PreviewTex, Tex).a;
+
+  if (ISN == 0)
+    gl_FragColor = vec4(H, H, H, 1);
+  else
+  {
+    /* Texel step in noise space (maps side is 10) */
+    vec2 d = 1.0 / textureSize(PreviewTex, 0);
+    float step = d.x * 10;
+    vec3
+      b1 = vec3(step, 0, texture2D(PreviewTex, Tex + vec2(d.x, 0)).a - H),
+      b2 = vec3(0, step, texture2D(PreviewTex, Tex + vec2(0, d.y)).a - H);
+
+    gl_FragColor = vec4(normalize(cross(normalize(b1), normalize(b2))), 1);
+  }
+} // End of 'main' function
\ No newline at end of file
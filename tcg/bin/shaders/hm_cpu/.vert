@@ -0,0 +1,14 @@
+#version 420
+
+/* Input */
+layout (location = 0) in vec3 InPos;
+
+/* Fragment shader pass data */
+out vec2 Tex;
+
+void main( void )
+{
+  Tex = (InPos.xy + vec2(1, 1)) / 2;
+
+  gl_Position = vec4(InPos.xy, 0, 1);
+} // End of 'main' function
\ No newline at end of file
@@ -18,6 +18,9 @@
 #define __tvc_cd_h_
 
 #include "../def.h"
+#include "computational_geometry.h"
+#include "../support/map_minmax.h"
+#include "../support/thread_pool.h"
 
 /* Computational geometry project namespace */
 namespace tcg
@@ -168,7 +171,7 @@ namespace tcg
     {
     private:
       /* Intersection parametres */
-      vec Du, Dv;                   /* Unit vectors for uv(texture) coordinate system */
+      vec E1, E2;                   /* Edges (P1 - P0), (P2 - P0) for Moller-Trumbore test */
     public:
       vec P0, P1, P2, Normal;       /* Points and plane normal */
 
@@ -225,6 +228,401 @@ namespace tcg
       collision Intersect( const ray &Ray, const BOOL &ComputeNormal = FALSE, const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
     }; /* End of 'triangle' class */
 
+    /* Triangles pack class.
+     * Triangles are precomputed for Moller-Trumbore test (first point and
+     * two edges in floats) and stored by blocks of 8 as separate arrays of
+     * every coordinate, so one SIMD call tests whole block (AVX2: 8
+     * triangles, SSE4: two halves of 4). Tests are double-sided, degenerate
+     * triangles (and unused block places) never intersect. */
+    class triangle_pack : public shape
+    {
+    public:
+      static const INT BlockSize = 8;  /* Number of triangles in block */
+
+      /* Triangles block */
+      struct block
+      {
+        FLT
+          P0[3][BlockSize],            /* First points coordinates */
+          E1[3][BlockSize],            /* First edges (P1 - P0) coordinates */
+          E2[3][BlockSize];            /* Second edges (P2 - P0) coordinates */
+      }; /* End of 'block' struct */
+
+    private:
+      std::vector<block> Blocks;       /* Triangles blocks */
+      INT NumOfTriangles;              /* Number of triangles */
+
+      /* Intersect ray with triangles blocks kernels.
+       * ARGUMENTS:
+       *   - ray origin and direction:
+       *       const FLT *Org, *Dir;
+       *   - blocks range (last is excluded):
+       *       INT First, INT Last;
+       *   - nearest intersection parameter (updated):
+       *       FLT &T;
+       * RETURNS:
+       *   (INT) number of nearer intersected triangle, -1 if none.
+       */
+      INT IntersectScalar( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const;
+      INT IntersectSse4( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const;
+      INT IntersectAvx2( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const;
+
+      /* Intersect ray with triangles blocks function.
+       * ARGUMENTS:
+       *   - ray origin and direction:
+       *       const FLT *Org, *Dir;
+       *   - blocks range (last is excluded):
+       *       INT First, INT Last;
+       *   - nearest intersection parameter (updated):
+       *       FLT &T;
+       * RETURNS:
+       *   (INT) number of nearer intersected triangle, -1 if none.
+       */
+      INT IntersectBlocks( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const;
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS: None.
+       */
+      triangle_pack( VOID );
+
+      /* Remove all triangles function.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Clear( VOID );
+
+      /* Add triangle function.
+       * ARGUMENTS:
+       *   - triangle points:
+       *       const vec &P0, &P1, &P2;
+       * RETURNS:
+       *   (INT) triangle number in pack.
+       */
+      INT Add( const vec &P0, const vec &P1, const vec &P2 );
+
+      /* Set number of triangles function.
+       * New places are degenerate triangles (never intersected).
+       * ARGUMENTS:
+       *   - new number of triangles:
+       *       INT NewNumOfTriangles;
+       * RETURNS: None.
+       */
+      VOID Resize( INT NewNumOfTriangles );
+
+      /* Replace triangle function.
+       * ARGUMENTS:
+       *   - triangle number:
+       *       INT Index;
+       *   - new triangle points:
+       *       const vec &P0, &P1, &P2;
+       * RETURNS: None.
+       */
+      VOID Set( INT Index, const vec &P0, const vec &P1, const vec &P2 );
+
+      /* Obtain triangle points function.
+       * ARGUMENTS:
+       *   - triangle number:
+       *       INT Index;
+       *   - triangle points (as they are stored):
+       *       vec &P0, &P1, &P2;
+       * RETURNS: None.
+       */
+      VOID Get( INT Index, vec &P0, vec &P1, vec &P2 ) const;
+
+      /* Obtain number of triangles function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (INT) number of triangles.
+       */
+      INT GetNumOfTriangles( VOID ) const;
+
+      /* Obtain number of blocks function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (INT) number of blocks.
+       */
+      INT GetNumOfBlocks( VOID ) const;
+
+      /* Obtain triangle normal function.
+       * ARGUMENTS:
+       *   - triangle number:
+       *       INT Index;
+       * RETURNS:
+       *   (vec) unit normal ((P1 - P0) x (P2 - P0) direction).
+       */
+      vec GetNormal( INT Index ) const;
+
+      /* Intersect ray with 8 triangles of block function.
+       * ARGUMENTS:
+       *   - ray origin and direction (ray parameter is not normalized):
+       *       const FLT *Org, *Dir;
+       *   - block number:
+       *       INT Block;
+       *   - nearest intersection parameter (only nearer intersections are found, updated):
+       *       FLT &T;
+       * RETURNS:
+       *   (INT) number of nearer intersected triangle, -1 if none.
+       */
+      INT IntersectBlock( const FLT *Org, const FLT *Dir, INT Block, FLT &T ) const;
+
+      /* Intersect ray with all triangles function.
+       * ARGUMENTS:
+       *   - ray origin and direction (ray parameter is not normalized):
+       *       const FLT *Org, *Dir;
+       *   - nearest intersection parameter (only nearer intersections are found, updated):
+       *       FLT &T;
+       * RETURNS:
+       *   (INT) number of nearest intersected triangle, -1 if none.
+       */
+      INT IntersectNearest( const FLT *Org, const FLT *Dir, FLT &T ) const;
+
+      /* Intersect with ray function.
+       * ARGUMENTS:
+       *   - ray to intersect with:
+       *       const ray &Ray;
+       *   - compute normal flag:
+       *       const BOOL &ComputeNormal;
+       *   - compute point flag:
+       *       const BOOL &ComputePoint;
+       *   - transformation matrix:
+       *       const trans &Trans;
+       * RETURNS:
+       *   (collision) collision information (nearest intersection).
+       */
+      collision Intersect( const ray &Ray, const BOOL &ComputeNormal = FALSE, const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
+
+      /* Intersect with rays packet function.
+       * Rays are tested by groups against every block, so block stays
+       * in cache for whole group.
+       * ARGUMENTS:
+       *   - rays to intersect with:
+       *       const ray *Rays;
+       *   - number of rays:
+       *       INT NumOfRays;
+       *   - collisions information (one per ray):
+       *       collision *Collisions;
+       *   - compute normal flag:
+       *       const BOOL &ComputeNormal;
+       *   - compute point flag:
+       *       const BOOL &ComputePoint;
+       *   - transformation matrix:
+       *       const trans &Trans;
+       * RETURNS:
+       *   (INT) number of rays which intersect triangles.
+       */
+      INT Intersect( const ray *Rays, INT NumOfRays, collision *Collisions, const BOOL &ComputeNormal = FALSE,
+                     const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
+    }; /* End of 'triangle_pack' class */
+
+    /* Bounding volume hierarchy class.
+     * Tree is built over mesh triangles with binned surface area heuristic
+     * (large nodes are binned and subtrees are built by threads). Nodes are
+     * kept in flat array, children of inner node are adjacent. Every leaf
+     * is one block of triangles pack (up to 8 triangles for one SIMD call).
+     * Moved triangles are supported by refitting of bounding boxes. */
+    class bvh : public shape
+    {
+    public:
+      static const INT
+        NumOfBins = 16,                /* Number of SAH bins per axis */
+        StackSize = 128;               /* Traversal stack size (bounds tree depth) */
+
+      /* Tree node */
+      struct node
+      {
+        FLT Min[3], Max[3];            /* Bounding box */
+        INT First;                     /* Inner node: left child (right one follows), leaf: pack block */
+        INT Count;                     /* Number of leaf triangles (0 for inner nodes) */
+      }; /* End of 'node' struct */
+
+    private:
+      /* Triangle build information */
+      struct prim
+      {
+        FLT Min[3], Max[3], Center[3]; /* Bounding box and its center */
+        INT Index;                     /* Mesh triangle number */
+      }; /* End of 'prim' struct */
+
+      /* Subtree build task */
+      struct task
+      {
+        INT Node, First, Last, Depth;  /* Subtree root, triangles range and depth */
+      }; /* End of 'task' struct */
+
+      std::vector<node> Nodes;         /* Tree nodes (root is first) */
+      triangle_pack Pack;              /* Leaves triangles */
+      std::vector<INT>
+        SlotToTri,                     /* Mesh triangle of pack place (-1 for unused) */
+        TriToSlot;                     /* Pack place of mesh triangle */
+
+      /* Obtain triangle bounding box function.
+       * ARGUMENTS:
+       *   - triangle points:
+       *       const vec &P0, &P1, &P2;
+       *   - box (padded to cover float triangle):
+       *       FLT *Min, *Max;
+       * RETURNS: None.
+       */
+      static VOID Bound( const vec &P0, const vec &P1, const vec &P2, FLT *Min, FLT *Max );
+
+      /* Split triangles range function.
+       * ARGUMENTS:
+       *   - triangles build information (range is reordered):
+       *       prim *Prims;
+       *   - triangles range (last is excluded):
+       *       INT First, INT Last;
+       *   - tree depth of range node:
+       *       INT Depth;
+       *   - node to fill by range box:
+       *       node &Node;
+       *   - worker threads for large ranges (may be NULL):
+       *       thread_pool *Pool;
+       * RETURNS:
+       *   (INT) first triangle of right part, -1 if range is leaf.
+       */
+      static INT Split( prim *Prims, INT First, INT Last, INT Depth, node &Node, thread_pool *Pool );
+
+      /* Build subtree function.
+       * ARGUMENTS:
+       *   - nodes array (root is already added):
+       *       std::vector<node> &Tree;
+       *   - root node and its triangles:
+       *       const task &Root;
+       *   - triangles build information (range is reordered):
+       *       prim *Prims;
+       *   - minimal range size to leave for subtrees (0 - build all nodes):
+       *       INT Grain;
+       *   - left subtrees (used if 'Grain' is not 0):
+       *       std::vector<task> *Tasks;
+       *   - worker threads for large ranges (may be NULL):
+       *       thread_pool *Pool;
+       * RETURNS: None.
+       */
+      static VOID BuildSubtree( std::vector<node> &Tree, const task &Root, prim *Prims, INT Grain,
+                                std::vector<task> *Tasks, thread_pool *Pool );
+
+      /* Intersect ray with node box function.
+       * ARGUMENTS:
+       *   - node:
+       *       const node &Node;
+       *   - ray origin and inverse direction:
+       *       const FLT *Org, *Inv;
+       *   - nearest intersection parameter:
+       *       FLT T;
+       *   - box entry parameter:
+       *       FLT &T0;
+       * RETURNS:
+       *   (BOOL) TRUE if box is intersected nearer than 'T'.
+       */
+      static BOOL IntersectBox( const node &Node, const FLT *Org, const FLT *Inv, FLT T, FLT &T0 );
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS: None.
+       */
+      bvh( VOID );
+
+      /* Build tree function.
+       * ARGUMENTS:
+       *   - mesh points:
+       *       const std::vector<vec> &Points;
+       *   - mesh triangles:
+       *       const std::vector<math::triangle> &Triangles;
+       *   - number of threads (0 - as many as processors):
+       *       INT NumOfThreads;
+       * RETURNS: None.
+       */
+      VOID Build( const std::vector<vec> &Points, const std::vector<math::triangle> &Triangles, INT NumOfThreads = 0 );
+
+      /* Remove tree function.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Clear( VOID );
+
+      /* Move triangle function ('Refit' should be called after all moves).
+       * ARGUMENTS:
+       *   - mesh triangle number:
+       *       INT Index;
+       *   - new triangle points:
+       *       const vec &P0, &P1, &P2;
+       * RETURNS: None.
+       */
+      VOID Move( INT Index, const vec &P0, const vec &P1, const vec &P2 );
+
+      /* Refit nodes boxes to moved triangles function.
+       * Tree topology is kept, so it degrades after large moves (build again).
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Refit( VOID );
+
+      /* Check if tree is empty function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (BOOL) TRUE if there are no triangles.
+       */
+      BOOL IsEmpty( VOID ) const;
+
+      /* Obtain tree nodes function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (const std::vector<node> &) nodes (root is first).
+       */
+      const std::vector<node> & GetNodes( VOID ) const;
+
+      /* Intersect ray with triangles function.
+       * ARGUMENTS:
+       *   - ray origin and direction (ray parameter is not normalized):
+       *       const FLT *Org, *Dir;
+       *   - nearest intersection parameter (only nearer intersections are found, updated):
+       *       FLT &T;
+       * RETURNS:
+       *   (INT) mesh number of nearest intersected triangle, -1 if none.
+       */
+      INT IntersectNearest( const FLT *Org, const FLT *Dir, FLT &T ) const;
+
+      /* Check any ray intersection with triangles function.
+       * ARGUMENTS:
+       *   - ray origin and direction (ray parameter is not normalized):
+       *       const FLT *Org, *Dir;
+       *   - maximal intersection parameter:
+       *       FLT TMax;
+       * RETURNS:
+       *   (BOOL) TRUE if ray intersects some triangle in [0, TMax).
+       */
+      BOOL IntersectAny( const FLT *Org, const FLT *Dir, FLT TMax ) const;
+
+      /* Intersect with ray function.
+       * ARGUMENTS:
+       *   - ray to intersect with:
+       *       const ray &Ray;
+       *   - compute normal flag:
+       *       const BOOL &ComputeNormal;
+       *   - compute point flag:
+       *       const BOOL &ComputePoint;
+       *   - transformation matrix:
+       *       const trans &Trans;
+       * RETURNS:
+       *   (collision) collision information (nearest intersection).
+       */
+      collision Intersect( const ray &Ray, const BOOL &ComputeNormal = FALSE, const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
+
+      /* Check if segment of ray is occluded function.
+       * ARGUMENTS:
+       *   - ray to check:
+       *       const ray &Ray;
+       *   - segment end ray parameter:
+       *       DBL TMax;
+       *   - transformation matrix:
+       *       const trans &Trans;
+       * RETURNS:
+       *   (BOOL) TRUE if some triangle intersects ray in [0, TMax).
+       */
+      BOOL IsOccluded( const ray &Ray, DBL TMax, const trans &Trans = trans().SetUnit() ) const;
+    }; /* End of 'bvh' class */
+
     /* Plane class */
     class plane : public shape
     {
@@ -333,6 +731,163 @@ namespace tcg
        */
       collision Intersect( const ray &Ray, const BOOL &ComputeNormal = FALSE, const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
     }; /* End of 'plane_finite' class */
+
+    /* Height field class.
+     * Surface is bilinear over samples grid; sample (X, Y) of height H
+     * is at point Loc + (X * Size.X / (W - 1), H * Size.Y, Y * Size.Z / (H - 1)).
+     * Rays are traced through min/max quadtree of heights and intersected
+     * exactly with bilinear patches of passed cells only. */
+    class heightfield : public shape
+    {
+    private:
+      minmax_tree Tree;   /* Heights and their min/max quadtree */
+      vec Loc, Size;      /* Location of first sample and grid size (Y - heights scale) */
+
+      /* Intersect ray with grid cell bilinear patch function.
+       * ARGUMENTS:
+       *   - ray in grid space:
+       *       const ray &Ray;
+       *   - cell position:
+       *       INT X, INT Y;
+       *   - ray parameter interval in cell:
+       *       DBL T0, DBL T1;
+       *   - nearest intersection parameter (updated):
+       *       DBL &T;
+       * RETURNS:
+       *   (BOOL) TRUE if nearer intersection was found.
+       */
+      BOOL IntersectCell( const ray &Ray, INT X, INT Y, DBL T0, DBL T1, DBL &T ) const;
+
+      /* Intersect ray in grid space function.
+       * ARGUMENTS:
+       *   - ray in grid space:
+       *       const ray &Ray;
+       *   - nearest intersection parameter:
+       *       DBL &T;
+       * RETURNS:
+       *   (BOOL) TRUE if intersection was found.
+       */
+      BOOL IntersectGrid( const ray &Ray, DBL &T ) const;
+
+      /* Obtain ray in grid space function.
+       * ARGUMENTS:
+       *   - ray in height field space:
+       *       const ray &Ray;
+       * RETURNS:
+       *   (ray) ray with the same parameter in grid space.
+       */
+      ray ToGrid( const ray &Ray ) const;
+
+      /* Obtain normal in height field space function.
+       * ARGUMENTS:
+       *   - point in grid space:
+       *       const vec &P;
+       * RETURNS:
+       *   (vec) surface normal.
+       */
+      vec GetNormal( const vec &P ) const;
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS:
+       *   - location of first sample:
+       *       const vec &Loc;
+       *   - grid size (Y - heights scale):
+       *       const vec &Size;
+       */
+      heightfield( const vec &Loc = vec(0), const vec &Size = vec(1) );
+
+      /* Set height samples function.
+       * ARGUMENTS:
+       *   - height samples (row by row):
+       *       const FLOAT *Heights;
+       *   - samples grid size:
+       *       INT W, INT H;
+       * RETURNS:
+       *   (BOOL) TRUE if successful, FALSE otherwise.
+       */
+      BOOL Set( const FLOAT *Heights, INT W, INT H );
+
+      /* Load height samples from height map file function.
+       * ARGUMENTS:
+       *   - height map file name (any height encoding, see 'map_file'):
+       *       const CHAR *FileName;
+       *   - saved quadtree file name (tree is built if file is absent or stale, may be nullptr):
+       *       const CHAR *TreeFileName;
+       * RETURNS:
+       *   (BOOL) TRUE if successful, FALSE otherwise.
+       */
+      BOOL Load( const CHAR *FileName, const CHAR *TreeFileName = nullptr );
+
+      /* Place height field function.
+       * ARGUMENTS:
+       *   - location of first sample:
+       *       const vec &NewLoc;
+       *   - grid size (Y - heights scale):
+       *       const vec &NewSize;
+       * RETURNS: None.
+       */
+      VOID Place( const vec &NewLoc, const vec &NewSize );
+
+      /* Check if height field has samples function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (BOOL) TRUE if samples were set.
+       */
+      BOOL IsEmpty( VOID ) const;
+
+      /* Obtain heights quadtree function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (minmax_tree &) quadtree (samples may be changed with 'minmax_tree::Update').
+       */
+      minmax_tree & GetTree( VOID );
+
+      /* Obtain surface height function.
+       * ARGUMENTS:
+       *   - point coordinates on base plane (clamped to grid):
+       *       DBL X, DBL Z;
+       * RETURNS:
+       *   (DBL) surface Y coordinate (0 if there are no samples).
+       */
+      DBL GetHeight( DBL X, DBL Z ) const;
+
+      /* Intersect with ray function.
+       * ARGUMENTS:
+       *   - ray to intersect with:
+       *       const ray &Ray;
+       *   - compute normal flag:
+       *       const BOOL &ComputeNormal;
+       *   - compute point flag:
+       *       const BOOL &ComputePoint;
+       *   - transformation matrix:
+       *       const trans &Trans;
+       * RETURNS:
+       *   (collision) collision information (nearest intersection).
+       */
+      collision Intersect( const ray &Ray, const BOOL &ComputeNormal = FALSE, const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
+
+      /* Intersect with rays batch function.
+       * Large batches are split between threads.
+       * ARGUMENTS:
+       *   - rays to intersect with:
+       *       const ray *Rays;
+       *   - number of rays:
+       *       INT NumOfRays;
+       *   - collisions information (one per ray):
+       *       collision *Collisions;
+       *   - compute normal flag:
+       *       const BOOL &ComputeNormal;
+       *   - compute point flag:
+       *       const BOOL &ComputePoint;
+       *   - transformation matrix:
+       *       const trans &Trans;
+       * RETURNS:
+       *   (INT) number of rays which intersect height field.
+       */
+      INT Intersect( const ray *Rays, INT NumOfRays, collision *Collisions, const BOOL &ComputeNormal = FALSE,
+                     const BOOL &ComputePoint = FALSE, const trans &Trans = trans().SetUnit() ) const;
+    }; /* End of 'heightfield' class */
   } /* end of 'cd' namespace */
 } /* end of 'tcg' namespace */
 
@@ -0,0 +1,687 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : cd_bvh.cpp
+ * PURPOSE     : Computational geometry project.
+ *               Collision detection support module.
+ *               Bounding volume hierarchy support module.
+ * PROGRAMMER  : MM5.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <cfloat>
+#include <algorithm>
+
+#include "../def.h"
+
+#include "cd.h"
+#include "../support/thread_pool.h"
+
+/* Class constructor.
+ * ARGUMENTS: None.
+ */
+tcg::cd::bvh::bvh( VOID )
+{
+} /* End of 'tcg::cd::bvh::bvh' function */
+
+/* Obtain triangle bounding box function.
+ * ARGUMENTS:
+ *   - triangle points:
+ *       const vec &P0, &P1, &P2;
+ *   - box (padded to cover float triangle):
+ *       FLT *Min, *Max;
+ * RETURNS: None.
+ */
+VOID tcg::cd::bvh::Bound( const vec &P0, const vec &P1, const vec &P2, FLT *Min, FLT *Max )
+{
+  DBL
+    Lo[3] = {math::Minimal({P0.X, P1.X, P2.X}), math::Minimal({P0.Y, P1.Y, P2.Y}), math::Minimal({P0.Z, P1.Z, P2.Z})},
+    Hi[3] = {math::Maximal({P0.X, P1.X, P2.X}), math::Maximal({P0.Y, P1.Y, P2.Y}), math::Maximal({P0.Z, P1.Z, P2.Z})};
+
+  /* Pad covers float rounding of pack points and edges */
+  for (INT k = 0; k < 3; k++)
+  {
+    DBL Pad = 1e-5 * (1 + COM_MAX(fabs(Lo[k]), fabs(Hi[k])));
+
+    Min[k] = (FLT)(Lo[k] - Pad);
+    Max[k] = (FLT)(Hi[k] + Pad);
+  }
+} /* End of 'tcg::cd::bvh::Bound' function */
+
+/* Split triangles range function.
+ * ARGUMENTS:
+ *   - triangles build information (range is reordered):
+ *       prim *Prims;
+ *   - triangles range (last is excluded):
+ *       INT First, INT Last;
+ *   - tree depth of range node:
+ *       INT Depth;
+ *   - node to fill by range box:
+ *       node &Node;
+ *   - worker threads for large ranges (may be NULL):
+ *       thread_pool *Pool;
+ * RETURNS:
+ *   (INT) first triangle of right part, -1 if range is leaf.
+ */
+INT tcg::cd::bvh::Split( prim *Prims, INT First, INT Last, INT Depth, node &Node, thread_pool *Pool )
+{
+  /* Range part bounds */
+  struct bin
+  {
+    FLT Min[3], Max[3];
+    INT Count;
+  };
+  const INT
+    ChunkSize = 1 << 14,
+    MaxSahDepth = 64,
+    BlockSize = triangle_pack::BlockSize;
+  const DBL TraverseCost = 1, BlockCost = 2;
+  INT
+    N = Last - First,
+    NumOfChunks = Pool != NULL && N >= ChunkSize * 4 ? (N + ChunkSize - 1) / ChunkSize : 1;
+  auto Empty = []( bin &B )
+  {
+    B.Min[0] = B.Min[1] = B.Min[2] = FLT_MAX;
+    B.Max[0] = B.Max[1] = B.Max[2] = -FLT_MAX;
+    B.Count = 0;
+  };
+  auto Grow = []( bin &B, const FLT *Min, const FLT *Max, INT Count )
+  {
+    for (INT k = 0; k < 3; k++)
+    {
+      B.Min[k] = COM_MIN(B.Min[k], Min[k]);
+      B.Max[k] = COM_MAX(B.Max[k], Max[k]);
+    }
+    B.Count += Count;
+  };
+  auto Area = []( const bin &B )
+  {
+    if (B.Count == 0)
+      return 0.0;
+
+    DBL dx = B.Max[0] - B.Min[0], dy = B.Max[1] - B.Min[1], dz = B.Max[2] - B.Min[2];
+
+    return dx * dy + dy * dz + dz * dx;
+  };
+  auto Blocks = [BlockSize]( INT Count )
+  {
+    return (DBL)((Count + BlockSize - 1) / BlockSize);
+  };
+
+  /* Boxes of triangles and of their centers */
+  bin Box, Centers;
+  auto Scan = [&]( bin &B, bin &C, INT a, INT b )
+  {
+    Empty(B);
+    Empty(C);
+    for (INT i = a; i < b; i++)
+    {
+      const prim &P = Prims[i];
+
+      Grow(B, P.Min, P.Max, 1);
+      Grow(C, P.Center, P.Center, 1);
+    }
+  };
+
+  if (NumOfChunks == 1)
+    Scan(Box, Centers, First, Last);
+  else
+  {
+    std::vector<bin> Parts(NumOfChunks * 2);
+
+    Pool->ParallelFor(NumOfChunks, [&]( INT c )
+      {
+        Scan(Parts[c * 2], Parts[c * 2 + 1], First + c * ChunkSize, COM_MIN(First + (c + 1) * ChunkSize, Last));
+      });
+    Empty(Box);
+    Empty(Centers);
+    for (INT c = 0; c < NumOfChunks; c++)
+    {
+      Grow(Box, Parts[c * 2].Min, Parts[c * 2].Max, Parts[c * 2].Count);
+      Grow(Centers, Parts[c * 2 + 1].Min, Parts[c * 2 + 1].Max, Parts[c * 2 + 1].Count);
+    }
+  }
+  for (INT k = 0; k < 3; k++)
+    Node.Min[k] = Box.Min[k], Node.Max[k] = Box.Max[k];
+  if (N <= 1)
+    return -1;
+
+  /* Centers binning along every axis */
+  FLT Scale[3];
+  bin Bins[3][NumOfBins];
+  auto BinOf = [&]( const prim &P, INT k )
+  {
+    FLT f = (P.Center[k] - Centers.Min[k]) * Scale[k];
+
+    /* Float comparison also sends NaN of too small extent to last bin */
+    return f < NumOfBins - 1 ? (INT)f : NumOfBins - 1;
+  };
+  auto Fill = [&]( bin (*B)[NumOfBins], INT a, INT b )
+  {
+    for (INT k = 0; k < 3; k++)
+      for (INT j = 0; j < NumOfBins; j++)
+        Empty(B[k][j]);
+    for (INT i = a; i < b; i++)
+    {
+      const prim &P = Prims[i];
+
+      for (INT k = 0; k < 3; k++)
+        if (Scale[k] > 0)
+          Grow(B[k][BinOf(P, k)], P.Min, P.Max, 1);
+    }
+  };
+
+  for (INT k = 0; k < 3; k++)
+  {
+    FLT Extent = Centers.Max[k] - Centers.Min[k];
+
+    Scale[k] = Extent > 0 ? NumOfBins / Extent : 0;
+  }
+  if (NumOfChunks == 1)
+    Fill(Bins, First, Last);
+  else
+  {
+    std::vector<bin> Parts(NumOfChunks * 3 * NumOfBins);
+
+    Pool->ParallelFor(NumOfChunks, [&]( INT c )
+      {
+        Fill((bin (*)[NumOfBins])&Parts[c * 3 * NumOfBins], First + c * ChunkSize, COM_MIN(First + (c + 1) * ChunkSize, Last));
+      });
+    for (INT k = 0; k < 3; k++)
+      for (INT j = 0; j < NumOfBins; j++)
+      {
+        Empty(Bins[k][j]);
+        for (INT c = 0; c < NumOfChunks; c++)
+        {
+          const bin &B = Parts[(c * 3 + k) * NumOfBins + j];
+
+          Grow(Bins[k][j], B.Min, B.Max, B.Count);
+        }
+      }
+  }
+
+  /* Best plane between bins (leaves cost is in pack blocks) */
+  DBL Best = DBL_MAX;
+  INT BestAxis = -1, BestBin = 0;
+
+  for (INT k = 0; k < 3; k++)
+  {
+    if (Scale[k] == 0)
+      continue;
+
+    DBL RightCost[NumOfBins];
+    bin Side;
+
+    Empty(Side);
+    for (INT j = NumOfBins - 1; j > 0; j--)
+    {
+      Grow(Side, Bins[k][j].Min, Bins[k][j].Max, Bins[k][j].Count);
+      RightCost[j] = Side.Count > 0 ? Area(Side) * Blocks(Side.Count) : -1;
+    }
+    Empty(Side);
+    for (INT j = 1; j < NumOfBins; j++)
+    {
+      Grow(Side, Bins[k][j - 1].Min, Bins[k][j - 1].Max, Bins[k][j - 1].Count);
+      if (Side.Count > 0 && RightCost[j] >= 0)
+      {
+        DBL Cost = Area(Side) * Blocks(Side.Count) + RightCost[j];
+
+        if (Cost < Best)
+          Best = Cost, BestAxis = k, BestBin = j;
+      }
+    }
+  }
+
+  DBL A = Area(Box);
+
+  if (N <= BlockSize && (BestAxis < 0 || A <= 0 || BlockCost * Blocks(N) <= TraverseCost + BlockCost * Best / A))
+    return -1;
+  if (BestAxis < 0 || Depth >= MaxSahDepth)
+  {
+    /* Median split: equal centers or too deep tree (traversal stack is limited) */
+    INT
+      Axis = 0,
+      Mid = First + N / 2;
+
+    for (INT k = 1; k < 3; k++)
+      if (Centers.Max[k] - Centers.Min[k] > Centers.Max[Axis] - Centers.Min[Axis])
+        Axis = k;
+    std::nth_element(Prims + First, Prims + Mid, Prims + Last, [&]( const prim &a, const prim &b )
+      {
+        return a.Center[Axis] < b.Center[Axis] || (a.Center[Axis] == b.Center[Axis] && a.Index < b.Index);
+      });
+    return Mid;
+  }
+  return (INT)(std::partition(Prims + First, Prims + Last, [&]( const prim &P )
+    {
+      return BinOf(P, BestAxis) < BestBin;
+    }) - Prims);
+} /* End of 'tcg::cd::bvh::Split' function */
+
+/* Build subtree function.
+ * ARGUMENTS:
+ *   - nodes array (root is already added):
+ *       std::vector<node> &Tree;
+ *   - root node and its triangles:
+ *       const task &Root;
+ *   - triangles build information (range is reordered):
+ *       prim *Prims;
+ *   - minimal range size to leave for subtrees (0 - build all nodes):
+ *       INT Grain;
+ *   - left subtrees (used if 'Grain' is not 0):
+ *       std::vector<task> *Tasks;
+ *   - worker threads for large ranges (may be NULL):
+ *       thread_pool *Pool;
+ * RETURNS: None.
+ */
+VOID tcg::cd::bvh::BuildSubtree( std::vector<node> &Tree, const task &Root, prim *Prims, INT Grain,
+                                 std::vector<task> *Tasks, thread_pool *Pool )
+{
+  std::vector<task> Stack(1, Root);
+
+  while (!Stack.empty())
+  {
+    task T = Stack.back();
+
+    Stack.pop_back();
+    if (Grain > 0 && T.Last - T.First <= Grain)
+    {
+      Tasks->push_back(T);
+      continue;
+    }
+
+    INT Mid = Split(Prims, T.First, T.Last, T.Depth, Tree[T.Node], Pool);
+
+    if (Mid < 0)
+    {
+      /* Leaf keeps triangles range until pack is filled */
+      Tree[T.Node].First = T.First;
+      Tree[T.Node].Count = T.Last - T.First;
+      continue;
+    }
+
+    INT Left = (INT)Tree.size();
+    task
+      L = {Left, T.First, Mid, T.Depth + 1},
+      R = {Left + 1, Mid, T.Last, T.Depth + 1};
+
+    Tree[T.Node].First = Left;
+    Tree[T.Node].Count = 0;
+    Tree.resize(Tree.size() + 2);
+    Stack.push_back(R);
+    Stack.push_back(L);
+  }
+} /* End of 'tcg::cd::bvh::BuildSubtree' function */
+
+/* Build tree function.
+ * ARGUMENTS:
+ *   - mesh points:
+ *       const std::vector<vec> &Points;
+ *   - mesh triangles:
+ *       const std::vector<math::triangle> &Triangles;
+ *   - number of threads (0 - as many as processors):
+ *       INT NumOfThreads;
+ * RETURNS: None.
+ */
+VOID tcg::cd::bvh::Build( const std::vector<vec> &Points, const std::vector<math::triangle> &Triangles, INT NumOfThreads )
+{
+  const INT ChunkSize = 1 << 12, BlockSize = triangle_pack::BlockSize;
+  INT N = (INT)Triangles.size();
+
+  Clear();
+  if (N == 0)
+    return;
+
+  thread_pool Pool(NumOfThreads);
+  std::vector<prim> Prims(N);
+
+  Pool.ParallelFor((N + ChunkSize - 1) / ChunkSize, [&]( INT c )
+    {
+      for (INT i = c * ChunkSize; i < N && i < (c + 1) * ChunkSize; i++)
+      {
+        prim &P = Prims[i];
+
+        Bound(Points[Triangles[i].P[0]], Points[Triangles[i].P[1]], Points[Triangles[i].P[2]], P.Min, P.Max);
+        for (INT k = 0; k < 3; k++)
+          P.Center[k] = (P.Min[k] + P.Max[k]) / 2;
+        P.Index = i;
+      }
+    });
+
+  /* Top nodes are split with binning by all threads, then subtrees are built by threads */
+  INT
+    NumOfWorkers = Pool.GetNumOfThreads(),
+    Grain = NumOfWorkers > 1 ? COM_MAX(N / (NumOfWorkers * 8), 1024) : 0;
+  std::vector<task> Tasks;
+  task Root = {0, 0, N, 0};
+
+  Nodes.resize(1);
+  BuildSubtree(Nodes, Root, &Prims[0], Grain, &Tasks, NumOfWorkers > 1 ? &Pool : NULL);
+
+  std::vector<std::vector<node>> Subtrees(Tasks.size());
+
+  Pool.ParallelFor((INT)Tasks.size(), [&]( INT t )
+    {
+      task Local = Tasks[t];
+
+      Local.Node = 0;
+      Subtrees[t].resize(1);
+      BuildSubtree(Subtrees[t], Local, &Prims[0], 0, NULL, NULL);
+    });
+
+  /* Subtrees nodes are appended in tasks order (tree does not depend on threads timing) */
+  for (INT t = 0; t < (INT)Tasks.size(); t++)
+  {
+    std::vector<node> &S = Subtrees[t];
+    INT Base = (INT)Nodes.size() - 1;
+
+    for (auto &Nd : S)
+      if (Nd.Count == 0)
+        Nd.First += Base;
+    Nodes[Tasks[t].Node] = S[0];
+    Nodes.insert(Nodes.end(), S.begin() + 1, S.end());
+  }
+
+  /* Every leaf gets pack block (in nodes order) */
+  std::vector<INT> Leaves;
+
+  for (INT i = 0; i < (INT)Nodes.size(); i++)
+    if (Nodes[i].Count > 0)
+      Leaves.push_back(i);
+
+  INT NumOfLeaves = (INT)Leaves.size();
+
+  Pack.Resize(NumOfLeaves * BlockSize);
+  SlotToTri.assign(NumOfLeaves * BlockSize, -1);
+  TriToSlot.resize(N);
+  Pool.ParallelFor((NumOfLeaves + ChunkSize - 1) / ChunkSize, [&]( INT c )
+    {
+      for (INT l = c * ChunkSize; l < NumOfLeaves && l < (c + 1) * ChunkSize; l++)
+      {
+        node &Nd = Nodes[Leaves[l]];
+
+        for (INT k = 0; k < Nd.Count; k++)
+        {
+          INT Tri = Prims[Nd.First + k].Index, Slot = l * BlockSize + k;
+
+          Pack.Set(Slot, Points[Triangles[Tri].P[0]], Points[Triangles[Tri].P[1]], Points[Triangles[Tri].P[2]]);
+          SlotToTri[Slot] = Tri;
+          TriToSlot[Tri] = Slot;
+        }
+        Nd.First = l;
+      }
+    });
+} /* End of 'tcg::cd::bvh::Build' function */
+
+/* Remove tree function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::cd::bvh::Clear( VOID )
+{
+  Nodes.clear();
+  Pack.Clear();
+  SlotToTri.clear();
+  TriToSlot.clear();
+} /* End of 'tcg::cd::bvh::Clear' function */
+
+/* Move triangle function ('Refit' should be called after all moves).
+ * ARGUMENTS:
+ *   - mesh triangle number:
+ *       INT Index;
+ *   - new triangle points:
+ *       const vec &P0, &P1, &P2;
+ * RETURNS: None.
+ */
+VOID tcg::cd::bvh::Move( INT Index, const vec &P0, const vec &P1, const vec &P2 )
+{
+  Pack.Set(TriToSlot[Index], P0, P1, P2);
+} /* End of 'tcg::cd::bvh::Move' function */
+
+/* Refit nodes boxes to moved triangles function.
+ * Tree topology is kept, so it degrades after large moves (build again).
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::cd::bvh::Refit( VOID )
+{
+  /* Children are always after parent */
+  for (INT i = (INT)Nodes.size() - 1; i >= 0; i--)
+  {
+    node &Nd = Nodes[i];
+
+    for (INT k = 0; k < 3; k++)
+      Nd.Min[k] = FLT_MAX, Nd.Max[k] = -FLT_MAX;
+    if (Nd.Count > 0)
+      for (INT j = 0; j < Nd.Count; j++)
+      {
+        vec P0, P1, P2;
+        FLT Min[3], Max[3];
+
+        Pack.Get(Nd.First * triangle_pack::BlockSize + j, P0, P1, P2);
+        Bound(P0, P1, P2, Min, Max);
+        for (INT k = 0; k < 3; k++)
+          Nd.Min[k] = COM_MIN(Nd.Min[k], Min[k]), Nd.Max[k] = COM_MAX(Nd.Max[k], Max[k]);
+      }
+    else
+      for (INT c = Nd.First; c < Nd.First + 2; c++)
+        for (INT k = 0; k < 3; k++)
+          Nd.Min[k] = COM_MIN(Nd.Min[k], Nodes[c].Min[k]), Nd.Max[k] = COM_MAX(Nd.Max[k], Nodes[c].Max[k]);
+  }
+} /* End of 'tcg::cd::bvh::Refit' function */
+
+/* Check if tree is empty function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (BOOL) TRUE if there are no triangles.
+ */
+BOOL tcg::cd::bvh::IsEmpty( VOID ) const
+{
+  return Nodes.empty();
+} /* End of 'tcg::cd::bvh::IsEmpty' function */
+
+/* Obtain tree nodes function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (const std::vector<node> &) nodes (root is first).
+ */
+const std::vector<tcg::cd::bvh::node> & tcg::cd::bvh::GetNodes( VOID ) const
+{
+  return Nodes;
+} /* End of 'tcg::cd::bvh::GetNodes' function */
+
+/* Intersect ray with node box function.
+ * ARGUMENTS:
+ *   - node:
+ *       const node &Node;
+ *   - ray origin and inverse direction:
+ *       const FLT *Org, *Inv;
+ *   - nearest intersection parameter:
+ *       FLT T;
+ *   - box entry parameter:
+ *       FLT &T0;
+ * RETURNS:
+ *   (BOOL) TRUE if box is intersected nearer than 'T'.
+ */
+BOOL tcg::cd::bvh::IntersectBox( const node &Node, const FLT *Org, const FLT *Inv, FLT T, FLT &T0 )
+{
+  FLT t0 = 0, t1 = T;
+
+  for (INT k = 0; k < 3; k++)
+  {
+    FLT
+      a = (Node.Min[k] - Org[k]) * Inv[k],
+      b = (Node.Max[k] - Org[k]) * Inv[k];
+
+    t0 = COM_MAX(t0, COM_MIN(a, b));
+    t1 = COM_MIN(t1, COM_MAX(a, b));
+  }
+  T0 = t0;
+  return t0 <= t1;
+} /* End of 'tcg::cd::bvh::IntersectBox' function */
+
+/* Intersect ray with triangles function.
+ * ARGUMENTS:
+ *   - ray origin and direction (ray parameter is not normalized):
+ *       const FLT *Org, *Dir;
+ *   - nearest intersection parameter (only nearer intersections are found, updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) mesh number of nearest intersected triangle, -1 if none.
+ */
+INT tcg::cd::bvh::IntersectNearest( const FLT *Org, const FLT *Dir, FLT &T ) const
+{
+  FLT Inv[3], Enter[StackSize], t0, t1;
+  INT Stack[StackSize], Top = 0, Node = 0, Slot = -1;
+
+  /* Zero direction coordinates are replaced with tiny ones (no NaN in slabs test) */
+  for (INT k = 0; k < 3; k++)
+    Inv[k] = 1 / (Dir[k] != 0 ? Dir[k] : 1e-30f);
+  if (Nodes.empty() || !IntersectBox(Nodes[0], Org, Inv, T, t0))
+    return -1;
+  while (TRUE)
+  {
+    const node &Nd = Nodes[Node];
+
+    if (Nd.Count > 0)
+    {
+      INT j = Pack.IntersectBlock(Org, Dir, Nd.First, T);
+
+      if (j >= 0)
+        Slot = j;
+    }
+    else
+    {
+      INT Near = Nd.First, Far = Nd.First + 1;
+      BOOL
+        IsNear = IntersectBox(Nodes[Near], Org, Inv, T, t0),
+        IsFar = IntersectBox(Nodes[Far], Org, Inv, T, t1);
+
+      if (IsNear && IsFar)
+      {
+        /* Nearer child first, other one waits in stack */
+        if (t1 < t0)
+          std::swap(Near, Far), t1 = t0;
+        Stack[Top] = Far;
+        Enter[Top++] = t1;
+        Node = Near;
+        continue;
+      }
+      if (IsNear || IsFar)
+      {
+        Node = IsNear ? Near : Far;
+        continue;
+      }
+    }
+
+    /* Next waiting node which is not farther than found intersection */
+    do
+    {
+      if (Top == 0)
+        return Slot >= 0 ? SlotToTri[Slot] : -1;
+    } while (Enter[--Top] > T);
+    Node = Stack[Top];
+  }
+} /* End of 'tcg::cd::bvh::IntersectNearest' function */
+
+/* Check any ray intersection with triangles function.
+ * ARGUMENTS:
+ *   - ray origin and direction (ray parameter is not normalized):
+ *       const FLT *Org, *Dir;
+ *   - maximal intersection parameter:
+ *       FLT TMax;
+ * RETURNS:
+ *   (BOOL) TRUE if ray intersects some triangle in [0, TMax).
+ */
+BOOL tcg::cd::bvh::IntersectAny( const FLT *Org, const FLT *Dir, FLT TMax ) const
+{
+  FLT Inv[3], t;
+  INT Stack[StackSize], Top = 0;
+
+  for (INT k = 0; k < 3; k++)
+    Inv[k] = 1 / (Dir[k] != 0 ? Dir[k] : 1e-30f);
+  if (Nodes.empty() || !IntersectBox(Nodes[0], Org, Inv, TMax, t))
+    return FALSE;
+  Stack[Top++] = 0;
+  while (Top > 0)
+  {
+    const node &Nd = Nodes[Stack[--Top]];
+
+    if (Nd.Count > 0)
+    {
+      t = TMax;
+      if (Pack.IntersectBlock(Org, Dir, Nd.First, t) >= 0)
+        return TRUE;
+    }
+    else
+      for (INT c = Nd.First + 1; c >= Nd.First; c--)
+        if (IntersectBox(Nodes[c], Org, Inv, TMax, t))
+          Stack[Top++] = c;
+  }
+  return FALSE;
+} /* End of 'tcg::cd::bvh::IntersectAny' function */
+
+/* Intersect with ray function.
+ * ARGUMENTS:
+ *   - ray to intersect with:
+ *       const ray &Ray;
+ *   - compute normal flag:
+ *       const BOOL &ComputeNormal;
+ *   - compute point flag:
+ *       const BOOL &ComputePoint;
+ *   - transformation matrix:
+ *       const trans &Trans;
+ * RETURNS:
+ *   (collision) collision information (nearest intersection).
+ */
+tcg::cd::collision tcg::cd::bvh::Intersect( const ray &Ray, const BOOL &ComputeNormal, const BOOL &ComputePoint, const trans &Trans ) const
+{
+  /* Transform ray (affine transformations keep ray parameter) */
+  vec Org = Trans.InvTransformPoint(Ray.Org), Dir = Trans.InvTransformVector(Ray.Dir);
+  FLT
+    o[3] = {(FLT)Org.X, (FLT)Org.Y, (FLT)Org.Z},
+    d[3] = {(FLT)Dir.X, (FLT)Dir.Y, (FLT)Dir.Z},
+    t = FLT_MAX;
+  INT Index = IntersectNearest(o, d, t);
+
+  if (Index < 0)
+    return collision(0);
+
+  collision Collision(1, t);
+
+  if (ComputePoint)
+    Collision.Intersection.Location = Ray(t);
+  if (ComputeNormal)
+    Collision.Intersection.Normal = Trans.TransformNormal(Pack.GetNormal(TriToSlot[Index]));
+
+  return Collision;
+} /* End of 'tcg::cd::bvh::Intersect' function */
+
+/* Check if segment of ray is occluded function.
+ * ARGUMENTS:
+ *   - ray to check:
+ *       const ray &Ray;
+ *   - segment end ray parameter:
+ *       DBL TMax;
+ *   - transformation matrix:
+ *       const trans &Trans;
+ * RETURNS:
+ *   (BOOL) TRUE if some triangle intersects ray in [0, TMax).
+ */
+BOOL tcg::cd::bvh::IsOccluded( const ray &Ray, DBL TMax, const trans &Trans ) const
+{
+  vec Org = Trans.InvTransformPoint(Ray.Org), Dir = Trans.InvTransformVector(Ray.Dir);
+  FLT
+    o[3] = {(FLT)Org.X, (FLT)Org.Y, (FLT)Org.Z},
+    d[3] = {(FLT)Dir.X, (FLT)Dir.Y, (FLT)Dir.Z};
+
+  return IntersectAny(o, d, (FLT)COM_MIN(TMax, FLT_MAX));
+} /* End of 'tcg::cd::bvh::IsOccluded' function */
+
+/* END OF 'cd_bvh.cpp' FILE */
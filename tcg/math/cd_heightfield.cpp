@@ -0,0 +1,341 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : cd_heightfield.cpp
+ * PURPOSE     : Computational geometry project.
+ *               Collision detection support module.
+ *               Height field support module.
+ * PROGRAMMER  : MM5.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <cfloat>
+
+#include "../def.h"
+
+#include "cd.h"
+#include "../support/thread_pool.h"
+
+/* Class constructor.
+ * ARGUMENTS:
+ *   - location of first sample:
+ *       const vec &Loc;
+ *   - grid size (Y - heights scale):
+ *       const vec &Size;
+ */
+tcg::cd::heightfield::heightfield( const vec &Loc, const vec &Size ) : Loc(Loc), Size(Size)
+{
+} /* End of 'tcg::cd::heightfield::heightfield' function */
+
+/* Set height samples function.
+ * ARGUMENTS:
+ *   - height samples (row by row):
+ *       const FLOAT *Heights;
+ *   - samples grid size:
+ *       INT W, INT H;
+ * RETURNS:
+ *   (BOOL) TRUE if successful, FALSE otherwise.
+ */
+BOOL tcg::cd::heightfield::Set( const FLOAT *Heights, INT W, INT H )
+{
+  return Tree.Build(Heights, W, H);
+} /* End of 'tcg::cd::heightfield::Set' function */
+
+/* Load height samples from height map file function.
+ * ARGUMENTS:
+ *   - height map file name (any height encoding, see 'map_file'):
+ *       const CHAR *FileName;
+ *   - saved quadtree file name (tree is built if file is absent or stale, may be nullptr):
+ *       const CHAR *TreeFileName;
+ * RETURNS:
+ *   (BOOL) TRUE if successful, FALSE otherwise.
+ */
+BOOL tcg::cd::heightfield::Load( const CHAR *FileName, const CHAR *TreeFileName )
+{
+  return Tree.Load(FileName, TreeFileName);
+} /* End of 'tcg::cd::heightfield::Load' function */
+
+/* Place height field function.
+ * ARGUMENTS:
+ *   - location of first sample:
+ *       const vec &NewLoc;
+ *   - grid size (Y - heights scale):
+ *       const vec &NewSize;
+ * RETURNS: None.
+ */
+VOID tcg::cd::heightfield::Place( const vec &NewLoc, const vec &NewSize )
+{
+  Loc = NewLoc;
+  Size = NewSize;
+} /* End of 'tcg::cd::heightfield::Place' function */
+
+/* Check if height field has samples function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (BOOL) TRUE if samples were set.
+ */
+BOOL tcg::cd::heightfield::IsEmpty( VOID ) const
+{
+  return Tree.GetLevels() == 0;
+} /* End of 'tcg::cd::heightfield::IsEmpty' function */
+
+/* Obtain heights quadtree function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (minmax_tree &) quadtree (samples may be changed with 'minmax_tree::Update').
+ */
+tcg::minmax_tree & tcg::cd::heightfield::GetTree( VOID )
+{
+  return Tree;
+} /* End of 'tcg::cd::heightfield::GetTree' function */
+
+/* Obtain surface height function.
+ * ARGUMENTS:
+ *   - point coordinates on base plane (clamped to grid):
+ *       DBL X, DBL Z;
+ * RETURNS:
+ *   (DBL) surface Y coordinate (0 if there are no samples).
+ */
+DBL tcg::cd::heightfield::GetHeight( DBL X, DBL Z ) const
+{
+  if (IsEmpty())
+    return 0;
+
+  INT W = Tree.GetW(), H = Tree.GetH();
+  DBL
+    u = COM_MIN(COM_MAX((X - Loc.X) / Size.X * (W - 1), 0), W - 1),
+    v = COM_MIN(COM_MAX((Z - Loc.Z) / Size.Z * (H - 1), 0), H - 1);
+  INT
+    x = COM_MIN((INT)u, COM_MAX(W - 2, 0)),
+    y = COM_MIN((INT)v, COM_MAX(H - 2, 0)),
+    x1 = COM_MIN(x + 1, W - 1);
+  const FLOAT
+    *r0 = Tree.GetHeights() + (size_t)y * W,
+    *r1 = Tree.GetHeights() + (size_t)COM_MIN(y + 1, H - 1) * W;
+
+  u -= x, v -= y;
+  return Loc.Y + Size.Y * ((r0[x] * (1 - u) + r0[x1] * u) * (1 - v) + (r1[x] * (1 - u) + r1[x1] * u) * v);
+} /* End of 'tcg::cd::heightfield::GetHeight' function */
+
+/* Obtain ray in grid space function.
+ * ARGUMENTS:
+ *   - ray in height field space:
+ *       const ray &Ray;
+ * RETURNS:
+ *   (ray) ray with the same parameter in grid space.
+ */
+tcg::ray tcg::cd::heightfield::ToGrid( const ray &Ray ) const
+{
+  DBL
+    sx = Size.X / COM_MAX(Tree.GetW() - 1, 1),
+    sz = Size.Z / COM_MAX(Tree.GetH() - 1, 1);
+
+  return ray(vec((Ray.Org.X - Loc.X) / sx, (Ray.Org.Y - Loc.Y) / Size.Y, (Ray.Org.Z - Loc.Z) / sz),
+             vec(Ray.Dir.X / sx, Ray.Dir.Y / Size.Y, Ray.Dir.Z / sz));
+} /* End of 'tcg::cd::heightfield::ToGrid' function */
+
+/* Intersect ray with grid cell bilinear patch function.
+ * ARGUMENTS:
+ *   - ray in grid space:
+ *       const ray &Ray;
+ *   - cell position:
+ *       INT X, INT Y;
+ *   - ray parameter interval in cell:
+ *       DBL T0, DBL T1;
+ *   - nearest intersection parameter (updated):
+ *       DBL &T;
+ * RETURNS:
+ *   (BOOL) TRUE if nearer intersection was found.
+ */
+BOOL tcg::cd::heightfield::IntersectCell( const ray &Ray, INT X, INT Y, DBL T0, DBL T1, DBL &T ) const
+{
+  INT W = Tree.GetW(), H = Tree.GetH();
+  const FLOAT
+    *r0 = Tree.GetHeights() + (size_t)Y * W,
+    *r1 = Tree.GetHeights() + (size_t)COM_MIN(Y + 1, H - 1) * W;
+  INT X1 = COM_MIN(X + 1, W - 1);
+
+  /* Patch h(u, v) = a + b * u + c * v + d * u * v along ray gives quadratic equation */
+  DBL
+    a = r0[X], b = r0[X1] - a, c = r1[X] - a, d = r1[X1] - r0[X1] - r1[X] + a,
+    u0 = Ray.Org.X - X, du = Ray.Dir.X,
+    v0 = Ray.Org.Z - Y, dv = Ray.Dir.Z,
+    A = d * du * dv,
+    B = b * du + c * dv + d * (u0 * dv + v0 * du) - Ray.Dir.Y,
+    C = a + b * u0 + c * v0 + d * u0 * v0 - Ray.Org.Y,
+    Eps = 1e-9 * (1 + fabs(T1)),
+    Roots[2];
+  INT n = 0;
+
+  if (fabs(A) <= 1e-12 * (fabs(B) + fabs(C)))
+  {
+    if (B != 0)
+      Roots[n++] = -C / B;
+  }
+  else
+  {
+    DBL D = B * B - 4 * A * C;
+
+    if (D < 0)
+      return FALSE;
+
+    /* Stable roots evaluation */
+    DBL q = -(B + (B < 0 ? -sqrt(D) : sqrt(D))) / 2;
+
+    Roots[n++] = q / A;
+    if (q != 0)
+      Roots[n++] = C / q;
+  }
+
+  BOOL IsFound = FALSE;
+
+  for (INT i = 0; i < n; i++)
+    if (Roots[i] >= T0 - Eps && Roots[i] <= T1 + Eps)
+    {
+      DBL t = COM_MIN(COM_MAX(Roots[i], T0), T1);
+
+      if (t < T)
+        T = t, IsFound = TRUE;
+    }
+  return IsFound;
+} /* End of 'tcg::cd::heightfield::IntersectCell' function */
+
+/* Intersect ray in grid space function.
+ * ARGUMENTS:
+ *   - ray in grid space:
+ *       const ray &Ray;
+ *   - nearest intersection parameter:
+ *       DBL &T;
+ * RETURNS:
+ *   (BOOL) TRUE if intersection was found.
+ */
+BOOL tcg::cd::heightfield::IntersectGrid( const ray &Ray, DBL &T ) const
+{
+  BOOL IsFound = FALSE;
+
+  T = DBL_MAX;
+  Tree.Trace(Ray, 0, DBL_MAX, [&]( INT X, INT Y, DBL T0, DBL T1 )
+    {
+      /* Cells are visited by entry parameter, so nearer ones are over */
+      if (T0 > T)
+        return TRUE;
+      if (IntersectCell(Ray, X, Y, T0, T1, T))
+        IsFound = TRUE;
+      return FALSE;
+    });
+  return IsFound;
+} /* End of 'tcg::cd::heightfield::IntersectGrid' function */
+
+/* Obtain normal in height field space function.
+ * ARGUMENTS:
+ *   - point in grid space:
+ *       const vec &P;
+ * RETURNS:
+ *   (vec) surface normal.
+ */
+tcg::vec tcg::cd::heightfield::GetNormal( const vec &P ) const
+{
+  INT
+    W = Tree.GetW(), H = Tree.GetH(),
+    X = COM_MIN(COM_MAX((INT)floor(P.X), 0), COM_MAX(W - 2, 0)),
+    Y = COM_MIN(COM_MAX((INT)floor(P.Z), 0), COM_MAX(H - 2, 0)),
+    X1 = COM_MIN(X + 1, W - 1);
+  const FLOAT
+    *r0 = Tree.GetHeights() + (size_t)Y * W,
+    *r1 = Tree.GetHeights() + (size_t)COM_MIN(Y + 1, H - 1) * W;
+  DBL
+    u = P.X - X, v = P.Z - Y,
+    b = r0[X1] - r0[X], c = r1[X] - r0[X], d = r1[X1] - r0[X1] - r1[X] + r0[X],
+    sx = Size.X / COM_MAX(W - 1, 1),
+    sz = Size.Z / COM_MAX(H - 1, 1);
+
+  return vec(-(b + d * v) * Size.Y / sx, 1, -(c + d * u) * Size.Y / sz).Normalizing();
+} /* End of 'tcg::cd::heightfield::GetNormal' function */
+
+/* Intersect with ray function.
+ * ARGUMENTS:
+ *   - ray to intersect with:
+ *       const ray &Ray;
+ *   - compute normal flag:
+ *       const BOOL &ComputeNormal;
+ *   - compute point flag:
+ *       const BOOL &ComputePoint;
+ *   - transformation matrix:
+ *       const trans &Trans;
+ * RETURNS:
+ *   (collision) collision information (nearest intersection).
+ */
+tcg::cd::collision tcg::cd::heightfield::Intersect( const ray &Ray, const BOOL &ComputeNormal, const BOOL &ComputePoint, const trans &Trans ) const
+{
+  if (IsEmpty())
+    return collision(0);
+
+  /* Transform ray (affine transformations keep ray parameter) */
+  ray RayGrid = ToGrid(ray(Trans.InvTransformPoint(Ray.Org), Trans.InvTransformVector(Ray.Dir)));
+  DBL t;
+
+  if (!IntersectGrid(RayGrid, t))
+    return collision(0);
+
+  collision Collision(1, t);
+
+  if (ComputePoint)
+    Collision.Intersection.Location = Ray(t);
+  if (ComputeNormal)
+    Collision.Intersection.Normal = Trans.TransformNormal(GetNormal(RayGrid(t)));
+
+  return Collision;
+} /* End of 'tcg::cd::heightfield::Intersect' function */
+
+/* Intersect with rays batch function.
+ * ARGUMENTS:
+ *   - rays to intersect with:
+ *       const ray *Rays;
+ *   - number of rays:
+ *       INT NumOfRays;
+ *   - collisions information (one per ray):
+ *       collision *Collisions;
+ *   - compute normal flag:
+ *       const BOOL &ComputeNormal;
+ *   - compute point flag:
+ *       const BOOL &ComputePoint;
+ *   - transformation matrix:
+ *       const trans &Trans;
+ * RETURNS:
+ *   (INT) number of rays which intersect height field.
+ */
+INT tcg::cd::heightfield::Intersect( const ray *Rays, INT NumOfRays, collision *Collisions, const BOOL &ComputeNormal,
+                                     const BOOL &ComputePoint, const trans &Trans ) const
+{
+  const INT Chunk = 64;
+  INT Count = 0;
+  auto Run = [&]( INT First, INT Last )
+  {
+    for (INT i = First; i < Last; i++)
+      Collisions[i] = Intersect(Rays[i], ComputeNormal, ComputePoint, Trans);
+  };
+
+  /* Threads start costs about as much as several chunks */
+  if (NumOfRays >= Chunk * 16)
+  {
+    thread_pool Pool;
+
+    Pool.ParallelFor((NumOfRays + Chunk - 1) / Chunk, [&]( INT c )
+      {
+        Run(c * Chunk, COM_MIN((c + 1) * Chunk, NumOfRays));
+      });
+  }
+  else
+    Run(0, NumOfRays);
+  for (INT i = 0; i < NumOfRays; i++)
+    Count += Collisions[i].IsCollide;
+  return Count;
+} /* End of 'tcg::cd::heightfield::Intersect' function */
+
+/* END OF 'cd_heightfield.cpp' FILE */
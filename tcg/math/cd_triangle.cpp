@@ -32,11 +32,7 @@ tcg::cd::triangle::triangle( VOID )
  *       const vec &P0, &P1, &P2;
  */
 tcg::cd::triangle::triangle( const vec &P0, const vec &P1, const vec &P2 ) :
-  P0(P0), P1(P1), P2(P2), Normal(((P1 - P0) % (P2 - P0)).Normalizing()),
-  Du(((P2 - P0) * ((P1 - P0) & (P2 - P0)) - (P1 - P0) * ((P2 - P0) & (P2 - P0))) /
-    ((DBL)((P1 - P0) & (P2 - P0)) * ((P1 - P0) & (P2 - P0)) - (DBL)((P1 - P0) & (P1 - P0)) * ((P2 - P0) & (P2 - P0)))),
-  Dv(((P1 - P0) * ((P1 - P0) & (P2 - P0)) - (P2 - P0) * ((P1 - P0) & (P1 - P0))) /
-    ((DBL)((P1 - P0) & (P2 - P0)) * ((P1 - P0) & (P2 - P0)) - (DBL)((P1 - P0) & (P1 - P0)) * ((P2 - P0) & (P2 - P0))))
+  P0(P0), P1(P1), P2(P2), Normal(((P1 - P0) % (P2 - P0)).Normalizing()), E1(P1 - P0), E2(P2 - P0)
 {
 } /* End of 'tcg::cd::triangle::triangle' function */
 
@@ -46,7 +42,7 @@ tcg::cd::triangle::triangle( const vec &P0, const vec &P1, const vec &P2 ) :
  *       const triangle &Triangle;
  */
 tcg::cd::triangle::triangle( const triangle &Triangle ) :
-  P0(Triangle.P0), P1(Triangle.P1), P2(Triangle.P2), Normal(Triangle.Normal), Du(Triangle.Du), Dv(Triangle.Dv)
+  P0(Triangle.P0), P1(Triangle.P1), P2(Triangle.P2), Normal(Triangle.Normal), E1(Triangle.E1), E2(Triangle.E2)
 {
 } /* End of 'tcg::cd::triangle::triangle' function */
 
@@ -60,7 +56,7 @@ tcg::cd::triangle::triangle( const triangle &Triangle ) :
 tcg::cd::triangle & tcg::cd::triangle::operator=( const triangle &Triangle )
 {
   P0 = Triangle.P0, P1 = Triangle.P1, P2 = Triangle.P2, Normal = Triangle.Normal;
-  Du = Triangle.Du, Dv = Triangle.Dv;
+  E1 = Triangle.E1, E2 = Triangle.E2;
 
   return *this;
 } /* End of 'tcg::cd::triangle::operator=' function */
@@ -74,11 +70,8 @@ tcg::cd::triangle & tcg::cd::triangle::operator=( const triangle &Triangle )
 VOID tcg::cd::triangle::Set( const vec &P0, const vec &P1, const vec &P2 )
 {
   this->P0 = P0, this->P1 = P1, this->P2 = P2;
-  Normal = ((P1 - P0) % (P2 - P0)).Normalizing(),
-  Du = ((P2 - P0) * ((P1 - P0) & (P2 - P0)) - (P1 - P0) * ((P2 - P0) & (P2 - P0))) /
-    ((DBL)((P1 - P0) & (P2 - P0)) * ((P1 - P0) & (P2 - P0)) - (DBL)((P1 - P0) & (P1 - P0)) * ((P2 - P0) & (P2 - P0)));
-  Dv = ((P1 - P0) * ((P1 - P0) & (P2 - P0)) - (P2 - P0) * ((P1 - P0) & (P1 - P0))) /
-    ((DBL)((P1 - P0) & (P2 - P0)) * ((P1 - P0) & (P2 - P0)) - (DBL)((P1 - P0) & (P1 - P0)) * ((P2 - P0) & (P2 - P0)));
+  Normal = ((P1 - P0) % (P2 - P0)).Normalizing();
+  E1 = P1 - P0, E2 = P2 - P0;
 } /* End of 'tcg::cd::triangle::Set' function */
 
 /* Intersection of triangle with ray function 
@@ -96,36 +89,35 @@ VOID tcg::cd::triangle::Set( const vec &P0, const vec &P1, const vec &P2 )
  */
 tcg::cd::collision tcg::cd::triangle::Intersect( const ray &Ray, const BOOL &ComputeNormal, const BOOL &ComputePoint, const trans &Trans ) const
 {
-  /* Transform ray */
+  /* Transform ray (parameter is kept, so direction is not normalized) */
   ray RayTrans(Trans.InvTransformPoint(Ray.Org), Trans.InvTransformVector(Ray.Dir));
-  FLT ScaleCoef = 1.0 / !RayTrans.Dir;
-  RayTrans.Dir.Normalize();
 
-  if (fabs(P0.X - P1.X) < tsg::Threshold && fabs(P0.Y - P1.Y) < tsg::Threshold && fabs(P0.Z - P1.Z) < tsg::Threshold ||
-      fabs(P0.X - P2.X) < tsg::Threshold && fabs(P0.Y - P2.Y) < tsg::Threshold && fabs(P0.Z - P2.Z) < tsg::Threshold ||
-      fabs(P1.X - P2.X) < tsg::Threshold && fabs(P1.Y - P2.Y) < tsg::Threshold && fabs(P1.Z - P2.Z) < tsg::Threshold)
+  /* Moller-Trumbore test, same as 'triangle_pack' kernels:
+   * degenerate triangles and parallel rays have zero determinant */
+  vec Pv = RayTrans.Dir % E2;
+  DBL det = E1 & Pv;
+  if (det == 0)
     return collision(0);
 
-  DBL nd = Normal & RayTrans.Dir;
-  if (fabs(nd) < tsg::Threshold)
+  DBL inv = 1 / det;
+  vec Tv = RayTrans.Org - P0;
+  DBL u = (Tv & Pv) * inv;
+  if (u < 0 || u > 1)
     return collision(0);
 
-  DBL t = ((P0 & Normal) - (Normal & RayTrans.Org)) / nd;
-  if (t < 0)
+  vec Qv = Tv % E1;
+  DBL v = (RayTrans.Dir & Qv) * inv;
+  if (v < 0 || u + v > 1)
     return collision(0);
 
-  vec P = RayTrans(t);
-  DBL
-    u = (P & Du) - (P0 & Du),
-    v = (P & Dv) - (P0 & Dv);
-
-  if (u < 0 || v < 0 || (u + v) > 1)
+  DBL t = (E2 & Qv) * inv;
+  if (t < 0)
     return collision(0);
 
-  collision Collision(1, t * ScaleCoef);
+  collision Collision(1, t);
 
   if (ComputePoint)
-    Collision.Intersection.Location = Ray(t * ScaleCoef);
+    Collision.Intersection.Location = Ray(t);
   if (ComputeNormal)
     Collision.Intersection.Normal = Trans.TransformNormal(Normal);
 
@@ -0,0 +1,502 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : cd_triangle_pack.cpp
+ * PURPOSE     : Computational geometry project.
+ *               Collision detection support module.
+ *               Triangles pack support module.
+ * PROGRAMMER  : MM5.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <cfloat>
+#include <cstring>
+
+#include "../def.h"
+
+#include "cd.h"
+#include "../support/cpu.h"
+
+/* Class constructor.
+ * ARGUMENTS: None.
+ */
+tcg::cd::triangle_pack::triangle_pack( VOID ) : NumOfTriangles(0)
+{
+} /* End of 'tcg::cd::triangle_pack::triangle_pack' function */
+
+/* Remove all triangles function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::cd::triangle_pack::Clear( VOID )
+{
+  Blocks.clear();
+  NumOfTriangles = 0;
+} /* End of 'tcg::cd::triangle_pack::Clear' function */
+
+/* Add triangle function.
+ * ARGUMENTS:
+ *   - triangle points:
+ *       const vec &P0, &P1, &P2;
+ * RETURNS:
+ *   (INT) triangle number in pack.
+ */
+INT tcg::cd::triangle_pack::Add( const vec &P0, const vec &P1, const vec &P2 )
+{
+  INT n = NumOfTriangles % BlockSize;
+
+  /* Unused places stay zero (degenerate triangles) */
+  if (n == 0)
+  {
+    block B;
+
+    memset(&B, 0, sizeof(B));
+    Blocks.push_back(B);
+  }
+
+  Set(NumOfTriangles, P0, P1, P2);
+  return NumOfTriangles++;
+} /* End of 'tcg::cd::triangle_pack::Add' function */
+
+/* Set number of triangles function.
+ * New places are degenerate triangles (never intersected).
+ * ARGUMENTS:
+ *   - new number of triangles:
+ *       INT NewNumOfTriangles;
+ * RETURNS: None.
+ */
+VOID tcg::cd::triangle_pack::Resize( INT NewNumOfTriangles )
+{
+  block Zero;
+
+  memset(&Zero, 0, sizeof(Zero));
+  Blocks.resize((NewNumOfTriangles + BlockSize - 1) / BlockSize, Zero);
+  /* Clear places of removed triangles in last block */
+  for (INT i = NewNumOfTriangles; i < NumOfTriangles && i < (INT)Blocks.size() * BlockSize; i++)
+    Set(i, vec(0), vec(0), vec(0));
+  NumOfTriangles = NewNumOfTriangles;
+} /* End of 'tcg::cd::triangle_pack::Resize' function */
+
+/* Replace triangle function.
+ * ARGUMENTS:
+ *   - triangle number:
+ *       INT Index;
+ *   - new triangle points:
+ *       const vec &P0, &P1, &P2;
+ * RETURNS: None.
+ */
+VOID tcg::cd::triangle_pack::Set( INT Index, const vec &P0, const vec &P1, const vec &P2 )
+{
+  block &B = Blocks[Index / BlockSize];
+  INT n = Index % BlockSize;
+  vec E1 = P1 - P0, E2 = P2 - P0;
+
+  B.P0[0][n] = (FLT)P0.X, B.P0[1][n] = (FLT)P0.Y, B.P0[2][n] = (FLT)P0.Z;
+  B.E1[0][n] = (FLT)E1.X, B.E1[1][n] = (FLT)E1.Y, B.E1[2][n] = (FLT)E1.Z;
+  B.E2[0][n] = (FLT)E2.X, B.E2[1][n] = (FLT)E2.Y, B.E2[2][n] = (FLT)E2.Z;
+} /* End of 'tcg::cd::triangle_pack::Set' function */
+
+/* Obtain triangle points function.
+ * ARGUMENTS:
+ *   - triangle number:
+ *       INT Index;
+ *   - triangle points (as they are stored):
+ *       vec &P0, &P1, &P2;
+ * RETURNS: None.
+ */
+VOID tcg::cd::triangle_pack::Get( INT Index, vec &P0, vec &P1, vec &P2 ) const
+{
+  const block &B = Blocks[Index / BlockSize];
+  INT n = Index % BlockSize;
+
+  P0 = vec(B.P0[0][n], B.P0[1][n], B.P0[2][n]);
+  P1 = P0 + vec(B.E1[0][n], B.E1[1][n], B.E1[2][n]);
+  P2 = P0 + vec(B.E2[0][n], B.E2[1][n], B.E2[2][n]);
+} /* End of 'tcg::cd::triangle_pack::Get' function */
+
+/* Obtain number of triangles function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (INT) number of triangles.
+ */
+INT tcg::cd::triangle_pack::GetNumOfTriangles( VOID ) const
+{
+  return NumOfTriangles;
+} /* End of 'tcg::cd::triangle_pack::GetNumOfTriangles' function */
+
+/* Obtain number of blocks function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (INT) number of blocks.
+ */
+INT tcg::cd::triangle_pack::GetNumOfBlocks( VOID ) const
+{
+  return (INT)Blocks.size();
+} /* End of 'tcg::cd::triangle_pack::GetNumOfBlocks' function */
+
+/* Obtain triangle normal function.
+ * ARGUMENTS:
+ *   - triangle number:
+ *       INT Index;
+ * RETURNS:
+ *   (vec) unit normal ((P1 - P0) x (P2 - P0) direction).
+ */
+tcg::vec tcg::cd::triangle_pack::GetNormal( INT Index ) const
+{
+  const block &B = Blocks[Index / BlockSize];
+  INT n = Index % BlockSize;
+
+  return (vec(B.E1[0][n], B.E1[1][n], B.E1[2][n]) % vec(B.E2[0][n], B.E2[1][n], B.E2[2][n])).Normalizing();
+} /* End of 'tcg::cd::triangle_pack::GetNormal' function */
+
+/* Intersect ray with triangles blocks scalar kernel.
+ * Operations are the same as in SIMD kernels, so results are equal.
+ * ARGUMENTS:
+ *   - ray origin and direction:
+ *       const FLT *Org, *Dir;
+ *   - blocks range (last is excluded):
+ *       INT First, INT Last;
+ *   - nearest intersection parameter (updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) number of nearer intersected triangle, -1 if none.
+ */
+INT tcg::cd::triangle_pack::IntersectScalar( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const
+{
+  INT Index = -1;
+
+  for (INT b = First; b < Last; b++)
+  {
+    const block &B = Blocks[b];
+
+    for (INT n = 0; n < BlockSize; n++)
+    {
+      FLT
+        e1x = B.E1[0][n], e1y = B.E1[1][n], e1z = B.E1[2][n],
+        e2x = B.E2[0][n], e2y = B.E2[1][n], e2z = B.E2[2][n],
+        /* P = D x E2 */
+        px = Dir[1] * e2z - Dir[2] * e2y,
+        py = Dir[2] * e2x - Dir[0] * e2z,
+        pz = Dir[0] * e2y - Dir[1] * e2x,
+        det = e1x * px + e1y * py + e1z * pz,
+        inv = 1 / det,
+        /* S = O - P0 */
+        sx = Org[0] - B.P0[0][n],
+        sy = Org[1] - B.P0[1][n],
+        sz = Org[2] - B.P0[2][n],
+        u = (sx * px + sy * py + sz * pz) * inv,
+        /* Q = S x E1 */
+        qx = sy * e1z - sz * e1y,
+        qy = sz * e1x - sx * e1z,
+        qz = sx * e1y - sy * e1x,
+        v = (Dir[0] * qx + Dir[1] * qy + Dir[2] * qz) * inv,
+        t = (e2x * qx + e2y * qy + e2z * qz) * inv;
+
+      if (det != 0 && u >= 0 && v >= 0 && u + v <= 1 && t >= 0 && t < T)
+        T = t, Index = b * BlockSize + n;
+    }
+  }
+  return Index;
+} /* End of 'tcg::cd::triangle_pack::IntersectScalar' function */
+
+/* Intersect ray with triangles blocks SSE4 kernel (block by two halves).
+ * ARGUMENTS:
+ *   - ray origin and direction:
+ *       const FLT *Org, *Dir;
+ *   - blocks range (last is excluded):
+ *       INT First, INT Last;
+ *   - nearest intersection parameter (updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) number of nearer intersected triangle, -1 if none.
+ */
+TCG_TARGET("sse4.1") INT tcg::cd::triangle_pack::IntersectSse4( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const
+{
+  __m128
+    ox = _mm_set1_ps(Org[0]), oy = _mm_set1_ps(Org[1]), oz = _mm_set1_ps(Org[2]),
+    dx = _mm_set1_ps(Dir[0]), dy = _mm_set1_ps(Dir[1]), dz = _mm_set1_ps(Dir[2]),
+    zero = _mm_setzero_ps(), one = _mm_set1_ps(1),
+    BestT[2] = {_mm_set1_ps(T), _mm_set1_ps(T)};
+  __m128i
+    BestI[2] = {_mm_set1_epi32(-1), _mm_set1_epi32(-1)},
+    Lane = _mm_set_epi32(3, 2, 1, 0);
+
+  for (INT b = First; b < Last; b++)
+  {
+    const block &B = Blocks[b];
+
+    for (INT h = 0; h < 2; h++)
+    {
+      INT o = h * 4;
+      __m128
+        e1x = _mm_loadu_ps(B.E1[0] + o), e1y = _mm_loadu_ps(B.E1[1] + o), e1z = _mm_loadu_ps(B.E1[2] + o),
+        e2x = _mm_loadu_ps(B.E2[0] + o), e2y = _mm_loadu_ps(B.E2[1] + o), e2z = _mm_loadu_ps(B.E2[2] + o),
+        px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y)),
+        py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z)),
+        pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x)),
+        det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz)),
+        inv = _mm_div_ps(one, det),
+        sx = _mm_sub_ps(ox, _mm_loadu_ps(B.P0[0] + o)),
+        sy = _mm_sub_ps(oy, _mm_loadu_ps(B.P0[1] + o)),
+        sz = _mm_sub_ps(oz, _mm_loadu_ps(B.P0[2] + o)),
+        u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv),
+        qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y)),
+        qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z)),
+        qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x)),
+        v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv),
+        t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv),
+        m = _mm_and_ps(_mm_and_ps(_mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_cmpge_ps(u, zero)),
+                                  _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one))),
+                       _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, BestT[h])));
+
+      if (_mm_movemask_ps(m) != 0)
+      {
+        BestT[h] = _mm_blendv_ps(BestT[h], t, m);
+        BestI[h] = _mm_blendv_epi8(BestI[h], _mm_add_epi32(_mm_set1_epi32(b * BlockSize + o), Lane), _mm_castps_si128(m));
+      }
+    }
+  }
+
+  /* Lanes reduction: nearest, then smallest number (as sequential order) */
+  FLT Ts[8];
+  INT Is[8], Index = -1;
+
+  _mm_storeu_ps(Ts, BestT[0]);
+  _mm_storeu_ps(Ts + 4, BestT[1]);
+  _mm_storeu_si128((__m128i *)Is, BestI[0]);
+  _mm_storeu_si128((__m128i *)(Is + 4), BestI[1]);
+  for (INT n = 0; n < 8; n++)
+    if (Is[n] >= 0 && (Ts[n] < T || (Ts[n] == T && Index >= 0 && Is[n] < Index)))
+      T = Ts[n], Index = Is[n];
+  return Index;
+} /* End of 'tcg::cd::triangle_pack::IntersectSse4' function */
+
+/* Intersect ray with triangles blocks AVX2 kernel (whole block at once).
+ * ARGUMENTS:
+ *   - ray origin and direction:
+ *       const FLT *Org, *Dir;
+ *   - blocks range (last is excluded):
+ *       INT First, INT Last;
+ *   - nearest intersection parameter (updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) number of nearer intersected triangle, -1 if none.
+ */
+TCG_TARGET("avx2") INT tcg::cd::triangle_pack::IntersectAvx2( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const
+{
+  __m256
+    ox = _mm256_set1_ps(Org[0]), oy = _mm256_set1_ps(Org[1]), oz = _mm256_set1_ps(Org[2]),
+    dx = _mm256_set1_ps(Dir[0]), dy = _mm256_set1_ps(Dir[1]), dz = _mm256_set1_ps(Dir[2]),
+    zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1),
+    BestT = _mm256_set1_ps(T);
+  __m256i
+    BestI = _mm256_set1_epi32(-1),
+    Lane = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+  for (INT b = First; b < Last; b++)
+  {
+    const block &B = Blocks[b];
+    __m256
+      e1x = _mm256_loadu_ps(B.E1[0]), e1y = _mm256_loadu_ps(B.E1[1]), e1z = _mm256_loadu_ps(B.E1[2]),
+      e2x = _mm256_loadu_ps(B.E2[0]), e2y = _mm256_loadu_ps(B.E2[1]), e2z = _mm256_loadu_ps(B.E2[2]),
+      px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y)),
+      py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z)),
+      pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x)),
+      det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz)),
+      inv = _mm256_div_ps(one, det),
+      sx = _mm256_sub_ps(ox, _mm256_loadu_ps(B.P0[0])),
+      sy = _mm256_sub_ps(oy, _mm256_loadu_ps(B.P0[1])),
+      sz = _mm256_sub_ps(oz, _mm256_loadu_ps(B.P0[2])),
+      u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inv),
+      qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y)),
+      qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z)),
+      qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x)),
+      v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv),
+      t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv),
+      m = _mm256_and_ps(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(det, zero, _CMP_NEQ_UQ), _mm256_cmp_ps(u, zero, _CMP_GE_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ))),
+                        _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, BestT, _CMP_LT_OQ)));
+
+    if (_mm256_movemask_ps(m) != 0)
+    {
+      BestT = _mm256_blendv_ps(BestT, t, m);
+      BestI = _mm256_blendv_epi8(BestI, _mm256_add_epi32(_mm256_set1_epi32(b * BlockSize), Lane), _mm256_castps_si256(m));
+    }
+  }
+
+  /* Lanes reduction: nearest, then smallest number (as sequential order) */
+  FLT Ts[8];
+  INT Is[8], Index = -1;
+
+  _mm256_storeu_ps(Ts, BestT);
+  _mm256_storeu_si256((__m256i *)Is, BestI);
+  for (INT n = 0; n < 8; n++)
+    if (Is[n] >= 0 && (Ts[n] < T || (Ts[n] == T && Index >= 0 && Is[n] < Index)))
+      T = Ts[n], Index = Is[n];
+  return Index;
+} /* End of 'tcg::cd::triangle_pack::IntersectAvx2' function */
+
+/* Intersect ray with triangles blocks function.
+ * ARGUMENTS:
+ *   - ray origin and direction:
+ *       const FLT *Org, *Dir;
+ *   - blocks range (last is excluded):
+ *       INT First, INT Last;
+ *   - nearest intersection parameter (updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) number of nearer intersected triangle, -1 if none.
+ */
+INT tcg::cd::triangle_pack::IntersectBlocks( const FLT *Org, const FLT *Dir, INT First, INT Last, FLT &T ) const
+{
+  switch (cpu::Simd())
+  {
+  case cpu::SIMD_AVX2:
+    return IntersectAvx2(Org, Dir, First, Last, T);
+  case cpu::SIMD_SSE4:
+    return IntersectSse4(Org, Dir, First, Last, T);
+  }
+  return IntersectScalar(Org, Dir, First, Last, T);
+} /* End of 'tcg::cd::triangle_pack::IntersectBlocks' function */
+
+/* Intersect ray with 8 triangles of block function.
+ * ARGUMENTS:
+ *   - ray origin and direction (ray parameter is not normalized):
+ *       const FLT *Org, *Dir;
+ *   - block number:
+ *       INT Block;
+ *   - nearest intersection parameter (only nearer intersections are found, updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) number of nearer intersected triangle, -1 if none.
+ */
+INT tcg::cd::triangle_pack::IntersectBlock( const FLT *Org, const FLT *Dir, INT Block, FLT &T ) const
+{
+  return IntersectBlocks(Org, Dir, Block, Block + 1, T);
+} /* End of 'tcg::cd::triangle_pack::IntersectBlock' function */
+
+/* Intersect ray with all triangles function.
+ * ARGUMENTS:
+ *   - ray origin and direction (ray parameter is not normalized):
+ *       const FLT *Org, *Dir;
+ *   - nearest intersection parameter (only nearer intersections are found, updated):
+ *       FLT &T;
+ * RETURNS:
+ *   (INT) number of nearest intersected triangle, -1 if none.
+ */
+INT tcg::cd::triangle_pack::IntersectNearest( const FLT *Org, const FLT *Dir, FLT &T ) const
+{
+  return IntersectBlocks(Org, Dir, 0, (INT)Blocks.size(), T);
+} /* End of 'tcg::cd::triangle_pack::IntersectNearest' function */
+
+/* Intersect with ray function.
+ * ARGUMENTS:
+ *   - ray to intersect with:
+ *       const ray &Ray;
+ *   - compute normal flag:
+ *       const BOOL &ComputeNormal;
+ *   - compute point flag:
+ *       const BOOL &ComputePoint;
+ *   - transformation matrix:
+ *       const trans &Trans;
+ * RETURNS:
+ *   (collision) collision information (nearest intersection).
+ */
+tcg::cd::collision tcg::cd::triangle_pack::Intersect( const ray &Ray, const BOOL &ComputeNormal, const BOOL &ComputePoint, const trans &Trans ) const
+{
+  /* Transform ray (affine transformations keep ray parameter) */
+  vec Org = Trans.InvTransformPoint(Ray.Org), Dir = Trans.InvTransformVector(Ray.Dir);
+  FLT
+    o[3] = {(FLT)Org.X, (FLT)Org.Y, (FLT)Org.Z},
+    d[3] = {(FLT)Dir.X, (FLT)Dir.Y, (FLT)Dir.Z},
+    t = FLT_MAX;
+  INT Index = IntersectNearest(o, d, t);
+
+  if (Index < 0)
+    return collision(0);
+
+  collision Collision(1, t);
+
+  if (ComputePoint)
+    Collision.Intersection.Location = Ray(t);
+  if (ComputeNormal)
+    Collision.Intersection.Normal = Trans.TransformNormal(GetNormal(Index));
+
+  return Collision;
+} /* End of 'tcg::cd::triangle_pack::Intersect' function */
+
+/* Intersect with rays packet function.
+ * ARGUMENTS:
+ *   - rays to intersect with:
+ *       const ray *Rays;
+ *   - number of rays:
+ *       INT NumOfRays;
+ *   - collisions information (one per ray):
+ *       collision *Collisions;
+ *   - compute normal flag:
+ *       const BOOL &ComputeNormal;
+ *   - compute point flag:
+ *       const BOOL &ComputePoint;
+ *   - transformation matrix:
+ *       const trans &Trans;
+ * RETURNS:
+ *   (INT) number of rays which intersect triangles.
+ */
+INT tcg::cd::triangle_pack::Intersect( const ray *Rays, INT NumOfRays, collision *Collisions, const BOOL &ComputeNormal,
+                                       const BOOL &ComputePoint, const trans &Trans ) const
+{
+  /* Group rays and blocks chunk fit L1 cache (~9 KB of blocks) */
+  const INT GroupSize = 16, ChunkSize = 32;
+  FLT o[GroupSize][3], d[GroupSize][3], t[GroupSize];
+  INT Index[GroupSize], Count = 0, NumOfBlocks = (INT)Blocks.size();
+
+  for (INT r0 = 0; r0 < NumOfRays; r0 += GroupSize)
+  {
+    INT n = COM_MIN(GroupSize, NumOfRays - r0);
+
+    for (INT i = 0; i < n; i++)
+    {
+      vec
+        Org = Trans.InvTransformPoint(Rays[r0 + i].Org),
+        Dir = Trans.InvTransformVector(Rays[r0 + i].Dir);
+
+      o[i][0] = (FLT)Org.X, o[i][1] = (FLT)Org.Y, o[i][2] = (FLT)Org.Z;
+      d[i][0] = (FLT)Dir.X, d[i][1] = (FLT)Dir.Y, d[i][2] = (FLT)Dir.Z;
+      t[i] = FLT_MAX;
+      Index[i] = -1;
+    }
+    for (INT b = 0; b < NumOfBlocks; b += ChunkSize)
+      for (INT i = 0; i < n; i++)
+      {
+        INT j = IntersectBlocks(o[i], d[i], b, COM_MIN(b + ChunkSize, NumOfBlocks), t[i]);
+
+        if (j >= 0)
+          Index[i] = j;
+      }
+    for (INT i = 0; i < n; i++)
+    {
+      collision &C = Collisions[r0 + i];
+
+      if (Index[i] < 0)
+      {
+        C = collision(0);
+        continue;
+      }
+      C = collision(1, t[i]);
+      if (ComputePoint)
+        C.Intersection.Location = Rays[r0 + i](t[i]);
+      if (ComputeNormal)
+        C.Intersection.Normal = Trans.TransformNormal(GetNormal(Index[i]));
+      Count++;
+    }
+  }
+  return Count;
+} /* End of 'tcg::cd::triangle_pack::Intersect' function */
+
+/* END OF 'cd_triangle_pack.cpp' FILE */
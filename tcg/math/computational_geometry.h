@@ -19,6 +19,7 @@
 
 #include "../def.h"
 
+#include <set>
 #include <vector>
 
 /* Computational geometry project namespace */
@@ -147,7 +148,7 @@ namespace tcg
        * RETURNS:
        *   (BOOL) TRUE if less, FALSE otherwise.
        */
-      BOOL operator<( const triangle_edge &Edge );
+      BOOL operator<( const triangle_edge &Edge ) const;
 
       /* Compare edges function
        * ARGUMENTS:
@@ -156,31 +157,16 @@ namespace tcg
        * RETURNS:
        *   (BOOL) TRUE if more, FALSE otherwise.
        */
-      BOOL operator>( const triangle_edge &Edge );
+      BOOL operator>( const triangle_edge &Edge ) const;
     }; /* End of 'triangle_edge' struct */
 
     /* Edge stock class */
     class edge_stock
     {
     public:
-      std::vector<triangle_edge> Edges; // Stock of active edges.
+      std::set<triangle_edge> Edges; // Stock of active edges sorted by points indices.
 
     public:
-      /* Compare edges function
-       * ARGUMENTS:
-       *   - edges to compare:
-       *       const triangle_edge &a, &b;
-       * RETURNS:
-       *   (INT) -1 if first is less, 1 if first is more, 0 if equal.
-       */
-      INT compare( const triangle_edge &a, const triangle_edge &b );
-
-      /* Sort edges function.
-       * ARGUMENTS: None.
-       * RETURNS: None.
-       */
-      VOID sort( VOID );
-
       /* Add edge function.
        * ARGUMENTS:
        *   - edge to add or delete if it already exists:
@@ -189,44 +175,98 @@ namespace tcg
        */
       VOID add( triangle_edge Edge );
 
-      /* Add edge that definitely is not already active.
-       * ARGUMENTS:
-       *   - edge to add:
-       *       const triangle_edge &Edge;
-       * RETURNS: None.
-       */
-      VOID push_back( const triangle_edge &Edge );
-
-      /* Delete edge from end of stock.
+      /* Delete last edge from stock.
        * ARGUMENTS: None.
        * RETURNS: None.
        */
       VOID pop_back( VOID );
 
-      /* Get edge by index function.
-       * ARGUMENTS:
-       *   - index of edge:
-       *       INT n;
-       * RETURNS:
-       *   (triangle_edge &) reference to edge.
-       */
-      triangle_edge & operator[]( INT n );
-
       /* Get last edge function.
        * ARGUMENTS: None.
        * RETURNS:
-       *   (triangle_edge &) reference to last edge.
+       *   (const triangle_edge &) reference to edge with greatest indices.
        */
-      triangle_edge & last( VOID );
+      const triangle_edge & last( VOID ) const;
 
       /* Get number of active edges function.
        * ARGUMENTS: None.
        * RETURNS:
        *   (INT) number of edges.
        */
-      INT size( VOID );
+      INT size( VOID ) const;
     }; /* End of 'edge_stock' class */
 
+    /* Uniform grid of points class */
+    class point_grid
+    {
+    public:
+      DOUBLE MinX, MinZ;             // Grid corner.
+      DOUBLE CellSize;               // Size of one cell.
+      INT W, H;                      // Number of cells by X and Z.
+      std::vector<INT> CellStart;    // First point of every cell in 'CellPoints' (W * H + 1 values).
+      std::vector<INT> CellPoints;   // Points indices sorted by cells.
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS: None.
+       */
+      point_grid( VOID ) : MinX(0), MinZ(0), CellSize(1), W(0), H(0)
+      {
+      } /* End of 'point_grid' function */
+
+      /* Build grid function.
+       * ARGUMENTS:
+       *   - points to distribute:
+       *       const std::vector<point> &Points;
+       *   - average number of points per cell:
+       *       DOUBLE PointsPerCell;
+       * RETURNS: None.
+       */
+      VOID Build( const std::vector<point> &Points, DOUBLE PointsPerCell = 2 );
+
+      /* Get cell column function.
+       * ARGUMENTS:
+       *   - coordinate:
+       *       DOUBLE X;
+       * RETURNS:
+       *   (INT) column clamped to grid.
+       */
+      INT CellX( DOUBLE X ) const;
+
+      /* Get cell row function.
+       * ARGUMENTS:
+       *   - coordinate:
+       *       DOUBLE Z;
+       * RETURNS:
+       *   (INT) row clamped to grid.
+       */
+      INT CellZ( DOUBLE Z ) const;
+    }; /* End of 'point_grid' class */
+
+    const INT SmallPolygonSize = 32; // Polygons with no more points are processed without grid.
+
+    /* Test polygon self intersection function.
+     * ARGUMENTS:
+     *   - polygon points:
+     *       const std::vector<point> &Polygon;
+     * RETURNS:
+     *   (BOOL) TRUE if two not neighbour edges intersect, FALSE otherwise.
+     */
+    BOOL IsSelfIntersecting( const std::vector<point> &Polygon );
+
+    /* Clip polygon ears function.
+     * ARGUMENTS:
+     *   - counterclockwise polygon points:
+     *       const std::vector<point> &Polygon;
+     *   - stock of triangles to fill:
+     *       std::vector<triangle> &Triangles;
+     *   - add triangle of first three remaining points if no ear found flag:
+     *       BOOL IsForced;
+     * RETURNS:
+     *   (BOOL) TRUE if polygon is triangulated, FALSE if no ear found.
+     */
+    BOOL ClipEars( const std::vector<point> &Polygon, std::vector<triangle> &Triangles, BOOL IsForced );
+
     /* Triangulate polygon function.
      * ARGUMENTS:
      *   - polygon points:
@@ -260,6 +300,273 @@ namespace tcg
      * RETURNS: None.
      */
     VOID Triangulate( const std::vector<vec> &Points, std::vector<triangle> &Triangles );
+
+    /* Incremental Delaunay triangulation class.
+     * Triangles are kept in slots with neighbours, removed triangle slot has
+     * first point index -1 and is reused by next created triangle.
+     */
+    class delaunay
+    {
+    private:
+      /* Triangle neighbours struct */
+      struct neighbours
+      {
+        INT T[3]; // Neighbour triangles across edges P[i]P[i + 1] (-1 on hull).
+      }; /* End of 'neighbours' struct */
+
+      std::vector<vec> &Points;           // Triangulated points.
+      std::vector<neighbours> Neighbours; // Triangles neighbours.
+      std::vector<INT> FreeSlots;         // Removed triangles slots.
+      std::vector<INT> FreePoints;        // Removed points indices (reused by 'Insert').
+      INT NumOfPoints;                    // Number of points passed to triangulation (rest are added by points owner).
+      std::vector<INT> Incident;          // Points last set triangles slots (may be removed or reused).
+      std::set<std::pair<INT, INT>> Constraints; // Constrained edges (smaller point index first).
+      DOUBLE Sign;                        // Triangles orientation sign.
+      INT LastTriangle;                   // Walk start triangle.
+      UINT Seed;                          // Walk random generator state.
+
+    public:
+      std::vector<triangle> Triangles; // Triangles slots.
+      std::vector<INT> Changed;        // Slots changed since last 'Changed.clear()' (may repeat).
+
+    private:
+      /* Get point side of edge function.
+       * ARGUMENTS:
+       *   - edge points indices:
+       *       INT A, B;
+       *   - point:
+       *       const vec &P;
+       * RETURNS:
+       *   (DOUBLE) positive if point is on triangles inner side, negative otherwise.
+       */
+      DOUBLE Side( INT A, INT B, const vec &P ) const;
+
+      /* Test point in triangle circumcircle function.
+       * ARGUMENTS:
+       *   - triangle points indices:
+       *       INT A, B, C;
+       *   - point index:
+       *       INT D;
+       * RETURNS:
+       *   (BOOL) TRUE if point is strictly inside circle, FALSE otherwise.
+       */
+      BOOL InCircle( INT A, INT B, INT C, INT D ) const;
+
+      /* Locate triangle with point function.
+       * ARGUMENTS:
+       *   - point:
+       *       const vec &P;
+       * RETURNS:
+       *   (INT) triangle slot, -1 if point is out of triangulation.
+       */
+      INT Locate( const vec &P );
+
+      /* Create triangle function.
+       * ARGUMENTS:
+       *   - triangle points indices:
+       *       INT P0, P1, P2;
+       *   - neighbours across edges P0P1, P1P2, P2P0:
+       *       INT N0, N1, N2;
+       * RETURNS:
+       *   (INT) triangle slot.
+       */
+      INT Create( INT P0, INT P1, INT P2, INT N0, INT N1, INT N2 );
+
+      /* Set triangle in slot function.
+       * ARGUMENTS:
+       *   - triangle slot:
+       *       INT T;
+       *   - triangle points indices:
+       *       INT P0, P1, P2;
+       *   - neighbours across edges P0P1, P1P2, P2P0:
+       *       INT N0, N1, N2;
+       * RETURNS: None.
+       */
+      VOID Set( INT T, INT P0, INT P1, INT P2, INT N0, INT N1, INT N2 );
+
+      /* Set neighbour across triangle edge function.
+       * ARGUMENTS:
+       *   - triangle slot (nothing is done if -1):
+       *       INT T;
+       *   - edge points indices:
+       *       INT A, B;
+       *   - new neighbour slot:
+       *       INT N;
+       * RETURNS: None.
+       */
+      VOID Link( INT T, INT A, INT B, INT N );
+
+      /* Restore Delaunay condition by edges flips function.
+       * ARGUMENTS:
+       *   - triangles with new point as third vertex:
+       *       std::vector<INT> &Stack;
+       * RETURNS: None.
+       */
+      VOID Legalize( std::vector<INT> &Stack );
+
+      /* Insert point out of triangulation function.
+       * Point is connected with hull edges visible from it (all slots are scanned).
+       * ARGUMENTS:
+       *   - point index:
+       *       INT Index;
+       * RETURNS:
+       *   (INT) point index (hull one if point coincides with it), -1 if no hull edge is visible.
+       */
+      INT InsertOutside( INT Index );
+
+      /* Get triangles around point function.
+       * ARGUMENTS:
+       *   - point index:
+       *       INT A;
+       *   - stock of triangles slots to fill:
+       *       std::vector<INT> &Fan;
+       * RETURNS: None.
+       */
+      VOID GetFan( INT A, std::vector<INT> &Fan );
+
+      /* Triangulate pocket polygon with base edge function.
+       * ARGUMENTS:
+       *   - pocket polygon points indices (base edge is first and last points):
+       *       const std::vector<INT> &Chain;
+       *   - base edge points positions in chain:
+       *       INT Lo, Hi;
+       *   - stock of triangles to fill:
+       *       std::vector<triangle> &New;
+       * RETURNS: None.
+       */
+      VOID TriangulatePocket( const std::vector<INT> &Chain, INT Lo, INT Hi, std::vector<triangle> &New ) const;
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS:
+       *   - points to triangulate (new points are added to its end):
+       *       std::vector<vec> &Points;
+       */
+      delaunay( std::vector<vec> &Points ) : Points(Points), NumOfPoints(0), Sign(1), LastTriangle(-1), Seed(30)
+      {
+      } /* End of 'delaunay' function */
+
+      /* Triangulate all points function.
+       * Removed points are triangulated again.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Build( VOID );
+
+      /* Insert points added to points stock since last update function.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Update( VOID );
+
+      /* Insert point function.
+       * Point is added to the end of points stock or replaces removed point.
+       * ARGUMENTS:
+       *   - point:
+       *       const vec &Point;
+       * RETURNS:
+       *   (INT) point index (existing one if point coincides with it), -1 if point is not inserted.
+       */
+      INT Insert( const vec &Point );
+
+      /* Insert existing point function.
+       * Point out of triangulation extends its hull.
+       * ARGUMENTS:
+       *   - point index:
+       *       INT Index;
+       * RETURNS:
+       *   (INT) point index (existing one if point coincides with it), -1 if point is not inserted.
+       */
+      INT InsertIndex( INT Index );
+
+      /* Insert constrained edge function.
+       * Triangles crossed by edge are replaced with constrained Delaunay
+       * triangulation of pockets on both edge sides, edge is split in points
+       * lying on it and in crossings with other constrained edges.
+       * ARGUMENTS:
+       *   - edge points indices:
+       *       INT A, INT B;
+       *   - stock of points split edge to fill (in order from A to B):
+       *       std::vector<INT> &Splits;
+       * RETURNS:
+       *   (BOOL) TRUE if edge is inserted, FALSE otherwise.
+       */
+      BOOL InsertEdge( INT A, INT B, std::vector<INT> &Splits );
+
+      /* Test edge constrained function.
+       * ARGUMENTS:
+       *   - edge points indices:
+       *       INT A, B;
+       * RETURNS:
+       *   (BOOL) TRUE if edge is constrained, FALSE otherwise.
+       */
+      BOOL IsConstrained( INT A, INT B ) const
+      {
+        return Constraints.size() > 0 && Constraints.count(std::pair<INT, INT>(COM_MIN(A, B), COM_MAX(A, B))) > 0;
+      } /* End of 'IsConstrained' function */
+
+      /* Find triangle with edge function.
+       * ARGUMENTS:
+       *   - edge points indices:
+       *       INT A, B;
+       * RETURNS:
+       *   (INT) slot of triangle with AB edge in its points order, -1 if not found.
+       */
+      INT FindEdge( INT A, INT B );
+
+      /* Get triangle neighbour function.
+       * ARGUMENTS:
+       *   - triangle slot:
+       *       INT T;
+       *   - edge number (edge is P[k]P[k + 1]):
+       *       INT k;
+       * RETURNS:
+       *   (INT) neighbour triangle slot, -1 if none.
+       */
+      INT GetNeighbour( INT T, INT k ) const
+      {
+        return Neighbours[T].T[k];
+      } /* End of 'GetNeighbour' function */
+
+      /* Find triangulation point nearest to point function.
+       * ARGUMENTS:
+       *   - point:
+       *       const vec &Point;
+       * RETURNS:
+       *   (INT) nearest point of triangle with point, -1 if point is out of triangulation.
+       */
+      INT Find( const vec &Point );
+
+      /* Remove point by index function.
+       * Hull and constrained edges points are not removed. Removed point stays
+       * in points stock (indices are kept), its place is reused by 'Insert'.
+       * ARGUMENTS:
+       *   - point index:
+       *       INT Index;
+       * RETURNS:
+       *   (BOOL) TRUE if point is removed, FALSE otherwise.
+       */
+      BOOL RemoveIndex( INT Index );
+
+      /* Remove point function.
+       * Triangle with point is found and its vertex nearest to point is removed
+       * (see 'RemoveIndex').
+       * ARGUMENTS:
+       *   - point:
+       *       const vec &Point;
+       * RETURNS:
+       *   (INT) removed point index, -1 if nothing is removed.
+       */
+      INT Remove( const vec &Point );
+
+      /* Get triangles function.
+       * ARGUMENTS:
+       *   - stock of triangles to fill:
+       *       std::vector<triangle> &Triangles;
+       * RETURNS: None.
+       */
+      VOID GetTriangles( std::vector<triangle> &Triangles ) const;
+    }; /* End of 'delaunay' class */
   } /* end of 'math' namespace */
 } /* end of 'tcg' namespace */
 
@@ -0,0 +1,898 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : delaunay.cpp
+ * PURPOSE     : Computational geometry project.
+ *               Computational geometry support module.
+ *               Incremental Delaunay triangulation module.
+ * PROGRAMMER  : MM5.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+#include <map>
+
+#include "computational_geometry.h"
+
+/* Get point side of edge function.
+ * ARGUMENTS:
+ *   - edge points indices:
+ *       INT A, B;
+ *   - point:
+ *       const vec &P;
+ * RETURNS:
+ *   (DOUBLE) positive if point is on triangles inner side, negative otherwise.
+ */
+DOUBLE tcg::math::delaunay::Side( INT A, INT B, const vec &P ) const
+{
+  const vec &a = Points[A], &b = Points[B];
+
+  return Sign * ((b.X - a.X) * (P.Z - a.Z) - (b.Z - a.Z) * (P.X - a.X));
+} /* End of 'tcg::math::delaunay::Side' function */
+
+/* Test point in triangle circumcircle function.
+ * ARGUMENTS:
+ *   - triangle points indices:
+ *       INT A, B, C;
+ *   - point index:
+ *       INT D;
+ * RETURNS:
+ *   (BOOL) TRUE if point is strictly inside circle, FALSE otherwise.
+ */
+BOOL tcg::math::delaunay::InCircle( INT A, INT B, INT C, INT D ) const
+{
+  const vec &d = Points[D];
+  DOUBLE
+    ax = Points[A].X - d.X, az = Points[A].Z - d.Z,
+    bx = Points[B].X - d.X, bz = Points[B].Z - d.Z,
+    cx = Points[C].X - d.X, cz = Points[C].Z - d.Z,
+    det = (ax * ax + az * az) * (bx * cz - bz * cx) -
+          (bx * bx + bz * bz) * (ax * cz - az * cx) +
+          (cx * cx + cz * cz) * (ax * bz - az * bx);
+
+  return Sign * det > Threshold;
+} /* End of 'tcg::math::delaunay::InCircle' function */
+
+/* Locate triangle with point function.
+ * Walk starts from nearest of last and few random triangles and
+ * goes through edges point is behind of.
+ * ARGUMENTS:
+ *   - point:
+ *       const vec &P;
+ * RETURNS:
+ *   (INT) triangle slot, -1 if point is out of triangulation.
+ */
+INT tcg::math::delaunay::Locate( const vec &P )
+{
+  INT T = -1;
+  DOUBLE Best = 0;
+
+  if (Triangles.size() == 0)
+    return -1;
+  if (LastTriangle != -1 && Triangles[LastTriangle].P[0] != -1)
+  {
+    T = LastTriangle;
+    Best = (Points[Triangles[T].P[0]] - P).Length2D();
+  }
+  for (INT i = 0, n = (INT)pow((DOUBLE)Triangles.size(), 1.0 / 3) + 1; i < n; i++)
+  {
+    Seed = Seed * 1103515245 + 12345;
+
+    INT S = (Seed >> 8) % Triangles.size();
+
+    if (Triangles[S].P[0] != -1 && (T == -1 || (Points[Triangles[S].P[0]] - P).Length2D() < Best))
+      T = S, Best = (Points[Triangles[S].P[0]] - P).Length2D();
+  }
+  if (T == -1)
+    return -1;
+
+  for (INT Step = 0; Step <= Triangles.size(); Step++)
+  {
+    Seed = Seed * 1103515245 + 12345;
+
+    INT Start = (Seed >> 8) % 3, e;
+
+    for (e = 0; e < 3; e++)
+      if (Side(Triangles[T].P[(Start + e) % 3], Triangles[T].P[(Start + e + 1) % 3], P) < 0)
+        break;
+    if (e == 3)
+      return LastTriangle = T;
+    if ((T = Neighbours[T].T[(Start + e) % 3]) == -1)
+      return -1;
+  }
+  return -1;
+} /* End of 'tcg::math::delaunay::Locate' function */
+
+/* Create triangle function.
+ * ARGUMENTS:
+ *   - triangle points indices:
+ *       INT P0, P1, P2;
+ *   - neighbours across edges P0P1, P1P2, P2P0:
+ *       INT N0, N1, N2;
+ * RETURNS:
+ *   (INT) triangle slot.
+ */
+INT tcg::math::delaunay::Create( INT P0, INT P1, INT P2, INT N0, INT N1, INT N2 )
+{
+  INT T;
+
+  if (FreeSlots.size() > 0)
+  {
+    T = FreeSlots.back();
+    FreeSlots.pop_back();
+  }
+  else
+  {
+    T = Triangles.size();
+    Triangles.push_back(triangle(-1, -1, -1));
+    Neighbours.push_back(neighbours());
+  }
+  Set(T, P0, P1, P2, N0, N1, N2);
+  return T;
+} /* End of 'tcg::math::delaunay::Create' function */
+
+/* Set triangle in slot function.
+ * ARGUMENTS:
+ *   - triangle slot:
+ *       INT T;
+ *   - triangle points indices:
+ *       INT P0, P1, P2;
+ *   - neighbours across edges P0P1, P1P2, P2P0:
+ *       INT N0, N1, N2;
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::Set( INT T, INT P0, INT P1, INT P2, INT N0, INT N1, INT N2 )
+{
+  Triangles[T] = triangle(P0, P1, P2);
+  if (Incident.size() < Points.size())
+    Incident.resize(Points.size(), -1);
+  Incident[P0] = Incident[P1] = Incident[P2] = T;
+  Neighbours[T].T[0] = N0;
+  Neighbours[T].T[1] = N1;
+  Neighbours[T].T[2] = N2;
+  Changed.push_back(T);
+} /* End of 'tcg::math::delaunay::Set' function */
+
+/* Set neighbour across triangle edge function.
+ * ARGUMENTS:
+ *   - triangle slot (nothing is done if -1):
+ *       INT T;
+ *   - edge points indices:
+ *       INT A, B;
+ *   - new neighbour slot:
+ *       INT N;
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::Link( INT T, INT A, INT B, INT N )
+{
+  if (T == -1)
+    return;
+  for (INT k = 0; k < 3; k++)
+    if (Triangles[T].P[k] == A && Triangles[T].P[(k + 1) % 3] == B)
+      Neighbours[T].T[k] = N;
+} /* End of 'tcg::math::delaunay::Link' function */
+
+/* Restore Delaunay condition by edges flips function.
+ * ARGUMENTS:
+ *   - triangles with new point as third vertex:
+ *       std::vector<INT> &Stack;
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::Legalize( std::vector<INT> &Stack )
+{
+  while (Stack.size() > 0)
+  {
+    INT
+      T = Stack.back(),
+      X = Triangles[T].P[0], Y = Triangles[T].P[1], P = Triangles[T].P[2],
+      U = Neighbours[T].T[0], j;
+
+    Stack.pop_back();
+    if (U == -1)
+      continue;
+
+    // Neighbour is (Y, X, D) triangle.
+    for (j = 0; Triangles[U].P[j] != Y; j++)
+      ;
+    INT D = Triangles[U].P[(j + 2) % 3];
+    if (!InCircle(X, Y, P, D) || IsConstrained(X, Y))
+      continue;
+
+    // Flip XY edge to PD one.
+    INT
+      NXD = Neighbours[U].T[(j + 1) % 3], NDY = Neighbours[U].T[(j + 2) % 3],
+      NYP = Neighbours[T].T[1], NPX = Neighbours[T].T[2];
+
+    Set(T, X, D, P, NXD, U, NPX);
+    Set(U, D, Y, P, NDY, NYP, T);
+    Link(NXD, D, X, T);
+    Link(NYP, P, Y, U);
+    Stack.push_back(T);
+    Stack.push_back(U);
+  }
+} /* End of 'tcg::math::delaunay::Legalize' function */
+
+/* Insert point out of triangulation function.
+ * Point is connected with hull edges visible from it (all slots are scanned).
+ * ARGUMENTS:
+ *   - point index:
+ *       INT Index;
+ * RETURNS:
+ *   (INT) point index (hull one if point coincides with it), -1 if no hull edge is visible.
+ */
+INT tcg::math::delaunay::InsertOutside( INT Index )
+{
+  const vec Point = Points[Index];
+  std::vector<std::pair<INT, INT>> Visible;
+  std::vector<INT> Stack;
+  std::map<INT, INT> Starts, Ends; // New triangles by their hull edge start and end points.
+
+  for (INT T = 0; T < Triangles.size(); T++)
+    if (Triangles[T].P[0] != -1)
+      for (INT k = 0; k < 3; k++)
+      {
+        INT A = Triangles[T].P[k], B = Triangles[T].P[(k + 1) % 3];
+
+        if (Neighbours[T].T[k] != -1 || Side(A, B, Point) >= -Threshold * 1000 * (Points[B] - Points[A]).Length2D())
+          continue;
+        if (fabs(Points[A].X - Point.X) < tsg::Threshold * 100 && fabs(Points[A].Z - Point.Z) < tsg::Threshold * 100)
+          return A;
+        if (fabs(Points[B].X - Point.X) < tsg::Threshold * 100 && fabs(Points[B].Z - Point.Z) < tsg::Threshold * 100)
+          return B;
+        Visible.push_back(std::pair<INT, INT>(T, k));
+      }
+  if (Visible.size() == 0)
+    return -1;
+
+  // Triangle BAP outside of every visible hull edge AB.
+  for (INT i = 0; i < Visible.size(); i++)
+  {
+    INT
+      T = Visible[i].first, k = Visible[i].second,
+      A = Triangles[T].P[k], B = Triangles[T].P[(k + 1) % 3],
+      N = Create(B, A, Index, T, -1, -1);
+
+    Neighbours[T].T[k] = N;
+    Starts[A] = N;
+    Ends[B] = N;
+    Stack.push_back(N);
+  }
+  // Link new triangles sharing edges with point.
+  for (std::map<INT, INT>::iterator S = Starts.begin(); S != Starts.end(); S++)
+  {
+    std::map<INT, INT>::iterator E = Ends.find(S->first);
+
+    if (E != Ends.end())
+    {
+      Neighbours[S->second].T[1] = E->second;
+      Neighbours[E->second].T[2] = S->second;
+    }
+  }
+  LastTriangle = Stack[0];
+  Legalize(Stack);
+  return Index;
+} /* End of 'tcg::math::delaunay::InsertOutside' function */
+
+/* Triangulate all points function.
+ * Removed points are triangulated again.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::Build( VOID )
+{
+  Triangles.clear();
+  Neighbours.clear();
+  FreeSlots.clear();
+  FreePoints.clear();
+  NumOfPoints = Points.size();
+  Changed.clear();
+  Constraints.clear();
+  Incident.assign(Points.size(), -1);
+  LastTriangle = -1;
+
+  Triangulate(Points, Triangles);
+  if (Triangles.size() == 0)
+    return;
+  LastTriangle = 0;
+
+  // Triangles orientation.
+  for (INT i = 0; i < Triangles.size(); i++)
+  {
+    const vec &a = Points[Triangles[i].P[0]], &b = Points[Triangles[i].P[1]], &c = Points[Triangles[i].P[2]];
+    DOUBLE Orient = (b.X - a.X) * (c.Z - a.Z) - (b.Z - a.Z) * (c.X - a.X);
+
+    if (Orient != 0)
+    {
+      Sign = Orient > 0 ? 1 : -1;
+      break;
+    }
+  }
+
+  // Pair equal edges sorted by points indices.
+  std::vector<INT> Edges(Triangles.size() * 3);
+
+  Neighbours.resize(Triangles.size());
+  for (INT i = 0; i < Edges.size(); i++)
+  {
+    Edges[i] = i;
+    Neighbours[i / 3].T[i % 3] = -1;
+    Incident[Triangles[i / 3].P[i % 3]] = i / 3;
+  }
+  std::sort(Edges.begin(), Edges.end(), [this]( INT a, INT b )
+  {
+    INT
+      a0 = Triangles[a / 3].P[a % 3], a1 = Triangles[a / 3].P[(a + 1) % 3],
+      b0 = Triangles[b / 3].P[b % 3], b1 = Triangles[b / 3].P[(b + 1) % 3];
+
+    if (COM_MIN(a0, a1) != COM_MIN(b0, b1))
+      return COM_MIN(a0, a1) < COM_MIN(b0, b1);
+    return COM_MAX(a0, a1) < COM_MAX(b0, b1);
+  });
+  for (INT i = 0; i + 1 < Edges.size(); i++)
+  {
+    INT a = Edges[i], b = Edges[i + 1];
+
+    if (Triangles[a / 3].P[a % 3] == Triangles[b / 3].P[(b + 1) % 3] &&
+        Triangles[a / 3].P[(a + 1) % 3] == Triangles[b / 3].P[b % 3])
+    {
+      Neighbours[a / 3].T[a % 3] = b / 3;
+      Neighbours[b / 3].T[b % 3] = a / 3;
+      i++;
+    }
+  }
+} /* End of 'tcg::math::delaunay::Build' function */
+
+/* Insert points added to points stock since last update function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::Update( VOID )
+{
+  // Too few points to have triangles - rebuild all.
+  if (LastTriangle == -1)
+  {
+    Build();
+    for (INT i = 0; i < Triangles.size(); i++)
+      Changed.push_back(i);
+    return;
+  }
+
+  for (; NumOfPoints < Points.size(); NumOfPoints++)
+    if (std::find(FreePoints.begin(), FreePoints.end(), NumOfPoints) == FreePoints.end())
+      InsertIndex(NumOfPoints);
+} /* End of 'tcg::math::delaunay::Update' function */
+
+/* Insert point function.
+ * Point is added to the end of points stock or replaces removed point.
+ * ARGUMENTS:
+ *   - point:
+ *       const vec &Point;
+ * RETURNS:
+ *   (INT) point index (existing one if point coincides with it), -1 if point is not inserted.
+ */
+INT tcg::math::delaunay::Insert( const vec &Point )
+{
+  // Too few points to have triangles - rebuild all.
+  if (LastTriangle == -1)
+  {
+    Points.push_back(Point);
+    Build();
+    for (INT i = 0; i < Triangles.size(); i++)
+      Changed.push_back(i);
+    return Points.size() - 1;
+  }
+
+  INT P;
+
+  // Removed point place is reused, so edits do not grow points stock.
+  if (FreePoints.size() > 0)
+  {
+    INT F = FreePoints.back();
+
+    Points[F] = Point;
+    if ((P = InsertIndex(F)) == F)
+      FreePoints.pop_back();
+    return P;
+  }
+
+  Points.push_back(Point);
+  if ((P = InsertIndex(Points.size() - 1)) != Points.size() - 1)
+    Points.pop_back();
+  else if (NumOfPoints == P)
+    NumOfPoints++;
+  return P;
+} /* End of 'tcg::math::delaunay::Insert' function */
+
+/* Insert existing point function.
+ * Point out of triangulation extends its hull.
+ * ARGUMENTS:
+ *   - point index:
+ *       INT Index;
+ * RETURNS:
+ *   (INT) point index (existing one if point coincides with it), -1 if point is not inserted.
+ */
+INT tcg::math::delaunay::InsertIndex( INT Index )
+{
+  const vec Point = Points[Index];
+  INT T = Locate(Point);
+  if (T == -1)
+    return InsertOutside(Index);
+
+  triangle Tr = Triangles[T];
+  for (INT k = 0; k < 3; k++)
+    if (fabs(Points[Tr.P[k]].X - Point.X) < tsg::Threshold * 100 && fabs(Points[Tr.P[k]].Z - Point.Z) < tsg::Threshold * 100)
+      return Tr.P[k];
+
+  INT P = Index, E = -1;
+  neighbours N = Neighbours[T];
+  std::vector<INT> Stack;
+
+  for (INT k = 0; k < 3; k++)
+    if (fabs(Side(Tr.P[k], Tr.P[(k + 1) % 3], Point)) < Threshold * 1000 * (Points[Tr.P[(k + 1) % 3]] - Points[Tr.P[k]]).Length2D())
+      E = k;
+
+  if (E == -1)
+  {
+    // Split triangle ABC into ABP, BCP and CAP.
+    INT
+      A = Tr.P[0], B = Tr.P[1], C = Tr.P[2],
+      T1 = Create(B, C, P, N.T[1], -1, T),
+      T2 = Create(C, A, P, N.T[2], T, T1);
+
+    Neighbours[T1].T[1] = T2;
+    Set(T, A, B, P, N.T[0], T1, T2);
+    Link(N.T[1], C, B, T1);
+    Link(N.T[2], A, C, T2);
+    Stack.push_back(T);
+    Stack.push_back(T1);
+    Stack.push_back(T2);
+  }
+  else
+  {
+    // Split triangles ABC and BAD sharing edge AB with point.
+    INT
+      A = Tr.P[E], B = Tr.P[(E + 1) % 3], C = Tr.P[(E + 2) % 3],
+      U = N.T[E], U1 = -1,
+      T1 = Create(B, C, P, N.T[(E + 1) % 3], T, -1);
+
+    if (IsConstrained(A, B))
+    {
+      Constraints.erase(std::pair<INT, INT>(COM_MIN(A, B), COM_MAX(A, B)));
+      Constraints.insert(std::pair<INT, INT>(COM_MIN(A, P), COM_MAX(A, P)));
+      Constraints.insert(std::pair<INT, INT>(COM_MIN(B, P), COM_MAX(B, P)));
+    }
+    if (U != -1)
+    {
+      INT j;
+
+      for (j = 0; Triangles[U].P[j] != B; j++)
+        ;
+      INT
+        D = Triangles[U].P[(j + 2) % 3],
+        NAD = Neighbours[U].T[(j + 1) % 3], NDB = Neighbours[U].T[(j + 2) % 3];
+
+      U1 = Create(A, D, P, NAD, U, T);
+      Set(U, D, B, P, NDB, T1, U1);
+      Link(NAD, D, A, U1);
+      Neighbours[T1].T[2] = U;
+      Stack.push_back(U);
+      Stack.push_back(U1);
+    }
+    Set(T, C, A, P, N.T[(E + 2) % 3], U1, T1);
+    Link(N.T[(E + 1) % 3], C, B, T1);
+    Stack.push_back(T);
+    Stack.push_back(T1);
+  }
+  Legalize(Stack);
+  return P;
+} /* End of 'tcg::math::delaunay::InsertIndex' function */
+
+/* Get triangles around point function.
+ * ARGUMENTS:
+ *   - point index:
+ *       INT A;
+ *   - stock of triangles slots to fill:
+ *       std::vector<INT> &Fan;
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::GetFan( INT A, std::vector<INT> &Fan )
+{
+  INT T0 = A < Incident.size() ? Incident[A] : -1, T, k;
+
+  Fan.clear();
+  // Last set triangle with point may be already removed - locate point then.
+  if (T0 == -1 || (Triangles[T0].P[0] != A && Triangles[T0].P[1] != A && Triangles[T0].P[2] != A))
+    T0 = Locate(Points[A]);
+  if (T0 == -1 || (Triangles[T0].P[0] != A && Triangles[T0].P[1] != A && Triangles[T0].P[2] != A))
+    return;
+
+  // Go around point until hull or hole is met, then go other way from start.
+  T = T0;
+  do
+  {
+    Fan.push_back(T);
+    for (k = 0; Triangles[T].P[k] != A; k++)
+      ;
+    T = Neighbours[T].T[(k + 2) % 3];
+  } while (T != -1 && T != T0);
+  if (T == -1)
+    for (T = T0;;)
+    {
+      for (k = 0; Triangles[T].P[k] != A; k++)
+        ;
+      if ((T = Neighbours[T].T[k]) == -1)
+        break;
+      Fan.push_back(T);
+    }
+} /* End of 'tcg::math::delaunay::GetFan' function */
+
+/* Find triangle with edge function.
+ * ARGUMENTS:
+ *   - edge points indices:
+ *       INT A, B;
+ * RETURNS:
+ *   (INT) slot of triangle with AB edge in its points order, -1 if not found.
+ */
+INT tcg::math::delaunay::FindEdge( INT A, INT B )
+{
+  std::vector<INT> Fan;
+
+  GetFan(A, Fan);
+  for (INT i = 0; i < Fan.size(); i++)
+    for (INT k = 0; k < 3; k++)
+      if (Triangles[Fan[i]].P[k] == A && Triangles[Fan[i]].P[(k + 1) % 3] == B)
+        return Fan[i];
+  return -1;
+} /* End of 'tcg::math::delaunay::FindEdge' function */
+
+/* Triangulate pocket polygon with base edge function.
+ * Point with circumcircle free of other pocket points is taken as third
+ * base edge triangle point, pocket parts on its both sides are processed recursively.
+ * ARGUMENTS:
+ *   - pocket polygon points indices (base edge is first and last points):
+ *       const std::vector<INT> &Chain;
+ *   - base edge points positions in chain:
+ *       INT Lo, Hi;
+ *   - stock of triangles to fill:
+ *       std::vector<triangle> &New;
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::TriangulatePocket( const std::vector<INT> &Chain, INT Lo, INT Hi, std::vector<triangle> &New ) const
+{
+  if (Hi - Lo < 2)
+    return;
+
+  INT C = Lo + 1;
+  for (INT i = Lo + 2; i < Hi; i++)
+    if (Side(Chain[Lo], Chain[Hi], Points[Chain[C]]) > 0 ?
+          InCircle(Chain[Lo], Chain[Hi], Chain[C], Chain[i]) :
+          InCircle(Chain[Hi], Chain[Lo], Chain[C], Chain[i]))
+      C = i;
+
+  TriangulatePocket(Chain, Lo, C, New);
+  TriangulatePocket(Chain, C, Hi, New);
+  if (Side(Chain[Lo], Chain[Hi], Points[Chain[C]]) > 0)
+    New.push_back(triangle(Chain[Lo], Chain[Hi], Chain[C]));
+  else
+    New.push_back(triangle(Chain[Hi], Chain[Lo], Chain[C]));
+} /* End of 'tcg::math::delaunay::TriangulatePocket' function */
+
+/* Insert constrained edge function.
+ * Triangles crossed by edge are replaced with constrained Delaunay
+ * triangulation of pockets on both edge sides, edge is split in points
+ * lying on it and in crossings with other constrained edges.
+ * ARGUMENTS:
+ *   - edge points indices:
+ *       INT A, INT B;
+ *   - stock of points split edge to fill (in order from A to B):
+ *       std::vector<INT> &Splits;
+ * RETURNS:
+ *   (BOOL) TRUE if edge is inserted, FALSE otherwise.
+ */
+BOOL tcg::math::delaunay::InsertEdge( INT A, INT B, std::vector<INT> &Splits )
+{
+  std::vector<INT> Fan, Killed, Chain[2];
+  std::vector<triangle> New;
+
+  while (A != B)
+  {
+    DOUBLE Len = (Points[B] - Points[A]).Length2D(), Tolerance = Threshold * 1000 * Len;
+    INT T = -1, k = 0, End = -1;
+
+    // Triangle around A with edge crossed by AB or point lying on AB.
+    GetFan(A, Fan);
+    for (INT i = 0; i < Fan.size() && T == -1 && End == -1; i++)
+    {
+      for (k = 0; Triangles[Fan[i]].P[k] != A; k++)
+        ;
+      INT X = Triangles[Fan[i]].P[(k + 1) % 3], Y = Triangles[Fan[i]].P[(k + 2) % 3];
+
+      if (X == B || Y == B)
+        End = B;
+      else if (fabs(Side(A, B, Points[X])) < Tolerance && ((Points[X] - Points[A]) & (Points[B] - Points[A])) > 0)
+        End = X;
+      else if (fabs(Side(A, B, Points[Y])) < Tolerance && ((Points[Y] - Points[A]) & (Points[B] - Points[A])) > 0)
+        End = Y;
+      else if (Side(A, X, Points[B]) > 0 && Side(Y, A, Points[B]) > 0)
+        T = Fan[i];
+    }
+    if (T == -1 && End == -1)
+      return FALSE;
+
+    if (End == -1)
+    {
+      // Walk through triangles crossed by AB, edge UW is crossed one.
+      INT e = (k + 1) % 3, Cross = -1;
+
+      Killed.clear();
+      Killed.push_back(T);
+      Chain[0].clear();
+      Chain[1].clear();
+      Chain[0].push_back(A);
+      Chain[1].push_back(A);
+      while (End == -1)
+      {
+        INT
+          U = Triangles[T].P[e], W = Triangles[T].P[(e + 1) % 3],
+          Next = Neighbours[T].T[e], j;
+
+        if (IsConstrained(U, W))
+        {
+          Cross = e;
+          break;
+        }
+        if (Next == -1)
+          return FALSE;
+        if (Chain[Side(A, B, Points[U]) > 0].back() != U)
+          Chain[Side(A, B, Points[U]) > 0].push_back(U);
+        if (Chain[Side(A, B, Points[W]) > 0].back() != W)
+          Chain[Side(A, B, Points[W]) > 0].push_back(W);
+
+        for (j = 0; Triangles[Next].P[j] != W; j++)
+          ;
+        INT V = Triangles[Next].P[(j + 2) % 3];
+
+        T = Next;
+        Killed.push_back(T);
+        if (V == B || fabs(Side(A, B, Points[V])) < Tolerance)
+          End = V;
+        else if ((Side(A, B, Points[V]) > 0) == (Side(A, B, Points[U]) > 0))
+          e = (j + 2) % 3;
+        else
+          e = (j + 1) % 3;
+      }
+
+      if (Cross != -1)
+      {
+        // Split AB and crossed constrained edge in their crossing point.
+        INT U = Triangles[T].P[Cross], W = Triangles[T].P[(Cross + 1) % 3];
+        DOUBLE
+          su = Side(A, B, Points[U]), sw = Side(A, B, Points[W]);
+        INT X = Insert(Points[U] + (Points[W] - Points[U]) * (su / (su - sw)));
+
+        // Crossing may coincide with crossed edge point.
+        if (X == -1 || (X != A && X != U && X != W && IsConstrained(U, W)))
+          return FALSE;
+        if (X == A)
+        {
+          // A is too close to crossed constrained edge - pass it through A.
+          std::vector<INT> Tmp;
+
+          Constraints.erase(std::pair<INT, INT>(COM_MIN(U, W), COM_MAX(U, W)));
+          if (!InsertEdge(U, A, Tmp) || !InsertEdge(A, W, Tmp))
+            return FALSE;
+          continue;
+        }
+        if (X != B)
+        {
+          if (!InsertEdge(A, X, Splits))
+            return FALSE;
+          Splits.push_back(X);
+        }
+        A = X;
+        continue;
+      }
+
+      // Collect pocket border with outer neighbours and remove crossed triangles.
+      std::vector<INT> Border, Outer;
+
+      for (INT i = 0; i < Killed.size(); i++)
+        for (INT e = 0; e < 3; e++)
+          if (std::find(Killed.begin(), Killed.end(), Neighbours[Killed[i]].T[e]) == Killed.end())
+          {
+            Border.push_back(Triangles[Killed[i]].P[e]);
+            Border.push_back(Triangles[Killed[i]].P[(e + 1) % 3]);
+            Outer.push_back(Neighbours[Killed[i]].T[e]);
+          }
+      for (INT i = 0; i < Killed.size(); i++)
+      {
+        Triangles[Killed[i]] = triangle(-1, -1, -1);
+        FreeSlots.push_back(Killed[i]);
+        Changed.push_back(Killed[i]);
+      }
+
+      New.clear();
+      for (INT s = 0; s < 2; s++)
+      {
+        Chain[s].push_back(End);
+        TriangulatePocket(Chain[s], 0, Chain[s].size() - 1, New);
+      }
+
+      // Create new triangles and link them with each other and with pocket border.
+      std::vector<INT> Slots;
+
+      for (INT i = 0; i < New.size(); i++)
+        Slots.push_back(Create(New[i].P[0], New[i].P[1], New[i].P[2], -1, -1, -1));
+      for (INT i = 0; i < New.size(); i++)
+        for (INT e = 0; e < 3; e++)
+        {
+          INT P0 = New[i].P[e], P1 = New[i].P[(e + 1) % 3];
+
+          for (INT b = 0; b < Outer.size(); b++)
+            if (Border[b * 2] == P0 && Border[b * 2 + 1] == P1)
+            {
+              Neighbours[Slots[i]].T[e] = Outer[b];
+              Link(Outer[b], P1, P0, Slots[i]);
+            }
+          for (INT n = 0; n < New.size(); n++)
+            for (INT m = 0; m < 3; m++)
+              if (New[n].P[m] == P1 && New[n].P[(m + 1) % 3] == P0)
+                Neighbours[Slots[i]].T[e] = Slots[n];
+        }
+      LastTriangle = Slots[0];
+    }
+
+    Constraints.insert(std::pair<INT, INT>(COM_MIN(A, End), COM_MAX(A, End)));
+    if (End != B)
+      Splits.push_back(End);
+    A = End;
+  }
+  return TRUE;
+} /* End of 'tcg::math::delaunay::InsertEdge' function */
+
+/* Find triangulation point nearest to point function.
+ * ARGUMENTS:
+ *   - point:
+ *       const vec &Point;
+ * RETURNS:
+ *   (INT) nearest point of triangle with point, -1 if point is out of triangulation.
+ */
+INT tcg::math::delaunay::Find( const vec &Point )
+{
+  INT T = Locate(Point), V = 0;
+  if (T == -1)
+    return -1;
+
+  for (INT k = 1; k < 3; k++)
+    if ((Points[Triangles[T].P[k]] - Point).Length2D() < (Points[Triangles[T].P[V]] - Point).Length2D())
+      V = k;
+  return Triangles[T].P[V];
+} /* End of 'tcg::math::delaunay::Find' function */
+
+/* Remove point by index function.
+ * Hull and constrained edges points are not removed. Removed point stays
+ * in points stock (indices are kept), its place is reused by 'Insert'.
+ * ARGUMENTS:
+ *   - point index:
+ *       INT Index;
+ * RETURNS:
+ *   (BOOL) TRUE if point is removed, FALSE otherwise.
+ */
+BOOL tcg::math::delaunay::RemoveIndex( INT Index )
+{
+  INT V = Index, T0, T;
+  std::vector<INT> Fan;
+
+  GetFan(V, Fan);
+  if (Fan.size() == 0)
+    return FALSE;
+  T0 = Fan[0];
+
+  // Star of point: triangles (V, Ring[i], Ring[i + 1]) with Outer[i] neighbours.
+  std::vector<INT> Ring, Outer, Star;
+
+  T = T0;
+  do
+  {
+    INT k;
+
+    for (k = 0; Triangles[T].P[k] != V; k++)
+      ;
+    Ring.push_back(Triangles[T].P[(k + 1) % 3]);
+    Outer.push_back(Neighbours[T].T[(k + 1) % 3]);
+    Star.push_back(T);
+    if ((T = Neighbours[T].T[(k + 2) % 3]) == -1)
+      return FALSE;
+  } while (T != T0);
+
+  for (INT i = 0; i < Ring.size(); i++)
+    if (IsConstrained(V, Ring[i]))
+      return FALSE;
+  for (INT i = 0; i < Star.size(); i++)
+  {
+    Triangles[Star[i]] = triangle(-1, -1, -1);
+    FreeSlots.push_back(Star[i]);
+    Changed.push_back(Star[i]);
+  }
+
+  // Cut ears with empty circumcircles from star polygon.
+  while (Ring.size() > 3)
+  {
+    INT m = Ring.size(), Ear = -1;
+
+    for (INT pass = 0; pass < 2 && Ear == -1; pass++)
+      for (INT i = 0; i < m && Ear == -1; i++)
+      {
+        INT A = Ring[(i + m - 1) % m], B = Ring[i], C = Ring[(i + 1) % m];
+        BOOL IsEmpty = TRUE;
+
+        if (Side(A, B, Points[C]) <= 0)
+          continue;
+        for (INT j = (i + 2) % m; IsEmpty && j != (i + m - 1) % m; j = (j + 1) % m)
+          if (pass == 0)
+            IsEmpty = !InCircle(A, B, C, Ring[j]);
+          else
+            IsEmpty = Side(A, B, Points[Ring[j]]) <= 0 || Side(B, C, Points[Ring[j]]) <= 0 || Side(C, A, Points[Ring[j]]) <= 0;
+        if (IsEmpty)
+          Ear = i;
+      }
+    if (Ear == -1)
+      Ear = 0;
+
+    INT
+      Prev = (Ear + m - 1) % m,
+      A = Ring[Prev], B = Ring[Ear], C = Ring[(Ear + 1) % m],
+      N = Create(A, B, C, Outer[Prev], Outer[Ear], -1);
+
+    Link(Outer[Prev], B, A, N);
+    Link(Outer[Ear], C, B, N);
+    Outer[Prev] = N;
+    Ring.erase(Ring.begin() + Ear);
+    Outer.erase(Outer.begin() + Ear);
+  }
+  LastTriangle = Create(Ring[0], Ring[1], Ring[2], Outer[0], Outer[1], Outer[2]);
+  Link(Outer[0], Ring[1], Ring[0], LastTriangle);
+  Link(Outer[1], Ring[2], Ring[1], LastTriangle);
+  Link(Outer[2], Ring[0], Ring[2], LastTriangle);
+  Incident[V] = -1;
+  FreePoints.push_back(V);
+  return TRUE;
+} /* End of 'tcg::math::delaunay::RemoveIndex' function */
+
+/* Remove point function.
+ * Triangle with point is found and its vertex nearest to point is removed
+ * (see 'RemoveIndex').
+ * ARGUMENTS:
+ *   - point:
+ *       const vec &Point;
+ * RETURNS:
+ *   (INT) removed point index, -1 if nothing is removed.
+ */
+INT tcg::math::delaunay::Remove( const vec &Point )
+{
+  INT V = Find(Point);
+
+  return V != -1 && RemoveIndex(V) ? V : -1;
+} /* End of 'tcg::math::delaunay::Remove' function */
+
+/* Get triangles function.
+ * ARGUMENTS:
+ *   - stock of triangles to fill:
+ *       std::vector<triangle> &Triangles;
+ * RETURNS: None.
+ */
+VOID tcg::math::delaunay::GetTriangles( std::vector<triangle> &Triangles ) const
+{
+  Triangles.clear();
+  for (INT i = 0; i < this->Triangles.size(); i++)
+    if (this->Triangles[i].P[0] != -1)
+      Triangles.push_back(this->Triangles[i]);
+} /* End of 'tcg::math::delaunay::GetTriangles' function */
+
+/* END OF 'delaunay.cpp' FILE */
@@ -4,27 +4,131 @@
 #define __noise_h_
 
 #include <cstdlib>
+#include <cstdint>
 
 #include "../def.h"
 #include "math.h"
+#include "noise_simd.h"
 
 #include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 namespace tcg
 {
   namespace math
   {
-    /* Perlin's noise representation class. */
-    class noise
+    /* Noise lattice tables class (common for all noise engines).
+     * Template parameters are noise samples precision and tables size in bits
+     * (power of 2, up to 16 for 16-bit permutations). For the same seed all
+     * engines get the same tables.
+     * Tables are immutable and shared through process-wide cache keyed by seed,
+     * they are built in O(SIZE) by counter-based generator (same on all platforms).
+     */
+    template<class type, int Bits>
+    class noise_tables
     {
-    private:
-      static const int BITS = 14;          // Noise table size in bits
+    protected:
+      static_assert(Bits > 0 && Bits <= 16, "Noise table size must fit 16-bit permutations");
+
+      static const int BITS = Bits;        // Noise table size in bits
       static const int SIZE = (1 << BITS); // Noise table size
       static const int MASK = (SIZE - 1);  // Mask for computing with module
-      int RandSeed;                        // Current random value
 
-      double Table[SIZE];                  // Noise table: random values for interpolation
-      int Perm[SIZE];                      // Permutations table: noise table elements indices
+      /* Tables data representation type */
+      struct data
+      {
+        type Table[SIZE];                  // Noise table: random values for interpolation
+        uint16_t Perm[SIZE + 1];           // Permutations table: noise table elements indices (+1 padding for SIMD gathers)
+      }; /* End of 'data' structure */
+
+      std::shared_ptr<const data> Data;    // Shared tables data
+      const type *Table;                   // Noise table
+      const uint16_t *Perm;                // Permutations table
+
+    private:
+      static const int CACHE_SIZE = 16;    // Number of recently used seeds kept in cache
+
+      static std::mutex CacheMutex;                                 // Cache access lock
+      static std::map<int, std::shared_ptr<const data>> Cache;      // Tables by seed
+      static std::deque<int> CacheOrder;                            // Seeds in cache order
+
+      /* Counter-based random value obtain function (SplitMix64 mixing).
+       * ARGUMENTS:
+       *   - stream key (seed):
+       *       UINT64 Key;
+       *   - counter:
+       *       UINT64 Counter;
+       * RETURNS:
+       *   (UINT64) random value.
+       */
+      static UINT64 Random(UINT64 Key, UINT64 Counter)
+      {
+        UINT64 z = Key + (Counter + 1) * 0x9E3779B97F4A7C15ULL;
+
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+      } /* End of 'Random' function */
+
+      /* Build tables for seed function.
+       * ARGUMENTS:
+       *   - random seed:
+       *       int Seed;
+       * RETURNS:
+       *   (std::shared_ptr<const data>) new tables.
+       */
+      static std::shared_ptr<const data> Build(int Seed)
+      {
+        std::shared_ptr<data> d = std::make_shared<data>();
+        UINT64 Key = Random((UINT)Seed, ~0ULL);
+
+        /* Values in [0, 1) from 53 random bits */
+        for (int i = 0; i < SIZE; i++)
+          d->Table[i] = (type)((Random(Key, i) >> 11) * (1.0 / 9007199254740992.0));
+
+        /* Single Fisher-Yates shuffle */
+        for (int i = 0; i < SIZE; i++)
+          d->Perm[i] = i;
+        for (int i = SIZE - 1; i > 0; i--)
+        {
+          int j = (int)(((Random(Key, SIZE + i) >> 32) * (UINT64)(i + 1)) >> 32);
+          uint16_t tmp = d->Perm[i];
+
+          d->Perm[i] = d->Perm[j];
+          d->Perm[j] = tmp;
+        }
+        d->Perm[SIZE] = d->Perm[0];
+        return d;
+      } /* End of 'Build' function */
+
+      /* Obtain (cached) tables for seed function.
+       * ARGUMENTS:
+       *   - random seed:
+       *       int Seed;
+       * RETURNS:
+       *   (std::shared_ptr<const data>) tables.
+       */
+      static std::shared_ptr<const data> Obtain(int Seed)
+      {
+        std::lock_guard<std::mutex> Lock(CacheMutex);
+        auto it = Cache.find(Seed);
+
+        if (it != Cache.end())
+          return it->second;
+        if ((int)CacheOrder.size() == CACHE_SIZE)
+        {
+          /* Instances still using evicted tables keep their own references */
+          Cache.erase(CacheOrder.front());
+          CacheOrder.pop_front();
+        }
+        CacheOrder.push_back(Seed);
+        return Cache[Seed] = Build(Seed);
+      } /* End of 'Obtain' function */
+
+    protected:
 
       /* Permutated 1D index obtain function.
        * ARGUMENTS:
@@ -90,9 +194,9 @@ namespace tcg
        *   - element index:
        *       int Index;
        * RETURNS:
-       *   (double) noise table value.
+       *   (type) noise table value.
        */
-      double GetTable(int Index) const
+      type GetTable(int Index) const
       {
         return Table[Index];
       } /* End of 'GetTable' function */
@@ -109,41 +213,67 @@ namespace tcg
         return Perm[Index];
       } /* End of 'GetPerm' function */
 
-      /* Constructor (noise and permision tables initialisation).
+      /* Constructor (noise and permision tables obtaining).
        * ARGUMENTS:
        *   - random seed start value:
        *       int RandomSeed;
        */
-      noise(int RandomSeed = 30 * 59)
+      noise_tables(int RandomSeed) : Data(Obtain(RandomSeed)), Table(Data->Table), Perm(Data->Perm)
       {
-        int Test = 0;
+      } /* End of 'noise_tables' constructor */
+    }; /* End of 'noise_tables' class */
 
-        srand(RandomSeed);
-        for (int i = 0; i < SIZE; i++)
-          Table[i] = rand0();
-        for (int i = 0; i < SIZE; i++)
-          Perm[i] = i;
-        for (int i = 0; i < 30 * SIZE; i++)
-        {
-          int tmp, t1 = ::rand() & MASK, t2 = ::rand() & MASK;
+    /* Tables cache static members */
+    template<class type, int Bits>
+      std::mutex noise_tables<type, Bits>::CacheMutex;
+    template<class type, int Bits>
+      std::map<int, std::shared_ptr<const typename noise_tables<type, Bits>::data>> noise_tables<type, Bits>::Cache;
+    template<class type, int Bits>
+      std::deque<int> noise_tables<type, Bits>::CacheOrder;
 
-          tmp = Perm[t1];
-          Perm[t1] = Perm[t2];
-          Perm[t2] = tmp;
-        }
-      } /* End of 'noise' constructor */
+    /* Perlin's noise representation class.
+     * Template parameters are noise samples (and interpolation) precision
+     * and tables size in bits: smaller tables stay cache resident, e.g.
+     * 'basic_noise<float, 12>' takes 24 KB against 160 KB of default 'noise'.
+     * Coordinates are always double.
+     */
+    template<class type = double, int Bits = 14>
+    class basic_noise : public noise_tables<type, Bits>
+    {
+    public:
+      typedef type sample;                 // Noise sample type
+
+    private:
+      typedef noise_tables<type, Bits> tables;
+
+      using tables::BITS;
+      using tables::SIZE;
+      using tables::MASK;
+      using tables::Table;
+      using tables::Perm;
+      using tables::Index;
+
+    public:
+      /* Constructor (noise and permision tables initialisation).
+       * ARGUMENTS:
+       *   - random seed start value:
+       *       int RandomSeed;
+       */
+      basic_noise(int RandomSeed = 30 * 59) : tables(RandomSeed)
+      {
+      } /* End of 'basic_noise' constructor */
 
       /* Noise (one-dimensional) random value generation function.
        * ARGUMENTS:
        *   - noise function argument:
        *       double X;
        * RETURNS:
-       *   (double) noise random value.
+       *   (type) noise random value.
        */
-      double Noise(double X)
+      type Noise(double X)
       {
         int ix, ix1;
-        double fx;
+        type fx;
 
         if (X < 0)
           X = fmod(SIZE - X, SIZE);
@@ -161,12 +291,12 @@ namespace tcg
        *   - noise function arguments:
        *       double X, Y;
        * RETURNS:
-       *   (double) noise random value.
+       *   (type) noise random value.
        */
-      double Noise(double X, double Y)
+      type Noise(double X, double Y)
       {
         int ix, ix1, iy, iy1;
-        double fx, fy;
+        type fx, fy;
 
         if (X < 0)
           X = fmod(SIZE - X, SIZE);
@@ -190,17 +320,65 @@ namespace tcg
           Table[Index(ix1, iy1)] * fx * fy;
       } /* End of 'Noise' function */
 
+      /* Noise (two-dimensional) random value with gradient generation function.
+       * Gradient is analytic (smoothstep fade derivative), value is equal
+       * to 'Noise(X, Y)' result.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y;
+       *   - noise gradient (Z component is zero):
+       *       vec &Grad;
+       * RETURNS:
+       *   (type) noise random value.
+       */
+      type NoiseD(double X, double Y, vec &Grad)
+      {
+        int ix, ix1, iy, iy1;
+        type fx, fy, dx, dy;
+        double sx = 1, sy = 1;
+
+        /* Negative arguments are mirrored, so are derivatives */
+        if (X < 0)
+          X = fmod(SIZE - X, SIZE), sx = -1;
+        if (Y < 0)
+          Y = fmod(SIZE - Y, SIZE), sy = -1;
+
+        ix = (int)X & MASK;
+        ix1 = (ix + 1) & MASK;
+        fx = X - (int)X;
+        dx = 6 * fx * (1 - fx);
+        fx = fx * fx * (3 - 2 * fx);
+
+        iy = (int)Y & MASK;
+        iy1 = (iy + 1) & MASK;
+        fy = Y - (int)Y;
+        dy = 6 * fy * (1 - fy);
+        fy = fy * fy * (3 - 2 * fy);
+
+        type
+          c0 = Table[Index(ix, iy)], c1 = Table[Index(ix1, iy)],
+          c2 = Table[Index(ix, iy1)], c3 = Table[Index(ix1, iy1)];
+
+        Grad = vec(sx * dx * ((c1 - c0) * (1 - fy) + (c3 - c2) * fy),
+                   sy * dy * ((c2 - c0) * (1 - fx) + (c3 - c1) * fx), 0);
+        return
+          c0 * (1 - fx) * (1 - fy) +
+          c1 * fx * (1 - fy) +
+          c2 * (1 - fx) * fy +
+          c3 * fx * fy;
+      } /* End of 'NoiseD' function */
+
       /* Noise (three-dimensional) random value generation function.
        * ARGUMENTS:
        *   - noise function arguments:
        *       double X, Y, Z;
        * RETURNS:
-       *   (double) noise random value.
+       *   (type) noise random value.
        */
-      double Noise(double X, double Y, double Z)
+      type Noise(double X, double Y, double Z)
       {
         int ix, ix1, iy, iy1, iz, iz1;
-        double fx, fy, fz;
+        type fx, fy, fz;
 
         if (X < 0)
           X = fmod(SIZE - X, SIZE);
@@ -235,17 +413,101 @@ namespace tcg
           Table[Index(ix1, iy1, iz1)] * fx * fy * fz;
       } /* End of 'Noise' function */
 
+      /* Noise (three-dimensional) random value with gradient generation function.
+       * Gradient is analytic (smoothstep fade derivative), value is equal
+       * to 'Noise(X, Y, Z)' result.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y, Z;
+       *   - noise gradient:
+       *       vec &Grad;
+       * RETURNS:
+       *   (type) noise random value.
+       */
+      type NoiseD(double X, double Y, double Z, vec &Grad)
+      {
+        int ix, ix1, iy, iy1, iz, iz1;
+        type fx, fy, fz, dx, dy, dz;
+        double sx = 1, sy = 1, sz = 1;
+
+        /* Negative arguments are mirrored, so are derivatives */
+        if (X < 0)
+          X = fmod(SIZE - X, SIZE), sx = -1;
+        if (Y < 0)
+          Y = fmod(SIZE - Y, SIZE), sy = -1;
+        if (Z < 0)
+          Z = fmod(SIZE - Z, SIZE), sz = -1;
+
+        ix = (int)X & MASK;
+        ix1 = (ix + 1) & MASK;
+        fx = X - (int)X;
+        dx = 6 * fx * (1 - fx);
+        fx = fx * fx * (3 - 2 * fx);
+
+        iy = (int)Y & MASK;
+        iy1 = (iy + 1) & MASK;
+        fy = Y - (int)Y;
+        dy = 6 * fy * (1 - fy);
+        fy = fy * fy * (3 - 2 * fy);
+
+        iz = (int)Z & MASK;
+        iz1 = (iz + 1) & MASK;
+        fz = Z - (int)Z;
+        dz = 6 * fz * (1 - fz);
+        fz = fz * fz * (3 - 2 * fz);
+
+        type
+          c0 = Table[Index(ix, iy, iz)], c1 = Table[Index(ix1, iy, iz)],
+          c2 = Table[Index(ix, iy1, iz)], c3 = Table[Index(ix1, iy1, iz)],
+          c4 = Table[Index(ix, iy, iz1)], c5 = Table[Index(ix1, iy, iz1)],
+          c6 = Table[Index(ix, iy1, iz1)], c7 = Table[Index(ix1, iy1, iz1)];
+
+        Grad = vec(sx * dx * (((c1 - c0) * (1 - fy) + (c3 - c2) * fy) * (1 - fz) +
+                              ((c5 - c4) * (1 - fy) + (c7 - c6) * fy) * fz),
+                   sy * dy * (((c2 - c0) * (1 - fx) + (c3 - c1) * fx) * (1 - fz) +
+                              ((c6 - c4) * (1 - fx) + (c7 - c5) * fx) * fz),
+                   sz * dz * (((c4 - c0) * (1 - fx) + (c5 - c1) * fx) * (1 - fy) +
+                              ((c6 - c2) * (1 - fx) + (c7 - c3) * fx) * fy));
+        return
+          c0 * (1 - fx) * (1 - fy) * (1 - fz) +
+          c1 * fx * (1 - fy) * (1 - fz) +
+          c2 * (1 - fx) * fy * (1 - fz) +
+          c3 * fx * fy * (1 - fz) +
+          c4 * (1 - fx) * (1 - fy) * fz +
+          c5 * fx * (1 - fy) * fz +
+          c6 * (1 - fx) * fy * fz +
+          c7 * fx * fy * fz;
+      } /* End of 'NoiseD' function */
+
+      /* Noise (three-dimensional) batch random values generation function.
+       * Uses AVX2/SSE4.1 kernels when available, results are equal
+       * to per point 'Noise(X, Y, Z)' calls (see 'noise_simd.h').
+       * ARGUMENTS:
+       *   - noise function arguments (SoA arrays):
+       *       const double *X, *Y, *Z;
+       *   - result values array:
+       *       type *Res;
+       *   - number of points:
+       *       int N;
+       * RETURNS: None.
+       */
+      void Noise(const double *X, const double *Y, const double *Z, type *Res, int N)
+      {
+        for (int i = simd::Noise3(Table, Perm, BITS, X, Y, Z, Res, N); i < N; i++)
+          Res[i] = Noise(X[i], Y[i], Z[i]);
+      } /* End of 'Noise' function */
+
       /* Noise (four-dimensional) random value generation function.
        * ARGUMENTS:
        *   - noise function arguments:
        *       double X, Y, Z, W;
        * RETURNS:
-       *   (double) noise random value.
+       *   (type) noise random value.
        */
-      double Noise(double X, double Y, double Z, double W)
+      type Noise(double X, double Y, double Z, double W)
       {
         int ix, ix1, iy, iy1, iz, iz1, iw, iw1;
-        double fx, fy, fz, fw;
+        type fx, fy, fz, fw;
 
         if (X < 0)
           X = fmod(SIZE - X, SIZE);
@@ -367,20 +629,51 @@ namespace tcg
         return sum / denum;
       } /* End of 'Turb' function */
 
-      /* Noise (three-dimensional) random value (with turbulence) generation function.
+      /* Noise (two-dimensional) random value (with turbulence) and its gradient generation function.
        * ARGUMENTS:
        *   - noise function arguments:
-       *       double X, Y, Z;
+       *       double X, Y;
        *   - number of turbulence steps (octaves)
        *       int Oct;
+       *   - turbulence gradient (Z component is zero):
+       *       vec &Grad;
        * RETURNS:
        *   (double) noise random value.
        */
+      double TurbD(double X, double Y, int Oct, vec &Grad)
+      {
+        double sum = 0, coef = 1, denum = 0;
+        vec g;
+
+        Grad = vec(0);
+        for (int i = 0; i < Oct; i++)
+        {
+          sum += NoiseD(X, Y, g) / coef;
+          Grad += g;
+          denum += 1 / coef;
+          X *= 2;
+          Y *= 2;
+          coef *= 2;
+        }
+        Grad /= denum;
+        return sum / denum;
+      } /* End of 'TurbD' function */
+
+      /* Turbulence height field (Y = Turb(X, Z)) normal obtain function.
+       * ARGUMENTS:
+       *   - height field point coordinates:
+       *       double X, Z;
+       *   - number of turbulence steps (octaves)
+       *       int Oct;
+       * RETURNS:
+       *   (vec) height field normal.
+       */
       vec TurbNorm(double X, double Z, int Oct)
       {
-        vec p = vec(X, Turb(X, Z, Oct), Z);
-        return ((vec(X, Turb(X, Z + math::ThresholdFloat, Oct), Z + math::ThresholdFloat) - p) %
-                (vec(X + math::ThresholdFloat, Turb(X + math::ThresholdFloat, Z, Oct), Z) - p)).Normalizing();
+        vec g;
+
+        TurbD(X, Z, Oct, g);
+        return vec(-g.X, 1, -g.Y).Normalizing();
       } /* End of 'TurbNorm' function */
 
       /* Noise (four-dimensional) random value (with turbulence) generation function.
@@ -408,62 +701,713 @@ namespace tcg
         }
         return sum / denum;
       } /* End of 'Turb' function */
-    }; /* End of 'noise' class */
+    }; /* End of 'basic_noise' class */
+
+    /* Default (double precision, 16384 elements tables) noise, GPU preview uses its tables */
+    typedef basic_noise<> noise;
+
+    /* Simplex noise representation class.
+     * Uses the same tables (and seed semantics) as 'basic_noise', but
+     * interpolates 4 simplex corners in 3D (3 in 2D, 5 in 4D) with
+     * gradients chosen by permutation chain. Result is remapped to the
+     * value noise [0, 1] range, so both engines fit the same fBm parameters.
+     */
+    template<class type = double, int Bits = 14>
+    class basic_simplex_noise : public noise_tables<type, Bits>
+    {
+    public:
+      typedef type sample;                 // Noise sample type
+
+    private:
+      typedef noise_tables<type, Bits> tables;
+
+      using tables::MASK;
+      using tables::Index;
+
+      /* Floor to integer function.
+       * ARGUMENTS:
+       *   - value:
+       *       double X;
+       * RETURNS:
+       *   (int) floor value.
+       */
+      static int Floor(double X)
+      {
+        int i = (int)X;
+
+        return X < i ? i - 1 : i;
+      } /* End of 'Floor' function */
+
+      /* Gradient (12 cube edges directions, 4 repeated to avoid division) obtain function.
+       * ARGUMENTS:
+       *   - permutated corner index:
+       *       int Hash;
+       * RETURNS:
+       *   (const type *) gradient vector (3 components).
+       */
+      static const type * Grad3(int Hash)
+      {
+        static const type G[16][3] =
+        {
+          {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0},
+          {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+          {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1},
+          {1, 1, 0}, {-1, 1, 0}, {0, -1, 1}, {0, -1, -1}
+        };
+
+        return G[Hash & 15];
+      } /* End of 'Grad3' function */
+
+      /* Gradient (32 tesseract edges directions) obtain function.
+       * ARGUMENTS:
+       *   - permutated corner index:
+       *       int Hash;
+       * RETURNS:
+       *   (const type *) gradient vector (4 components).
+       */
+      static const type * Grad4(int Hash)
+      {
+        static const type G[32][4] =
+        {
+          {0, 1, 1, 1}, {0, 1, 1, -1}, {0, 1, -1, 1}, {0, 1, -1, -1},
+          {0, -1, 1, 1}, {0, -1, 1, -1}, {0, -1, -1, 1}, {0, -1, -1, -1},
+          {1, 0, 1, 1}, {1, 0, 1, -1}, {1, 0, -1, 1}, {1, 0, -1, -1},
+          {-1, 0, 1, 1}, {-1, 0, 1, -1}, {-1, 0, -1, 1}, {-1, 0, -1, -1},
+          {1, 1, 0, 1}, {1, 1, 0, -1}, {1, -1, 0, 1}, {1, -1, 0, -1},
+          {-1, 1, 0, 1}, {-1, 1, 0, -1}, {-1, -1, 0, 1}, {-1, -1, 0, -1},
+          {1, 1, 1, 0}, {1, 1, -1, 0}, {1, -1, 1, 0}, {1, -1, -1, 0},
+          {-1, 1, 1, 0}, {-1, 1, -1, 0}, {-1, -1, 1, 0}, {-1, -1, -1, 0}
+        };
+
+        return G[Hash & 31];
+      } /* End of 'Grad4' function */
+
+      /* Simplex corner (three-dimensional) contribution function.
+       * ARGUMENTS:
+       *   - offset from corner:
+       *       type X, Y, Z;
+       *   - permutated corner index:
+       *       int Hash;
+       *   - gradient accumulator (can be nullptr):
+       *       type *D;
+       * RETURNS:
+       *   (type) corner contribution.
+       */
+      static type Corner(type X, type Y, type Z, int Hash, type *D)
+      {
+        type t = (type)0.5 - X * X - Y * Y - Z * Z;
+        const type *g = Grad3(Hash);
+
+        /* Corners outside of the kernel radius give zeros (branchless max(t, 0)) */
+        t = (t + fabs(t)) * (type)0.5;
+        type
+          t2 = t * t,
+          dot = g[0] * X + g[1] * Y + g[2] * Z;
+
+        if (D != nullptr)
+        {
+          type c = -8 * t2 * t * dot;
+
+          D[0] += c * X + t2 * t2 * g[0];
+          D[1] += c * Y + t2 * t2 * g[1];
+          D[2] += c * Z + t2 * t2 * g[2];
+        }
+        return t2 * t2 * dot;
+      } /* End of 'Corner' function */
+
+      /* Noise (three-dimensional) simplex sum with gradient evaluation function.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y, Z;
+       *   - gradient (3 components, can be nullptr):
+       *       type *D;
+       * RETURNS:
+       *   (type) unscaled corners sum.
+       */
+      type Sum3(double X, double Y, double Z, type *D)
+      {
+        const double F3 = 1.0 / 3, G3 = 1.0 / 6;
+        double s = (X + Y + Z) * F3;
+        int i = Floor(X + s), j = Floor(Y + s), k = Floor(Z + s);
+        double t = (i + j + k) * G3;
+        type
+          x0 = (type)(X - (i - t)), y0 = (type)(Y - (j - t)), z0 = (type)(Z - (k - t));
+
+        /* Simplex (of 6 in the skewed cube) selection by coordinates ranks
+         * (largest coordinate is stepped first), no unpredictable branches */
+        int
+          rx = (x0 >= y0) + (x0 >= z0), ry = (x0 < y0) + (y0 >= z0), rz = (x0 < z0) + (y0 < z0),
+          i1 = rx == 2, j1 = ry == 2, k1 = rz == 2,
+          i2 = rx >= 1, j2 = ry >= 1, k2 = rz >= 1;
 
-    class fBm_multi_ridged
+        type g3 = (type)G3;
+
+        if (D != nullptr)
+          D[0] = D[1] = D[2] = 0;
+        i &= MASK, j &= MASK, k &= MASK;
+        return
+          Corner(x0, y0, z0, Index(i, j, k), D) +
+          Corner(x0 - i1 + g3, y0 - j1 + g3, z0 - k1 + g3, Index(i + i1, j + j1, k + k1), D) +
+          Corner(x0 - i2 + 2 * g3, y0 - j2 + 2 * g3, z0 - k2 + 2 * g3, Index(i + i2, j + j2, k + k2), D) +
+          Corner(x0 - 1 + 3 * g3, y0 - 1 + 3 * g3, z0 - 1 + 3 * g3, Index(i + 1, j + 1, k + 1), D);
+      } /* End of 'Sum3' function */
+
+    public:
+      /* Constructor (noise and permision tables initialisation).
+       * ARGUMENTS:
+       *   - random seed start value:
+       *       int RandomSeed;
+       */
+      basic_simplex_noise(int RandomSeed = 30 * 59) : tables(RandomSeed)
+      {
+      } /* End of 'basic_simplex_noise' constructor */
+
+      /* Noise (two-dimensional) random value generation function.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y;
+       * RETURNS:
+       *   (type) noise random value.
+       */
+      type Noise(double X, double Y)
+      {
+        const double F2 = 0.5 * (sqrt(3.0) - 1), G2 = (3 - sqrt(3.0)) / 6;
+        double s = (X + Y) * F2;
+        int i = Floor(X + s), j = Floor(Y + s), i1, j1;
+        double t = (i + j) * G2;
+        type
+          x0 = (type)(X - (i - t)), y0 = (type)(Y - (j - t)),
+          g2 = (type)G2, sum = 0, x[3], y[3];
+        int h[3];
+
+        i1 = x0 > y0;
+        j1 = 1 - i1;
+        i &= MASK, j &= MASK;
+        x[0] = x0, y[0] = y0, h[0] = Index(i, j);
+        x[1] = x0 - i1 + g2, y[1] = y0 - j1 + g2, h[1] = Index(i + i1, j + j1);
+        x[2] = x0 - 1 + 2 * g2, y[2] = y0 - 1 + 2 * g2, h[2] = Index(i + 1, j + 1);
+        for (int c = 0; c < 3; c++)
+        {
+          type r = (type)0.5 - x[c] * x[c] - y[c] * y[c];
+          const type *g = Grad3(h[c]);
+
+          r = (r + fabs(r)) * (type)0.5;
+          r *= r;
+          sum += r * r * (g[0] * x[c] + g[1] * y[c]);
+        }
+        return (type)0.5 + 35 * sum;
+      } /* End of 'Noise' function */
+
+      /* Noise (three-dimensional) random value generation function.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y, Z;
+       * RETURNS:
+       *   (type) noise random value.
+       */
+      type Noise(double X, double Y, double Z)
+      {
+        return (type)0.5 + 38 * Sum3(X, Y, Z, nullptr);
+      } /* End of 'Noise' function */
+
+      /* Noise (three-dimensional) random value with gradient generation function.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y, Z;
+       *   - noise gradient:
+       *       vec &Grad;
+       * RETURNS:
+       *   (type) noise random value.
+       */
+      type NoiseD(double X, double Y, double Z, vec &Grad)
+      {
+        type D[3], v = (type)0.5 + 38 * Sum3(X, Y, Z, D);
+
+        Grad = vec(38 * D[0], 38 * D[1], 38 * D[2]);
+        return v;
+      } /* End of 'NoiseD' function */
+
+      /* Noise (three-dimensional) batch random values generation function.
+       * ARGUMENTS:
+       *   - noise function arguments (SoA arrays):
+       *       const double *X, *Y, *Z;
+       *   - result values array:
+       *       type *Res;
+       *   - number of points:
+       *       int N;
+       * RETURNS: None.
+       */
+      void Noise(const double *X, const double *Y, const double *Z, type *Res, int N)
+      {
+        for (int i = 0; i < N; i++)
+          Res[i] = Noise(X[i], Y[i], Z[i]);
+      } /* End of 'Noise' function */
+
+      /* Noise (four-dimensional) random value generation function.
+       * ARGUMENTS:
+       *   - noise function arguments:
+       *       double X, Y, Z, W;
+       * RETURNS:
+       *   (type) noise random value.
+       */
+      type Noise(double X, double Y, double Z, double W)
+      {
+        const double F4 = (sqrt(5.0) - 1) / 4, G4 = (5 - sqrt(5.0)) / 20;
+        double s = (X + Y + Z + W) * F4;
+        int i = Floor(X + s), j = Floor(Y + s), k = Floor(Z + s), l = Floor(W + s);
+        double t = (i + j + k + l) * G4;
+        type
+          x0[4] = {(type)(X - (i - t)), (type)(Y - (j - t)), (type)(Z - (k - t)), (type)(W - (l - t))},
+          g4 = (type)G4, sum = 0;
+        int rank[4] = {0, 0, 0, 0};
+
+        /* Simplex selection by coordinates magnitude ordering */
+        for (int a = 0; a < 4; a++)
+          for (int b = a + 1; b < 4; b++)
+            if (x0[a] > x0[b])
+              rank[a]++;
+            else
+              rank[b]++;
+
+        i &= MASK, j &= MASK, k &= MASK, l &= MASK;
+        for (int c = 0; c < 5; c++)
+        {
+          int o[4];
+          type p[4], r = (type)0.6;
+
+          for (int a = 0; a < 4; a++)
+          {
+            o[a] = c == 0 ? 0 : (c == 4 ? 1 : rank[a] >= 4 - c);
+            p[a] = x0[a] - o[a] + c * g4;
+            r -= p[a] * p[a];
+          }
+          if (r > 0)
+          {
+            const type *g = Grad4(Index(i + o[0], j + o[1], k + o[2], l + o[3]));
+
+            r *= r;
+            sum += r * r * (g[0] * p[0] + g[1] * p[1] + g[2] * p[2] + g[3] * p[3]);
+          }
+        }
+        return (type)0.5 + (type)13.5 * sum;
+      } /* End of 'Noise' function */
+    }; /* End of 'basic_simplex_noise' class */
+
+    /* Default simplex noise (same tables as 'noise') */
+    typedef basic_simplex_noise<> simplex_noise;
+
+    /* Noise engines (for run time selection) */
+    enum noise_engine
     {
+      NOISE_VALUE,   // Value noise ('noise')
+      NOISE_SIMPLEX  // Simplex noise ('simplex_noise')
+    }; /* End of 'noise_engine' enum */
+
+    /* Multifractal ridged fBm class, template parameter is noise engine type */
+    template<class noise_type = noise>
+    class multi_ridged
+    {
+    public:
+      static const int MAX_OCTAVES = 32; // Maximal supported number of octaves
+
     private:
-      noise Noise;
+      static const int BATCH = 256;      // Batch evaluation chunk size
+
+      /* Evaluation functions (specialized by octaves number) types */
+      typedef double (multi_ridged::*eval)(vec Point);
+      typedef double (multi_ridged::*eval_d)(vec Point, vec &Grad);
+      typedef void (multi_ridged::*eval_batch)(const double *X, const double *Y, const double *Z, double *Res, int N);
+
+      noise_type Noise;
       int Octaves;
-      double *Exponents, Dimension, Lacunarity, Offset, Gain;
+      double Exponents[MAX_OCTAVES], Dimension, Lacunarity, Offset, Gain;
+      eval Eval;                         // Point evaluation function
+      eval_d EvalD;                      // Point with gradient evaluation function
+      eval_batch EvalBatch;              // Batch evaluation function
+
+      /* Octave weight obtain function.
+       * Same as 'Maximal({0.0, Minimal({1.0, Signal * Gain})})' (NaN included),
+       * but without initializer lists and vectorizable.
+       * ARGUMENTS:
+       *   - previous octave signal:
+       *       double Signal;
+       * RETURNS:
+       *   (double) weight in [0, 1] range.
+       */
+      double Weight(double Signal) const
+      {
+        double w = Signal * Gain < 1.0 ? Signal * Gain : 1.0;
+
+        return w > 0.0 ? w : 0.0;
+      } /* End of 'Weight' function */
+
+      /* Select evaluation functions specialization function.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      template<int Oct>
+        void Bind(void)
+        {
+          Eval = &multi_ridged::Evaluate<Oct>;
+          EvalD = &multi_ridged::EvaluateD<Oct>;
+          EvalBatch = &multi_ridged::EvaluateBatch<Oct>;
+        } /* End of 'Bind' function */
+
+      /* Evaluation functions binding function object (see 'Visit') */
+      struct binder
+      {
+        multi_ridged *Fbm;               // Fractal to bind functions of
+
+        /* Constructor.
+         * ARGUMENTS:
+         *   - fractal to bind functions of:
+         *       multi_ridged *Fbm;
+         */
+        binder(multi_ridged *Fbm) : Fbm(Fbm)
+        {
+        } /* End of 'binder' constructor */
+
+        /* Bind specialization of evaluator octaves number function.
+         * ARGUMENTS:
+         *   - octaves specialized evaluator:
+         *       const fixed_type &Fixed;
+         * RETURNS: None.
+         */
+        template<class fixed_type>
+          void operator()(const fixed_type &Fixed) const
+          {
+            Fbm->template Bind<fixed_type::OCTAVES>();
+          } /* End of 'operator()' function */
+      }; /* End of 'binder' structure */
 
     public:
-      fBm_multi_ridged(double Dimension, double Lacunarity,
+      /* Constructor.
+       * Octaves number above 'MAX_OCTAVES' is clamped.
+       * ARGUMENTS:
+       *   - fractal parameters:
+       *       double Dimension, Lacunarity, Gain, Offset;
+       *   - number of octaves:
+       *       int Octaves;
+       *   - noise random seed:
+       *       int Seed;
+       */
+      multi_ridged(double Dimension, double Lacunarity,
                        double Gain, double Offset = 0,
                        int Octaves = 8, int Seed = 30 * 59) :
-                       Noise(Seed), Octaves(Octaves), Lacunarity(Lacunarity), Dimension(Dimension), Offset(Offset), Gain(Gain)
+                       Noise(Seed), Octaves(Minimal({Octaves, (int)MAX_OCTAVES})), Lacunarity(Lacunarity), Dimension(Dimension), Offset(Offset), Gain(Gain)
       {
         double frequency = 1.0;
-        Exponents = new double[Octaves];
-        for (int i = 0; i < Octaves; i++)
+        for (int i = 0; i < this->Octaves; i++)
         {
           Exponents[i] = pow(frequency, -Dimension);
           frequency *= Lacunarity;
         }
-      }
 
-      double operator()(vec Point)
-      {
-        float result, signal, weight;
+        /* Specialized (unrolled) paths for common presets */
+        Visit(binder(this));
+      } /* End of 'multi_ridged' constructor */
+
+      /* Fractal evaluator with compile time number of octaves class.
+       * It calls 'Evaluate<Oct>' and others directly (not through member
+       * function pointers), so loops templated on fractal type get unrolled
+       * octaves loop inlined. Evaluator refers to fractal, see 'Visit'. */
+      template<int Oct>
+        class fixed
+        {
+        private:
+          multi_ridged &Fbm;             // Evaluated fractal
+
+        public:
+          enum { OCTAVES = Oct };        // Octaves number (0 - run time 'Octaves' value)
 
-        int i;
+          /* Constructor.
+           * ARGUMENTS:
+           *   - evaluated fractal:
+           *       multi_ridged &Fbm;
+           */
+          explicit fixed(multi_ridged &Fbm) : Fbm(Fbm)
+          {
+          } /* End of 'fixed' constructor */
 
-        signal = fabs(Noise.Noise(Point.X, Point.Y, Point.Z));
-        signal = Offset - signal;
-        signal = signal * signal;
-        result = signal;
-        weight = 1.0;
+          /* Evaluation function (see 'multi_ridged::Evaluate').
+           * ARGUMENTS:
+           *   - point:
+           *       vec Point;
+           * RETURNS:
+           *   (double) function value.
+           */
+          double operator()(vec Point)
+          {
+            return Fbm.template Evaluate<Oct>(Point);
+          } /* End of 'operator()' function */
 
-        for (i = 1; i < Octaves; i++)
+          /* Evaluation with analytic gradient function (see 'multi_ridged::EvaluateD').
+           * ARGUMENTS:
+           *   - point:
+           *       vec Point;
+           *   - function gradient:
+           *       vec &Grad;
+           * RETURNS:
+           *   (double) function value.
+           */
+          double fBmD(vec Point, vec &Grad)
+          {
+            return Fbm.template EvaluateD<Oct>(Point, Grad);
+          } /* End of 'fBmD' function */
+
+          /* Batch evaluation function (see 'multi_ridged::EvaluateBatch').
+           * ARGUMENTS:
+           *   - points coordinates (SoA arrays):
+           *       const double *X, *Y, *Z;
+           *   - result values array:
+           *       double *Res;
+           *   - number of points:
+           *       int N;
+           * RETURNS: None.
+           */
+          void operator()(const double *X, const double *Y, const double *Z, double *Res, int N)
+          {
+            Fbm.template EvaluateBatch<Oct>(X, Y, Z, Res, N);
+          } /* End of 'operator()' function */
+        }; /* End of 'fixed' class */
+
+      /* Call function object with octaves specialized evaluator function.
+       * Octaves number is dispatched once per call, so callers visit once
+       * per rows band or batch and call the evaluator in their hot loops.
+       * ARGUMENTS:
+       *   - function object (called with 'fixed<Oct>' evaluator, Oct = 0
+       *     for octaves numbers without specialization):
+       *       const func &Func;
+       * RETURNS: None.
+       */
+      template<class func>
+        void Visit(const func &Func)
         {
-          Point *= Lacunarity;
+          switch (Octaves)
+          {
+          case 4:
+            Func(fixed<4>(*this));
+            break;
+          case 5:
+            Func(fixed<5>(*this));
+            break;
+          case 6:
+            Func(fixed<6>(*this));
+            break;
+          case 7:
+            Func(fixed<7>(*this));
+            break;
+          case 8:
+            Func(fixed<8>(*this));
+            break;
+          case 9:
+            Func(fixed<9>(*this));
+            break;
+          case 10:
+            Func(fixed<10>(*this));
+            break;
+          default:
+            Func(fixed<0>(*this));
+            break;
+          }
+        } /* End of 'Visit' function */
 
-          weight = Maximal({0.0, Minimal({1.0, signal * Gain})});
+      /* Evaluation function (compile time number of octaves).
+       * Octaves loop has constant bounds and is unrolled by the compiler,
+       * 'Oct' = 0 means run time 'Octaves' value.
+       * ARGUMENTS:
+       *   - point:
+       *       vec Point;
+       * RETURNS:
+       *   (double) function value.
+       */
+      template<int Oct>
+        double Evaluate(vec Point)
+        {
+          const int Count = Oct > 0 ? Oct : Octaves;
+          float result, signal, weight;
 
           signal = fabs(Noise.Noise(Point.X, Point.Y, Point.Z));
           signal = Offset - signal;
           signal = signal * signal;
-          signal *= weight;
-          result += signal * Exponents[i];
-        }
-        return (result);
-      }
+          result = signal;
+
+          for (int i = 1; i < Count; i++)
+          {
+            Point *= Lacunarity;
 
-      ~fBm_multi_ridged(void)
+            weight = Weight(signal);
+
+            signal = fabs(Noise.Noise(Point.X, Point.Y, Point.Z));
+            signal = Offset - signal;
+            signal = signal * signal;
+            signal *= weight;
+            result += signal * Exponents[i];
+          }
+          return (result);
+        } /* End of 'Evaluate' function */
+
+      /* Evaluation with analytic gradient function (compile time number of octaves).
+       * Value is equal to 'Evaluate<Oct>(Point)' result.
+       * ARGUMENTS:
+       *   - point:
+       *       vec Point;
+       *   - function gradient:
+       *       vec &Grad;
+       * RETURNS:
+       *   (double) function value.
+       */
+      template<int Oct>
+        double EvaluateD(vec Point, vec &Grad)
+        {
+          const int Count = Oct > 0 ? Oct : Octaves;
+          float result, signal, weight;
+          double frequency = 1, a, n;
+          vec g, dresult, dsignal, dweight;
+
+          n = Noise.NoiseD(Point.X, Point.Y, Point.Z, g);
+          signal = fabs(n);
+          signal = Offset - signal;
+          a = signal;
+          signal = signal * signal;
+          result = signal;
+          dsignal = g * (-2 * a * Sign(n));
+          dresult = dsignal;
+
+          for (int i = 1; i < Count; i++)
+          {
+            Point *= Lacunarity;
+            frequency *= Lacunarity;
+
+            weight = Weight(signal);
+            dweight = signal * Gain > 0 && signal * Gain < 1 ? dsignal * Gain : vec(0);
+
+            n = Noise.NoiseD(Point.X, Point.Y, Point.Z, g);
+            signal = fabs(n);
+            signal = Offset - signal;
+            a = signal;
+            signal = signal * signal;
+            dsignal = g * (-2 * a * Sign(n) * frequency * weight) + dweight * signal;
+            signal *= weight;
+            result += signal * Exponents[i];
+            dresult += dsignal * Exponents[i];
+          }
+          Grad = dresult;
+          return (result);
+        } /* End of 'EvaluateD' function */
+
+      /* Batch evaluation function (compile time number of octaves).
+       * Octaves are processed for a chunk of points at once, so noise
+       * lookups go through batched (SIMD) 'noise::Noise'. Results are
+       * equal to per point 'Evaluate<Oct>(Point)' calls.
+       * ARGUMENTS:
+       *   - points coordinates (SoA arrays):
+       *       const double *X, *Y, *Z;
+       *   - result values array:
+       *       double *Res;
+       *   - number of points:
+       *       int N;
+       * RETURNS: None.
+       */
+      template<int Oct>
+        void EvaluateBatch(const double *X, const double *Y, const double *Z, double *Res, int N)
+        {
+          const int Count = Oct > 0 ? Oct : Octaves;
+          double px[BATCH], py[BATCH], pz[BATCH];
+          typename noise_type::sample n[BATCH];
+          float result[BATCH], signal[BATCH];
+
+          for (int s = 0; s < N; s += BATCH)
+          {
+            int cnt = Minimal({N - s, BATCH});
+
+            for (int j = 0; j < cnt; j++)
+              px[j] = X[s + j], py[j] = Y[s + j], pz[j] = Z[s + j];
+
+            Noise.Noise(px, py, pz, n, cnt);
+            for (int j = 0; j < cnt; j++)
+            {
+              signal[j] = fabs(n[j]);
+              signal[j] = Offset - signal[j];
+              signal[j] = signal[j] * signal[j];
+              result[j] = signal[j];
+            }
+
+            for (int i = 1; i < Count; i++)
+            {
+              double e = Exponents[i];
+
+              for (int j = 0; j < cnt; j++)
+                px[j] *= Lacunarity, py[j] *= Lacunarity, pz[j] *= Lacunarity;
+
+              Noise.Noise(px, py, pz, n, cnt);
+              for (int j = 0; j < cnt; j++)
+              {
+                float weight = Weight(signal[j]);
+
+                signal[j] = fabs(n[j]);
+                signal[j] = Offset - signal[j];
+                signal[j] = signal[j] * signal[j];
+                signal[j] *= weight;
+                result[j] += signal[j] * e;
+              }
+            }
+
+            for (int j = 0; j < cnt; j++)
+              Res[s + j] = result[j];
+          }
+        } /* End of 'EvaluateBatch' function */
+
+      /* Evaluation function (specialized by octaves number at construction).
+       * Call goes through member function pointer, hot loops should use
+       * 'Visit' evaluator instead.
+       * ARGUMENTS:
+       *   - point:
+       *       vec Point;
+       * RETURNS:
+       *   (double) function value.
+       */
+      double operator()(vec Point)
+      {
+        return (this->*Eval)(Point);
+      } /* End of 'operator()' function */
+
+      /* Evaluation with analytic gradient function.
+       * Value is equal to 'operator()(Point)' result.
+       * ARGUMENTS:
+       *   - point:
+       *       vec Point;
+       *   - function gradient:
+       *       vec &Grad;
+       * RETURNS:
+       *   (double) function value.
+       */
+      double fBmD(vec Point, vec &Grad)
+      {
+        return (this->*EvalD)(Point, Grad);
+      } /* End of 'fBmD' function */
+
+      /* Batch evaluation function.
+       * ARGUMENTS:
+       *   - points coordinates (SoA arrays):
+       *       const double *X, *Y, *Z;
+       *   - result values array:
+       *       double *Res;
+       *   - number of points:
+       *       int N;
+       * RETURNS: None.
+       */
+      void operator()(const double *X, const double *Y, const double *Z, double *Res, int N)
       {
-        delete[] Exponents;
-      }
-    }; /* End of 'fBm_multi_ridged' class */
+        (this->*EvalBatch)(X, Y, Z, Res, N);
+      } /* End of 'operator()' function */
+    }; /* End of 'multi_ridged' class */
+
+    /* Default multifractal ridged fBm */
+    typedef multi_ridged<> fBm_multi_ridged;
+
+    /* Multifractal ridged fBm on simplex noise */
+    typedef multi_ridged<simplex_noise> fBm_multi_ridged_simplex;
   } /* End of 'math' namespace */
 } /* End of 'tcg' namespace */
 #endif /* __noise_h_ */
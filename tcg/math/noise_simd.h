@@ -0,0 +1,322 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : noise_simd.h
+ * PURPOSE     : Computational geometry project.
+ *               Batched noise evaluation SIMD kernels.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ *               Kernels repeat scalar 'noise::Noise(X, Y, Z)' operation
+ *               by operation (same order, no fused multiply-add), so
+ *               results are bit-identical to the scalar path on SSE2
+ *               floating point. If the compiler contracts the scalar
+ *               code into FMA the difference stays below 1e-15.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __noise_simd_h_
+#define __noise_simd_h_
+
+#include "../def.h"
+#include "../support/cpu.h"
+#include <cstdint>
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Math support namespace */
+  namespace math
+  {
+    /* SIMD kernels namespace */
+    namespace simd
+    {
+      /* SSE 2-lane operations on noise sample type (double: '__m128d', float: low half of '__m128') */
+      template<class type>
+        struct sse_ops;
+
+      /* SSE 2-lane operations on double samples */
+      template<>
+        struct sse_ops<DOUBLE>
+        {
+          typedef __m128d vec;
+
+          static TCG_TARGET("sse4.1") vec From( __m128d A ) { return A; }
+          static TCG_TARGET("sse4.1") vec Set1( DOUBLE A ) { return _mm_set1_pd(A); }
+          static TCG_TARGET("sse4.1") vec Add( vec A, vec B ) { return _mm_add_pd(A, B); }
+          static TCG_TARGET("sse4.1") vec Sub( vec A, vec B ) { return _mm_sub_pd(A, B); }
+          static TCG_TARGET("sse4.1") vec Mul( vec A, vec B ) { return _mm_mul_pd(A, B); }
+          static TCG_TARGET("sse4.1") vec Load2( const DOUBLE *A ) { return _mm_loadu_pd(A); }
+          static TCG_TARGET("sse4.1") VOID Store2( DOUBLE *A, vec B ) { _mm_storeu_pd(A, B); }
+        }; /* End of 'sse_ops' structure */
+
+      /* SSE 2-lane operations on float samples */
+      template<>
+        struct sse_ops<FLT>
+        {
+          typedef __m128 vec;
+
+          static TCG_TARGET("sse4.1") vec From( __m128d A ) { return _mm_cvtpd_ps(A); }
+          static TCG_TARGET("sse4.1") vec Set1( FLT A ) { return _mm_set1_ps(A); }
+          static TCG_TARGET("sse4.1") vec Add( vec A, vec B ) { return _mm_add_ps(A, B); }
+          static TCG_TARGET("sse4.1") vec Sub( vec A, vec B ) { return _mm_sub_ps(A, B); }
+          static TCG_TARGET("sse4.1") vec Mul( vec A, vec B ) { return _mm_mul_ps(A, B); }
+          static TCG_TARGET("sse4.1") vec Load2( const FLT *A ) { return _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)A)); }
+          static TCG_TARGET("sse4.1") VOID Store2( FLT *A, vec B ) { _mm_storel_epi64((__m128i *)A, _mm_castps_si128(B)); }
+        }; /* End of 'sse_ops' structure */
+
+      /* AVX2 4-lane operations on noise sample type (double: '__m256d', float: '__m128') */
+      template<class type>
+        struct avx_ops;
+
+      /* AVX2 4-lane operations on double samples */
+      template<>
+        struct avx_ops<DOUBLE>
+        {
+          typedef __m256d vec;
+
+          static TCG_TARGET("avx2") vec From( __m256d A ) { return A; }
+          static TCG_TARGET("avx2") vec Set1( DOUBLE A ) { return _mm256_set1_pd(A); }
+          static TCG_TARGET("avx2") vec Add( vec A, vec B ) { return _mm256_add_pd(A, B); }
+          static TCG_TARGET("avx2") vec Sub( vec A, vec B ) { return _mm256_sub_pd(A, B); }
+          static TCG_TARGET("avx2") vec Mul( vec A, vec B ) { return _mm256_mul_pd(A, B); }
+          static TCG_TARGET("avx2") vec Gather( const DOUBLE *T, __m128i I ) { return _mm256_i32gather_pd(T, I, 8); }
+          static TCG_TARGET("avx2") VOID Store4( DOUBLE *A, vec B ) { _mm256_storeu_pd(A, B); }
+        }; /* End of 'avx_ops' structure */
+
+      /* AVX2 4-lane operations on float samples */
+      template<>
+        struct avx_ops<FLT>
+        {
+          typedef __m128 vec;
+
+          static TCG_TARGET("avx2") vec From( __m256d A ) { return _mm256_cvtpd_ps(A); }
+          static TCG_TARGET("avx2") vec Set1( FLT A ) { return _mm_set1_ps(A); }
+          static TCG_TARGET("avx2") vec Add( vec A, vec B ) { return _mm_add_ps(A, B); }
+          static TCG_TARGET("avx2") vec Sub( vec A, vec B ) { return _mm_sub_ps(A, B); }
+          static TCG_TARGET("avx2") vec Mul( vec A, vec B ) { return _mm_mul_ps(A, B); }
+          static TCG_TARGET("avx2") vec Gather( const FLT *T, __m128i I ) { return _mm_i32gather_ps(T, I, 4); }
+          static TCG_TARGET("avx2") VOID Store4( FLT *A, vec B ) { _mm_storeu_ps(A, B); }
+        }; /* End of 'avx_ops' structure */
+
+      /* Value noise (three-dimensional) SSE 4.1 batch kernel (2 points per step).
+       * ARGUMENTS:
+       *   - noise and permutation tables:
+       *       const type *Table; const uint16_t *Perm;
+       *   - tables size in bits:
+       *       INT Bits;
+       *   - points coordinates (SoA):
+       *       const DOUBLE *X, *Y, *Z;
+       *   - result values:
+       *       type *Res;
+       *   - number of points:
+       *       INT N;
+       * RETURNS:
+       *   (INT) number of processed points (rest is left to scalar code).
+       */
+      template<class type>
+        inline TCG_TARGET("sse4.1")
+        INT Noise3Sse4( const type *Table, const uint16_t *Perm, INT Bits,
+                        const DOUBLE *X, const DOUBLE *Y, const DOUBLE *Z,
+                        type *Res, INT N )
+        {
+          typedef sse_ops<type> op;
+          const INT Mask = (1 << Bits) - 1;
+          const __m128d
+            Zero = _mm_setzero_pd(), Size = _mm_set1_pd(1 << Bits), InvSize = _mm_set1_pd(1.0 / (1 << Bits));
+          const typename op::vec One = op::Set1(1), Two = op::Set1(2), Three = op::Set1(3);
+          const __m128i MaskI = _mm_set1_epi32(Mask), OneI = _mm_set1_epi32(1);
+          INT i;
+
+          for (i = 0; i + 2 <= N; i += 2)
+          {
+            __m128d C[3] = {_mm_loadu_pd(X + i), _mm_loadu_pd(Y + i), _mm_loadu_pd(Z + i)};
+            typename op::vec F[3];
+            __m128i I0[3], I1[3];
+
+            for (INT k = 0; k < 3; k++)
+            {
+              /* Negative arguments: fmod(SIZE - X, SIZE), exact for power of 2 size */
+              __m128d Neg = _mm_cmplt_pd(C[k], Zero);
+              if (_mm_movemask_pd(Neg))
+              {
+                __m128d
+                  A = _mm_sub_pd(Size, C[k]),
+                  Q = _mm_round_pd(_mm_mul_pd(A, InvSize), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                C[k] = _mm_blendv_pd(C[k], _mm_sub_pd(A, _mm_mul_pd(Q, Size)), Neg);
+              }
+              __m128i T = _mm_cvttpd_epi32(C[k]);
+              I0[k] = _mm_and_si128(T, MaskI);
+              I1[k] = _mm_and_si128(_mm_add_epi32(I0[k], OneI), MaskI);
+              typename op::vec Fr = op::From(_mm_sub_pd(C[k], _mm_cvtepi32_pd(T)));
+              F[k] = op::Mul(op::Mul(Fr, Fr), op::Sub(Three, op::Mul(Two, Fr)));
+            }
+
+            /* Scalar permutation chain per lane */
+            type V[8][2];
+            for (INT l = 0; l < 2; l++)
+            {
+              INT
+                ix = l ? _mm_extract_epi32(I0[0], 1) : _mm_cvtsi128_si32(I0[0]),
+                ix1 = l ? _mm_extract_epi32(I1[0], 1) : _mm_cvtsi128_si32(I1[0]),
+                iy = l ? _mm_extract_epi32(I0[1], 1) : _mm_cvtsi128_si32(I0[1]),
+                iy1 = l ? _mm_extract_epi32(I1[1], 1) : _mm_cvtsi128_si32(I1[1]),
+                iz = l ? _mm_extract_epi32(I0[2], 1) : _mm_cvtsi128_si32(I0[2]),
+                iz1 = l ? _mm_extract_epi32(I1[2], 1) : _mm_cvtsi128_si32(I1[2]),
+                pz0 = Perm[iz], pz1 = Perm[iz1],
+                p00 = Perm[(iy + pz0) & Mask], p10 = Perm[(iy1 + pz0) & Mask],
+                p01 = Perm[(iy + pz1) & Mask], p11 = Perm[(iy1 + pz1) & Mask];
+
+              V[0][l] = Table[Perm[(ix + p00) & Mask]];
+              V[1][l] = Table[Perm[(ix1 + p00) & Mask]];
+              V[2][l] = Table[Perm[(ix + p10) & Mask]];
+              V[3][l] = Table[Perm[(ix1 + p10) & Mask]];
+              V[4][l] = Table[Perm[(ix + p01) & Mask]];
+              V[5][l] = Table[Perm[(ix1 + p01) & Mask]];
+              V[6][l] = Table[Perm[(ix + p11) & Mask]];
+              V[7][l] = Table[Perm[(ix1 + p11) & Mask]];
+            }
+
+            typename op::vec
+              fx = F[0], fy = F[1], fz = F[2],
+              ox = op::Sub(One, fx), oy = op::Sub(One, fy), oz = op::Sub(One, fz), R;
+#define TCG_CORNER(n, a, b, c) \
+  op::Mul(op::Mul(op::Mul(op::Load2(V[n]), a), b), c)
+            R = TCG_CORNER(0, ox, oy, oz);
+            R = op::Add(R, TCG_CORNER(1, fx, oy, oz));
+            R = op::Add(R, TCG_CORNER(2, ox, fy, oz));
+            R = op::Add(R, TCG_CORNER(3, fx, fy, oz));
+            R = op::Add(R, TCG_CORNER(4, ox, oy, fz));
+            R = op::Add(R, TCG_CORNER(5, fx, oy, fz));
+            R = op::Add(R, TCG_CORNER(6, ox, fy, fz));
+            R = op::Add(R, TCG_CORNER(7, fx, fy, fz));
+#undef TCG_CORNER
+            op::Store2(Res + i, R);
+          }
+          return i;
+        } /* End of 'Noise3Sse4' function */
+
+      /* Value noise (three-dimensional) AVX2 batch kernel (4 points per step).
+       * Permutation table is gathered by 32-bit words with 2-byte scale,
+       * so it must have one padding element after the last one.
+       * ARGUMENTS:
+       *   - noise and permutation tables:
+       *       const type *Table; const uint16_t *Perm;
+       *   - tables size in bits:
+       *       INT Bits;
+       *   - points coordinates (SoA):
+       *       const DOUBLE *X, *Y, *Z;
+       *   - result values:
+       *       type *Res;
+       *   - number of points:
+       *       INT N;
+       * RETURNS:
+       *   (INT) number of processed points (rest is left to scalar code).
+       */
+      template<class type>
+        inline TCG_TARGET("avx2")
+        INT Noise3Avx2( const type *Table, const uint16_t *Perm, INT Bits,
+                        const DOUBLE *X, const DOUBLE *Y, const DOUBLE *Z,
+                        type *Res, INT N )
+        {
+          typedef avx_ops<type> op;
+          const __m256d
+            Zero = _mm256_setzero_pd(), Size = _mm256_set1_pd(1 << Bits), InvSize = _mm256_set1_pd(1.0 / (1 << Bits));
+          const typename op::vec One = op::Set1(1), Two = op::Set1(2), Three = op::Set1(3);
+          const __m128i
+            MaskI = _mm_set1_epi32((1 << Bits) - 1), OneI = _mm_set1_epi32(1), Low16 = _mm_set1_epi32(0xFFFF);
+          INT i;
+
+          for (i = 0; i + 4 <= N; i += 4)
+          {
+            __m256d C[3] = {_mm256_loadu_pd(X + i), _mm256_loadu_pd(Y + i), _mm256_loadu_pd(Z + i)};
+            typename op::vec F[3];
+            __m128i I0[3], I1[3];
+
+            for (INT k = 0; k < 3; k++)
+            {
+              /* Negative arguments: fmod(SIZE - X, SIZE), exact for power of 2 size */
+              __m256d Neg = _mm256_cmp_pd(C[k], Zero, _CMP_LT_OQ);
+              if (_mm256_movemask_pd(Neg))
+              {
+                __m256d
+                  A = _mm256_sub_pd(Size, C[k]),
+                  Q = _mm256_round_pd(_mm256_mul_pd(A, InvSize), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                C[k] = _mm256_blendv_pd(C[k], _mm256_sub_pd(A, _mm256_mul_pd(Q, Size)), Neg);
+              }
+              __m128i T = _mm256_cvttpd_epi32(C[k]);
+              I0[k] = _mm_and_si128(T, MaskI);
+              I1[k] = _mm_and_si128(_mm_add_epi32(I0[k], OneI), MaskI);
+              typename op::vec Fr = op::From(_mm256_sub_pd(C[k], _mm256_cvtepi32_pd(T)));
+              F[k] = op::Mul(op::Mul(Fr, Fr), op::Sub(Three, op::Mul(Two, Fr)));
+            }
+
+            /* Gathered permutation chain: Perm[(x + Perm[(y + Perm[z]) & M]) & M] */
+#define TCG_PERM(I) _mm_and_si128(_mm_i32gather_epi32((const INT *)Perm, I, 2), Low16)
+#define TCG_STEP(A, B) TCG_PERM(_mm_and_si128(_mm_add_epi32(A, B), MaskI))
+            __m128i
+              pz0 = TCG_PERM(I0[2]), pz1 = TCG_PERM(I1[2]),
+              p00 = TCG_STEP(I0[1], pz0), p10 = TCG_STEP(I1[1], pz0),
+              p01 = TCG_STEP(I0[1], pz1), p11 = TCG_STEP(I1[1], pz1);
+            typename op::vec
+              fx = F[0], fy = F[1], fz = F[2],
+              ox = op::Sub(One, fx), oy = op::Sub(One, fy), oz = op::Sub(One, fz), R;
+#define TCG_CORNER(x, p, a, b, c) \
+  op::Mul(op::Mul(op::Mul(op::Gather(Table, TCG_STEP(x, p)), a), b), c)
+            R = TCG_CORNER(I0[0], p00, ox, oy, oz);
+            R = op::Add(R, TCG_CORNER(I1[0], p00, fx, oy, oz));
+            R = op::Add(R, TCG_CORNER(I0[0], p10, ox, fy, oz));
+            R = op::Add(R, TCG_CORNER(I1[0], p10, fx, fy, oz));
+            R = op::Add(R, TCG_CORNER(I0[0], p01, ox, oy, fz));
+            R = op::Add(R, TCG_CORNER(I1[0], p01, fx, oy, fz));
+            R = op::Add(R, TCG_CORNER(I0[0], p11, ox, fy, fz));
+            R = op::Add(R, TCG_CORNER(I1[0], p11, fx, fy, fz));
+#undef TCG_CORNER
+#undef TCG_STEP
+#undef TCG_PERM
+            op::Store4(Res + i, R);
+          }
+          return i;
+        } /* End of 'Noise3Avx2' function */
+
+      /* Value noise (three-dimensional) batch dispatch function.
+       * ARGUMENTS:
+       *   - noise and permutation tables:
+       *       const type *Table; const uint16_t *Perm;
+       *   - tables size in bits:
+       *       INT Bits;
+       *   - points coordinates (SoA):
+       *       const DOUBLE *X, *Y, *Z;
+       *   - result values:
+       *       type *Res;
+       *   - number of points:
+       *       INT N;
+       * RETURNS:
+       *   (INT) number of processed points (rest is left to scalar code).
+       */
+      template<class type>
+        inline INT Noise3( const type *Table, const uint16_t *Perm, INT Bits,
+                           const DOUBLE *X, const DOUBLE *Y, const DOUBLE *Z,
+                           type *Res, INT N )
+        {
+          switch (cpu::Simd())
+          {
+          case cpu::SIMD_AVX2:
+            return Noise3Avx2(Table, Perm, Bits, X, Y, Z, Res, N);
+          case cpu::SIMD_SSE4:
+            return Noise3Sse4(Table, Perm, Bits, X, Y, Z, Res, N);
+          }
+          return 0;
+        } /* End of 'Noise3' function */
+    } /* end of 'simd' namespace */
+  } /* end of 'math' namespace */
+} /* end of 'tcg' namespace */
+
+#endif /* __noise_simd_h_ */
+
+/* END OF 'noise_simd.h' FILE */
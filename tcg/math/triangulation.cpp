@@ -19,6 +19,268 @@
 
 #include "computational_geometry.h"
 
+/* Test polygon self intersection function.
+ * Edges are distributed over uniform grid cells they pass through,
+ * so only edges sharing a cell are tested against each other.
+ * ARGUMENTS:
+ *   - polygon points:
+ *       const std::vector<point> &Polygon;
+ * RETURNS:
+ *   (BOOL) TRUE if two not neighbour edges intersect, FALSE otherwise.
+ */
+BOOL tcg::math::IsSelfIntersecting( const std::vector<point> &Polygon )
+{
+  INT n = Polygon.size();
+
+  auto IsCrossing = [&]( INT i, INT j ) -> BOOL
+  {
+    vec
+      p0 = Polygon[i].Loc, p1 = Polygon[(i + 1) % n].Loc,
+      q0 = Polygon[j].Loc, q1 = Polygon[(j + 1) % n].Loc;
+    vec
+      np = vec(p0.Z - p1.Z, 0, p1.X - p0.X).Normalizing(),
+      nq = vec(q0.Z - q1.Z, 0, q1.X - q0.X).Normalizing();
+    DOUBLE
+      cp = -np.X * p0.X - np.Z * p0.Z,
+      cq = -nq.X * q0.X - nq.Z * q0.Z;
+
+    return (np.X * q0.X + np.Z * q0.Z + cp) * (np.X * q1.X + np.Z * q1.Z + cp) < 0 &&
+           (nq.X * p0.X + nq.Z * p0.Z + cq) * (nq.X * p1.X + nq.Z * p1.Z + cq) < 0;
+  };
+
+  // Small polygons are cheaper to test edge by edge.
+  if (n <= SmallPolygonSize)
+  {
+    for (INT i = 0; i < n; i++)
+      for (INT j = i + 2; j < n; j++)
+        if (IsCrossing(i, j))
+          return TRUE;
+    return FALSE;
+  }
+
+  point_grid Grid;
+  Grid.Build(Polygon);
+
+  // Collect cells crossed by edge, row spans are widened to stay conservative.
+  auto GetEdgeCells = [&]( INT i, std::vector<INT> &Cells )
+  {
+    const vec &p0 = Polygon[i].Loc, &p1 = Polygon[(i + 1) % n].Loc;
+    DOUBLE
+      MinZ = COM_MIN(p0.Z, p1.Z), MaxZ = COM_MAX(p0.Z, p1.Z),
+      Pad = Grid.CellSize * 0.001;
+    INT z0 = Grid.CellZ(MinZ), z1 = Grid.CellZ(MaxZ);
+
+    Cells.clear();
+    for (INT z = z0; z <= z1; z++)
+    {
+      DOUBLE
+        Lo = COM_MAX(MinZ, Grid.MinZ + z * Grid.CellSize - Pad),
+        Hi = COM_MIN(MaxZ, Grid.MinZ + (z + 1) * Grid.CellSize + Pad),
+        xa = p0.X, xb = p1.X;
+      if (MaxZ - MinZ > Threshold)
+      {
+        xa = p0.X + (Lo - p0.Z) * (p1.X - p0.X) / (p1.Z - p0.Z);
+        xb = p0.X + (Hi - p0.Z) * (p1.X - p0.X) / (p1.Z - p0.Z);
+      }
+      if (xa > xb)
+        std::swap(xa, xb);
+      INT x0 = Grid.CellX(COM_MAX(xa - Pad, COM_MIN(p0.X, p1.X))), x1 = Grid.CellX(COM_MIN(xb + Pad, COM_MAX(p0.X, p1.X)));
+      for (INT x = x0; x <= x1; x++)
+        Cells.push_back(z * Grid.W + x);
+    }
+  };
+
+  // Counting sort of edges by cells.
+  std::vector<INT> Cells, CellStart(Grid.W * Grid.H + 1, 0);
+  for (INT i = 0; i < n; i++)
+  {
+    GetEdgeCells(i, Cells);
+    for (INT k = 0; k < Cells.size(); k++)
+      CellStart[Cells[k] + 1]++;
+  }
+  for (INT i = 0; i < Grid.W * Grid.H; i++)
+    CellStart[i + 1] += CellStart[i];
+  std::vector<INT> CellEdges(CellStart.back());
+  std::vector<INT> Fill(CellStart.begin(), CellStart.end() - 1);
+  for (INT i = 0; i < n; i++)
+  {
+    GetEdgeCells(i, Cells);
+    for (INT k = 0; k < Cells.size(); k++)
+      CellEdges[Fill[Cells[k]]++] = i;
+  }
+
+  // Every pair is tested once, from edge with less index.
+  std::vector<INT> Tested(n, -1);
+  for (INT i = 0; i < n; i++)
+  {
+    GetEdgeCells(i, Cells);
+    for (INT k = 0; k < Cells.size(); k++)
+      for (INT e = CellStart[Cells[k]]; e < CellStart[Cells[k] + 1]; e++)
+      {
+        INT j = CellEdges[e];
+        if (j < i + 2 || Tested[j] == i)
+          continue;
+        Tested[j] = i;
+
+        if (IsCrossing(i, j))
+          return TRUE;
+      }
+  }
+  return FALSE;
+} /* End of 'tcg::math::IsSelfIntersecting' function */
+
+/* Clip polygon ears function.
+ * Polygon is kept as doubly linked list of vertices and ear candidates are
+ * tested only against vertices from grid cells under ear bound box. Vertex is
+ * retested when its neighbour changes or the vertex found inside its ear is
+ * clipped. Ears are clipped in the same order as by scanning polygon from its
+ * first vertex after every clip.
+ * ARGUMENTS:
+ *   - counterclockwise polygon points:
+ *       const std::vector<point> &Polygon;
+ *   - stock of triangles to fill:
+ *       std::vector<triangle> &Triangles;
+ *   - add triangle of first three remaining points if no ear found flag:
+ *       BOOL IsForced;
+ * RETURNS:
+ *   (BOOL) TRUE if polygon is triangulated, FALSE if no ear found.
+ */
+BOOL tcg::math::ClipEars( const std::vector<point> &Polygon, std::vector<triangle> &Triangles, BOOL IsForced )
+{
+  INT n = Polygon.size(), Size = n, Head = 0;
+  if (n < 3)
+    return TRUE;
+
+  auto IsInside = [&]( const vec &A, const vec &B, const vec &C, const vec &P ) -> BOOL
+  {
+    INT r = Rotation(P - A, B - A);
+    return r * Rotation(P - B, C - B) > 0 && r * Rotation(P - C, A - C) > 0;
+  };
+
+  // Small polygon is clipped by plain rescans from its first vertex.
+  if (n <= SmallPolygonSize)
+  {
+    std::vector<point> Rest(Polygon);
+    while (Rest.size() > 2)
+    {
+      INT m = Rest.size(), i, j;
+      for (i = 0; i < m; i++)
+      {
+        const vec &A = Rest[i].Loc, &B = Rest[(i + 1) % m].Loc, &C = Rest[(i + 2) % m].Loc;
+        if (Rotation(B - A, C - B) <= 0)
+          continue;
+        for (j = 0; j < m; j++)
+          if (j != i && j != (i + 1) % m && j != (i + 2) % m && IsInside(A, B, C, Rest[j].Loc))
+            break;
+        if (j == m)
+          break;
+      }
+      if (i == m)
+      {
+        if (IsForced)
+          Triangles.push_back(triangle(Rest[0].Index, Rest[1].Index, Rest[2].Index));
+        return FALSE;
+      }
+      Triangles.push_back(triangle(Rest[i].Index, Rest[(i + 1) % m].Index, Rest[(i + 2) % m].Index));
+      Rest.erase(Rest.begin() + (i + 1) % m);
+    }
+    return TRUE;
+  }
+
+  point_grid Grid;
+  Grid.Build(Polygon);
+
+  std::vector<INT> Prev(n), Next(n), Inside(n, -1);
+  std::vector<BOOL> IsConvex(n), IsAlive(n, TRUE);
+  std::vector<std::vector<INT>> Blocked(n);
+  std::set<INT> Ears;
+
+  for (INT i = 0; i < n; i++)
+    Prev[i] = (i + n - 1) % n, Next[i] = (i + 1) % n;
+
+  auto UpdateConvex = [&]( INT v )
+  {
+    IsConvex[v] = Rotation(Polygon[v].Loc - Polygon[Prev[v]].Loc, Polygon[Next[v]].Loc - Polygon[v].Loc) > 0;
+  };
+
+  auto IsEar = [&]( INT v ) -> BOOL
+  {
+    if (!IsConvex[v])
+      return FALSE;
+
+    INT a = Prev[v], c = Next[v];
+    const vec &A = Polygon[a].Loc, &B = Polygon[v].Loc, &C = Polygon[c].Loc;
+    INT
+      x0 = Grid.CellX(COM_MIN(COM_MIN(A.X, B.X), C.X)), x1 = Grid.CellX(COM_MAX(COM_MAX(A.X, B.X), C.X)),
+      z0 = Grid.CellZ(COM_MIN(COM_MIN(A.Z, B.Z), C.Z)), z1 = Grid.CellZ(COM_MAX(COM_MAX(A.Z, B.Z), C.Z));
+
+    for (INT z = z0; z <= z1; z++)
+      for (INT x = x0; x <= x1; x++)
+        for (INT k = Grid.CellStart[z * Grid.W + x]; k < Grid.CellStart[z * Grid.W + x + 1]; k++)
+        {
+          INT j = Grid.CellPoints[k];
+          if (!IsAlive[j] || j == a || j == v || j == c)
+            continue;
+
+          if (IsInside(A, B, C, Polygon[j].Loc))
+          {
+            Inside[v] = j;
+            Blocked[j].push_back(v);
+            return FALSE;
+          }
+        }
+    return TRUE;
+  };
+
+  auto Update = [&]( INT v )
+  {
+    Inside[v] = -1;
+    if (IsEar(v))
+      Ears.insert(v);
+    else
+      Ears.erase(v);
+  };
+
+  for (INT i = 0; i < n; i++)
+    UpdateConvex(i);
+  for (INT i = 0; i < n; i++)
+    Update(i);
+
+  while (Size > 2)
+  {
+    if (Ears.empty())
+    {
+      if (IsForced)
+        Triangles.push_back(triangle(Polygon[Head].Index, Polygon[Next[Head]].Index, Polygon[Next[Next[Head]]].Index));
+      return FALSE;
+    }
+
+    // First vertex is scanned as ear tip last.
+    std::set<INT>::iterator It = Ears.begin();
+    if (*It == Head && Ears.size() > 1)
+      It++;
+    INT v = *It, a = Prev[v], c = Next[v];
+    Ears.erase(It);
+
+    Triangles.push_back(triangle(Polygon[a].Index, Polygon[v].Index, Polygon[c].Index));
+    IsAlive[v] = FALSE;
+    Next[a] = c, Prev[c] = a;
+    if (v == Head)
+      Head = c;
+    Size--;
+
+    UpdateConvex(a);
+    UpdateConvex(c);
+    Update(a);
+    Update(c);
+    for (INT i = 0; i < Blocked[v].size(); i++)
+      if (IsAlive[Blocked[v][i]] && Inside[Blocked[v][i]] == v)
+        Update(Blocked[v][i]);
+    std::vector<INT>().swap(Blocked[v]);
+  }
+  return TRUE;
+} /* End of 'tcg::math::ClipEars' function */
+
 /* Triangulate polygon function.
  * ARGUMENTS:
  *   - polygon points:
@@ -46,68 +308,23 @@ VOID tcg::math::TriangulateConst( const std::vector<vec> &Points, const std::vec
   if (s < 0)
     std::reverse(PolygonPoints.begin(), PolygonPoints.end());
 
-  for (INT i = 0; i < PolygonPoints.size(); i++)
-    for (INT j = i + 1; j < PolygonPoints.size(); j++)
-      if (PolygonPoints[i].Loc == PolygonPoints[j].Loc)
-        return;
-
-  for (INT i = 0; i < PolygonPoints.size(); i++)
-    for (INT j = i + 2; j < PolygonPoints.size(); j++)
-    {
-      vec
-        p0 = PolygonPoints[i].Loc, p1 = PolygonPoints[(i + 1) % PolygonPoints.size()].Loc,
-        q0 = PolygonPoints[j].Loc, q1 = PolygonPoints[(j + 1) % PolygonPoints.size()].Loc;
-      vec
-        np = vec(p0.Z - p1.Z, 0, p1.X - p0.X).Normalizing(),
-        nq = vec(q0.Z - q1.Z, 0, q1.X - q0.X).Normalizing();
-      DOUBLE
-        cp = -np.X * p0.X - np.Z * p0.Z,
-        cq = -nq.X * q0.X - nq.Z * q0.Z;
-
-      if ((np.X * q0.X + np.Z * q0.Z + cp) * (np.X * q1.X + np.Z * q1.Z + cp) < 0 &&
-          (nq.X * p0.X + nq.Z * p0.Z + cq) * (nq.X * p1.X + nq.Z * p1.Z + cq) < 0)
+  // Equal points are searched among neighbours by X.
+  std::vector<INT> Order(PolygonPoints.size());
+  for (INT i = 0; i < Order.size(); i++)
+    Order[i] = i;
+  std::sort(Order.begin(), Order.end(), [&]( INT a, INT b )
+  {
+    return PolygonPoints[a].Loc.X < PolygonPoints[b].Loc.X;
+  });
+  for (INT i = 0; i < Order.size(); i++)
+    for (INT j = i + 1; j < Order.size() && PolygonPoints[Order[j]].Loc.X - PolygonPoints[Order[i]].Loc.X < tsg::Threshold; j++)
+      if (PolygonPoints[Order[i]].Loc == PolygonPoints[Order[j]].Loc)
         return;
-    }
 
-  while (PolygonPoints.size() > 2)
-  {
-    INT size = PolygonPoints.size();
-    for (INT i = 0; i < PolygonPoints.size(); i++)
-    {
-      if (Rotation(PolygonPoints[(i + 1) % PolygonPoints.size()].Loc - PolygonPoints[i].Loc,
-                   PolygonPoints[(i + 2) % PolygonPoints.size()].Loc - PolygonPoints[(i + 1) % PolygonPoints.size()].Loc) > 0)
-      {
-        BOOL skip = FALSE;
-        for (INT j = 0; j < PolygonPoints.size(); j++)
-          if (j != i && j != (i + 1) % PolygonPoints.size() && j != (i + 2) % PolygonPoints.size() &&
-              (Rotation(PolygonPoints[j].Loc -                              PolygonPoints[i].Loc,
-                        PolygonPoints[(i + 1) % PolygonPoints.size()].Loc - PolygonPoints[i].Loc) *
-               Rotation(PolygonPoints[j].Loc -                              PolygonPoints[(i + 1) % PolygonPoints.size()].Loc,
-                        PolygonPoints[(i + 2) % PolygonPoints.size()].Loc - PolygonPoints[(i + 1) % PolygonPoints.size()].Loc) > 0 &&
-               Rotation(PolygonPoints[j].Loc -                              PolygonPoints[i].Loc,
-                        PolygonPoints[(i + 1) % PolygonPoints.size()].Loc - PolygonPoints[i].Loc) *
-               Rotation(PolygonPoints[j].Loc -                              PolygonPoints[(i + 2) % PolygonPoints.size()].Loc,
-                        PolygonPoints[i].Loc - PolygonPoints[(i + 2) % PolygonPoints.size()].Loc) > 0))
-          {
-            skip = TRUE;
-            break;
-          }
-        if (skip)
-          continue;
+  if (IsSelfIntersecting(PolygonPoints))
+    return;
 
-        Triangles.push_back(triangle(PolygonPoints[i].Index,
-                                     PolygonPoints[(i + 1) % PolygonPoints.size()].Index,
-                                     PolygonPoints[(i + 2) % PolygonPoints.size()].Index));
-        PolygonPoints.erase(PolygonPoints.begin() + (i + 1) % PolygonPoints.size());
-        break;
-      }
-    }
-    if (size == PolygonPoints.size())
-    {
-      Triangles.push_back(triangle(PolygonPoints[0].Index, PolygonPoints[1].Index, PolygonPoints[2].Index));
-      return;
-    }
-  }
+  ClipEars(PolygonPoints, Triangles, TRUE);
 } /* End of 'tcg::math::TriangulateConst' function */
 
 /* Triangulate polygon function.
@@ -137,57 +354,10 @@ VOID tcg::math::Triangulate( const std::vector<vec> &Points, std::vector<INT> &I
   for (INT i = 0; i < Indices.size(); i++)
     PolygonPoints.push_back(point(Points[Indices[i]], Indices[i]));
 
-  for (INT i = 0; i < PolygonPoints.size(); i++)
-    for (INT j = i + 2; j < PolygonPoints.size(); j++)
-    {
-      vec
-        p0 = PolygonPoints[i].Loc, p1 = PolygonPoints[(i + 1) % PolygonPoints.size()].Loc,
-        q0 = PolygonPoints[j].Loc, q1 = PolygonPoints[(j + 1) % PolygonPoints.size()].Loc;
-      vec
-        np = vec(p0.Z - p1.Z, 0, p1.X - p0.X).Normalizing(),
-        nq = vec(q0.Z - q1.Z, 0, q1.X - q0.X).Normalizing();
-      DOUBLE
-        cp = -np.X * p0.X - np.Z * p0.Z,
-        cq = -nq.X * q0.X - nq.Z * q0.Z;
-
-      if ((np.X * q0.X + np.Z * q0.Z + cp) * (np.X * q1.X + np.Z * q1.Z + cp) < 0 &&
-          (nq.X * p0.X + nq.Z * p0.Z + cq) * (nq.X * p1.X + nq.Z * p1.Z + cq) < 0)
-        return;
-    }
-
-  while (PolygonPoints.size() > 2)
-  {
-    for (INT i = 0; i < PolygonPoints.size(); i++)
-    {
-      if (Rotation(PolygonPoints[(i + 1) % PolygonPoints.size()].Loc - PolygonPoints[i].Loc,
-                   PolygonPoints[(i + 2) % PolygonPoints.size()].Loc - PolygonPoints[(i + 1) % PolygonPoints.size()].Loc) > 0)
-      {
-        BOOL skip = FALSE;
-        for (INT j = 0; j < PolygonPoints.size(); j++)
-          if (j != i && j != (i + 1) % PolygonPoints.size() && j != (i + 2) % PolygonPoints.size() &&
-              (Rotation(PolygonPoints[j].Loc -                              PolygonPoints[i].Loc,
-                        PolygonPoints[(i + 1) % PolygonPoints.size()].Loc - PolygonPoints[i].Loc) *
-               Rotation(PolygonPoints[j].Loc -                              PolygonPoints[(i + 1) % PolygonPoints.size()].Loc,
-                        PolygonPoints[(i + 2) % PolygonPoints.size()].Loc - PolygonPoints[(i + 1) % PolygonPoints.size()].Loc) > 0 &&
-               Rotation(PolygonPoints[j].Loc -                              PolygonPoints[i].Loc,
-                        PolygonPoints[(i + 1) % PolygonPoints.size()].Loc - PolygonPoints[i].Loc) *
-               Rotation(PolygonPoints[j].Loc -                              PolygonPoints[(i + 2) % PolygonPoints.size()].Loc,
-                        PolygonPoints[i].Loc - PolygonPoints[(i + 2) % PolygonPoints.size()].Loc) > 0))
-          {
-            skip = TRUE;
-            break;
-          }
-        if (skip)
-          continue;
+  if (IsSelfIntersecting(PolygonPoints))
+    return;
 
-        Triangles.push_back(triangle(PolygonPoints[i].Index,
-                                     PolygonPoints[(i + 1) % PolygonPoints.size()].Index,
-                                     PolygonPoints[(i + 2) % PolygonPoints.size()].Index));
-        PolygonPoints.erase(PolygonPoints.begin() + (i + 1) % PolygonPoints.size());
-        break;
-      }
-    }
-  }
+  ClipEars(PolygonPoints, Triangles, FALSE);
 } /* End of 'tcg::math::Triangulate' function */
 
 /* Swap points function
@@ -208,7 +378,7 @@ VOID tcg::math::triangle_edge::swap( VOID )
  * RETURNS:
  *   (BOOL) TRUE if less, FALSE otherwise.
  */
-BOOL tcg::math::triangle_edge::operator<( const triangle_edge &Edge )
+BOOL tcg::math::triangle_edge::operator<( const triangle_edge &Edge ) const
 {
   if (P0 < Edge.P0)
     return TRUE;
@@ -224,7 +394,7 @@ BOOL tcg::math::triangle_edge::operator<( const triangle_edge &Edge )
  * RETURNS:
  *   (BOOL) TRUE if more, FALSE otherwise.
  */
-BOOL tcg::math::triangle_edge::operator>( const triangle_edge &Edge )
+BOOL tcg::math::triangle_edge::operator>( const triangle_edge &Edge ) const
 {
   if (P0 > Edge.P0)
     return TRUE;
@@ -233,39 +403,6 @@ BOOL tcg::math::triangle_edge::operator>( const triangle_edge &Edge )
   return FALSE;
 } /* End of 'tcg::math::triangle_edge::operator>' function */
 
-/* Compare edges function
- * ARGUMENTS:
- *   - edges to compare:
- *       const triangle_edge &a, &b;
- * RETURNS:
- *   (INT) -1 if first is less, 1 if first is more, 0 if equal.
- */
-INT tcg::math::edge_stock::compare( const triangle_edge &a, const triangle_edge &b )
-{
-  if (a.P0 < b.P0)
-    return -1;
-  if (a.P0 == b.P0)
-    if (a.P1 < b.P1)
-      return -1;
-    else if (a.P1 > b.P1)
-      return 1;
-    else
-      return 0;
-  return 1;
-} /* End of 'tcg::math::edge_stock::compare' function */
-
-/* Sort edges function.
- * ARGUMENTS: None.
- * RETURNS: None.
- */
-VOID tcg::math::edge_stock::sort( VOID )
-{
-  for (INT i = 0; i < Edges.size(); i++)
-    if (Edges[i].P0 > Edges[i].P1)
-      Edges[i].swap(), Edges[i].FreeSide = !Edges[i].FreeSide;
-  std::sort(Edges.begin(), Edges.end());
-} /* End of 'tcg::math::edge_stock::sort' function */
-
 /* Add edge function.
  * ARGUMENTS:
  *   - edge to add or delete if it already exists:
@@ -275,80 +412,31 @@ VOID tcg::math::edge_stock::sort( VOID )
 VOID tcg::math::edge_stock::add( triangle_edge Edge )
 {
   if (Edge.P0 > Edge.P1)
-      Edge.swap(), Edge.FreeSide = !Edge.FreeSide;
-  INT min = 0, max = Edges.size() - 1, medium, comp;
-  if (compare(Edges[min], Edge) == 0)
-  {
-    Edges.erase(Edges.begin() + min);
-    return;
-  }
-  if (compare(Edges[max], Edge) == 0)
-  {
-    Edges.erase(Edges.begin() + max);
-    return;
-  }
-  while (max - min > 1)
-  {
-    medium = (min + max) / 2;
-    comp = compare(Edges[medium], Edge);
-    if (comp < 0)
-      min = medium;
-    else if (comp > 0)
-      max = medium;
-    else
-    {
-      Edges.erase(Edges.begin() + medium);
-      return;
-    }
-  }
-  if (Edges[min] > Edge)
-    Edges.insert(Edges.begin() + min, Edge);
-  else if (Edges[max] < Edge)
-    Edges.insert(Edges.begin() + max + 1, Edge);
+    Edge.swap(), Edge.FreeSide = !Edge.FreeSide;
+  std::set<triangle_edge>::iterator It = Edges.find(Edge);
+  if (It != Edges.end())
+    Edges.erase(It);
   else
-    Edges.insert(Edges.begin() + max, Edge);
+    Edges.insert(Edge);
 } /* End of 'tcg::math::edge_stock::add' function */
 
-/* Add edge that definitely is not already active.
- * ARGUMENTS:
- *   - edge to add:
- *       const triangle_edge &Edge;
- * RETURNS: None.
- */
-VOID tcg::math::edge_stock::push_back( const triangle_edge &Edge )
-{
-  Edges.push_back(Edge);
-} /* End of 'tcg::math::edge_stock::push_back' function */
-
-/* Delete edge from end of stock.
+/* Delete last edge from stock.
  * ARGUMENTS: None.
  * RETURNS: None.
  */
 VOID tcg::math::edge_stock::pop_back( VOID )
 {
-  Edges.pop_back();
+  Edges.erase(--Edges.end());
 } /* End of 'tcg::math::edge_stock::pop_back' function */
 
-/* Get edge by index function.
- * ARGUMENTS:
- *   - index of edge:
- *       INT n;
- * RETURNS:
- *   (triangle_edge &) reference to edge.
- */
-tcg::math::triangle_edge & tcg::math::edge_stock::operator[]( INT n )
-{
-  return Edges[n];
-} /* End of 'tcg::math::edge_stock::operator[] function */
-
 /* Get last edge function.
  * ARGUMENTS: None.
  * RETURNS:
- *   (triangle_edge &) reference to last edge.
+ *   (const triangle_edge &) reference to edge with greatest indices.
  */
-tcg::math::triangle_edge & tcg::math::edge_stock::last( VOID )
+const tcg::math::triangle_edge & tcg::math::edge_stock::last( VOID ) const
 {
-  return Edges.back();
+  return *Edges.rbegin();
 } /* End of 'tcg::math::edge_stock::last' function */
 
 /* Get number of active edges function.
@@ -356,11 +444,86 @@ tcg::math::triangle_edge & tcg::math::edge_stock::last( VOID )
  * RETURNS:
  *   (INT) number of edges.
  */
-INT tcg::math::edge_stock::size( VOID )
+INT tcg::math::edge_stock::size( VOID ) const
 {
   return Edges.size();
 } /* End of 'tcg::math::edge_stock::size' function */
 
+/* Build grid function.
+ * ARGUMENTS:
+ *   - points to distribute:
+ *       const std::vector<point> &Points;
+ *   - average number of points per cell:
+ *       DOUBLE PointsPerCell;
+ * RETURNS: None.
+ */
+VOID tcg::math::point_grid::Build( const std::vector<point> &Points, DOUBLE PointsPerCell )
+{
+  CellStart.clear();
+  CellPoints.clear();
+  W = H = 0;
+  if (Points.size() == 0)
+    return;
+
+  DOUBLE MaxX = Points[0].Loc.X, MaxZ = Points[0].Loc.Z;
+  MinX = MaxX, MinZ = MaxZ;
+  for (INT i = 1; i < Points.size(); i++)
+  {
+    MinX = COM_MIN(MinX, Points[i].Loc.X), MaxX = COM_MAX(MaxX, Points[i].Loc.X);
+    MinZ = COM_MIN(MinZ, Points[i].Loc.Z), MaxZ = COM_MAX(MaxZ, Points[i].Loc.Z);
+  }
+
+  // Square cells with about 'PointsPerCell' points each, degenerate extents give one row or column.
+  DOUBLE
+    SizeX = MaxX - MinX,
+    SizeZ = MaxZ - MinZ,
+    NumOfCells = COM_MAX(Points.size() / PointsPerCell, 1.0);
+  if (SizeX > Threshold && SizeZ > Threshold)
+    CellSize = sqrt(SizeX * SizeZ / NumOfCells);
+  else
+    CellSize = COM_MAX(COM_MAX(SizeX, SizeZ) / NumOfCells, Threshold);
+  W = COM_MIN((INT)(SizeX / CellSize) + 1, (INT)NumOfCells + 1);
+  H = COM_MIN((INT)(SizeZ / CellSize) + 1, (INT)NumOfCells + 1);
+
+  // Counting sort of points by cells.
+  std::vector<INT> Cells(Points.size());
+  CellStart.assign(W * H + 1, 0);
+  for (INT i = 0; i < Points.size(); i++)
+    CellStart[(Cells[i] = CellZ(Points[i].Loc.Z) * W + CellX(Points[i].Loc.X)) + 1]++;
+  for (INT i = 0; i < W * H; i++)
+    CellStart[i + 1] += CellStart[i];
+  CellPoints.resize(Points.size());
+  std::vector<INT> Fill(CellStart.begin(), CellStart.end() - 1);
+  for (INT i = 0; i < Points.size(); i++)
+    CellPoints[Fill[Cells[i]]++] = i;
+} /* End of 'tcg::math::point_grid::Build' function */
+
+/* Get cell column function.
+ * ARGUMENTS:
+ *   - coordinate:
+ *       DOUBLE X;
+ * RETURNS:
+ *   (INT) column clamped to grid.
+ */
+INT tcg::math::point_grid::CellX( DOUBLE X ) const
+{
+  DOUBLE x = (X - MinX) / CellSize;
+  return x <= 0 ? 0 : x >= W - 1 ? W - 1 : (INT)x;
+} /* End of 'tcg::math::point_grid::CellX' function */
+
+/* Get cell row function.
+ * ARGUMENTS:
+ *   - coordinate:
+ *       DOUBLE Z;
+ * RETURNS:
+ *   (INT) row clamped to grid.
+ */
+INT tcg::math::point_grid::CellZ( DOUBLE Z ) const
+{
+  DOUBLE z = (Z - MinZ) / CellSize;
+  return z <= 0 ? 0 : z >= H - 1 ? H - 1 : (INT)z;
+} /* End of 'tcg::math::point_grid::CellZ' function */
+
 /* Triangulate set of points function.
  * ARGUMENTS:
  *   - set of points:
@@ -397,42 +560,52 @@ VOID tcg::math::Triangulate( const std::vector<vec> &Points, std::vector<triangl
   });
 
   // Build convex hull.
+  std::vector<triangle_edge> Hull;
+
+  // Exact vectors rotation, 'Rotation' threshold leaves concave hull in dense sets.
+  auto Turn = []( const vec &a, const vec &b ) -> INT
+  {
+    DOUBLE c = b.X * a.Z - a.X * b.Z;
+
+    return c > 0 ? 1 : c < 0 ? -1 : 0;
+  };
 
   // Bottom side.
-  ActiveEdges.push_back(triangle_edge(0, 1));
+  Hull.push_back(triangle_edge(0, 1));
   for (INT i = 1; i < RoundPoints.size() - 1; i++)
   {
     INT rotation =
-      Rotation(RoundPoints[ActiveEdges.last().P1].Loc - RoundPoints[ActiveEdges.last().P0].Loc, RoundPoints[i + 1].Loc - RoundPoints[ActiveEdges.last().P1].Loc);
-    while (rotation < 0 && ActiveEdges.size() > 0)
+      Turn(RoundPoints[Hull.back().P1].Loc - RoundPoints[Hull.back().P0].Loc, RoundPoints[i + 1].Loc - RoundPoints[Hull.back().P1].Loc);
+    while (rotation < 0 && Hull.size() > 0)
     {
-      ActiveEdges.pop_back();
-      if (ActiveEdges.size() > 0)
+      Hull.pop_back();
+      if (Hull.size() > 0)
         rotation =
-          Rotation(RoundPoints[ActiveEdges.last().P1].Loc - RoundPoints[ActiveEdges.last().P0].Loc, RoundPoints[i + 1].Loc - RoundPoints[ActiveEdges.last().P1].Loc);
+          Turn(RoundPoints[Hull.back().P1].Loc - RoundPoints[Hull.back().P0].Loc, RoundPoints[i + 1].Loc - RoundPoints[Hull.back().P1].Loc);
     }
-    if (ActiveEdges.size() > 0)
-      ActiveEdges.push_back(triangle_edge(ActiveEdges.last().P1, i + 1));
+    if (Hull.size() > 0)
+      Hull.push_back(triangle_edge(Hull.back().P1, i + 1));
     else
-      ActiveEdges.push_back(triangle_edge(0, i + 1));
+      Hull.push_back(triangle_edge(0, i + 1));
   }
   // Top side.
-  ActiveEdges.push_back(triangle_edge(ActiveEdges.last().P1, Points.size() - 2));
+  Hull.push_back(triangle_edge(Hull.back().P1, Points.size() - 2));
   for (INT i = RoundPoints.size() - 2; i > 0; i--)
   {
     INT rotation =
-      Rotation(RoundPoints[ActiveEdges.last().P1].Loc - RoundPoints[ActiveEdges.last().P0].Loc, RoundPoints[i - 1].Loc - RoundPoints[ActiveEdges.last().P1].Loc);
-    while (rotation < 0 && ActiveEdges.size() > 0)
+      Turn(RoundPoints[Hull.back().P1].Loc - RoundPoints[Hull.back().P0].Loc, RoundPoints[i - 1].Loc - RoundPoints[Hull.back().P1].Loc);
+    while (rotation < 0 && Hull.size() > 0)
     {
-      ActiveEdges.pop_back();
-      if (ActiveEdges.size() > 0)
+      Hull.pop_back();
+      if (Hull.size() > 0)
         rotation =
-          Rotation(RoundPoints[ActiveEdges.last().P1].Loc - RoundPoints[ActiveEdges.last().P0].Loc, RoundPoints[i - 1].Loc - RoundPoints[ActiveEdges.last().P1].Loc);
+          Turn(RoundPoints[Hull.back().P1].Loc - RoundPoints[Hull.back().P0].Loc, RoundPoints[i - 1].Loc - RoundPoints[Hull.back().P1].Loc);
     }
-    ActiveEdges.push_back(triangle_edge(ActiveEdges.last().P1, i - 1));
+    Hull.push_back(triangle_edge(Hull.back().P1, i - 1));
   }
 
-  ActiveEdges.sort();
+  for (INT i = 0; i < Hull.size(); i++)
+    ActiveEdges.add(Hull[i]);
 
   // Number of triangles is n + i - 2, where
   // n is number of points, i is number of interior points.
@@ -445,6 +618,10 @@ VOID tcg::math::Triangulate( const std::vector<vec> &Points, std::vector<triangl
   triangle_edge CurrentEdge;     // Current edge.
   vec P0, P1, P01;               // Current edge coordinates.
   ray Perp0, Perp1;              // Median perpendiculars coordinates.
+  point_grid Grid;               // Grid of points for mating point search.
+  INT CX, CZ;                    // Cell of current edge center.
+
+  Grid.Build(RoundPoints);
 
   // Search triangles while stock of edges is not empty.
   while (ActiveEdges.size() > 0)
@@ -460,42 +637,155 @@ VOID tcg::math::Triangulate( const std::vector<vec> &Points, std::vector<triangl
     Perp0.Org = (P0 + P1) / 2;
     Perp0.Dir = vec(P1.Z - P0.Z, 0, P0.X - P1.X).Normalizing();
 
-    // Find mating point(s).
-    for (INT i = 0; i < Points.size(); i++)
+    // Find mating point(s) in cells around edge center.
+    // Any better point lies in the free side part of the current circle,
+    // so only cells crossing that part are visited.
+    DOUBLE
+      Margin = Grid.CellSize * 1e-6 + Threshold,
+      MinX, MaxX, MinZ, MaxZ;
+    BOOL IsWhole = FALSE;
+    INT k;
+
+    auto Visit = [&]( INT x, INT z )
     {
-      // Skip points of current edge.
-      if (i == CurrentEdge.P0 || i == CurrentEdge.P1)
-        continue;
-      // Skip triangles in right side.
-      if (Rotation(P1 - P0, RoundPoints[i].Loc - P1) <= 0)
-        continue;
-      Perp1.Org = (RoundPoints[i].Loc + P1) / 2;
-      Perp1.Dir = vec(RoundPoints[i].Loc.Z - P1.Z, 0, P1.X - RoundPoints[i].Loc.X);
-      // Coordinate of circle center.
-      denom = Perp0.Dir.Z * Perp1.Dir.X - Perp0.Dir.X * Perp1.Dir.Z;
-      if (fabs(denom) < Threshold)
-        continue;
-      t = (Perp1.Dir.X * (Perp1.Org.Z - Perp0.Org.Z) + Perp1.Dir.Z * (Perp0.Org.X - Perp1.Org.X)) / denom;
-
-      // Found some points on one circle.
-      if (fabs(t - MinT) < Threshold)
+      for (INT j = Grid.CellStart[z * Grid.W + x]; j < Grid.CellStart[z * Grid.W + x + 1]; j++)
       {
-        if (!MoreMatingPoints)
+        INT i = Grid.CellPoints[j];
+
+        // Skip points of current edge.
+        if (i == CurrentEdge.P0 || i == CurrentEdge.P1)
+          continue;
+        // Skip triangles in right side (by distance to edge line,
+        // 'Rotation' threshold drops valid points of short edges in dense sets).
+        if ((RoundPoints[i].Loc.X - P1.X) * P01.Z - P01.X * (RoundPoints[i].Loc.Z - P1.Z) < Threshold)
+          continue;
+        Perp1.Org = (RoundPoints[i].Loc + P1) / 2;
+        Perp1.Dir = vec(RoundPoints[i].Loc.Z - P1.Z, 0, P1.X - RoundPoints[i].Loc.X);
+        // Coordinate of circle center.
+        denom = Perp0.Dir.Z * Perp1.Dir.X - Perp0.Dir.X * Perp1.Dir.Z;
+        if (fabs(denom) < Threshold)
+          continue;
+        t = (Perp1.Dir.X * (Perp1.Org.Z - Perp0.Org.Z) + Perp1.Dir.Z * (Perp0.Org.X - Perp1.Org.X)) / denom;
+
+        // Found some points on one circle.
+        if (fabs(t - MinT) < Threshold)
         {
-          MoreMatingPoints = TRUE;
-          MatingPoints.clear();
-          MatingPoints.push_back(MatingPoint);
+          if (!MoreMatingPoints)
+          {
+            MoreMatingPoints = TRUE;
+            MatingPoints.clear();
+            MatingPoints.push_back(MatingPoint);
+          }
+          MatingPoints.push_back(i);
+        }
+        // Found circle with less center coordinate.
+        else if (t < MinT)
+        {
+          MoreMatingPoints = FALSE;
+          MinT = t;
+          MatingPoint = i;
         }
-        MatingPoints.push_back(i);
       }
-      // Found circle with less center coordinate.
-      else if (t < MinT)
+    };
+
+    // Bound free side part of current circle: whole circle if its center is in free side,
+    // segment over edge with height 'R + MinT' otherwise.
+    auto Bound = [&]( VOID )
+    {
+      DOUBLE R = sqrt(((P1 - P0) & (P1 - P0)) / 4 + MinT * MinT);
+
+      if (MinT >= 0)
       {
-        MoreMatingPoints = FALSE;
-        MinT = t;
-        MatingPoint = i;
+        vec C = Perp0.Org + Perp0.Dir * MinT;
+
+        MinX = C.X - R, MaxX = C.X + R;
+        MinZ = C.Z - R, MaxZ = C.Z + R;
+      }
+      else
+      {
+        vec H = Perp0.Dir * (R + MinT);
+
+        MinX = COM_MIN(COM_MIN(P0.X, P1.X), COM_MIN(P0.X + H.X, P1.X + H.X));
+        MaxX = COM_MAX(COM_MAX(P0.X, P1.X), COM_MAX(P0.X + H.X, P1.X + H.X));
+        MinZ = COM_MIN(COM_MIN(P0.Z, P1.Z), COM_MIN(P0.Z + H.Z, P1.Z + H.Z));
+        MaxZ = COM_MAX(COM_MAX(P0.Z, P1.Z), COM_MAX(P0.Z + H.Z, P1.Z + H.Z));
       }
+      MinX -= Margin, MaxX += Margin;
+      MinZ -= Margin, MaxZ += Margin;
+    };
+
+    // Get cells of one row crossing free side part of current circle.
+    auto Row = [&]( INT z, INT &X0, INT &X1 ) -> BOOL
+    {
+      DOUBLE
+        R = sqrt(((P1 - P0) & (P1 - P0)) / 4 + MinT * MinT) + Margin,
+        Bottom = Grid.MinZ + z * Grid.CellSize, Top = Bottom + Grid.CellSize,
+        CenterX = Perp0.Org.X + Perp0.Dir.X * MinT,
+        CenterZ = Perp0.Org.Z + Perp0.Dir.Z * MinT,
+        dz = COM_MAX(COM_MAX(Bottom - CenterZ, CenterZ - Top), 0.0),
+        Side = Perp0.Dir.Z * ((Perp0.Dir.Z > 0 ? Top : Bottom) - P1.Z) + Margin,
+        w, Left, Right;
+
+      if (dz > R)
+        return FALSE;
+      w = sqrt(R * R - dz * dz);
+      Left = CenterX - w, Right = CenterX + w;
+      // Clip by edge line.
+      if (Perp0.Dir.X > Threshold)
+        Left = COM_MAX(Left, P1.X - Side / Perp0.Dir.X);
+      else if (Perp0.Dir.X < -Threshold)
+        Right = COM_MIN(Right, P1.X - Side / Perp0.Dir.X);
+      else if (Side < 0)
+        return FALSE;
+      if (Left > Right)
+        return FALSE;
+      X0 = Grid.CellX(Left);
+      X1 = Grid.CellX(Right);
+      return TRUE;
+    };
+
+    // Visit rings of cells until some mating point is found.
+    CX = Grid.CellX(Perp0.Org.X);
+    CZ = Grid.CellZ(Perp0.Org.Z);
+    for (k = 0; ; k++)
+    {
+      for (INT z = COM_MAX(CZ - k, 0); z <= COM_MIN(CZ + k, Grid.H - 1); z++)
+        if (z == CZ - k || z == CZ + k)
+          for (INT x = COM_MAX(CX - k, 0); x <= COM_MIN(CX + k, Grid.W - 1); x++)
+            Visit(x, z);
+        else
+        {
+          if (CX - k >= 0)
+            Visit(CX - k, z);
+          if (CX + k < Grid.W)
+            Visit(CX + k, z);
+        }
+      IsWhole = CX - k <= 0 && CZ - k <= 0 && CX + k >= Grid.W - 1 && CZ + k >= Grid.H - 1;
+      if (IsWhole || MatingPoint != -1)
+        break;
     }
+
+    // Visit rest of circle part row by row, it shrinks with every better point.
+    if (!IsWhole)
+    {
+      Bound();
+      if (Grid.CellX(MinX) < CX - k || Grid.CellX(MaxX) > CX + k ||
+          Grid.CellZ(MinZ) < CZ - k || Grid.CellZ(MaxZ) > CZ + k)
+        for (INT d = 0; ; d++)
+        {
+          INT Z0 = Grid.CellZ(MinZ), Z1 = Grid.CellZ(MaxZ), X0, X1;
+
+          if (CZ + d > Z1 && CZ - d < Z0)
+            break;
+          for (INT z = CZ - d; z <= CZ + d; z += COM_MAX(2 * d, 1))
+            if (z >= Z0 && z <= Z1 && Row(z, X0, X1))
+              for (INT x = X0; x <= X1; x++)
+                if (COM_ABS(x - CX) > k || COM_ABS(z - CZ) > k)
+                  Visit(x, z);
+          Bound();
+        }
+    }
+
     // Found one new triangle.
     if (!MoreMatingPoints)
     {
@@ -507,7 +797,7 @@ VOID tcg::math::Triangulate( const std::vector<vec> &Points, std::vector<triangl
     // Found some new triangles on one circle.
     else
     {
-      std::sort(MatingPoints.begin(), MatingPoints.end(), [RoundPoints, P0, P01]( INT a, INT b )
+      std::sort(MatingPoints.begin(), MatingPoints.end(), [&RoundPoints, P0, P01]( INT a, INT b )
       {
         return (P01 & (RoundPoints[a].Loc - P0).Normalizing()) > (P01 & (RoundPoints[b].Loc - P0).Normalizing());
       });
@@ -0,0 +1,184 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : cpu.h
+ * PURPOSE     : Computational geometry project.
+ *               Processor features detection module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __cpu_h_
+#define __cpu_h_
+
+#include "../def.h"
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#else /* _MSC_VER */
+#  include <cpuid.h>
+#endif /* _MSC_VER */
+#include <immintrin.h>
+
+#include <atomic>
+
+/* Instruction set target attribute for SIMD kernels (MSVC needs none) */
+#ifdef _MSC_VER
+#  define TCG_TARGET(Isa)
+#else /* _MSC_VER */
+#  define TCG_TARGET(Isa) __attribute__((target(Isa)))
+#endif /* _MSC_VER */
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Processor support namespace */
+  namespace cpu
+  {
+    /* Supported SIMD instruction set levels */
+    enum
+    {
+      SIMD_NONE,   // Scalar code only
+      SIMD_SSE4,   // SSE 4.1
+      SIMD_AVX2    // AVX2 (with OS YMM state support)
+    }; /* End of enum */
+
+    /* Detect best supported SIMD level function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) one of 'SIMD_***' values.
+     */
+    inline INT DetectSimd( VOID )
+    {
+#ifdef _MSC_VER
+      INT Info[4];
+
+      __cpuid(Info, 0);
+      if (Info[0] < 1)
+        return SIMD_NONE;
+      __cpuid(Info, 1);
+      BOOL
+        IsSse4 = (Info[2] & (1 << 19)) != 0,
+        IsOsAvx = (Info[2] & (1 << 27)) != 0 && (Info[2] & (1 << 28)) != 0;
+      if (!IsSse4)
+        return SIMD_NONE;
+      if (IsOsAvx && (_xgetbv(0) & 6) == 6)
+      {
+        __cpuidex(Info, 7, 0);
+        if (Info[1] & (1 << 5))
+          return SIMD_AVX2;
+      }
+      return SIMD_SSE4;
+#else /* _MSC_VER */
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+      if (__builtin_cpu_supports("sse4.1"))
+        return SIMD_SSE4;
+      return SIMD_NONE;
+#endif /* _MSC_VER */
+    } /* End of 'DetectSimd' function */
+
+    /* Detect half float conversions (F16C) support function.
+     * F16C has its own CPUID bit: some hypervisors and processors report
+     * AVX2 with F16C masked, so AVX2 level does not imply it.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if F16C instructions may be used, FALSE otherwise.
+     */
+    inline BOOL DetectF16c( VOID )
+    {
+#ifdef _MSC_VER
+      INT Info[4];
+
+      __cpuid(Info, 0);
+      if (Info[0] < 1)
+        return FALSE;
+      __cpuid(Info, 1);
+      /* F16C, AVX and OS YMM state support */
+      if ((Info[2] & (1 << 29)) == 0 || (Info[2] & (1 << 28)) == 0 || (Info[2] & (1 << 27)) == 0)
+        return FALSE;
+      return (_xgetbv(0) & 6) == 6;
+#else /* _MSC_VER */
+      UINT Info[4];
+
+      if (!__get_cpuid(1, &Info[0], &Info[1], &Info[2], &Info[3]) || (Info[2] & (1 << 29)) == 0)
+        return FALSE;
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx") != 0;
+#endif /* _MSC_VER */
+    } /* End of 'DetectF16c' function */
+
+    /* SIMD level storage structure.
+     * Template static members are shared by all translation units and
+     * initialized before 'main', so no function-local static is needed
+     * (not thread-safe in MSVC 2013).
+     */
+    template<class Dummy>
+    struct simd_level
+    {
+      static std::atomic<INT>
+        Level, // Current SIMD level (-1 if not detected yet)
+        F16c;  // F16C support flag (-1 if not detected yet)
+    }; /* End of 'simd_level' structure */
+
+    template<class Dummy>
+      std::atomic<INT> simd_level<Dummy>::Level(-1);
+    template<class Dummy>
+      std::atomic<INT> simd_level<Dummy>::F16c(-1);
+
+    /* Obtain SIMD level to use function.
+     * Result may be lowered with 'SetSimd' (e.g. to compare kernels).
+     * Racing threads may detect level concurrently, they store the same value.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) current SIMD level.
+     */
+    inline INT Simd( VOID )
+    {
+      INT Level = simd_level<VOID>::Level.load(std::memory_order_relaxed);
+
+      if (Level < 0)
+        simd_level<VOID>::Level.store(Level = DetectSimd(), std::memory_order_relaxed);
+      return Level;
+    } /* End of 'Simd' function */
+
+    /* Check half float conversions (F16C) usage function.
+     * F16C is used with AVX2 level only, so 'SetSimd' disables it too.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if F16C kernels may run, FALSE otherwise.
+     */
+    inline BOOL IsF16c( VOID )
+    {
+      INT F16c = simd_level<VOID>::F16c.load(std::memory_order_relaxed);
+
+      if (F16c < 0)
+        simd_level<VOID>::F16c.store(F16c = DetectF16c(), std::memory_order_relaxed);
+      return F16c && Simd() == SIMD_AVX2;
+    } /* End of 'IsF16c' function */
+
+    /* Limit SIMD level function.
+     * ARGUMENTS:
+     *   - maximal level to use:
+     *       INT Level;
+     * RETURNS: None.
+     */
+    inline VOID SetSimd( INT Level )
+    {
+      INT Detected = DetectSimd();
+
+      simd_level<VOID>::Level.store(Level < Detected ? Level : Detected);
+    } /* End of 'SetSimd' function */
+  } /* end of 'cpu' namespace */
+} /* end of 'tcg' namespace */
+
+#endif /* __cpu_h_ */
+
+/* END OF 'cpu.h' FILE */
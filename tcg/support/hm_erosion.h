@@ -0,0 +1,371 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : hm_erosion.h
+ * PURPOSE     : Computational geometry project.
+ *               Height map hydraulic and thermal erosion module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __hm_erosion_h_
+#define __hm_erosion_h_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+#include "../def.h"
+#include "thread_pool.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Height map erosion class.
+   * Hydraulic erosion is grid based (virtual pipes water flow, sediment
+   * dissolving/deposition and semi-Lagrangian transport), thermal erosion
+   * moves material down slopes steeper than talus one. Grid is kept as
+   * separate arrays of every cell field (row by row), every pass reads
+   * previous pass arrays and writes own cell only, so row bands are done
+   * in parallel and result does not depend on threads number. */
+  class hm_erosion
+  {
+  public:
+    /* Erosion parameters (depths and talus are in height map units) */
+    struct params
+    {
+      INT Iterations;       // Iterations budget (0 - no erosion)
+      INT Seed;             // Rain random seed
+      FLOAT Rain;           // Mean rain water depth per iteration
+      FLOAT Evaporation;    // Evaporated water part per iteration
+      FLOAT Capacity;       // Sediment capacity factor
+      FLOAT Dissolve;       // Dissolving rate (0..1)
+      FLOAT Deposit;        // Deposition rate (0..1)
+      FLOAT Talus;          // Thermal talus slope (height per map space unit)
+      FLOAT Thermal;        // Thermal relaxation rate (0..1)
+
+      /* Structure constructor.
+       * ARGUMENTS:
+       *   - iterations budget (0 - no erosion):
+       *       INT Iterations;
+       *   - rain random seed:
+       *       INT Seed;
+       */
+      params( INT Iterations = 0, INT Seed = 0 ) :
+        Iterations(Iterations), Seed(Seed), Rain(0.0002f), Evaporation(0.02f), Capacity(0.5f),
+        Dissolve(0.3f), Deposit(0.3f), Talus(3), Thermal(0.5f)
+      {
+      } /* End of 'params' constructor */
+    }; /* End of 'params' struct */
+
+  private:
+    static const INT BandRows = 16;  // Grid rows per work item
+    const INT W, H;                  // Grid size
+    const FLOAT CellSize;            // Grid cell size in map space
+    params Params;                   // Erosion parameters
+    DOUBLE CellsPerSecond;           // Measured speed of last run (grid cells per second per iteration)
+    std::vector<FLOAT>
+      B, B2,                         // Terrain heights (current and next, in cell sizes)
+      Water,                         // Water depths
+      S, S2,                         // Suspended sediment (current and next)
+      FL, FR, FT, FB,                // Outflow fluxes to left, right, top (previous row) and bottom neighbours
+      U, V;                          // Water velocities (cells per iteration)
+
+    /* Rain random value function.
+     * ARGUMENTS:
+     *   - iteration and cell numbers:
+     *       INT It;
+     *       size_t Cell;
+     * RETURNS:
+     *   (FLOAT) value in [0, 2).
+     */
+    FLOAT RainRandom( INT It, size_t Cell ) const
+    {
+      UINT x = (UINT)Cell * 0x9E3779B1u ^ (UINT)It * 0x85EBCA77u ^ (UINT)Params.Seed * 0xC2B2AE3Du;
+
+      x ^= x >> 16;
+      x *= 0x7FEB352Du;
+      x ^= x >> 15;
+      x *= 0x846CA68Bu;
+      x ^= x >> 16;
+      return (x >> 8) * (2.0f / (1 << 24));
+    } /* End of 'RainRandom' function */
+
+    /* Run pass over all grid rows in parallel function.
+     * ARGUMENTS:
+     *   - threads pool:
+     *       thread_pool &Pool;
+     *   - row pass callback (gets row number):
+     *       const thread_pool::job &Row;
+     * RETURNS: None.
+     */
+    VOID Pass( thread_pool &Pool, const thread_pool::job &Row ) const
+    {
+      Pool.ParallelFor((H + BandRows - 1) / BandRows, [&]( INT Band )
+        {
+          for (INT i = Band * BandRows; i < H && i < (Band + 1) * BandRows; i++)
+            Row(i);
+        });
+    } /* End of 'Pass' function */
+
+    /* Water outflow fluxes row evaluation function (closed map borders).
+     * ARGUMENTS:
+     *   - row number:
+     *       INT i;
+     * RETURNS: None.
+     */
+    VOID FluxRow( INT i )
+    {
+      const FLOAT Flow = 0.5f;  // Pipe flow factor (gravity * pipe area / length * time step)
+      size_t Row = (size_t)i * W;
+
+      for (INT j = 0; j < W; j++)
+      {
+        size_t c = Row + j;
+        FLOAT
+          h = B[c] + Water[c],
+          l = j > 0 ? std::max(0.0f, FL[c] + Flow * (h - B[c - 1] - Water[c - 1])) : 0,
+          r = j < W - 1 ? std::max(0.0f, FR[c] + Flow * (h - B[c + 1] - Water[c + 1])) : 0,
+          t = i > 0 ? std::max(0.0f, FT[c] + Flow * (h - B[c - W] - Water[c - W])) : 0,
+          b = i < H - 1 ? std::max(0.0f, FB[c] + Flow * (h - B[c + W] - Water[c + W])) : 0,
+          Sum = l + r + t + b,
+          /* Outflow can not exceed cell water */
+          k = Sum > Water[c] ? Water[c] / Sum : 1;
+
+        FL[c] = l * k;
+        FR[c] = r * k;
+        FT[c] = t * k;
+        FB[c] = b * k;
+      }
+    } /* End of 'FluxRow' function */
+
+    /* Water, velocity and erosion/deposition row evaluation function.
+     * ARGUMENTS:
+     *   - row number:
+     *       INT i;
+     * RETURNS: None.
+     */
+    VOID WaterRow( INT i )
+    {
+      size_t Row = (size_t)i * W;
+
+      for (INT j = 0; j < W; j++)
+      {
+        size_t c = Row + j;
+        FLOAT
+          fl = j > 0 ? FR[c - 1] : 0,      // Inflows from neighbours
+          fr = j < W - 1 ? FL[c + 1] : 0,
+          ft = i > 0 ? FB[c - W] : 0,
+          fb = i < H - 1 ? FT[c + W] : 0,
+          w0 = Water[c],
+          w1 = std::max(0.0f, w0 + fl + fr + ft + fb - FL[c] - FR[c] - FT[c] - FB[c]),
+          wa = (w0 + w1) / 2,
+          u = wa > 1e-4f ? (fl - FL[c] + FR[c] - fr) / 2 / wa : 0,
+          v = wa > 1e-4f ? (ft - FT[c] + FB[c] - fb) / 2 / wa : 0,
+          /* Terrain tilt sine by central differences */
+          gx = (B[j < W - 1 ? c + 1 : c] - B[j > 0 ? c - 1 : c]) / 2,
+          gy = (B[i < H - 1 ? c + W : c] - B[i > 0 ? c - W : c]) / 2,
+          Sin = sqrt((gx * gx + gy * gy) / (1 + gx * gx + gy * gy)),
+          Cap = Params.Capacity * std::max(Sin, 0.01f) * sqrt(u * u + v * v) * std::min(w1, 1.0f),
+          d = Cap > S[c] ? Params.Dissolve * (Cap - S[c]) : -Params.Deposit * (S[c] - Cap);
+
+        Water[c] = w1;
+        U[c] = u;
+        V[c] = v;
+        B2[c] = B[c] - d;
+        S[c] += d;
+      }
+    } /* End of 'WaterRow' function */
+
+    /* Sediment transport, evaporation and next iteration rain row evaluation function.
+     * ARGUMENTS:
+     *   - row number:
+     *       INT i;
+     *   - next iteration number:
+     *       INT It;
+     * RETURNS: None.
+     */
+    VOID TransportRow( INT i, INT It )
+    {
+      size_t Row = (size_t)i * W;
+      FLOAT Rain = Params.Rain / CellSize, Keep = 1 - Params.Evaporation;
+
+      for (INT j = 0; j < W; j++)
+      {
+        size_t c = Row + j;
+        /* Sediment comes from upstream point (bilinear sample) */
+        FLOAT
+          x = std::min(std::max(j - U[c], 0.0f), (FLOAT)(W - 1)),
+          y = std::min(std::max(i - V[c], 0.0f), (FLOAT)(H - 1));
+        INT
+          x0 = std::min((INT)x, W - 2 > 0 ? W - 2 : 0),
+          y0 = std::min((INT)y, H - 2 > 0 ? H - 2 : 0),
+          x1 = std::min(x0 + 1, W - 1),
+          y1 = std::min(y0 + 1, H - 1);
+        FLOAT
+          fx = x - x0, fy = y - y0,
+          s0 = S[(size_t)y0 * W + x0] + (S[(size_t)y0 * W + x1] - S[(size_t)y0 * W + x0]) * fx,
+          s1 = S[(size_t)y1 * W + x0] + (S[(size_t)y1 * W + x1] - S[(size_t)y1 * W + x0]) * fx;
+
+        S2[c] = s0 + (s1 - s0) * fy;
+        Water[c] = Water[c] * Keep + Rain * RainRandom(It, c);
+      }
+    } /* End of 'TransportRow' function */
+
+    /* Thermal outflow row evaluation function.
+     * Cell gives part of its largest excess over talus slope, which is
+     * split between lower neighbours by their excesses.
+     * ARGUMENTS:
+     *   - row number:
+     *       INT i;
+     *   - thermal outflow and excesses sum rows (result):
+     *       FLOAT *Out, *Sum;
+     * RETURNS: None.
+     */
+    VOID ThermalOutRow( INT i, FLOAT *Out, FLOAT *Sum ) const
+    {
+      size_t Row = (size_t)i * W;
+      FLOAT T = Params.Talus;
+
+      for (INT j = 0; j < W; j++)
+      {
+        size_t c = Row + j;
+        FLOAT
+          l = j > 0 ? std::max(0.0f, B[c] - B[c - 1] - T) : 0,
+          r = j < W - 1 ? std::max(0.0f, B[c] - B[c + 1] - T) : 0,
+          t = i > 0 ? std::max(0.0f, B[c] - B[c - W] - T) : 0,
+          b = i < H - 1 ? std::max(0.0f, B[c] - B[c + W] - T) : 0;
+
+        Sum[c] = l + r + t + b;
+        Out[c] = Params.Thermal * std::max(std::max(l, r), std::max(t, b)) / 2;
+      }
+    } /* End of 'ThermalOutRow' function */
+
+    /* Thermal material gathering row evaluation function.
+     * ARGUMENTS:
+     *   - row number:
+     *       INT i;
+     *   - thermal outflow and excesses sum:
+     *       const FLOAT *Out, *Sum;
+     * RETURNS: None.
+     */
+    VOID ThermalInRow( INT i, const FLOAT *Out, const FLOAT *Sum )
+    {
+      size_t Row = (size_t)i * W;
+      FLOAT T = Params.Talus;
+      auto In = [&]( size_t c, size_t n )
+      {
+        FLOAT e = B[n] - B[c] - T;
+
+        return e > 0 ? Out[n] * e / Sum[n] : 0;
+      };
+
+      for (INT j = 0; j < W; j++)
+      {
+        size_t c = Row + j;
+        FLOAT h = B[c] - Out[c];
+
+        if (j > 0)
+          h += In(c, c - 1);
+        if (j < W - 1)
+          h += In(c, c + 1);
+        if (i > 0)
+          h += In(c, c - W);
+        if (i < H - 1)
+          h += In(c, c + W);
+        B2[c] = h;
+      }
+    } /* End of 'ThermalInRow' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS:
+     *   - height map size:
+     *       INT W, H;
+     *   - height map cell size in map space:
+     *       FLOAT CellSize;
+     *   - erosion parameters:
+     *       const params &Params;
+     */
+    hm_erosion( INT W, INT H, FLOAT CellSize, const params &Params ) :
+      W(W), H(H), CellSize(CellSize), Params(Params), CellsPerSecond(0)
+    {
+      size_t Size = (size_t)W * H;
+
+      for (auto *a : {&B, &B2, &Water, &S, &S2, &FL, &FR, &FT, &FB, &U, &V})
+        a->assign(Size, 0);
+    } /* End of 'hm_erosion' constructor */
+
+    /* Erode height map function.
+     * ARGUMENTS:
+     *   - height map (row by row, changed in place):
+     *       FLOAT *Heights;
+     *   - threads pool:
+     *       thread_pool &Pool;
+     *   - progress callback (gets done fraction, returns FALSE to cancel):
+     *       const thread_pool::progress &Progress;
+     * RETURNS:
+     *   (BOOL) TRUE if all iterations were done, FALSE if canceled (heights are unchanged).
+     */
+    BOOL Run( FLOAT *Heights, thread_pool &Pool, const thread_pool::progress &Progress = nullptr )
+    {
+      size_t Size = (size_t)W * H;
+      std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+      /* Speed is measured over done iterations */
+      auto Measure = [&]( INT Done )
+      {
+        DOUBLE Time = std::chrono::duration<DOUBLE>(std::chrono::steady_clock::now() - Start).count();
+
+        if (Time > 0)
+          CellsPerSecond = (DOUBLE)Size * Done / Time;
+      };
+
+      /* Work in cell size units, so slopes are the same as in map space */
+      for (size_t k = 0; k < Size; k++)
+        B[k] = Heights[k] / CellSize, Water[k] = Params.Rain / CellSize * RainRandom(0, k);
+      for (INT It = 0; It < Params.Iterations; It++)
+      {
+        Pass(Pool, [&]( INT i ){ FluxRow(i); });
+        Pass(Pool, [&]( INT i ){ WaterRow(i); });
+        Pass(Pool, [&]( INT i ){ TransportRow(i, It + 1); });
+        B.swap(B2);
+        S.swap(S2);
+        /* Velocities are free till next iteration */
+        if (Params.Thermal > 0)
+        {
+          Pass(Pool, [&]( INT i ){ ThermalOutRow(i, &U[0], &V[0]); });
+          Pass(Pool, [&]( INT i ){ ThermalInRow(i, &U[0], &V[0]); });
+          B.swap(B2);
+        }
+        Measure(It + 1);
+        if (Progress && !Progress((It + 1.0) / Params.Iterations))
+          return FALSE;
+      }
+      /* Suspended sediment settles down */
+      for (size_t k = 0; k < Size; k++)
+        Heights[k] = (B[k] + S[k]) * CellSize;
+      return TRUE;
+    } /* End of 'Run' function */
+
+    /* Obtain measured erosion speed function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (DOUBLE) grid cells processed per second by one iteration of last run (0 if not run).
+     */
+    DOUBLE GetCellsPerSecond( VOID ) const
+    {
+      return CellsPerSecond;
+    } /* End of 'GetCellsPerSecond' function */
+  }; /* End of 'hm_erosion' class */
+} /* end of 'tcg' namespace */
+
+#endif /* __hm_erosion_h_ */
+
+/* END OF 'hm_erosion.h' FILE */
@@ -4,64 +4,701 @@
 #define __hm_gen_h_
 
 #include <ctime>
+#include <cstdio>
+#include <vector>
+#include <functional>
+#include <string>
+#include <cfloat>
 
 #include "../def.h"
 #include "../math/noise.h"
+#include "thread_pool.h"
+#include "map_pyramid.h"
+#include "hm_erosion.h"
+#include "map_minmax.h"
 
 namespace tcg
 {
   using namespace math;
-  /* Animation hm_gen class */
+
+  /* Normal map evaluation modes */
+  enum hm_normals
+  {
+    HM_NORMALS_ANALYTIC,  // Analytic fBm gradient per texel
+    HM_NORMALS_CENTRAL,   // Central differences of shared height grid
+    HM_NORMALS_SOBEL      // Sobel filter over shared height grid
+  }; /* End of 'hm_normals' enum */
+
+  /* Height map storage encodings */
+  enum hm_heights
+  {
+    HM_HEIGHTS_FLOAT,   // 32-bit floats
+    HM_HEIGHTS_UINT16,  // 16-bit codes with per-file (per-tile in pyramid) scale and bias
+    HM_HEIGHTS_HALF     // Half floats
+  }; /* End of 'hm_heights' enum */
+
+  /* Normal map storage encodings */
+  enum hm_normal_format
+  {
+    HM_NORMAL_SHORT3,  // 3 x 16-bit components
+    HM_NORMAL_OCT16,   // Octahedral 2 x 16-bit codes
+    HM_NORMAL_OCT8     // Octahedral 2 x 8-bit codes
+  }; /* End of 'hm_normal_format' enum */
+
+  /* Animation hm_gen class.
+   * Maps are generated by row bands which are written to files as soon as
+   * they are ready, so memory use depends on maps width and threads number only. */
   class hm_gen
   {
-  public:
-    /* Class constructor.
-     * ARGUMENTS: None.
+  private:
+    static const int
+      HeightTile = 16,   // Height map rows per work item
+      NormalTile = 64,   // Normal map rows per work item
+      b = 10;            // Maps side in noise space
+    int w, nw;           // Height and normal maps sizes
+    hm_heights Heights;  // Height map storage encoding
+    float MaxError;      // Maximal height encoding error
+    hm_normal_format NormalFormat;  // Normal map storage encoding
+    float MaxNormalError;           // Maximal normal encoding error in degrees
+    bool IsPacked;       // Lossless maps packing flag
+    hm_erosion::params Erosion;  // Height map erosion parameters
+    double ErosionRate;          // Measured erosion speed (cells per second per iteration)
+    bool IsDone;         // Generation completion flag
+
+    /* Float height map file encoding function.
+     * Map is read through file mapping and encoded by row chunks,
+     * result replaces source file.
+     * ARGUMENTS:
+     *   - height map file name:
+     *       const char *FileName;
+     * RETURNS:
+     *   (float) maximal absolute error of encoded heights.
      */
-    hm_gen( double H, double Lacunarity, double Gain, double Offset, double Octaves, int Seed )
+    float Encode( const char *FileName ) const
     {
-      math::fBm_multi_ridged fBm(H, Lacunarity, Gain, Offset, Octaves, Seed);
-      int w = 1024, size = w * w;
-      double b = 10;
-      float *pix = new float[size];
-      for (int i = 0; i < w; i++)
-        for (int j = 0; j < w; j++)
-          pix[i * w + j] = fBm(vec(j / (double)w * b, i / (double)w * b, 0));
-
-      FILE *f;
-
-      if ((f = fopen("bin/textures/heightmap1.float", "wb")) == nullptr)
-        throw "Too bad - file won't open!";
-      fwrite(&w, sizeof(int), 1, f);
-      fwrite(&w, sizeof(int), 1, f);
-      fwrite(pix, sizeof(float), size, f);
-      fclose(f);
-
-      w = 4096;
-      size = w * w;
-      float step = 1.0 / w;
-      tsg::TVec<short> *npix = new tsg::TVec<short>[size];
-      for (int i = 0; i < w; i++)
+      const size_t Chunk = (size_t)HeightTile * w;
+      float Min = FLT_MAX, Max = -FLT_MAX, Scale = 1, Bias = 0, Error = 0, e;
+      std::vector<uint16_t> codes(Chunk);
+      map_file Src;
+
+      if (!Src.Open(FileName, MAP_FLOAT) || Src.GetType() != MAP_FLOAT)
+        throw "Too bad - height map won't open!";
+
+      const float *pix = Src.GetData<float>();
+      size_t Count = (size_t)w * w;
+      map_writer f((std::string(FileName) + ".tmp").c_str(), w, w,
+        Heights == HM_HEIGHTS_UINT16 ? MAP_UINT16 : MAP_HALF);
+
+      if (Heights == HM_HEIGHTS_UINT16)
+      {
+        codec::Range(pix, Count, Min, Max);
+        codec::QuantizationParams(Min, Max, Scale, Bias);
+        f.SetQuantization(Scale, Bias);
+      }
+      for (size_t i = 0; i < Count; i += Chunk)
+      {
+        size_t n = Count - i < Chunk ? Count - i : Chunk;
+
+        if (Heights == HM_HEIGHTS_UINT16)
+          e = codec::Quantize(pix + i, n, Scale, Bias, &codes[0]);
+        else
+          e = codec::EncodeHalf(pix + i, n, &codes[0]);
+        if (e > Error)
+          Error = e;
+        f.Write(&codes[0], n);
+      }
+      f.Close();
+      Src.Close();
+      Finish(FileName, true);
+      return Error;
+    } /* End of 'Encode' function */
+
+    /* Map file lossless packing function.
+     * ARGUMENTS:
+     *   - map file name (packed file replaces it):
+     *       const char *FileName;
+     * RETURNS: None.
+     */
+    static void PackFile( const char *FileName )
+    {
+      if (!map_file::Pack(FileName, (std::string(FileName) + ".tmp").c_str()))
+        throw "Too bad - map won't pack!";
+      Finish(FileName, true);
+    } /* End of 'PackFile' function */
+
+    /* Band evaluation callback type (gets rows range and band first row) */
+    typedef std::function<void ( int Row0, int Row1, int Base )> band_eval;
+    /* Band store callback type (gets rows range) */
+    typedef std::function<void ( int Row0, int Row1 )> band_store;
+
+    /* Temporary output map file finishing function.
+     * ARGUMENTS:
+     *   - file name:
+     *       const char *FileName;
+     *   - keep result (otherwise file is removed) flag:
+     *       bool IsKeep;
+     * RETURNS: None.
+     */
+    static void Finish( const char *FileName, bool IsKeep )
+    {
+      std::string Tmp = std::string(FileName) + ".tmp";
+
+      if (IsKeep)
+      {
+        remove(FileName);
+        if (rename(Tmp.c_str(), FileName) != 0)
+          throw "Too bad - file won't rename!";
+      }
+      else
+        remove(Tmp.c_str());
+    } /* End of 'Finish' function */
+
+    /* Rows streaming function.
+     * Rows are evaluated by bands of 'Tile' rows per thread, every band
+     * is stored before next one starts.
+     * ARGUMENTS:
+     *   - threads pool:
+     *       thread_pool &Pool;
+     *   - total number of rows and rows per work item:
+     *       int NumOfRows, Tile;
+     *   - rows evaluation and store callbacks:
+     *       const band_eval &Eval;
+     *       const band_store &Store;
+     *   - progress range of this pass:
+     *       double Part0, Part1;
+     *   - progress callback (may be empty):
+     *       const thread_pool::progress &Progress;
+     * RETURNS:
+     *   (bool) true if all rows were stored, false if canceled.
+     */
+    static bool Stream( thread_pool &Pool, int NumOfRows, int Tile, const band_eval &Eval, const band_store &Store,
+                        double Part0, double Part1, const thread_pool::progress &Progress )
+    {
+      int Band = Tile * Pool.GetNumOfThreads();
+
+      for (int Base = 0; Base < NumOfRows; Base += Band)
+      {
+        int End = Minimal({Base + Band, NumOfRows});
+        thread_pool::progress BandProgress;
+
+        if (Progress)
+          BandProgress = [&]( double Done )
+          {
+            return Progress(Part0 + (Part1 - Part0) * (Base + Done * (End - Base)) / NumOfRows);
+          };
+        if (!Pool.ParallelFor((End - Base + Tile - 1) / Tile, [&]( int t )
+            {
+              Eval(Base + t * Tile, Minimal({Base + (t + 1) * Tile, End}), Base);
+            }, BandProgress))
+          return false;
+        Store(Base, End);
+      }
+      return true;
+    } /* End of 'Stream' function */
+
+    /* Height map rows evaluation function.
+     * ARGUMENTS:
+     *   - fractal function:
+     *       fbm_type &fBm;
+     *   - result rows:
+     *       float *pix;
+     *   - rows range:
+     *       int Row0, Row1;
+     * RETURNS: None.
+     */
+    template<class fbm_type>
+      void HeightRows( fbm_type &fBm, float *pix, int Row0, int Row1 ) const
+      {
+        std::vector<double> X0(w), Y0(w), Z(w), H0(w);
+
         for (int j = 0; j < w; j++)
+          X0[j] = j / (double)w * b, Z[j] = 0;
+        for (int i = Row0; i < Row1; i++)
+        {
+          for (int j = 0; j < w; j++)
+            Y0[j] = i / (double)w * b;
+          fBm(&X0[0], &Y0[0], &Z[0], &H0[0], w);
+          for (int j = 0; j < w; j++)
+            pix[(size_t)(i - Row0) * w + j] = H0[j];
+        }
+      } /* End of 'HeightRows' function */
+
+    /* Normal map rows evaluation with analytic fBm gradient function.
+     * ARGUMENTS:
+     *   - fractal function:
+     *       fbm_type &fBm;
+     *   - result rows:
+     *       tsg::TVec<short> *npix;
+     *   - rows range:
+     *       int Row0, Row1;
+     * RETURNS: None.
+     */
+    template<class fbm_type>
+      void AnalyticRows( fbm_type &fBm, tsg::TVec<short> *npix, int Row0, int Row1 ) const
+      {
+        for (int i = Row0; i < Row1; i++)
+          for (int j = 0; j < nw; j++)
+          {
+            vec g;
+
+            /* Height field (x, fBm(x, z), z) normal is (-dh/dx, 1, -dh/dz) */
+            fBm.fBmD(vec(j / (double)nw * b, i / (double)nw * b, 0), g);
+            vec r = vec(-g.X, 1, -g.Y).Normalizing();
+            npix[(size_t)(i - Row0) * nw + j] = tsg::TVec<short>(r.X * 32767, r.Y * 32767, r.Z * 32767);
+          }
+      } /* End of 'AnalyticRows' function */
+
+    /* Normal map rows evaluation function object (see 'multi_ridged::Visit').
+     * Octaves number is dispatched once per rows band, so 'AnalyticRows'
+     * inlines octaves specialized gradient evaluation. */
+    struct analytic_rows
+    {
+      const hm_gen *Gen;          // Generator
+      tsg::TVec<short> *npix;     // Result rows
+      int Row0, Row1;             // Rows range
+
+      /* Constructor.
+       * ARGUMENTS:
+       *   - generator:
+       *       const hm_gen *Gen;
+       *   - result rows:
+       *       tsg::TVec<short> *npix;
+       *   - rows range:
+       *       int Row0, Row1;
+       */
+      analytic_rows( const hm_gen *Gen, tsg::TVec<short> *npix, int Row0, int Row1 ) :
+        Gen(Gen), npix(npix), Row0(Row0), Row1(Row1)
+      {
+      } /* End of 'analytic_rows' constructor */
+
+      /* Evaluate rows by octaves specialized evaluator function.
+       * ARGUMENTS:
+       *   - fractal evaluator:
+       *       fixed_type Fixed;
+       * RETURNS: None.
+       */
+      template<class fixed_type>
+        void operator()( fixed_type Fixed ) const
         {
-          tsg::TVec<double>
-            v0 = tsg::TVec<double>(j / (double)w * b, fBm(vec(j / (double)w * b, i / (double)w * b, 0)), i / (double)w * b),
-            v1 = tsg::TVec<double>((j + 1) / (double)w * b, fBm(vec((j + 1) / (double)w * b, i / (double)w * b, 0)), i / (double)w * b),
-            v2 = tsg::TVec<double>(j / (double)w * b, fBm(vec(j / (double)w * b, (i + 1) / (double)w * b, 0)), (i + 1) / (double)w * b);
-          tsg::TVec<double> r = ((v1 - v0) % (v2 - v0)).Normalizing();
-          r *= Sign(r.Y);
-          npix[i * w + j] = tsg::TVec<short>(r.X * 32767, r.Y * 32767, r.Z * 32767);
+          Gen->AnalyticRows(Fixed, npix, Row0, Row1);
+        } /* End of 'operator()' function */
+    }; /* End of 'analytic_rows' structure */
+
+    /* Normal map rows evaluation from height grid function.
+     * Grid has normal map width plus one texel apron on every side.
+     * ARGUMENTS:
+     *   - height grid ((Rows + 2) x (nw + 2) samples):
+     *       const float *Grid;
+     *   - result rows:
+     *       tsg::TVec<short> *npix;
+     *   - number of rows:
+     *       int Rows;
+     *   - use Sobel filter (otherwise central difference) flag:
+     *       bool IsSobel;
+     * RETURNS: None.
+     */
+    void GridNormals( const float *Grid, tsg::TVec<short> *npix, int Rows, bool IsSobel ) const
+    {
+      const int gw = nw + 2;
+      /* Differences are taken over two texels (Sobel also sums 1-2-1 weights) */
+      const float Inv = (float)(nw / (double)b / (IsSobel ? 8 : 2));
+      std::vector<float> gx(nw), gz(nw), l(nw);
+
+      for (int i = 0; i < Rows; i++)
+      {
+        const float
+          *up = Grid + (size_t)i * gw,
+          *mid = up + gw,
+          *dn = mid + gw;
+
+        if (IsSobel)
+          for (int j = 0; j < nw; j++)
+          {
+            gx[j] = ((up[j + 2] + 2 * mid[j + 2] + dn[j + 2]) - (up[j] + 2 * mid[j] + dn[j])) * Inv;
+            gz[j] = ((dn[j] + 2 * dn[j + 1] + dn[j + 2]) - (up[j] + 2 * up[j + 1] + up[j + 2])) * Inv;
+          }
+        else
+          for (int j = 0; j < nw; j++)
+          {
+            gx[j] = (mid[j + 2] - mid[j]) * Inv;
+            gz[j] = (dn[j + 1] - up[j + 1]) * Inv;
+          }
+        for (int j = 0; j < nw; j++)
+          l[j] = 32767 / sqrt(gx[j] * gx[j] + 1 + gz[j] * gz[j]);
+        for (int j = 0; j < nw; j++)
+          npix[(size_t)i * nw + j] = tsg::TVec<short>(-gx[j] * l[j], l[j], -gz[j] * l[j]);
+      }
+    } /* End of 'GridNormals' function */
+
+    /* Add erosion changes to height grid function.
+     * Changes are bilinearly interpolated from height map grid, so they
+     * are exact at height map samples.
+     * ARGUMENTS:
+     *   - height grid (Rows x (nw + 2) samples with one texel apron):
+     *       float *Grid;
+     *   - height changes on height map grid:
+     *       const float *Delta;
+     *   - normal map row of first grid row without apron:
+     *       int Row0;
+     *   - number of grid rows:
+     *       int Rows;
+     * RETURNS: None.
+     */
+    void AddDelta( float *Grid, const float *Delta, int Row0, int Rows ) const
+    {
+      const int gw = nw + 2, step = nw / w;
+      std::vector<int> x0(gw), x1(gw);
+      std::vector<float> fx(gw);
+      /* Height map position of clamped normal map texel */
+      auto Pos = [&]( int t, int &p0, int &p1, float &f )
+      {
+        t = Minimal({Maximal({t, 0}), nw - 1});
+        p0 = t / step;
+        p1 = Minimal({p0 + 1, w - 1});
+        f = (t - p0 * step) / (float)step;
+      };
+
+      for (int j = 0; j < gw; j++)
+        Pos(j - 1, x0[j], x1[j], fx[j]);
+      for (int i = 0; i < Rows; i++)
+      {
+        int y0, y1;
+        float fy;
+
+        Pos(Row0 + i - 1, y0, y1, fy);
+
+        const float
+          *d0 = Delta + (size_t)y0 * w,
+          *d1 = Delta + (size_t)y1 * w;
+        float *g = Grid + (size_t)i * gw;
+
+        for (int j = 0; j < gw; j++)
+        {
+          float
+            a = d0[x0[j]] + (d0[x1[j]] - d0[x0[j]]) * fx[j],
+            c = d1[x0[j]] + (d1[x1[j]] - d1[x0[j]]) * fx[j];
+
+          g[j] += a + (c - a) * fy;
         }
-      if ((f = fopen("bin/textures/normalmap1.short", "wb")) == nullptr)
-        throw "Too bad - file won't open!";
-      fwrite(&w, sizeof(int), 1, f);
-      fwrite(&w, sizeof(int), 1, f);
-      fwrite(npix, sizeof(tsg::TVec<short>), size, f);
-      fclose(f);
-  
-      delete[] npix;
-      delete[] pix;
+      }
+    } /* End of 'AddDelta' function */
+
+    /* Height and normal map rows evaluation from shared height grid function.
+     * Heights are evaluated once on normal map grid (rows range plus apron),
+     * normals are taken by finite differences and height map rows are every
+     * 'nw / w'-th sample of the same grid (coordinates match exactly, so
+     * height map is the same as analytic mode one).
+     * ARGUMENTS:
+     *   - fractal function:
+     *       fbm_type &fBm;
+     *   - result normal map rows:
+     *       tsg::TVec<short> *npix;
+     *   - result height map rows (from first one at or after 'Row0'):
+     *       float *pix;
+     *   - normal map rows range:
+     *       int Row0, Row1;
+     *   - use Sobel filter (otherwise central difference) flag:
+     *       bool IsSobel;
+     *   - erosion height changes on height map grid (bilinearly added to grid, may be nullptr):
+     *       const float *Delta;
+     * RETURNS: None.
+     */
+    template<class fbm_type>
+      void SharedRows( fbm_type &fBm, tsg::TVec<short> *npix, float *pix, int Row0, int Row1, bool IsSobel,
+                       const float *Delta ) const
+      {
+        const int gw = nw + 2, step = nw / w, Rows = Row1 - Row0 + 2;
+        std::vector<float> Grid((size_t)Rows * gw);
+        std::vector<double> X0(gw), Y0(gw), Z(gw), H0(gw);
+
+        /* Sample (i, j) is at normal map texel (Row0 + i - 1, j - 1) */
+        for (int j = 0; j < gw; j++)
+          X0[j] = (j - 1) / (double)nw * b, Z[j] = 0;
+        for (int i = 0; i < Rows; i++)
+        {
+          for (int j = 0; j < gw; j++)
+            Y0[j] = (Row0 + i - 1) / (double)nw * b;
+          fBm(&X0[0], &Y0[0], &Z[0], &H0[0], gw);
+          for (int j = 0; j < gw; j++)
+            Grid[(size_t)i * gw + j] = (float)H0[j];
+        }
+        if (Delta != nullptr)
+          AddDelta(&Grid[0], Delta, Row0, Rows);
+
+        GridNormals(&Grid[0], npix, Row1 - Row0, IsSobel);
+
+        for (int i = (Row0 + step - 1) / step; i * step < Row1; i++, pix += w)
+          for (int j = 0; j < w; j++)
+            pix[j] = Grid[(size_t)(i * step - Row0 + 1) * gw + j * step + 1];
+      } /* End of 'SharedRows' function */
+
+    /* Height and normal maps generation function.
+     * Every band is written by one item only, so result does not depend on
+     * threads number. Maps are written to temporary files which replace
+     * previous maps only if generation was not canceled. If erosion is on,
+     * whole height map is evaluated and eroded first; its changes are added
+     * to shared grid heights (analytic normals can not follow erosion, so
+     * central differences are used instead). Tiled pyramid
+     * of height map is built after that, then height map is encoded
+     * (if needed); both use float heights as source. Maps are packed
+     * losslessly (if needed) and min/max quadtree of stored heights is
+     * saved at last.
+     * ARGUMENTS:
+     *   - fractal function:
+     *       fbm_type &fBm;
+     *   - normals evaluation mode:
+     *       hm_normals Mode;
+     *   - progress callback (returns false to cancel):
+     *       const thread_pool::progress &Progress;
+     * RETURNS:
+     *   (bool) true if maps were generated and stored, false if canceled.
+     */
+    template<class fbm_type>
+      bool Generate( fbm_type &fBm, hm_normals Mode, const thread_pool::progress &Progress )
+      {
+        const char
+          *HeightName = "bin/textures/heightmap1.float",
+          *PyramidName = "bin/textures/heightmap1.pyr",
+          *TreeName = "bin/textures/heightmap1.mmt",
+          *NormalName = "bin/textures/normalmap1.short";
+        thread_pool Pool;
+        int Threads = Pool.GetNumOfThreads(), step = nw / w;
+        map_writer
+          hf((std::string(HeightName) + ".tmp").c_str(), w, w, MAP_FLOAT),
+          nf((std::string(NormalName) + ".tmp").c_str(), nw, nw,
+            NormalFormat == HM_NORMAL_OCT16 ? MAP_OCT16 : NormalFormat == HM_NORMAL_OCT8 ? MAP_OCT8 : MAP_SHORT3);
+        std::vector<tsg::TVec<short>> npix((size_t)NormalTile * Threads * nw);
+        std::vector<short> ncodes(NormalFormat == HM_NORMAL_SHORT3 ? 0 : (size_t)NormalTile * Threads * nw * 2);
+        std::vector<float> nerr(Threads), Delta;
+        double ErosionPart = 0;
+        bool IsOk = true;
+
+        /* Encode evaluated normal rows (every work item has own error slot) */
+        auto Pack = [&]( int Row0, int Row1, int Base )
+        {
+          size_t Start = (size_t)(Row0 - Base) * nw, Count = (size_t)(Row1 - Row0) * nw;
+          float e = 0;
+
+          if (NormalFormat == HM_NORMAL_OCT16)
+            e = codec::OctEncode(&npix[Start].X, Count, &ncodes[Start * 2]);
+          else if (NormalFormat == HM_NORMAL_OCT8)
+            e = codec::OctEncode(&npix[Start].X, Count, (int8_t *)&ncodes[0] + Start * 2);
+          if (e > nerr[(Row0 - Base) / NormalTile])
+            nerr[(Row0 - Base) / NormalTile] = e;
+        };
+        /* Store normal rows band */
+        auto StoreNormals = [&]( int Row0, int Row1 )
+        {
+          size_t Count = (size_t)(Row1 - Row0) * nw;
+
+          if (NormalFormat == HM_NORMAL_SHORT3)
+            nf.Write(&npix[0], Count);
+          else
+            nf.Write(&ncodes[0], Count);
+        };
+
+        if (Erosion.Iterations > 0)
+        {
+          hm_erosion Eroder(w, w, (float)b / w, Erosion);
+          std::vector<float> Map((size_t)w * w);
+          /* Erosion iteration costs about as much as evaluation of height map sample */
+          double HeightPart = 1.0 / (1 + Erosion.Iterations + nw / w * nw / w);
+
+          ErosionPart = HeightPart * (1 + Erosion.Iterations);
+          IsOk =
+            Pool.ParallelFor((w + HeightTile - 1) / HeightTile, [&]( int t )
+              {
+                HeightRows(fBm, &Map[(size_t)t * HeightTile * w], t * HeightTile, Minimal({(t + 1) * HeightTile, w}));
+              },
+              [&]( double Done )
+              {
+                return !Progress || Progress(HeightPart * Done);
+              });
+          if (IsOk)
+          {
+            Delta = Map;
+            IsOk = Eroder.Run(&Map[0], Pool,
+              [&]( double Done )
+              {
+                return !Progress || Progress(HeightPart + (ErosionPart - HeightPart) * Done);
+              });
+            ErosionRate = Eroder.GetCellsPerSecond();
+            for (size_t k = 0; k < Map.size(); k++)
+              Delta[k] = Map[k] - Delta[k];
+          }
+          if (Mode == HM_NORMALS_ANALYTIC)
+            Mode = HM_NORMALS_CENTRAL;
+        }
+
+        /* Maps are streamed if erosion was not canceled */
+        if (IsOk && Mode == HM_NORMALS_ANALYTIC)
+        {
+          std::vector<float> pix((size_t)HeightTile * Threads * w);
+          /* Normal texel (analytic gradient) costs about two height samples */
+          double HeightPart = 1.0 / (1 + 2.0 * nw / w * nw / w);
+
+          IsOk =
+            Stream(Pool, w, HeightTile,
+              [&]( int Row0, int Row1, int Base )
+              {
+                HeightRows(fBm, &pix[(size_t)(Row0 - Base) * w], Row0, Row1);
+              },
+              [&]( int Row0, int Row1 )
+              {
+                hf.Write(&pix[0], (size_t)(Row1 - Row0) * w);
+              }, 0, HeightPart, Progress) &&
+            Stream(Pool, nw, NormalTile,
+              [&]( int Row0, int Row1, int Base )
+              {
+                fBm.Visit(analytic_rows(this, &npix[(size_t)(Row0 - Base) * nw], Row0, Row1));
+                Pack(Row0, Row1, Base);
+              }, StoreNormals, HeightPart, 1, Progress);
+        }
+        else if (IsOk)
+        {
+          std::vector<float> pix(((size_t)NormalTile * Threads / step + 1) * w);
+          auto FirstRow = [&]( int Row ){ return (Row + step - 1) / step; };
+
+          IsOk =
+            Stream(Pool, nw, NormalTile,
+              [&]( int Row0, int Row1, int Base )
+              {
+                SharedRows(fBm, &npix[(size_t)(Row0 - Base) * nw],
+                  &pix[(size_t)(FirstRow(Row0) - FirstRow(Base)) * w], Row0, Row1, Mode == HM_NORMALS_SOBEL,
+                  Delta.empty() ? nullptr : &Delta[0]);
+                Pack(Row0, Row1, Base);
+              },
+              [&]( int Row0, int Row1 )
+              {
+                StoreNormals(Row0, Row1);
+                hf.Write(&pix[0], (size_t)(FirstRow(Row1) - FirstRow(Row0)) * w);
+              }, ErosionPart, 1, Progress);
+        }
+
+        hf.Close();
+        nf.Close();
+        Finish(HeightName, IsOk);
+        Finish(NormalName, IsOk);
+        MaxNormalError = 0;
+        for (float e : nerr)
+          if (e > MaxNormalError)
+            MaxNormalError = e;
+        if (IsOk)
+        {
+          pyramid_codec Codec =
+            Heights == HM_HEIGHTS_UINT16 ? PYRAMID_UINT16 : Heights == HM_HEIGHTS_HALF ? PYRAMID_HALF :
+            IsPacked ? PYRAMID_PACKED : PYRAMID_RAW;
+          float Error = 0;
+
+          if (!map_pyramid::Build(HeightName, PyramidName, 128, Codec, &Error))
+            throw "Too bad - height map pyramid won't build!";
+          MaxError = Error;
+          if (Heights != HM_HEIGHTS_FLOAT && (Error = Encode(HeightName)) > MaxError)
+            MaxError = Error;
+          if (IsPacked)
+          {
+            PackFile(HeightName);
+            PackFile(NormalName);
+          }
+
+          /* Quadtree bounds stored heights (after erosion and encoding) */
+          minmax_tree Tree;
+
+          if (!Tree.Load(HeightName) || !Tree.Save(TreeName))
+            throw "Too bad - height map quadtree won't build!";
+        }
+        return IsOk;
+      } /* End of 'Generate' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS:
+     *   - fractal parameters:
+     *       double H, Lacunarity, Gain, Offset, Octaves;
+     *   - random seed:
+     *       int Seed;
+     *   - noise engine:
+     *       noise_engine Engine;
+     *   - normal map evaluation mode:
+     *       hm_normals Mode;
+     *   - progress callback (gets done fraction, returns false to cancel):
+     *       const thread_pool::progress &Progress;
+     *   - height and normal maps sizes (normal map size should be multiple of height map one):
+     *       int Size, NormalSize;
+     *   - height map storage encoding:
+     *       hm_heights Encoding;
+     *   - normal map storage encoding:
+     *       hm_normal_format Normals;
+     *   - lossless maps packing flag (height map pyramid is packed for float heights only):
+     *       bool Packed;
+     *   - height map erosion parameters (no erosion by default):
+     *       const hm_erosion::params &ErosionParams;
+     */
+    hm_gen( double H, double Lacunarity, double Gain, double Offset, double Octaves, int Seed,
+            noise_engine Engine = NOISE_VALUE, hm_normals Mode = HM_NORMALS_ANALYTIC,
+            const thread_pool::progress &Progress = nullptr, int Size = 1024, int NormalSize = 4096,
+            hm_heights Encoding = HM_HEIGHTS_FLOAT, hm_normal_format Normals = HM_NORMAL_SHORT3,
+            bool Packed = false, const hm_erosion::params &ErosionParams = hm_erosion::params() ) :
+      w(Size), nw(NormalSize), Heights(Encoding), MaxError(0),
+      NormalFormat(Normals), MaxNormalError(0), IsPacked(Packed), Erosion(ErosionParams), ErosionRate(0), IsDone(false)
+    {
+      if (w <= 0 || nw < w || nw % w != 0)
+        throw "Too bad - normal map size is not multiple of height map one!";
+      if (Engine == NOISE_SIMPLEX)
+      {
+        math::fBm_multi_ridged_simplex fBm(H, Lacunarity, Gain, Offset, Octaves, Seed);
+
+        IsDone = Generate(fBm, Mode, Progress);
+      }
+      else
+      {
+        math::fBm_multi_ridged fBm(H, Lacunarity, Gain, Offset, Octaves, Seed);
+
+        IsDone = Generate(fBm, Mode, Progress);
+      }
     } /* End of 'hm_gen' constructor */
+
+    /* Check if maps were generated (not canceled) function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (bool) true if height and normal maps files were written.
+     */
+    bool IsComplete( void ) const
+    {
+      return IsDone;
+    } /* End of 'IsComplete' function */
+
+    /* Obtain maximal height encoding error function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (float) maximal absolute difference between generated and stored
+     *           heights (over height map and all pyramid levels).
+     */
+    float GetMaxError( void ) const
+    {
+      return MaxError;
+    } /* End of 'GetMaxError' function */
+
+    /* Obtain maximal normal encoding error function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (float) maximal angle between evaluated (SHORT[3]) and stored
+     *           normals in degrees (0 for 'HM_NORMAL_SHORT3').
+     */
+    float GetMaxNormalError( void ) const
+    {
+      return MaxNormalError;
+    } /* End of 'GetMaxNormalError' function */
+
+    /* Obtain measured erosion speed function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (double) height map cells eroded per second by one iteration (0 if erosion is off).
+     */
+    double GetErosionRate( void ) const
+    {
+      return ErosionRate;
+    } /* End of 'GetErosionRate' function */
   }; /* End of 'hm_gen' class */
 } /* End of 'tcg' namespace */
 
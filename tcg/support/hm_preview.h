@@ -0,0 +1,296 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : hm_preview.h
+ * PURPOSE     : Computational geometry project.
+ *               Progressive height map preview engine module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __hm_preview_h_
+#define __hm_preview_h_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include "../def.h"
+#include "../math/noise.h"
+#include "thread_pool.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Progressive height map preview engine class.
+   * Height map of 'hm_gen' (same fractal and sampling) is evaluated on
+   * CPU coarse to fine: 1/16, 1/4 and full preview size. Every level is
+   * published as soon as it is ready. New parameters cancel pending work.
+   * No window or OpenGL is needed, so engine works headless. */
+  class hm_preview
+  {
+  public:
+    /* Fractal parameters */
+    struct params
+    {
+      DBL H, Lacunarity, Gain, Offset, Octaves;  // fBm parameters
+      INT Seed;                                  // Noise seed
+      math::noise_engine Engine;                 // Noise engine
+    }; /* End of 'params' struct */
+
+    /* Level publish callback type (gets heights, their size and level step, called from engine thread) */
+    typedef std::function<VOID ( const FLOAT *Pix, INT W, INT H, INT Step )> publish;
+
+  private:
+    static const INT
+      NumOfLevels = 3,  // Number of refinement levels
+      BandRows = 8;     // Rows per work item
+    const INT Size;                       // Full level size
+    publish OnPublish;                    // Level publish callback
+    thread_pool Pool;                     // Level rows workers
+    std::thread Controller;               // Levels scheduling thread
+    std::mutex Mutex;                     // Requests and results lock
+    std::condition_variable Wake, Done;   // New request and job finish signals
+    params Params;                        // Requested parameters
+    std::atomic<UINT> Generation;         // Request counter (changes cancel work)
+    UINT Finished;                        // Last finished (or canceled) request
+    BOOL IsExit;                          // Engine destruction flag
+    std::vector<FLOAT> Result;            // Last published level
+    INT ResultSize, ResultStep;           // Last published level size and step
+    UINT Version;                         // Published levels counter
+    BOOL IsFull;                          // Last request full level ready flag
+
+    /* Evaluate level function.
+     * ARGUMENTS:
+     *   - fractal function:
+     *       fbm_type &fBm;
+     *   - level size:
+     *       INT Side;
+     *   - result heights:
+     *       FLOAT *Pix;
+     *   - request number:
+     *       UINT Gen;
+     * RETURNS:
+     *   (BOOL) TRUE if level is ready, FALSE if request is outdated.
+     */
+    template<class fbm_type>
+      BOOL Level( fbm_type &fBm, INT Side, FLOAT *Pix, UINT Gen )
+      {
+        return Pool.ParallelFor((Side + BandRows - 1) / BandRows, [&]( INT Band )
+          {
+            std::vector<DBL> X(Side), Y(Side), Z(Side, 0), Res(Side);
+
+            /* Same sample points as 'hm_gen' (maps side is 10 in noise space) */
+            for (INT j = 0; j < Side; j++)
+              X[j] = j / (DBL)Side * 10;
+            for (INT i = Band * BandRows; i < Side && i < (Band + 1) * BandRows; i++)
+            {
+              if (Generation != Gen)
+                return;
+              for (INT j = 0; j < Side; j++)
+                Y[j] = i / (DBL)Side * 10;
+              fBm(&X[0], &Y[0], &Z[0], &Res[0], Side);
+              for (INT j = 0; j < Side; j++)
+                Pix[(size_t)i * Side + j] = (FLOAT)Res[j];
+            }
+          },
+          [&]( DBL )
+          {
+            return Generation == Gen;
+          }) && Generation == Gen;
+      } /* End of 'Level' function */
+
+    /* Evaluate all levels of request function.
+     * ARGUMENTS:
+     *   - fractal function:
+     *       fbm_type &fBm;
+     *   - request number:
+     *       UINT Gen;
+     * RETURNS: None.
+     */
+    template<class fbm_type>
+      VOID Levels( fbm_type &fBm, UINT Gen )
+      {
+        std::vector<FLOAT> Pix;
+
+        for (INT l = 0, Step = 16; l < NumOfLevels; l++, Step /= 4)
+        {
+          INT Side = Size / Step > 0 ? Size / Step : 1;
+
+          Pix.resize((size_t)Side * Side);
+          if (!Level(fBm, Side, &Pix[0], Gen))
+            return;
+          if (OnPublish)
+            OnPublish(&Pix[0], Side, Side, Step);
+
+          std::lock_guard<std::mutex> Lock(Mutex);
+
+          if (Generation != Gen)
+            return;
+          Result.swap(Pix);
+          ResultSize = Side;
+          ResultStep = Step;
+          Version++;
+          IsFull = Step == 1;
+        }
+      } /* End of 'Levels' function */
+
+    /* Levels scheduling thread function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Control( VOID )
+    {
+      UINT Seen = 0;
+
+      while (TRUE)
+      {
+        params P;
+        UINT Gen;
+
+        {
+          std::unique_lock<std::mutex> Lock(Mutex);
+
+          Finished = Seen;
+          Done.notify_all();
+          Wake.wait(Lock, [&]{ return IsExit || Generation != Seen; });
+          if (IsExit)
+            return;
+          Seen = Gen = Generation;
+          P = Params;
+        }
+        if (P.Octaves < 1)
+          continue;
+        if (P.Engine == math::NOISE_SIMPLEX)
+        {
+          math::fBm_multi_ridged_simplex fBm(P.H, P.Lacunarity, P.Gain, P.Offset, (INT)P.Octaves, P.Seed);
+
+          Levels(fBm, Gen);
+        }
+        else
+        {
+          math::fBm_multi_ridged fBm(P.H, P.Lacunarity, P.Gain, P.Offset, (INT)P.Octaves, P.Seed);
+
+          Levels(fBm, Gen);
+        }
+      }
+    } /* End of 'Control' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS:
+     *   - full level size (as height map size of 'hm_gen' to get equal heights):
+     *       INT Size;
+     *   - level publish callback (may be empty):
+     *       const publish &OnPublish;
+     *   - number of worker threads (0 - as many as processors):
+     *       INT NumOfThreads;
+     */
+    hm_preview( INT Size = 512, const publish &OnPublish = nullptr, INT NumOfThreads = 0 ) :
+      Size(Size), OnPublish(OnPublish), Pool(NumOfThreads), Generation(0), Finished(0), IsExit(FALSE),
+      ResultSize(0), ResultStep(0), Version(0), IsFull(FALSE)
+    {
+      memset(&Params, 0, sizeof(Params));
+      Controller = std::thread([this]{ Control(); });
+    } /* End of 'hm_preview' constructor */
+
+    /* Class destructor.
+     * ARGUMENTS: None.
+     */
+    ~hm_preview( VOID )
+    {
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+
+        IsExit = TRUE;
+        Generation++;
+      }
+      Wake.notify_all();
+      Controller.join();
+    } /* End of '~hm_preview' destructor */
+
+    /* Start preview of new parameters function.
+     * Pending levels of previous parameters are canceled.
+     * ARGUMENTS:
+     *   - fractal parameters:
+     *       const params &NewParams;
+     * RETURNS: None.
+     */
+    VOID Start( const params &NewParams )
+    {
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+
+        Params = NewParams;
+        Generation++;
+        IsFull = FALSE;
+      }
+      Wake.notify_all();
+    } /* End of 'Start' function */
+
+    /* Cancel pending levels function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Cancel( VOID )
+    {
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+
+        /* Empty request: octaves number is zero */
+        Params.Octaves = 0;
+        Generation++;
+        IsFull = FALSE;
+      }
+      Wake.notify_all();
+    } /* End of 'Cancel' function */
+
+    /* Wait for current request end function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if full level of current request is ready.
+     */
+    BOOL Wait( VOID )
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+
+      Done.wait(Lock, [&]{ return Finished == Generation; });
+      return IsFull;
+    } /* End of 'Wait' function */
+
+    /* Obtain last published level function.
+     * ARGUMENTS:
+     *   - last seen level number (updated):
+     *       UINT &Seen;
+     *   - result heights (row by row) and their size:
+     *       std::vector<FLOAT> &Pix;
+     *       INT &Side;
+     * RETURNS:
+     *   (INT) level step (16, 4 or 1), 0 if no new level was published since 'Seen'.
+     */
+    INT Fetch( UINT &Seen, std::vector<FLOAT> &Pix, INT &Side )
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+
+      if (Seen == Version || Result.empty())
+        return 0;
+      Seen = Version;
+      Pix = Result;
+      Side = ResultSize;
+      return ResultStep;
+    } /* End of 'Fetch' function */
+  }; /* End of 'hm_preview' class */
+} /* end of 'tcg' namespace */
+
+#endif /* __hm_preview_h_ */
+
+/* END OF 'hm_preview.h' FILE */
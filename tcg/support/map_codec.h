@@ -0,0 +1,449 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : map_codec.h
+ * PURPOSE     : Computational geometry project.
+ *               Height map samples encoding module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg::codec'.
+ *
+ *               Heights are stored as 32-bit floats, as 16-bit unsigned
+ *               integers with scale and bias (h = q * Scale + Bias) or as
+ *               IEEE 754 half floats. Decoders have SSE4/AVX2 kernels with
+ *               results equal to the scalar code.
+ *               Normals are stored as SHORT[3] (scaled by 32767) or
+ *               octahedral 2 x 16-bit / 2 x 8-bit signed codes ('Y' axis
+ *               is octahedron fold axis, codes are (X, Z) projection).
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __map_codec_h_
+#define __map_codec_h_
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#include "../def.h"
+#include "cpu.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Height map samples encoding namespace */
+  namespace codec
+  {
+    /* Convert float to half float (round to nearest even) function.
+     * ARGUMENTS:
+     *   - value:
+     *       FLOAT F;
+     * RETURNS:
+     *   (uint16_t) half float bits.
+     */
+    inline uint16_t FloatToHalf( FLOAT F )
+    {
+      UINT X, Sign, Abs, H, Rest, Half;
+      INT Shift;
+
+      memcpy(&X, &F, sizeof(X));
+      Sign = (X >> 16) & 0x8000;
+      Abs = X & 0x7FFFFFFF;
+      if (Abs >= 0x7F800000)
+        return (uint16_t)(Sign | 0x7C00 | (Abs > 0x7F800000 ? 0x200 : 0));
+      if (Abs >= 0x477FF000)
+        return (uint16_t)(Sign | 0x7C00);
+      if (Abs < 0x38800000)
+      {
+        /* Subnormal half */
+        if (Abs <= 0x33000000)
+          return (uint16_t)Sign;
+        Shift = 126 - (INT)(Abs >> 23);
+        Abs = (Abs & 0x7FFFFF) | 0x800000;
+        H = Abs >> Shift;
+        Rest = Abs & ((1U << Shift) - 1);
+        Half = 1U << (Shift - 1);
+      }
+      else
+      {
+        H = (Abs - 0x38000000) >> 13;
+        Rest = Abs & 0x1FFF;
+        Half = 0x1000;
+      }
+      if (Rest > Half || (Rest == Half && (H & 1)))
+        H++;
+      return (uint16_t)(Sign | H);
+    } /* End of 'FloatToHalf' function */
+
+    /* Convert half float to float function.
+     * ARGUMENTS:
+     *   - half float bits:
+     *       uint16_t H;
+     * RETURNS:
+     *   (FLOAT) value.
+     */
+    inline FLOAT HalfToFloat( uint16_t H )
+    {
+      UINT
+        Sign = (UINT)(H & 0x8000) << 16,
+        Exp = (H >> 10) & 0x1F,
+        Mant = H & 0x3FF,
+        X;
+      FLOAT F;
+
+      if (Exp == 0)
+      {
+        /* Zero or subnormal: exact in float */
+        F = Mant * (1.0f / (1 << 24));
+        return Sign ? -F : F;
+      }
+      if (Exp == 31)
+        X = Sign | 0x7F800000 | (Mant != 0 ? 0x400000 | (Mant << 13) : 0);  // NaN is quieted as F16C does
+      else
+        X = Sign | ((Exp + 112) << 23) | (Mant << 13);
+      memcpy(&F, &X, sizeof(F));
+      return F;
+    } /* End of 'HalfToFloat' function */
+
+    /* Find samples range function.
+     * ARGUMENTS:
+     *   - samples:
+     *       const FLOAT *Src;
+     *       size_t N;
+     *   - range to extend:
+     *       FLOAT &Min, &Max;
+     * RETURNS: None.
+     */
+    inline VOID Range( const FLOAT *Src, size_t N, FLOAT &Min, FLOAT &Max )
+    {
+      for (size_t i = 0; i < N; i++)
+      {
+        if (Src[i] < Min)
+          Min = Src[i];
+        if (Src[i] > Max)
+          Max = Src[i];
+      }
+    } /* End of 'Range' function */
+
+    /* Obtain 16-bit quantization parameters for range function.
+     * ARGUMENTS:
+     *   - samples range:
+     *       FLOAT Min, Max;
+     *   - result scale and bias:
+     *       FLOAT &Scale, &Bias;
+     * RETURNS: None.
+     */
+    inline VOID QuantizationParams( FLOAT Min, FLOAT Max, FLOAT &Scale, FLOAT &Bias )
+    {
+      Bias = Min;
+      Scale = (Max - Min) / 65535;
+      if (!(Scale > 0))
+        Scale = 1;
+    } /* End of 'QuantizationParams' function */
+
+    /* Quantize samples to 16 bits function.
+     * ARGUMENTS:
+     *   - samples:
+     *       const FLOAT *Src;
+     *       size_t N;
+     *   - quantization parameters:
+     *       FLOAT Scale, Bias;
+     *   - result codes:
+     *       uint16_t *Dst;
+     * RETURNS:
+     *   (FLOAT) maximal absolute error of decoded samples.
+     */
+    inline FLOAT Quantize( const FLOAT *Src, size_t N, FLOAT Scale, FLOAT Bias, uint16_t *Dst )
+    {
+      FLOAT MaxErr = 0;
+
+      for (size_t i = 0; i < N; i++)
+      {
+        DOUBLE q = floor((Src[i] - Bias) / (DOUBLE)Scale + 0.5);
+        FLOAT Err;
+
+        Dst[i] = (uint16_t)(q < 0 ? 0 : q > 65535 ? 65535 : q);
+        if ((Err = fabs(Dst[i] * Scale + Bias - Src[i])) > MaxErr)
+          MaxErr = Err;
+      }
+      return MaxErr;
+    } /* End of 'Quantize' function */
+
+    /* Encode samples to half floats function.
+     * ARGUMENTS:
+     *   - samples:
+     *       const FLOAT *Src;
+     *       size_t N;
+     *   - result codes:
+     *       uint16_t *Dst;
+     * RETURNS:
+     *   (FLOAT) maximal absolute error of decoded samples.
+     */
+    inline FLOAT EncodeHalf( const FLOAT *Src, size_t N, uint16_t *Dst )
+    {
+      FLOAT MaxErr = 0, Err;
+
+      for (size_t i = 0; i < N; i++)
+        if ((Err = fabs(HalfToFloat(Dst[i] = FloatToHalf(Src[i])) - Src[i])) > MaxErr)
+          MaxErr = Err;
+      return MaxErr;
+    } /* End of 'EncodeHalf' function */
+
+    /* Dequantize 16-bit samples SSE4 kernel.
+     * ARGUMENTS:
+     *   - codes:
+     *       const uint16_t *Src;
+     *   - quantization parameters:
+     *       FLOAT Scale, Bias;
+     *   - result samples:
+     *       FLOAT *Dst;
+     *   - number of samples:
+     *       size_t N;
+     * RETURNS:
+     *   (size_t) number of processed samples (rest is left to scalar code).
+     */
+    inline TCG_TARGET("sse4.1") size_t DequantizeSse4( const uint16_t *Src, FLOAT Scale, FLOAT Bias, FLOAT *Dst, size_t N )
+    {
+      __m128 s = _mm_set1_ps(Scale), b = _mm_set1_ps(Bias);
+      size_t i;
+
+      for (i = 0; i + 8 <= N; i += 8)
+      {
+        __m128i v = _mm_loadu_si128((const __m128i *)(Src + i));
+
+        _mm_storeu_ps(Dst + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(v)), s), b));
+        _mm_storeu_ps(Dst + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8))), s), b));
+      }
+      return i;
+    } /* End of 'DequantizeSse4' function */
+
+    /* Dequantize 16-bit samples AVX2 kernel.
+     * ARGUMENTS:
+     *   - codes:
+     *       const uint16_t *Src;
+     *   - quantization parameters:
+     *       FLOAT Scale, Bias;
+     *   - result samples:
+     *       FLOAT *Dst;
+     *   - number of samples:
+     *       size_t N;
+     * RETURNS:
+     *   (size_t) number of processed samples (rest is left to scalar code).
+     */
+    inline TCG_TARGET("avx2") size_t DequantizeAvx2( const uint16_t *Src, FLOAT Scale, FLOAT Bias, FLOAT *Dst, size_t N )
+    {
+      __m256 s = _mm256_set1_ps(Scale), b = _mm256_set1_ps(Bias);
+      size_t i;
+
+      for (i = 0; i + 16 <= N; i += 16)
+      {
+        __m128i
+          v0 = _mm_loadu_si128((const __m128i *)(Src + i)),
+          v1 = _mm_loadu_si128((const __m128i *)(Src + i + 8));
+
+        _mm256_storeu_ps(Dst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v0)), s), b));
+        _mm256_storeu_ps(Dst + i + 8, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v1)), s), b));
+      }
+      return i;
+    } /* End of 'DequantizeAvx2' function */
+
+    /* Decode half floats AVX2 (F16C) kernel.
+     * ARGUMENTS:
+     *   - codes:
+     *       const uint16_t *Src;
+     *   - result samples:
+     *       FLOAT *Dst;
+     *   - number of samples:
+     *       size_t N;
+     * RETURNS:
+     *   (size_t) number of processed samples (rest is left to scalar code).
+     */
+    inline TCG_TARGET("avx2,f16c") size_t DecodeHalfAvx2( const uint16_t *Src, FLOAT *Dst, size_t N )
+    {
+      size_t i;
+
+      for (i = 0; i + 8 <= N; i += 8)
+        _mm256_storeu_ps(Dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(Src + i))));
+      return i;
+    } /* End of 'DecodeHalfAvx2' function */
+
+    /* Dequantize 16-bit samples function.
+     * ARGUMENTS:
+     *   - codes:
+     *       const uint16_t *Src;
+     *   - quantization parameters:
+     *       FLOAT Scale, Bias;
+     *   - result samples:
+     *       FLOAT *Dst;
+     *   - number of samples:
+     *       size_t N;
+     * RETURNS: None.
+     */
+    inline VOID Dequantize( const uint16_t *Src, FLOAT Scale, FLOAT Bias, FLOAT *Dst, size_t N )
+    {
+      size_t i = 0;
+
+      switch (cpu::Simd())
+      {
+      case cpu::SIMD_AVX2:
+        i = DequantizeAvx2(Src, Scale, Bias, Dst, N);
+        break;
+      case cpu::SIMD_SSE4:
+        i = DequantizeSse4(Src, Scale, Bias, Dst, N);
+        break;
+      }
+      for (; i < N; i++)
+        Dst[i] = Src[i] * Scale + Bias;
+    } /* End of 'Dequantize' function */
+
+    /* Decode half floats function.
+     * ARGUMENTS:
+     *   - codes:
+     *       const uint16_t *Src;
+     *   - result samples:
+     *       FLOAT *Dst;
+     *   - number of samples:
+     *       size_t N;
+     * RETURNS: None.
+     */
+    inline VOID DecodeHalf( const uint16_t *Src, FLOAT *Dst, size_t N )
+    {
+      size_t i = 0;
+
+      if (cpu::IsF16c())
+        i = DecodeHalfAvx2(Src, Dst, N);
+      for (; i < N; i++)
+        Dst[i] = HalfToFloat(Src[i]);
+    } /* End of 'DecodeHalf' function */
+
+    /* Convert octahedral projection to unit vector function.
+     * ARGUMENTS:
+     *   - projection point (in [-1, 1]):
+     *       FLOAT U, V;
+     *   - result vector:
+     *       FLOAT *N;
+     * RETURNS: None.
+     */
+    inline VOID OctToVector( FLOAT U, FLOAT V, FLOAT *N )
+    {
+      FLOAT Y = 1 - fabs(U) - fabs(V), X = U, Z = V, Len;
+
+      if (Y < 0)
+      {
+        /* Lower hemisphere is folded over diamond edges */
+        X = (1 - fabs(V)) * (U < 0 ? -1 : 1);
+        Z = (1 - fabs(U)) * (V < 0 ? -1 : 1);
+      }
+      Len = sqrt(X * X + Y * Y + Z * Z);
+      N[0] = X / Len;
+      N[1] = Y / Len;
+      N[2] = Z / Len;
+    } /* End of 'OctToVector' function */
+
+    /* Encode SHORT[3] normals to octahedral codes function.
+     * Best of four nearest codes is chosen for every normal. Angles are
+     * compared by cross product length (float 'acos' of dot product is
+     * too coarse for 16-bit codes).
+     * ARGUMENTS:
+     *   - normals (3 components each):
+     *       const SHORT *Src;
+     *       size_t N;
+     *   - result codes (2 components each, 'SHORT' or 'int8_t'):
+     *       type *Dst;
+     * RETURNS:
+     *   (FLOAT) maximal angle between source and decoded normals in degrees.
+     */
+    template<class type>
+      FLOAT OctEncode( const SHORT *Src, size_t N, type *Dst )
+      {
+        const FLOAT Max = sizeof(type) == 1 ? 127.0f : 32767.0f;
+        FLOAT MaxSin2 = 0;
+
+        for (size_t i = 0; i < N; i++, Src += 3, Dst += 2)
+        {
+          FLOAT
+            X = Src[0], Y = Src[1], Z = Src[2],
+            Len = sqrt(X * X + Y * Y + Z * Z),
+            L1 = fabs(X) + fabs(Y) + fabs(Z),
+            U, V, Best = 2, n[3];
+
+          if (L1 == 0)
+          {
+            Dst[0] = Dst[1] = 0;
+            continue;
+          }
+          X /= Len, Y /= Len, Z /= Len, L1 /= Len;
+          U = X / L1;
+          V = Z / L1;
+          if (Y < 0)
+          {
+            FLOAT U1 = (1 - fabs(V)) * (U < 0 ? -1 : 1);
+
+            V = (1 - fabs(U)) * (V < 0 ? -1 : 1);
+            U = U1;
+          }
+          /* Plain rounded code is kept if no candidate is better */
+          FLOAT
+            ru = floor(U * Max + 0.5f),
+            rv = floor(V * Max + 0.5f);
+
+          Dst[0] = (type)(ru < -Max ? -Max : ru > Max ? Max : ru);
+          Dst[1] = (type)(rv < -Max ? -Max : rv > Max ? Max : rv);
+          for (INT k = 0; k < 4; k++)
+          {
+            FLOAT
+              cu = (k & 1 ? ceil(U * Max) : floor(U * Max)),
+              cv = (k & 2 ? ceil(V * Max) : floor(V * Max)), cx, cy, cz, Sin2;
+
+            cu = cu < -Max ? -Max : cu > Max ? Max : cu;
+            cv = cv < -Max ? -Max : cv > Max ? Max : cv;
+            OctToVector(cu / Max, cv / Max, n);
+            cx = n[1] * Z - n[2] * Y;
+            cy = n[2] * X - n[0] * Z;
+            cz = n[0] * Y - n[1] * X;
+            Sin2 = cx * cx + cy * cy + cz * cz;
+            if (n[0] * X + n[1] * Y + n[2] * Z > 0 && Sin2 < Best)
+            {
+              Best = Sin2;
+              Dst[0] = (type)cu;
+              Dst[1] = (type)cv;
+            }
+          }
+          if (Best > MaxSin2)
+            MaxSin2 = Best;
+        }
+        return asin(sqrt(MaxSin2 > 1 ? 1 : MaxSin2)) * 57.29577951f;
+      } /* End of 'OctEncode' function */
+
+    /* Decode octahedral codes to SHORT[3] normals function.
+     * ARGUMENTS:
+     *   - codes (2 components each, 'SHORT' or 'int8_t'):
+     *       const type *Src;
+     *       size_t N;
+     *   - result normals (3 components each, scaled by 32767):
+     *       SHORT *Dst;
+     * RETURNS: None.
+     */
+    template<class type>
+      VOID OctDecode( const type *Src, size_t N, SHORT *Dst )
+      {
+        const FLOAT Max = sizeof(type) == 1 ? 127.0f : 32767.0f;
+        FLOAT n[3];
+
+        for (size_t i = 0; i < N; i++, Src += 2, Dst += 3)
+        {
+          OctToVector(Src[0] / Max, Src[1] / Max, n);
+          for (INT k = 0; k < 3; k++)
+            Dst[k] = (SHORT)floor(n[k] * 32767 + 0.5f);
+        }
+      } /* End of 'OctDecode' function */
+  } /* end of 'codec' namespace */
+} /* end of 'tcg' namespace */
+
+#endif /* __map_codec_h_ */
+
+/* END OF 'map_codec.h' FILE */
@@ -0,0 +1,848 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : map_file.h
+ * PURPOSE     : Computational geometry project.
+ *               Height/normal map files support module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __map_file_h_
+#define __map_file_h_
+
+#include <cstdio>
+#include <cstring>
+
+#include "../def.h"
+#include "map_codec.h"
+#include "map_pack.h"
+#include "thread_pool.h"
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif /* _WIN32 */
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Map element types */
+  enum map_type
+  {
+    MAP_FLOAT = 1,   // FLOAT height
+    MAP_SHORT3 = 2,  // SHORT[3] normal (scaled by 32767)
+    MAP_UINT16 = 3,  // 16-bit quantized height (h = q * Scale + Bias)
+    MAP_HALF = 4,    // Half float height
+    MAP_OCT16 = 5,   // SHORT[2] octahedral normal
+    MAP_OCT8 = 6     // int8_t[2] octahedral normal
+  }; /* End of 'map_type' enum */
+
+  /* Map data encodings */
+  enum map_codec
+  {
+    MAP_CODEC_NONE = 0,   // Raw elements
+    MAP_CODEC_PACKED = 1  // Bands of rows packed by 'codec::Pack'
+  }; /* End of 'map_codec' enum */
+
+  /* Map file header.
+   * Legacy files have only 'INT W, H' header and are still readable,
+   * version 1 files have no quantization parameters, version 2 files
+   * are never packed. Packed data starts with bands index (band count + 1
+   * 'UINT64' file offsets), checksum is evaluated over unpacked elements. */
+  struct map_header
+  {
+    static const UINT
+      MAGIC = 0x4D474354,  // 'TCGM'
+      VERSION = 3,         // Current format version
+      V1_SIZE = 32,        // Version 1 header size
+      V2_SIZE = 40;        // Version 2 header size
+
+    UINT Magic;            // Format signature
+    UINT Version;          // Format version
+    INT W, H;              // Map size
+    INT Type;              // Element type (see 'map_type')
+    UINT DataOffset;       // Elements start in file (header size)
+    UINT64 Checksum;       // Elements checksum (see 'map_checksum')
+    FLOAT Scale, Bias;     // Quantization parameters ('MAP_UINT16' only)
+    INT Codec;             // Data encoding (see 'map_codec')
+    INT BandRows;          // Rows per packed band
+  }; /* End of 'map_header' struct */
+
+  /* Map element size obtain function.
+   * ARGUMENTS:
+   *   - element type:
+   *       INT Type;
+   * RETURNS:
+   *   (INT) element size in bytes, 0 if type is unknown.
+   */
+  inline INT MapElementSize( INT Type )
+  {
+    switch (Type)
+    {
+    case MAP_FLOAT:
+      return sizeof(FLOAT);
+    case MAP_SHORT3:
+      return sizeof(SHORT) * 3;
+    case MAP_UINT16:
+    case MAP_HALF:
+      return sizeof(uint16_t);
+    case MAP_OCT16:
+      return sizeof(SHORT) * 2;
+    case MAP_OCT8:
+      return sizeof(int8_t) * 2;
+    }
+    return 0;
+  } /* End of 'MapElementSize' function */
+
+  /* Obtain element layout for packing function.
+   * ARGUMENTS:
+   *   - element type:
+   *       INT Type;
+   * RETURNS:
+   *   (codec::pack_layout) layout (zero word size if type is unknown).
+   */
+  inline codec::pack_layout MapPackLayout( INT Type )
+  {
+    codec::pack_layout L = {0, 1, codec::PACK_UNSIGNED};
+
+    switch (Type)
+    {
+    case MAP_FLOAT:
+      L.WordSize = 4, L.Kind = codec::PACK_FLOAT;
+      break;
+    case MAP_SHORT3:
+      L.WordSize = 2, L.Components = 3, L.Kind = codec::PACK_SIGNED;
+      break;
+    case MAP_UINT16:
+      L.WordSize = 2;
+      break;
+    case MAP_HALF:
+      L.WordSize = 2, L.Kind = codec::PACK_FLOAT;
+      break;
+    case MAP_OCT16:
+      L.WordSize = 2, L.Components = 2, L.Kind = codec::PACK_SIGNED;
+      break;
+    case MAP_OCT8:
+      L.WordSize = 1, L.Components = 2, L.Kind = codec::PACK_SIGNED;
+      break;
+    }
+    return L;
+  } /* End of 'MapPackLayout' function */
+
+  /* Check if element type is height encoding function.
+   * ARGUMENTS:
+   *   - element type:
+   *       INT Type;
+   * RETURNS:
+   *   (BOOL) TRUE for 'MAP_FLOAT', 'MAP_UINT16' and 'MAP_HALF'.
+   */
+  inline BOOL MapIsHeight( INT Type )
+  {
+    return Type == MAP_FLOAT || Type == MAP_UINT16 || Type == MAP_HALF;
+  } /* End of 'MapIsHeight' function */
+
+  /* Check if element type is normal encoding function.
+   * ARGUMENTS:
+   *   - element type:
+   *       INT Type;
+   * RETURNS:
+   *   (BOOL) TRUE for 'MAP_SHORT3', 'MAP_OCT16' and 'MAP_OCT8'.
+   */
+  inline BOOL MapIsNormal( INT Type )
+  {
+    return Type == MAP_SHORT3 || Type == MAP_OCT16 || Type == MAP_OCT8;
+  } /* End of 'MapIsNormal' function */
+
+  /* Fletcher-like checksum (of 32-bit words, sums modulo 2^32) evaluation class.
+   * Data may come by parts of any size. */
+  class map_checksum
+  {
+  private:
+    UINT64 A, B;   // Sums (low 32 bits are used)
+    BYTE Tail[4];  // Incomplete word
+    INT TailLen;   // Incomplete word bytes count
+
+    /* Add word to sums function.
+     * ARGUMENTS:
+     *   - word:
+     *       UINT W;
+     * RETURNS: None.
+     */
+    VOID Word( UINT W )
+    {
+      A = (A + W) & 0xFFFFFFFF;
+      B = (B + A) & 0xFFFFFFFF;
+    } /* End of 'Word' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS: None.
+     */
+    map_checksum( VOID ) : A(0), B(0), TailLen(0)
+    {
+    } /* End of 'map_checksum' constructor */
+
+    /* Add data function.
+     * ARGUMENTS:
+     *   - data:
+     *       const VOID *Data;
+     *   - data size in bytes:
+     *       size_t Size;
+     * RETURNS: None.
+     */
+    VOID Add( const VOID *Data, size_t Size )
+    {
+      const BYTE *Ptr = (const BYTE *)Data;
+      UINT W;
+
+      while (TailLen > 0 && TailLen < 4 && Size > 0)
+        Tail[TailLen++] = *Ptr++, Size--;
+      if (TailLen == 4)
+      {
+        memcpy(&W, Tail, 4);
+        Word(W);
+        TailLen = 0;
+      }
+      /* Sums are reduced once per block, 64-bit sums can't overflow inside */
+      while (Size >= 4)
+      {
+        size_t Block = Size / 4 < 4096 ? Size / 4 : 4096;
+        UINT64 a = A, b = B;
+
+        for (size_t i = 0; i < Block; i++, Ptr += 4)
+        {
+          memcpy(&W, Ptr, 4);
+          a += W;
+          b += a;
+        }
+        A = a & 0xFFFFFFFF;
+        B = b & 0xFFFFFFFF;
+        Size -= Block * 4;
+      }
+      while (Size > 0)
+        Tail[TailLen++] = *Ptr++, Size--;
+    } /* End of 'Add' function */
+
+    /* Obtain checksum function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (UINT64) checksum of all added data (incomplete word is zero padded).
+     */
+    UINT64 Get( VOID ) const
+    {
+      map_checksum Tmp = *this;
+
+      if (Tmp.TailLen > 0)
+      {
+        UINT W = 0;
+
+        memcpy(&W, Tmp.Tail, Tmp.TailLen);
+        Tmp.Word(W);
+      }
+      return (Tmp.B << 32) | Tmp.A;
+    } /* End of 'Get' function */
+  }; /* End of 'map_checksum' class */
+
+  /* Map file sequential writer class */
+  class map_writer
+  {
+  private:
+    FILE *F;              // Output file
+    map_header Header;    // Header to store on close
+    map_checksum Sum;     // Checksum of written data
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS:
+     *   - file name:
+     *       const CHAR *FileName;
+     *   - map size:
+     *       INT W, H;
+     *   - element type:
+     *       map_type Type;
+     */
+    map_writer( const CHAR *FileName, INT W, INT H, map_type Type ) : F(nullptr)
+    {
+      Header.Magic = map_header::MAGIC;
+      Header.Version = map_header::VERSION;
+      Header.W = W;
+      Header.H = H;
+      Header.Type = Type;
+      Header.DataOffset = sizeof(map_header);
+      Header.Checksum = 0;
+      Header.Scale = 1;
+      Header.Bias = 0;
+      Header.Codec = MAP_CODEC_NONE;
+      Header.BandRows = 0;
+      if ((F = fopen(FileName, "wb")) == nullptr)
+        throw "Too bad - file won't open!";
+      if (fwrite(&Header, sizeof(map_header), 1, F) != 1)
+        Fail();
+    } /* End of 'map_writer' constructor */
+
+    /* Class destructor.
+     * Destructor must not throw, so write errors are reported by 'Close' only.
+     * ARGUMENTS: None.
+     */
+    ~map_writer( VOID )
+    {
+      try
+      {
+        Close();
+      }
+      catch (...)
+      {
+      }
+    } /* End of '~map_writer' destructor */
+
+    /* Write elements function.
+     * ARGUMENTS:
+     *   - elements:
+     *       const VOID *Data;
+     *   - number of elements:
+     *       size_t Count;
+     * RETURNS: None.
+     */
+    VOID Write( const VOID *Data, size_t Count )
+    {
+      size_t Size = Count * MapElementSize(Header.Type);
+
+      Sum.Add(Data, Size);
+      if (fwrite(Data, 1, Size, F) != Size)
+        Fail();
+    } /* End of 'Write' function */
+
+    /* Set quantization parameters function.
+     * ARGUMENTS:
+     *   - parameters (h = q * Scale + Bias):
+     *       FLOAT Scale, Bias;
+     * RETURNS: None.
+     */
+    VOID SetQuantization( FLOAT Scale, FLOAT Bias )
+    {
+      Header.Scale = Scale;
+      Header.Bias = Bias;
+    } /* End of 'SetQuantization' function */
+
+    /* Finish file (store checksum) function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Close( VOID )
+    {
+      if (F == nullptr)
+        return;
+      Header.Checksum = Sum.Get();
+      if (fseek(F, 0, SEEK_SET) != 0 || fwrite(&Header, sizeof(map_header), 1, F) != 1)
+        Fail();
+      FILE *Closed = F;
+      F = nullptr;
+      if (fclose(Closed) != 0)
+        throw "Too bad - file won't write!";
+    } /* End of 'Close' function */
+
+  private:
+    /* Abandon file after write error function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Fail( VOID )
+    {
+      fclose(F);
+      F = nullptr;
+      throw "Too bad - file won't write!";
+    } /* End of 'Fail' function */
+  }; /* End of 'map_writer' class */
+
+  /* Read-only memory mapped whole file class.
+   * Mapping is shared between processes through system page cache. */
+  class file_view
+  {
+  private:
+#ifdef _WIN32
+    HANDLE hFile, hMapping;  // File and mapping handles
+#else /* _WIN32 */
+    INT Fd;                  // File descriptor
+#endif /* _WIN32 */
+    const BYTE *View;        // Whole file view
+    size_t Size;             // File size
+
+    /* Copying is prohibited */
+    file_view( const file_view & );
+    file_view & operator=( const file_view & );
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS: None.
+     */
+    file_view( VOID ) :
+#ifdef _WIN32
+      hFile(INVALID_HANDLE_VALUE), hMapping(NULL),
+#else /* _WIN32 */
+      Fd(-1),
+#endif /* _WIN32 */
+      View(nullptr), Size(0)
+    {
+    } /* End of 'file_view' constructor */
+
+    /* Class destructor.
+     * ARGUMENTS: None.
+     */
+    ~file_view( VOID )
+    {
+      Close();
+    } /* End of '~file_view' destructor */
+
+    /* Map whole file function.
+     * ARGUMENTS:
+     *   - file name:
+     *       const CHAR *FileName;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise.
+     */
+    BOOL Open( const CHAR *FileName )
+    {
+      Close();
+#ifdef _WIN32
+      LARGE_INTEGER FileSize;
+
+      hFile = CreateFile(FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+      if (hFile != INVALID_HANDLE_VALUE && GetFileSizeEx(hFile, &FileSize) && FileSize.QuadPart != 0 &&
+          (hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
+      {
+        Size = (size_t)FileSize.QuadPart;
+        View = (const BYTE *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+      }
+#else /* _WIN32 */
+      struct stat St;
+
+      if ((Fd = open(FileName, O_RDONLY)) >= 0 && fstat(Fd, &St) == 0 && St.st_size != 0)
+      {
+        Size = (size_t)St.st_size;
+        View = (const BYTE *)mmap(nullptr, Size, PROT_READ, MAP_SHARED, Fd, 0);
+        if (View == (const BYTE *)MAP_FAILED)
+          View = nullptr;
+      }
+#endif /* _WIN32 */
+      if (View == nullptr)
+      {
+        Close();
+        return FALSE;
+      }
+      return TRUE;
+    } /* End of 'Open' function */
+
+    /* Unmap file function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Close( VOID )
+    {
+#ifdef _WIN32
+      if (View != nullptr)
+        UnmapViewOfFile(View);
+      if (hMapping != NULL)
+        CloseHandle(hMapping);
+      if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+      hFile = INVALID_HANDLE_VALUE;
+      hMapping = NULL;
+#else /* _WIN32 */
+      if (View != nullptr)
+        munmap((VOID *)View, Size);
+      if (Fd >= 0)
+        close(Fd);
+      Fd = -1;
+#endif /* _WIN32 */
+      View = nullptr;
+      Size = 0;
+    } /* End of 'Close' function */
+
+    /* Obtain file contents function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (const BYTE *) mapped file contents, nullptr if file is not open.
+     */
+    const BYTE * GetView( VOID ) const
+    {
+      return View;
+    } /* End of 'GetView' function */
+
+    /* Obtain file size function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (size_t) file size in bytes.
+     */
+    size_t GetSize( VOID ) const
+    {
+      return Size;
+    } /* End of 'GetSize' function */
+  }; /* End of 'file_view' class */
+
+  /* Read-only memory mapped map file class.
+   * Elements are accessed in place (no copy) unless file is packed. */
+  class map_file
+  {
+  private:
+    file_view File;          // Mapped file
+    map_header Header;       // File header (filled for legacy files too)
+    BOOL IsLegacy;           // Legacy (no checksum) file flag
+    std::vector<BYTE> Data;  // Unpacked elements (packed files only)
+
+    /* Unpack file data function.
+     * Bands are unpacked in parallel.
+     * ARGUMENTS:
+     *   - file size:
+     *       size_t Size;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE if data is broken.
+     */
+    BOOL Unpack( size_t Size )
+    {
+      if (Header.BandRows <= 0)
+        return FALSE;
+
+      INT NumOfBands = (Header.H - 1) / Header.BandRows + 1;
+      size_t RowSize = (size_t)Header.W * MapElementSize(Header.Type);
+
+      if ((Size - Header.DataOffset) / sizeof(UINT64) <= (size_t)NumOfBands)
+        return FALSE;
+
+      std::vector<UINT64> Index(NumOfBands + 1);
+
+      memcpy(&Index[0], File.GetView() + Header.DataOffset, sizeof(UINT64) * Index.size());
+      if (Index[0] < Header.DataOffset + sizeof(UINT64) * Index.size() || Index[NumOfBands] > Size)
+        return FALSE;
+      for (INT i = 0; i < NumOfBands; i++)
+        if (Index[i] > Index[i + 1])
+          return FALSE;
+      /* Every component sample takes at least one bit */
+      if ((Index[NumOfBands] - Index[0]) * 8 < (UINT64)Header.W * Header.H * MapPackLayout(Header.Type).Components)
+        return FALSE;
+
+      std::vector<BYTE> IsOk(NumOfBands, FALSE);
+      thread_pool Pool;
+
+      Data.resize(RowSize * Header.H);
+      Pool.ParallelFor(NumOfBands, [&]( INT i )
+        {
+          INT
+            Row0 = i * Header.BandRows,
+            Rows = Header.H - Row0 < Header.BandRows ? Header.H - Row0 : Header.BandRows;
+
+          IsOk[i] = codec::Unpack(File.GetView() + Index[i], (size_t)(Index[i + 1] - Index[i]),
+            Header.W, Rows, MapPackLayout(Header.Type), &Data[RowSize * Row0]);
+        });
+      for (INT i = 0; i < NumOfBands; i++)
+        if (!IsOk[i])
+          return FALSE;
+      return TRUE;
+    } /* End of 'Unpack' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS: None.
+     */
+    map_file( VOID ) : IsLegacy(FALSE)
+    {
+      memset(&Header, 0, sizeof(Header));
+    } /* End of 'map_file' constructor */
+
+    /* Open map file function.
+     * File is accepted if header is valid and file size matches it.
+     * Packed files are unpacked to memory.
+     * Height (normal) maps of any encoding are accepted for height (normal) types.
+     * ARGUMENTS:
+     *   - file name:
+     *       const CHAR *FileName;
+     *   - expected element type (also legacy file type):
+     *       map_type Type;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise.
+     */
+    BOOL Open( const CHAR *FileName, map_type Type )
+    {
+      const BYTE *View;
+      size_t Size;
+
+      if (!File.Open(FileName) || (Size = File.GetSize()) < sizeof(INT) * 2)
+      {
+        Close();
+        return FALSE;
+      }
+      View = File.GetView();
+
+      if (Size >= map_header::V1_SIZE && ((const map_header *)View)->Magic == map_header::MAGIC)
+      {
+        memset(&Header, 0, sizeof(Header));
+        memcpy(&Header, View, map_header::V1_SIZE);
+        Header.Scale = 1;
+        if (Header.Version >= 3 && Size >= sizeof(map_header))
+          memcpy(&Header, View, sizeof(map_header));
+        else if (Header.Version == 2 && Size >= map_header::V2_SIZE)
+          memcpy(&Header, View, map_header::V2_SIZE);
+        IsLegacy = FALSE;
+      }
+      else
+      {
+        /* Legacy 'INT W, H' header */
+        memset(&Header, 0, sizeof(Header));
+        memcpy(&Header.W, View, sizeof(INT) * 2);
+        Header.Version = 0;
+        Header.Type = Type;
+        Header.DataOffset = sizeof(INT) * 2;
+        Header.Scale = 1;
+        IsLegacy = TRUE;
+      }
+
+      size_t ElementSize = MapElementSize(Header.Type);
+
+      if (Header.Version > map_header::VERSION || ElementSize == 0 ||
+          (Header.Type != Type && !(MapIsHeight(Header.Type) && MapIsHeight(Type)) &&
+           !(MapIsNormal(Header.Type) && MapIsNormal(Type))) ||
+          Header.W <= 0 || Header.H <= 0 || Header.DataOffset > Size ||
+          (size_t)Header.H > ((size_t)-1) / ElementSize / Header.W ||
+          (Header.Codec == MAP_CODEC_NONE ?
+            (Size - Header.DataOffset) != (size_t)Header.W * Header.H * ElementSize :
+            Header.Codec != MAP_CODEC_PACKED || !Unpack(Size)))
+      {
+        Close();
+        return FALSE;
+      }
+      return TRUE;
+    } /* End of 'Open' function */
+
+    /* Close map file function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Close( VOID )
+    {
+      File.Close();
+      Data.clear();
+    } /* End of 'Close' function */
+
+    /* Check data checksum function.
+     * Reads all elements (legacy files have no checksum and always pass).
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if data is intact, FALSE otherwise.
+     */
+    BOOL Verify( VOID ) const
+    {
+      map_checksum Sum;
+
+      if (File.GetView() == nullptr)
+        return FALSE;
+      if (IsLegacy)
+        return TRUE;
+      Sum.Add(GetData<BYTE>(), (size_t)Header.W * Header.H * MapElementSize(Header.Type));
+      return Sum.Get() == Header.Checksum;
+    } /* End of 'Verify' function */
+
+    /* Obtain map width function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) map width.
+     */
+    INT GetW( VOID ) const
+    {
+      return Header.W;
+    } /* End of 'GetW' function */
+
+    /* Obtain map height function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) map height.
+     */
+    INT GetH( VOID ) const
+    {
+      return Header.H;
+    } /* End of 'GetH' function */
+
+    /* Obtain element type function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) element type (see 'map_type').
+     */
+    INT GetType( VOID ) const
+    {
+      return Header.Type;
+    } /* End of 'GetType' function */
+
+    /* Obtain quantization scale function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (FLOAT) scale ('MAP_UINT16' maps).
+     */
+    FLOAT GetScale( VOID ) const
+    {
+      return Header.Scale;
+    } /* End of 'GetScale' function */
+
+    /* Obtain quantization bias function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (FLOAT) bias ('MAP_UINT16' maps).
+     */
+    FLOAT GetBias( VOID ) const
+    {
+      return Header.Bias;
+    } /* End of 'GetBias' function */
+
+    /* Decode height samples to floats function.
+     * ARGUMENTS:
+     *   - first sample (row-major) and number of samples:
+     *       size_t First, Count;
+     *   - result samples:
+     *       FLOAT *Dst;
+     * RETURNS: None.
+     */
+    VOID Decode( size_t First, size_t Count, FLOAT *Dst ) const
+    {
+      switch (Header.Type)
+      {
+      case MAP_FLOAT:
+        memcpy(Dst, GetData<FLOAT>() + First, Count * sizeof(FLOAT));
+        break;
+      case MAP_UINT16:
+        codec::Dequantize(GetData<uint16_t>() + First, Header.Scale, Header.Bias, Dst, Count);
+        break;
+      case MAP_HALF:
+        codec::DecodeHalf(GetData<uint16_t>() + First, Dst, Count);
+        break;
+      }
+    } /* End of 'Decode' function */
+
+    /* Decode normals to SHORT[3] function.
+     * ARGUMENTS:
+     *   - first normal (row-major) and number of normals:
+     *       size_t First, Count;
+     *   - result normals (3 components each, scaled by 32767):
+     *       SHORT *Dst;
+     * RETURNS: None.
+     */
+    VOID DecodeNormals( size_t First, size_t Count, SHORT *Dst ) const
+    {
+      switch (Header.Type)
+      {
+      case MAP_SHORT3:
+        memcpy(Dst, GetData<SHORT>() + First * 3, Count * sizeof(SHORT) * 3);
+        break;
+      case MAP_OCT16:
+        codec::OctDecode(GetData<SHORT>() + First * 2, Count, Dst);
+        break;
+      case MAP_OCT8:
+        codec::OctDecode(GetData<int8_t>() + First * 2, Count, Dst);
+        break;
+      }
+    } /* End of 'DecodeNormals' function */
+
+    /* Obtain map version function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) format version, 0 for legacy files.
+     */
+    INT GetVersion( VOID ) const
+    {
+      return Header.Version;
+    } /* End of 'GetVersion' function */
+
+    /* Obtain map elements checksum function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (UINT64) stored checksum of elements, 0 for legacy files.
+     */
+    UINT64 GetChecksum( VOID ) const
+    {
+      return IsLegacy ? 0 : Header.Checksum;
+    } /* End of 'GetChecksum' function */
+
+    /* Obtain elements view function.
+     * View is valid until file is closed.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (const type *) pointer to elements in mapped memory (or in unpacked data).
+     */
+    template<class type>
+      const type * GetData( VOID ) const
+      {
+        if (File.GetView() == nullptr)
+          return nullptr;
+        return (const type *)(Data.empty() ? File.GetView() + Header.DataOffset : &Data[0]);
+      } /* End of 'GetData' function */
+
+    /* Store packed copy of map file function.
+     * Bands of rows are packed in parallel (see 'codec::Pack').
+     * ARGUMENTS:
+     *   - source map file name (any element type):
+     *       const CHAR *Source;
+     *   - packed map file name:
+     *       const CHAR *FileName;
+     *   - rows per band:
+     *       INT BandRows;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise (failed packed file is removed).
+     */
+    static BOOL Pack( const CHAR *Source, const CHAR *FileName, INT BandRows = 64 )
+    {
+      map_file Src;
+
+      if ((!Src.Open(Source, MAP_FLOAT) && !Src.Open(Source, MAP_SHORT3)) || !Src.Verify())
+        return FALSE;
+
+      map_header H = Src.Header;
+      INT NumOfBands = (H.H - 1) / BandRows + 1;
+      size_t RowSize = (size_t)H.W * MapElementSize(H.Type);
+      std::vector<std::vector<BYTE>> Bands(NumOfBands);
+      std::vector<UINT64> Index(NumOfBands + 1);
+      map_checksum Sum;
+      thread_pool Pool;
+      FILE *F;
+      BOOL IsOk;
+
+      Pool.ParallelFor(NumOfBands, [&]( INT i )
+        {
+          INT Row0 = i * BandRows, Rows = H.H - Row0 < BandRows ? H.H - Row0 : BandRows;
+
+          codec::Pack(Src.GetData<BYTE>() + RowSize * Row0, H.W, Rows, MapPackLayout(H.Type), Bands[i]);
+        });
+      Sum.Add(Src.GetData<BYTE>(), RowSize * H.H);
+      H.Magic = map_header::MAGIC;
+      H.Version = map_header::VERSION;
+      H.DataOffset = sizeof(map_header);
+      H.Checksum = Sum.Get();
+      H.Codec = MAP_CODEC_PACKED;
+      H.BandRows = BandRows;
+      Index[0] = sizeof(map_header) + sizeof(UINT64) * Index.size();
+      for (INT i = 0; i < NumOfBands; i++)
+        Index[i + 1] = Index[i] + Bands[i].size();
+
+      if ((F = fopen(FileName, "wb")) == nullptr)
+        return FALSE;
+      IsOk = fwrite(&H, sizeof(map_header), 1, F) == 1 &&
+             fwrite(&Index[0], sizeof(UINT64), Index.size(), F) == Index.size();
+      for (INT i = 0; IsOk && i < NumOfBands; i++)
+        IsOk = fwrite(Bands[i].data(), 1, Bands[i].size(), F) == Bands[i].size();
+      if (fclose(F) != 0 || !IsOk)
+      {
+        remove(FileName);
+        return FALSE;
+      }
+      return TRUE;
+    } /* End of 'Pack' function */
+  }; /* End of 'map_file' class */
+} /* end of 'tcg' namespace */
+
+#endif /* __map_file_h_ */
+
+/* END OF 'map_file.h' FILE */
@@ -0,0 +1,570 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : map_minmax.h
+ * PURPOSE     : Computational geometry project.
+ *               Height map min/max quadtree module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __map_minmax_h_
+#define __map_minmax_h_
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+
+#include "../def.h"
+#include "map_file.h"
+#include "thread_pool.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Heights range */
+  struct minmax
+  {
+    FLOAT Min, Max;  // Minimal and maximal heights
+  }; /* End of 'minmax' struct */
+
+  /* Height map min/max quadtree class.
+   * Level 0 node is grid cell (bounds of its 4 corner samples, so it bounds
+   * bilinear surface of cell too), level 'l' node covers 2^l x 2^l cells,
+   * last level is 1 x 1 root. Level sizes are halved rounding up.
+   * Ray queries work in grid space: X is sample column, Y is height,
+   * Z is sample row. */
+  class minmax_tree
+  {
+  private:
+    /* Tree file header */
+    struct header
+    {
+      static const UINT
+        MAGIC = 0x51474354,  // 'TCGQ'
+        VERSION = 1;         // Current format version
+      UINT Magic;            // Format magic number
+      UINT Version;          // Format version
+      INT W, H;              // Samples grid size
+      FLOAT Scale, Bias;     // Source map quantization parameters
+      UINT64 Checksum;       // Source map elements checksum
+    }; /* End of 'header' struct */
+
+    static const INT BandRows = 64;        // Node rows per build work item
+    INT W, H;                              // Samples grid size
+    header Source;                         // Source height map identity (zero checksum if unknown)
+    std::vector<FLOAT> Heights;            // Height samples (row by row)
+    std::vector<std::vector<minmax>> Levels;  // Node bounds of every level (row by row)
+    std::vector<INT> LevelW, LevelH;       // Levels sizes
+
+    /* Evaluate level nodes bounds rows part function.
+     * ARGUMENTS:
+     *   - level number:
+     *       INT l;
+     *   - nodes rectangle (half-open):
+     *       INT X0, INT Y0, INT X1, INT Y1;
+     * RETURNS: None.
+     */
+    VOID Evaluate( INT l, INT X0, INT Y0, INT X1, INT Y1 )
+    {
+      minmax *Dst = &Levels[l][0];
+
+      if (l == 0)
+        for (INT y = Y0; y < Y1; y++)
+        {
+          const FLOAT
+            *r0 = &Heights[(size_t)y * W],
+            *r1 = &Heights[(size_t)std::min(y + 1, H - 1) * W];
+
+          for (INT x = X0; x < X1; x++)
+          {
+            INT x1 = std::min(x + 1, W - 1);
+            FLOAT
+              a = std::min(r0[x], r0[x1]), b = std::min(r1[x], r1[x1]),
+              c = std::max(r0[x], r0[x1]), d = std::max(r1[x], r1[x1]);
+
+            Dst[(size_t)y * LevelW[0] + x].Min = std::min(a, b);
+            Dst[(size_t)y * LevelW[0] + x].Max = std::max(c, d);
+          }
+        }
+      else
+      {
+        const minmax *Src = &Levels[l - 1][0];
+        INT sw = LevelW[l - 1], sh = LevelH[l - 1];
+
+        for (INT y = Y0; y < Y1; y++)
+          for (INT x = X0; x < X1; x++)
+          {
+            minmax R = Src[(size_t)(y * 2) * sw + x * 2];
+
+            for (INT i = y * 2; i < y * 2 + 2 && i < sh; i++)
+              for (INT j = x * 2; j < x * 2 + 2 && j < sw; j++)
+              {
+                R.Min = std::min(R.Min, Src[(size_t)i * sw + j].Min);
+                R.Max = std::max(R.Max, Src[(size_t)i * sw + j].Max);
+              }
+            Dst[(size_t)y * LevelW[l] + x] = R;
+          }
+      }
+    } /* End of 'Evaluate' function */
+
+    /* Set samples grid and levels sizes function.
+     * ARGUMENTS:
+     *   - samples grid size:
+     *       INT NewW, INT NewH;
+     * RETURNS: None.
+     */
+    VOID Resize( INT NewW, INT NewH )
+    {
+      W = NewW;
+      H = NewH;
+      LevelW.assign(1, std::max(W - 1, 1));
+      LevelH.assign(1, std::max(H - 1, 1));
+      while (LevelW.back() > 1 || LevelH.back() > 1)
+      {
+        LevelW.push_back((LevelW.back() + 1) / 2);
+        LevelH.push_back((LevelH.back() + 1) / 2);
+      }
+      Levels.resize(LevelW.size());
+      for (INT l = 0; l < (INT)Levels.size(); l++)
+        Levels[l].resize((size_t)LevelW[l] * LevelH[l]);
+    } /* End of 'Resize' function */
+
+    /* Read node bounds from tree file function.
+     * ARGUMENTS:
+     *   - tree file name:
+     *       const CHAR *TreeFileName;
+     *   - expected source height map identity:
+     *       const header &Map;
+     * RETURNS:
+     *   (BOOL) TRUE if file matches height map and was read, FALSE otherwise.
+     */
+    BOOL Read( const CHAR *TreeFileName, const header &Map )
+    {
+      FILE *F = fopen(TreeFileName, "rb");
+      header Stored;
+      BOOL IsOk;
+
+      if (F == nullptr)
+        return FALSE;
+      IsOk = fread(&Stored, sizeof(header), 1, F) == 1 &&
+        memcmp(&Stored, &Map, sizeof(header)) == 0;
+      if (IsOk)
+      {
+        Resize(Map.W, Map.H);
+        for (INT l = 0; IsOk && l < (INT)Levels.size(); l++)
+          IsOk = fread(&Levels[l][0], sizeof(minmax), Levels[l].size(), F) == Levels[l].size();
+      }
+      fclose(F);
+      return IsOk;
+    } /* End of 'Read' function */
+
+    /* Merge nodes bounds range function.
+     * ARGUMENTS:
+     *   - level number:
+     *       INT l;
+     *   - nodes rectangle (half-open):
+     *       INT X0, INT Y0, INT X1, INT Y1;
+     *   - result bounds (updated):
+     *       minmax &R;
+     * RETURNS: None.
+     */
+    VOID Merge( INT l, INT X0, INT Y0, INT X1, INT Y1, minmax &R ) const
+    {
+      for (INT y = Y0; y < Y1; y++)
+      {
+        const minmax *N = &Levels[l][(size_t)y * LevelW[l]];
+
+        for (INT x = X0; x < X1; x++)
+        {
+          R.Min = std::min(R.Min, N[x].Min);
+          R.Max = std::max(R.Max, N[x].Max);
+        }
+      }
+    } /* End of 'Merge' function */
+
+    /* Clip ray parameter interval by slab function.
+     * ARGUMENTS:
+     *   - ray origin and direction components:
+     *       DBL Org, DBL Dir;
+     *   - slab bounds:
+     *       DBL Lo, DBL Hi;
+     *   - parameter interval (updated):
+     *       DBL &T0, DBL &T1;
+     * RETURNS:
+     *   (BOOL) TRUE if interval is not empty.
+     */
+    static BOOL Slab( DBL Org, DBL Dir, DBL Lo, DBL Hi, DBL &T0, DBL &T1 )
+    {
+      if (Dir == 0)
+        return Org >= Lo && Org <= Hi && T0 <= T1;
+
+      DBL a = (Lo - Org) / Dir, b = (Hi - Org) / Dir;
+
+      if (a > b)
+        std::swap(a, b);
+      if (a > T0)
+        T0 = a;
+      if (b < T1)
+        T1 = b;
+      return T0 <= T1;
+    } /* End of 'Slab' function */
+
+    /* Clip ray parameter interval by node box function.
+     * ARGUMENTS:
+     *   - ray in grid space:
+     *       const ray &R;
+     *   - node level and position:
+     *       INT l, INT x, INT y;
+     *   - parameter interval (updated):
+     *       DBL &T0, DBL &T1;
+     * RETURNS:
+     *   (BOOL) TRUE if ray passes through node box.
+     */
+    BOOL Box( const ray &R, INT l, INT x, INT y, DBL &T0, DBL &T1 ) const
+    {
+      const minmax &N = Levels[l][(size_t)y * LevelW[l] + x];
+
+      return
+        Slab(R.Org.X, R.Dir.X, x << l, std::min((x + 1) << l, LevelW[0]), T0, T1) &&
+        Slab(R.Org.Z, R.Dir.Z, y << l, std::min((y + 1) << l, LevelH[0]), T0, T1) &&
+        Slab(R.Org.Y, R.Dir.Y, N.Min, N.Max, T0, T1);
+    } /* End of 'Box' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS: None.
+     */
+    minmax_tree( VOID ) : W(0), H(0)
+    {
+      memset(&Source, 0, sizeof(Source));
+    } /* End of 'minmax_tree' constructor */
+
+    /* Build tree function.
+     * Levels are evaluated by row bands in parallel.
+     * ARGUMENTS:
+     *   - height samples (row by row):
+     *       const FLOAT *Src;
+     *   - samples grid size:
+     *       INT NewW, INT NewH;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise.
+     */
+    BOOL Build( const FLOAT *Src, INT NewW, INT NewH )
+    {
+      if (NewW <= 0 || NewH <= 0)
+        return FALSE;
+      Heights.assign(Src, Src + (size_t)NewW * NewH);
+      Resize(NewW, NewH);
+      memset(&Source, 0, sizeof(Source));
+
+      thread_pool Pool;
+
+      for (INT l = 0; l < (INT)Levels.size(); l++)
+      {
+        Pool.ParallelFor((LevelH[l] + BandRows - 1) / BandRows, [&]( INT Band )
+          {
+            Evaluate(l, 0, Band * BandRows, LevelW[l], std::min((Band + 1) * BandRows, LevelH[l]));
+          });
+      }
+      return TRUE;
+    } /* End of 'Build' function */
+
+    /* Load tree for height map file function.
+     * Node bounds are read from tree file if it was saved for the same
+     * height map (see 'Save'), otherwise tree is built.
+     * ARGUMENTS:
+     *   - height map file name (any height encoding, see 'map_file'):
+     *       const CHAR *FileName;
+     *   - tree file name (may be nullptr):
+     *       const CHAR *TreeFileName;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise.
+     */
+    BOOL Load( const CHAR *FileName, const CHAR *TreeFileName = nullptr )
+    {
+      map_file F;
+
+      if (!F.Open(FileName, MAP_FLOAT))
+        return FALSE;
+
+      std::vector<FLOAT> Src((size_t)F.GetW() * F.GetH());
+      header Map;
+
+      F.Decode(0, Src.size(), &Src[0]);
+      Map.Magic = header::MAGIC;
+      Map.Version = header::VERSION;
+      Map.W = F.GetW();
+      Map.H = F.GetH();
+      Map.Scale = F.GetScale();
+      Map.Bias = F.GetBias();
+      Map.Checksum = F.GetChecksum();
+      if (TreeFileName != nullptr && Map.Checksum != 0 && Read(TreeFileName, Map))
+      {
+        Heights.swap(Src);
+        Source = Map;
+        return TRUE;
+      }
+      if (!Build(&Src[0], Map.W, Map.H))
+        return FALSE;
+      Source = Map;
+      return TRUE;
+    } /* End of 'Load' function */
+
+    /* Save tree of loaded height map function.
+     * ARGUMENTS:
+     *   - tree file name:
+     *       const CHAR *TreeFileName;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise (tree was not loaded from
+     *          height map file or samples were changed).
+     */
+    BOOL Save( const CHAR *TreeFileName ) const
+    {
+      FILE *F;
+      BOOL IsOk;
+
+      if (Source.Checksum == 0 || (F = fopen(TreeFileName, "wb")) == nullptr)
+        return FALSE;
+      IsOk = fwrite(&Source, sizeof(header), 1, F) == 1;
+      for (INT l = 0; IsOk && l < (INT)Levels.size(); l++)
+        IsOk = fwrite(&Levels[l][0], sizeof(minmax), Levels[l].size(), F) == Levels[l].size();
+      if (fclose(F) != 0 || !IsOk)
+      {
+        remove(TreeFileName);
+        return FALSE;
+      }
+      return TRUE;
+    } /* End of 'Save' function */
+
+    /* Change height samples rectangle function.
+     * Only nodes over changed samples are evaluated again.
+     * ARGUMENTS:
+     *   - rectangle position and size (in samples):
+     *       INT X0, INT Y0, INT SW, INT SH;
+     *   - new samples (row by row, 'SW' per row):
+     *       const FLOAT *Src;
+     * RETURNS: None.
+     */
+    VOID Update( INT X0, INT Y0, INT SW, INT SH, const FLOAT *Src )
+    {
+      INT
+        x0 = std::max(X0, 0), x1 = std::min(X0 + SW, W),
+        y0 = std::max(Y0, 0), y1 = std::min(Y0 + SH, H);
+
+      if (x0 >= x1 || y0 >= y1)
+        return;
+      for (INT y = y0; y < y1; y++)
+        memcpy(&Heights[(size_t)y * W + x0], Src + (size_t)(y - Y0) * SW + (x0 - X0), (x1 - x0) * sizeof(FLOAT));
+      /* Tree does not match source map any more */
+      Source.Checksum = 0;
+
+      /* Cells with changed corners */
+      x0 = std::max(x0 - 1, 0), x1 = std::min(x1, LevelW[0]);
+      y0 = std::max(y0 - 1, 0), y1 = std::min(y1, LevelH[0]);
+      for (INT l = 0; l < (INT)Levels.size(); l++)
+      {
+        Evaluate(l, x0, y0, x1, y1);
+        x0 /= 2, y0 /= 2, x1 = (x1 + 1) / 2, y1 = (y1 + 1) / 2;
+      }
+    } /* End of 'Update' function */
+
+    /* Obtain heights range over samples rectangle function.
+     * ARGUMENTS:
+     *   - samples rectangle (inclusive, clamped by grid):
+     *       INT X0, INT Y0, INT X1, INT Y1;
+     * RETURNS:
+     *   (minmax) exact minimal and maximal samples heights.
+     */
+    minmax GetRange( INT X0, INT Y0, INT X1, INT Y1 ) const
+    {
+      minmax R = {FLT_MAX, -FLT_MAX};
+
+      X0 = std::max(X0, 0), X1 = std::min(X1, W - 1);
+      Y0 = std::max(Y0, 0), Y1 = std::min(Y1, H - 1);
+      if (X0 > X1 || Y0 > Y1)
+        return R;
+      if (X0 == X1 || Y0 == Y1)
+      {
+        /* Samples line */
+        for (INT y = Y0; y <= Y1; y++)
+          for (INT x = X0; x <= X1; x++)
+          {
+            R.Min = std::min(R.Min, Heights[(size_t)y * W + x]);
+            R.Max = std::max(R.Max, Heights[(size_t)y * W + x]);
+          }
+        return R;
+      }
+      /* Cells [X0, X1) x [Y0, Y1) have exactly samples of rectangle as corners.
+       * Odd border nodes of every level are taken, the rest is merged on next level
+       * (nodes may be taken twice, this does not change range) */
+      for (INT l = 0; X0 < X1 && Y0 < Y1; l++, X0 /= 2, Y0 /= 2, X1 /= 2, Y1 /= 2)
+      {
+        if (X0 & 1)
+          Merge(l, X0, Y0, X0 + 1, Y1, R), X0++;
+        if (X1 & 1)
+          Merge(l, X1 - 1, Y0, X1, Y1, R), X1--;
+        if (Y0 & 1)
+          Merge(l, X0, Y0, X1, Y0 + 1, R), Y0++;
+        if (Y1 & 1)
+          Merge(l, X0, Y1 - 1, X1, Y1, R), Y1--;
+      }
+      return R;
+    } /* End of 'GetRange' function */
+
+    /* Trace ray through cells front to back function.
+     * Only cells which bounds boxes are passed by ray are visited,
+     * in order of ray entry into them (ray going exactly along cells
+     * border may visit cells of both sides out of order, so callers
+     * looking for nearest hit should stop at cell entry beyond hit).
+     * ARGUMENTS:
+     *   - ray in grid space:
+     *       const ray &R;
+     *   - ray parameter interval:
+     *       DBL T0, DBL T1;
+     *   - cell callback (gets cell position and ray interval in its box,
+     *     returns TRUE to stop tracing):
+     *       leaf_func Leaf;
+     * RETURNS:
+     *   (BOOL) TRUE if tracing was stopped by callback.
+     */
+    template<class leaf_func>
+      BOOL Trace( const ray &R, DBL T0, DBL T1, leaf_func Leaf ) const
+      {
+        struct entry
+        {
+          INT l, x, y;  // Node level and position
+          DBL T0, T1;   // Ray interval in node box
+        } Stack[64 * 4], Child[4];
+        INT Top = 0;
+
+        if (Levels.empty() || !Box(R, (INT)Levels.size() - 1, 0, 0, T0, T1))
+          return FALSE;
+        Stack[Top].l = (INT)Levels.size() - 1, Stack[Top].x = Stack[Top].y = 0;
+        Stack[Top].T0 = T0, Stack[Top++].T1 = T1;
+        while (Top > 0)
+        {
+          entry E = Stack[--Top];
+
+          if (E.l == 0)
+          {
+            if (Leaf(E.x, E.y, E.T0, E.T1))
+              return TRUE;
+            continue;
+          }
+
+          /* Children passed by ray sorted by entry parameter */
+          INT n = 0;
+
+          for (INT i = E.y * 2; i < E.y * 2 + 2 && i < LevelH[E.l - 1]; i++)
+            for (INT j = E.x * 2; j < E.x * 2 + 2 && j < LevelW[E.l - 1]; j++)
+            {
+              entry C = {E.l - 1, j, i, E.T0, E.T1};
+              INT k = n;
+
+              if (!Box(R, C.l, j, i, C.T0, C.T1))
+                continue;
+              for (n++; k > 0 && Child[k - 1].T0 < C.T0; k--)
+                Child[k] = Child[k - 1];
+              Child[k] = C;
+            }
+          /* Children are sorted farthest first, so nearest one is on stack top */
+          for (INT k = 0; k < n; k++)
+            Stack[Top++] = Child[k];
+        }
+        return FALSE;
+      } /* End of 'Trace' function */
+
+    /* Conservative ray interval culling function.
+     * ARGUMENTS:
+     *   - ray in grid space:
+     *       const ray &R;
+     *   - ray parameter interval (clipped to part where ray can touch surface):
+     *       DBL &T0, DBL &T1;
+     * RETURNS:
+     *   (BOOL) TRUE if ray can touch surface, FALSE if it surely misses.
+     */
+    BOOL Cull( const ray &R, DBL &T0, DBL &T1 ) const
+    {
+      DBL First = T1, Last = T0;
+      BOOL IsHit = FALSE;
+
+      Trace(R, T0, T1, [&]( INT, INT, DBL t0, DBL t1 )
+        {
+          IsHit = TRUE;
+          if (t0 < First)
+            First = t0;
+          if (t1 > Last)
+            Last = t1;
+          return FALSE;
+        });
+      if (!IsHit)
+        return FALSE;
+      T0 = First;
+      T1 = Last;
+      return TRUE;
+    } /* End of 'Cull' function */
+
+    /* Obtain samples grid width function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) number of samples in row.
+     */
+    INT GetW( VOID ) const
+    {
+      return W;
+    } /* End of 'GetW' function */
+
+    /* Obtain samples grid height function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) number of sample rows.
+     */
+    INT GetH( VOID ) const
+    {
+      return H;
+    } /* End of 'GetH' function */
+
+    /* Obtain height samples function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (const FLOAT *) samples (row by row).
+     */
+    const FLOAT * GetHeights( VOID ) const
+    {
+      return Heights.empty() ? nullptr : &Heights[0];
+    } /* End of 'GetHeights' function */
+
+    /* Obtain number of levels function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) number of levels (0 if tree is not built).
+     */
+    INT GetLevels( VOID ) const
+    {
+      return (INT)Levels.size();
+    } /* End of 'GetLevels' function */
+
+    /* Obtain node bounds function.
+     * ARGUMENTS:
+     *   - node level and position:
+     *       INT Level, INT X, INT Y;
+     * RETURNS:
+     *   (const minmax &) node heights range.
+     */
+    const minmax & GetNode( INT Level, INT X, INT Y ) const
+    {
+      return Levels[Level][(size_t)Y * LevelW[Level] + X];
+    } /* End of 'GetNode' function */
+  }; /* End of 'minmax_tree' class */
+} /* end of 'tcg' namespace */
+
+#endif /* __map_minmax_h_ */
+
+/* END OF 'map_minmax.h' FILE */
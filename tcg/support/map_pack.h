@@ -0,0 +1,604 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : map_pack.h
+ * PURPOSE     : Computational geometry project.
+ *               Lossless map rows compression module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg::codec'.
+ *
+ *               Every element component is coded separately row by row.
+ *               Component words are mapped to unsigned integers keeping
+ *               values order, row predictor (left, up or LOCO-I median
+ *               edge detector) is chosen by residuals sum, zigzag mapped
+ *               residuals are Rice coded with per row parameter.
+ *               Row stream: 2-bit predictor and 6-bit Rice parameter,
+ *               then residuals (unary quotient, 24 zeros escape to raw word).
+ *               Bits are written LSB first. Blocks of rows are independent.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __map_pack_h_
+#define __map_pack_h_
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#include "../def.h"
+#include "cpu.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Height map samples encoding namespace */
+  namespace codec
+  {
+    /* Packed component kinds */
+    enum
+    {
+      PACK_UNSIGNED,  // Unsigned integer
+      PACK_SIGNED,    // Two's complement integer
+      PACK_FLOAT      // IEEE float (sign and magnitude)
+    }; /* End of enum */
+
+    /* Packed element layout */
+    struct pack_layout
+    {
+      INT WordSize;    // Component size in bytes (1, 2 or 4)
+      INT Components;  // Number of components per element
+      INT Kind;        // Component kind (see 'PACK_***')
+    }; /* End of 'pack_layout' struct */
+
+    /* Row predictors */
+    enum
+    {
+      PACK_LEFT,      // Left neighbour
+      PACK_UP,        // Upper neighbour
+      PACK_MEDIAN,    // LOCO-I median edge detector
+      PACK_PREDICTORS
+    }; /* End of enum */
+
+    /* Escape quotient (raw word follows) */
+    static const INT PackEscape = 24;
+
+    /* Count trailing zero bits function.
+     * ARGUMENTS:
+     *   - value (not zero):
+     *       UINT64 X;
+     * RETURNS:
+     *   (INT) number of trailing zero bits.
+     */
+    inline INT TrailingZeros( UINT64 X )
+    {
+#ifdef _MSC_VER
+      unsigned long Index;
+
+      _BitScanForward64(&Index, X);
+      return (INT)Index;
+#else /* _MSC_VER */
+      return __builtin_ctzll(X);
+#endif /* _MSC_VER */
+    } /* End of 'TrailingZeros' function */
+
+    /* LSB first bits writer class */
+    class bit_writer
+    {
+    private:
+      std::vector<BYTE> &Out;  // Output buffer
+      UINT64 Acc;              // Pending bits
+      INT Count;               // Number of pending bits
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS:
+       *   - output buffer (bytes are appended):
+       *       std::vector<BYTE> &Out;
+       */
+      bit_writer( std::vector<BYTE> &Out ) : Out(Out), Acc(0), Count(0)
+      {
+      } /* End of 'bit_writer' constructor */
+
+      /* Put bits function.
+       * ARGUMENTS:
+       *   - bits value and number of bits (up to 32):
+       *       UINT Bits;
+       *       INT N;
+       * RETURNS: None.
+       */
+      VOID Put( UINT Bits, INT N )
+      {
+        Acc |= (UINT64)Bits << Count;
+        if ((Count += N) >= 32)
+        {
+          for (INT i = 0; i < 4; i++)
+            Out.push_back((BYTE)(Acc >> i * 8));
+          Acc >>= 32;
+          Count -= 32;
+        }
+      } /* End of 'Put' function */
+
+      /* Store pending bits function.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Flush( VOID )
+      {
+        for (; Count > 0; Count -= 8, Acc >>= 8)
+          Out.push_back((BYTE)Acc);
+        Count = 0;
+        Acc = 0;
+      } /* End of 'Flush' function */
+    }; /* End of 'bit_writer' class */
+
+    /* LSB first bits reader class (never reads out of data) */
+    class bit_reader
+    {
+    private:
+      const BYTE *Ptr, *End;  // Data left
+      UINT64 Acc;             // Loaded bits
+      INT Count;              // Number of loaded bits
+
+    public:
+      /* Class constructor.
+       * ARGUMENTS:
+       *   - data:
+       *       const BYTE *Src;
+       *       size_t Size;
+       */
+      bit_reader( const BYTE *Src, size_t Size ) : Ptr(Src), End(Src + Size), Acc(0), Count(0)
+      {
+      } /* End of 'bit_reader' constructor */
+
+      /* Load at least 56 bits (if data is not over) function.
+       * ARGUMENTS: None.
+       * RETURNS: None.
+       */
+      VOID Refill( VOID )
+      {
+        if (End - Ptr >= 8)
+        {
+          UINT64 Next;
+
+          memcpy(&Next, Ptr, sizeof(Next));
+          Acc |= Next << Count;
+          Ptr += (63 - Count) >> 3;
+          Count |= 56;
+        }
+        else
+          for (; Count <= 56 && Ptr < End; Count += 8)
+            Acc |= (UINT64)*Ptr++ << Count;
+      } /* End of 'Refill' function */
+
+      /* Get bits function.
+       * ARGUMENTS:
+       *   - number of bits (up to 32, should be loaded):
+       *       INT N;
+       * RETURNS:
+       *   (UINT) bits value.
+       */
+      UINT Get( INT N )
+      {
+        UINT Bits = (UINT)(Acc & ((1ULL << N) - 1));
+
+        Acc >>= N;
+        Count -= N;
+        return Bits;
+      } /* End of 'Get' function */
+
+      /* Get unary coded value (zeros before one) function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (INT) value, -1 if stream is broken.
+       */
+      INT GetUnary( VOID )
+      {
+        INT Q = TrailingZeros(Acc | (1ULL << (PackEscape + 1)));
+
+        if (Q > PackEscape || Q >= Count)
+          return -1;
+        Acc >>= Q + 1;
+        Count -= Q + 1;
+        return Q;
+      } /* End of 'GetUnary' function */
+
+      /* Obtain number of loaded bits function.
+       * ARGUMENTS: None.
+       * RETURNS:
+       *   (INT) number of loaded bits.
+       */
+      INT GetCount( VOID ) const
+      {
+        return Count;
+      } /* End of 'GetCount' function */
+    }; /* End of 'bit_reader' class */
+
+    /* Rows packer/unpacker for one component word type class */
+    template<class word>
+      class row_pack
+      {
+      private:
+        static const INT Bits = sizeof(word) * 8;  // Word bits
+        const INT Kind;                            // Word kind
+        const UINT Mask, Sign;                     // Word mask and sign bit
+
+        /* Median edge detector predictor function.
+         * ARGUMENTS:
+         *   - left, upper and upper left neighbours:
+         *       UINT A, B, C;
+         * RETURNS:
+         *   (UINT) predicted value.
+         */
+        UINT Median( UINT A, UINT B, UINT C ) const
+        {
+          UINT Min = A < B ? A : B, Max = A < B ? B : A;
+
+          if (C >= Max)
+            return Min;
+          if (C <= Min)
+            return Max;
+          return (A + B - C) & Mask;
+        } /* End of 'Median' function */
+
+        /* Predict value function.
+         * ARGUMENTS:
+         *   - left, upper and upper left neighbours:
+         *       UINT A, B, C;
+         * RETURNS:
+         *   (UINT) predicted value.
+         */
+        template<INT Predictor>
+          UINT Predict( UINT A, UINT B, UINT C ) const
+          {
+            return Predictor == PACK_LEFT ? A : Predictor == PACK_UP ? B : Median(A, B, C);
+          } /* End of 'Predict' function */
+
+        /* Obtain zigzag mapped residual function.
+         * ARGUMENTS:
+         *   - value and its prediction:
+         *       UINT X, P;
+         * RETURNS:
+         *   (UINT) mapped residual.
+         */
+        UINT Residual( UINT X, UINT P ) const
+        {
+          UINT d = (X - P) & Mask;
+
+          return ((d << 1) ^ (0 - (d >> (Bits - 1)))) & Mask;
+        } /* End of 'Residual' function */
+
+        /* Evaluate row residuals sum function.
+         * ARGUMENTS:
+         *   - current and previous row values:
+         *       const UINT *Cur, *Prev;
+         *   - row size:
+         *       INT W;
+         * RETURNS:
+         *   (UINT64) residuals sum.
+         */
+        template<INT Predictor>
+          UINT64 Cost( const UINT *Cur, const UINT *Prev, INT W ) const
+          {
+            UINT64 Sum = 0;
+            UINT A = Prev[0], C = Prev[0];
+
+            for (INT j = 0; j < W; j++)
+            {
+              Sum += Residual(Cur[j], Predict<Predictor>(A, Prev[j], C));
+              A = Cur[j];
+              C = Prev[j];
+            }
+            return Sum;
+          } /* End of 'Cost' function */
+
+        /* Write row residuals function.
+         * ARGUMENTS:
+         *   - bits writer:
+         *       bit_writer &Bw;
+         *   - Rice parameter:
+         *       INT k;
+         *   - current and previous row values:
+         *       const UINT *Cur, *Prev;
+         *   - row size:
+         *       INT W;
+         * RETURNS: None.
+         */
+        template<INT Predictor>
+          VOID PutRow( bit_writer &Bw, INT k, const UINT *Cur, const UINT *Prev, INT W ) const
+          {
+            UINT A = Prev[0], C = Prev[0];
+
+            for (INT j = 0; j < W; j++)
+            {
+              UINT
+                z = Residual(Cur[j], Predict<Predictor>(A, Prev[j], C)),
+                q = k < 32 ? z >> k : 0;
+
+              if (q < (UINT)PackEscape)
+              {
+                Bw.Put(1U << q, q + 1);
+                if (k > 0)
+                  Bw.Put(z & (UINT)(((UINT64)1 << k) - 1), k);
+              }
+              else
+              {
+                Bw.Put(1U << PackEscape, PackEscape + 1);
+                Bw.Put(z, Bits);
+              }
+              A = Cur[j];
+              C = Prev[j];
+            }
+          } /* End of 'PutRow' function */
+
+        /* Read row residuals function.
+         * ARGUMENTS:
+         *   - bits reader:
+         *       bit_reader &Br;
+         *   - Rice parameter:
+         *       INT k;
+         *   - result current and previous row values:
+         *       UINT *Cur;
+         *       const UINT *Prev;
+         *   - row size:
+         *       INT W;
+         * RETURNS:
+         *   (BOOL) TRUE if successful, FALSE if data is broken.
+         */
+        template<INT Predictor>
+          BOOL GetRow( bit_reader &Br, INT k, UINT *Cur, const UINT *Prev, INT W ) const
+          {
+            UINT A = Prev[0], C = Prev[0], z, d;
+            INT q;
+
+            for (INT j = 0; j < W; j++)
+            {
+              Br.Refill();
+              if ((q = Br.GetUnary()) < 0)
+                return FALSE;
+              if (q < PackEscape)
+              {
+                if (Br.GetCount() < k)
+                  return FALSE;
+                z = k == 0 ? q : k < 32 ? (UINT)q << k | Br.Get(k) : Br.Get(k);
+              }
+              else
+              {
+                Br.Refill();
+                if (Br.GetCount() < Bits)
+                  return FALSE;
+                z = Br.Get(Bits);
+              }
+              d = ((z >> 1) ^ (0 - (z & 1))) & Mask;
+              A = Cur[j] = (Predict<Predictor>(A, Prev[j], C) + d) & Mask;
+              C = Prev[j];
+            }
+            return TRUE;
+          } /* End of 'GetRow' function */
+
+        /* Load row component as order preserving values function.
+         * ARGUMENTS:
+         *   - row elements:
+         *       const word *Row;
+         *   - number of elements and components:
+         *       INT W, Components;
+         *   - result values:
+         *       UINT *Dst;
+         * RETURNS: None.
+         */
+        VOID Load( const word *Row, INT W, INT Components, UINT *Dst ) const
+        {
+          if (Kind == PACK_SIGNED)
+            for (INT j = 0; j < W; j++)
+              Dst[j] = Row[(size_t)j * Components] ^ Sign;
+          else if (Kind == PACK_FLOAT)
+            for (INT j = 0; j < W; j++)
+            {
+              UINT X = Row[(size_t)j * Components];
+
+              Dst[j] = X & Sign ? ~X & Mask : X | Sign;
+            }
+          else
+            for (INT j = 0; j < W; j++)
+              Dst[j] = Row[(size_t)j * Components];
+        } /* End of 'Load' function */
+
+        /* Store order preserving values to row component function.
+         * ARGUMENTS:
+         *   - values:
+         *       const UINT *Src;
+         *   - number of elements and components:
+         *       INT W, Components;
+         *   - result row elements:
+         *       word *Row;
+         * RETURNS: None.
+         */
+        VOID Store( const UINT *Src, INT W, INT Components, word *Row ) const
+        {
+          if (Kind == PACK_SIGNED)
+            for (INT j = 0; j < W; j++)
+              Row[(size_t)j * Components] = (word)(Src[j] ^ Sign);
+          else if (Kind == PACK_FLOAT)
+            for (INT j = 0; j < W; j++)
+            {
+              UINT X = Src[j];
+
+              Row[(size_t)j * Components] = (word)(X & Sign ? X & ~Sign : ~X & Mask);
+            }
+          else
+            for (INT j = 0; j < W; j++)
+              Row[(size_t)j * Components] = (word)Src[j];
+        } /* End of 'Store' function */
+
+      public:
+        /* Class constructor.
+         * ARGUMENTS:
+         *   - component kind:
+         *       INT Kind;
+         */
+        row_pack( INT Kind ) :
+          Kind(Kind), Mask((UINT)(((UINT64)1 << Bits) - 1)), Sign(1U << (Bits - 1))
+        {
+        } /* End of 'row_pack' constructor */
+
+        /* Pack rows function.
+         * ARGUMENTS:
+         *   - rows:
+         *       const word *Src;
+         *   - row size in elements, number of rows and components:
+         *       INT W, H, Components;
+         *   - output buffer (bytes are appended):
+         *       std::vector<BYTE> &Out;
+         * RETURNS: None.
+         */
+        VOID Pack( const word *Src, INT W, INT H, INT Components, std::vector<BYTE> &Out ) const
+        {
+          /* Current and previous rows of every component (first row has zero previous one) */
+          std::vector<UINT> Rows((size_t)W * Components * 2, 0);
+          bit_writer Bw(Out);
+
+          for (INT i = 0; i < H; i++)
+            for (INT c = 0; c < Components; c++)
+            {
+              UINT
+                *Cur = &Rows[(size_t)W * (c * 2 + (i & 1))],
+                *Prev = &Rows[(size_t)W * (c * 2 + 1 - (i & 1))];
+              UINT64 Sum[PACK_PREDICTORS];
+              INT Best = PACK_LEFT, k = 0;
+
+              Load(Src + (size_t)i * W * Components + c, W, Components, Cur);
+              Sum[PACK_LEFT] = Cost<PACK_LEFT>(Cur, Prev, W);
+              Sum[PACK_UP] = Cost<PACK_UP>(Cur, Prev, W);
+              Sum[PACK_MEDIAN] = Cost<PACK_MEDIAN>(Cur, Prev, W);
+              for (INT p = 1; p < PACK_PREDICTORS; p++)
+                if (Sum[p] < Sum[Best])
+                  Best = p;
+
+              /* Rice parameter is about logarithm of mean residual */
+              while (k < Bits && ((UINT64)W << (k + 1)) <= Sum[Best])
+                k++;
+              Bw.Put(Best | k << 2, 8);
+              if (Best == PACK_LEFT)
+                PutRow<PACK_LEFT>(Bw, k, Cur, Prev, W);
+              else if (Best == PACK_UP)
+                PutRow<PACK_UP>(Bw, k, Cur, Prev, W);
+              else
+                PutRow<PACK_MEDIAN>(Bw, k, Cur, Prev, W);
+            }
+          Bw.Flush();
+        } /* End of 'Pack' function */
+
+        /* Unpack rows function.
+         * ARGUMENTS:
+         *   - packed data:
+         *       const BYTE *Src;
+         *       size_t Size;
+         *   - row size in elements, number of rows and components:
+         *       INT W, H, Components;
+         *   - result rows:
+         *       word *Dst;
+         * RETURNS:
+         *   (BOOL) TRUE if successful, FALSE if data is broken.
+         */
+        BOOL Unpack( const BYTE *Src, size_t Size, INT W, INT H, INT Components, word *Dst ) const
+        {
+          std::vector<UINT> Rows((size_t)W * Components * 2, 0);
+          bit_reader Br(Src, Size);
+
+          for (INT i = 0; i < H; i++)
+            for (INT c = 0; c < Components; c++)
+            {
+              UINT
+                *Cur = &Rows[(size_t)W * (c * 2 + (i & 1))],
+                *Prev = &Rows[(size_t)W * (c * 2 + 1 - (i & 1))];
+              INT Predictor, k;
+              BOOL IsOk;
+
+              Br.Refill();
+              if (Br.GetCount() < 8)
+                return FALSE;
+              Predictor = Br.Get(2);
+              k = Br.Get(6);
+              if (k > Bits)
+                return FALSE;
+              if (Predictor == PACK_LEFT)
+                IsOk = GetRow<PACK_LEFT>(Br, k, Cur, Prev, W);
+              else if (Predictor == PACK_UP)
+                IsOk = GetRow<PACK_UP>(Br, k, Cur, Prev, W);
+              else if (Predictor == PACK_MEDIAN)
+                IsOk = GetRow<PACK_MEDIAN>(Br, k, Cur, Prev, W);
+              else
+                IsOk = FALSE;
+              if (!IsOk)
+                return FALSE;
+              Store(Cur, W, Components, Dst + (size_t)i * W * Components + c);
+            }
+          return TRUE;
+        } /* End of 'Unpack' function */
+      }; /* End of 'row_pack' class */
+
+    /* Pack rows of elements function.
+     * ARGUMENTS:
+     *   - rows:
+     *       const VOID *Src;
+     *   - row size in elements and number of rows:
+     *       INT W, H;
+     *   - elements layout:
+     *       const pack_layout &Layout;
+     *   - output buffer (bytes are appended):
+     *       std::vector<BYTE> &Out;
+     * RETURNS: None.
+     */
+    inline VOID Pack( const VOID *Src, INT W, INT H, const pack_layout &Layout, std::vector<BYTE> &Out )
+    {
+      switch (Layout.WordSize)
+      {
+      case 1:
+        row_pack<BYTE>(Layout.Kind).Pack((const BYTE *)Src, W, H, Layout.Components, Out);
+        break;
+      case 2:
+        row_pack<uint16_t>(Layout.Kind).Pack((const uint16_t *)Src, W, H, Layout.Components, Out);
+        break;
+      case 4:
+        row_pack<UINT>(Layout.Kind).Pack((const UINT *)Src, W, H, Layout.Components, Out);
+        break;
+      }
+    } /* End of 'Pack' function */
+
+    /* Unpack rows of elements function.
+     * ARGUMENTS:
+     *   - packed data:
+     *       const BYTE *Src;
+     *       size_t Size;
+     *   - row size in elements and number of rows:
+     *       INT W, H;
+     *   - elements layout:
+     *       const pack_layout &Layout;
+     *   - result rows:
+     *       VOID *Dst;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE if data is broken.
+     */
+    inline BOOL Unpack( const BYTE *Src, size_t Size, INT W, INT H, const pack_layout &Layout, VOID *Dst )
+    {
+      switch (Layout.WordSize)
+      {
+      case 1:
+        return row_pack<BYTE>(Layout.Kind).Unpack(Src, Size, W, H, Layout.Components, (BYTE *)Dst);
+      case 2:
+        return row_pack<uint16_t>(Layout.Kind).Unpack(Src, Size, W, H, Layout.Components, (uint16_t *)Dst);
+      case 4:
+        return row_pack<UINT>(Layout.Kind).Unpack(Src, Size, W, H, Layout.Components, (UINT *)Dst);
+      }
+      return FALSE;
+    } /* End of 'Unpack' function */
+  } /* end of 'codec' namespace */
+} /* end of 'tcg' namespace */
+
+#endif /* __map_pack_h_ */
+
+/* END OF 'map_pack.h' FILE */
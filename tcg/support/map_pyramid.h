@@ -0,0 +1,579 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : map_pyramid.h
+ * PURPOSE     : Computational geometry project.
+ *               Tiled multi-resolution height map files support module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __map_pyramid_h_
+#define __map_pyramid_h_
+
+#include <vector>
+#include <string>
+#include <cfloat>
+#include <cstdio>
+
+#include "map_file.h"
+#include "thread_pool.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Pyramid file header.
+   * File layout: header, tiles index (level by level, row by row),
+   * tiles data. Level 'l' size is (max(1, W >> l), max(1, H >> l)),
+   * as for OpenGL mipmaps; edge tiles are cut by level size. */
+  struct pyramid_header
+  {
+    static const UINT
+      MAGIC = 0x50474354,  // 'TCGP'
+      VERSION = 1;         // Current format version
+
+    UINT Magic;            // Format signature
+    UINT Version;          // Format version
+    INT W, H;              // Level 0 size
+    INT Type;              // Element type (see 'map_type')
+    INT TileSize;          // Tile side
+    INT Levels;            // Number of levels
+    INT NumOfTiles;        // Number of tiles in all levels
+    UINT64 IndexOffset;    // Tiles index start in file
+    UINT64 IndexChecksum;  // Tiles index checksum (see 'map_checksum')
+  }; /* End of 'pyramid_header' struct */
+
+  /* Pyramid tile encodings */
+  enum pyramid_codec
+  {
+    PYRAMID_RAW = 0,     // Raw elements
+    PYRAMID_UINT16 = 1,  // 'FLOAT Scale, Bias' and 16-bit quantized heights
+    PYRAMID_HALF = 2,    // Half float heights
+    PYRAMID_PACKED = 3   // Float heights packed losslessly (see 'codec::Pack')
+  }; /* End of 'pyramid_codec' enum */
+
+  /* Pyramid tile index entry */
+  struct pyramid_tile
+  {
+    UINT64 Offset;         // Tile data start in file
+    UINT Size;             // Tile data size in bytes
+    UINT Codec;            // Tile data encoding (see 'pyramid_codec')
+    UINT64 Checksum;       // Tile data checksum
+  }; /* End of 'pyramid_tile' struct */
+
+  /* Read-only memory mapped pyramid file class */
+  class map_pyramid
+  {
+  private:
+    static const INT
+      ALIGN = 64;                  // Tiles data alignment in file
+    file_view File;                // Mapped file
+    pyramid_header Header;         // File header
+    const pyramid_tile *Index;     // Tiles index (in mapped file)
+    std::vector<INT> LevelStart;   // First tile of every level in index
+
+    /* Obtain encoded tile size function.
+     * ARGUMENTS:
+     *   - tile encoding:
+     *       UINT Codec;
+     *   - number of elements:
+     *       size_t Count;
+     *   - element type:
+     *       INT Type;
+     * RETURNS:
+     *   (size_t) size in bytes, 0 for unknown or variable size encoding.
+     */
+    static size_t EncodedSize( UINT Codec, size_t Count, INT Type )
+    {
+      switch (Codec)
+      {
+      case PYRAMID_RAW:
+        return Count * MapElementSize(Type);
+      case PYRAMID_UINT16:
+        return Type == MAP_FLOAT ? sizeof(FLOAT) * 2 + Count * sizeof(uint16_t) : 0;
+      case PYRAMID_HALF:
+        return Type == MAP_FLOAT ? Count * sizeof(uint16_t) : 0;
+      }
+      return 0;
+    } /* End of 'EncodedSize' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS: None.
+     */
+    map_pyramid( VOID ) : Index(nullptr)
+    {
+      memset(&Header, 0, sizeof(Header));
+    } /* End of 'map_pyramid' constructor */
+
+    /* Obtain level width function.
+     * ARGUMENTS:
+     *   - level:
+     *       INT Level;
+     * RETURNS:
+     *   (INT) level width.
+     */
+    INT GetLevelW( INT Level ) const
+    {
+      return (Header.W >> Level) > 1 ? Header.W >> Level : 1;
+    } /* End of 'GetLevelW' function */
+
+    /* Obtain level height function.
+     * ARGUMENTS:
+     *   - level:
+     *       INT Level;
+     * RETURNS:
+     *   (INT) level height.
+     */
+    INT GetLevelH( INT Level ) const
+    {
+      return (Header.H >> Level) > 1 ? Header.H >> Level : 1;
+    } /* End of 'GetLevelH' function */
+
+    /* Obtain number of tile columns of level function.
+     * ARGUMENTS:
+     *   - level:
+     *       INT Level;
+     * RETURNS:
+     *   (INT) number of tile columns.
+     */
+    INT GetTilesX( INT Level ) const
+    {
+      return (GetLevelW(Level) + Header.TileSize - 1) / Header.TileSize;
+    } /* End of 'GetTilesX' function */
+
+    /* Obtain number of tile rows of level function.
+     * ARGUMENTS:
+     *   - level:
+     *       INT Level;
+     * RETURNS:
+     *   (INT) number of tile rows.
+     */
+    INT GetTilesY( INT Level ) const
+    {
+      return (GetLevelH(Level) + Header.TileSize - 1) / Header.TileSize;
+    } /* End of 'GetTilesY' function */
+
+    /* Obtain tile width function.
+     * ARGUMENTS:
+     *   - level and tile column:
+     *       INT Level, X;
+     * RETURNS:
+     *   (INT) tile width (edge tiles are narrower).
+     */
+    INT GetTileW( INT Level, INT X ) const
+    {
+      INT Rest = GetLevelW(Level) - X * Header.TileSize;
+
+      return Rest < Header.TileSize ? Rest : Header.TileSize;
+    } /* End of 'GetTileW' function */
+
+    /* Obtain tile height function.
+     * ARGUMENTS:
+     *   - level and tile row:
+     *       INT Level, Y;
+     * RETURNS:
+     *   (INT) tile height (edge tiles are lower).
+     */
+    INT GetTileH( INT Level, INT Y ) const
+    {
+      INT Rest = GetLevelH(Level) - Y * Header.TileSize;
+
+      return Rest < Header.TileSize ? Rest : Header.TileSize;
+    } /* End of 'GetTileH' function */
+
+    /* Open pyramid file function.
+     * Header, index and tiles placement are checked, tiles data is not read.
+     * ARGUMENTS:
+     *   - file name:
+     *       const CHAR *FileName;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise.
+     */
+    BOOL Open( const CHAR *FileName )
+    {
+      map_checksum Sum;
+      size_t Size;
+
+      Close();
+      if (!File.Open(FileName) || (Size = File.GetSize()) < sizeof(pyramid_header))
+      {
+        Close();
+        return FALSE;
+      }
+      memcpy(&Header, File.GetView(), sizeof(pyramid_header));
+      if (Header.Magic != pyramid_header::MAGIC || Header.Version > pyramid_header::VERSION ||
+          MapElementSize(Header.Type) == 0 || Header.W <= 0 || Header.H <= 0 || Header.TileSize <= 0 ||
+          Header.Levels <= 0 || Header.Levels > 31 || Header.NumOfTiles <= 0 ||
+          Header.IndexOffset > Size || (Size - Header.IndexOffset) / sizeof(pyramid_tile) < (size_t)Header.NumOfTiles)
+      {
+        Close();
+        return FALSE;
+      }
+      Index = (const pyramid_tile *)(File.GetView() + Header.IndexOffset);
+      Sum.Add(Index, sizeof(pyramid_tile) * Header.NumOfTiles);
+
+      /* Check index consistency */
+      INT Count = 0;
+      BOOL IsOk = Sum.Get() == Header.IndexChecksum;
+
+      LevelStart.clear();
+      for (INT l = 0; IsOk && l < Header.Levels; l++)
+      {
+        LevelStart.push_back(Count);
+        for (INT y = 0; IsOk && y < GetTilesY(l); y++)
+          for (INT x = 0; IsOk && x < GetTilesX(l); x++, Count++)
+          {
+            const pyramid_tile &T = Index[Count];
+
+            IsOk = Count < Header.NumOfTiles && T.Offset <= Size && T.Size <= Size - T.Offset &&
+              (T.Codec == PYRAMID_PACKED ? Header.Type == MAP_FLOAT :
+                T.Size == EncodedSize(T.Codec, GetTileW(l, x) * GetTileH(l, y), Header.Type));
+          }
+      }
+      if (!IsOk || Count != Header.NumOfTiles)
+      {
+        Close();
+        return FALSE;
+      }
+      return TRUE;
+    } /* End of 'Open' function */
+
+    /* Close pyramid file function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Close( VOID )
+    {
+      File.Close();
+      Index = nullptr;
+      LevelStart.clear();
+    } /* End of 'Close' function */
+
+    /* Obtain number of levels function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) number of levels.
+     */
+    INT GetLevels( VOID ) const
+    {
+      return Header.Levels;
+    } /* End of 'GetLevels' function */
+
+    /* Obtain tile side function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) tile side.
+     */
+    INT GetTileSize( VOID ) const
+    {
+      return Header.TileSize;
+    } /* End of 'GetTileSize' function */
+
+    /* Obtain element type function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) element type (see 'map_type').
+     */
+    INT GetType( VOID ) const
+    {
+      return Header.Type;
+    } /* End of 'GetType' function */
+
+    /* Obtain tile index entry function.
+     * ARGUMENTS:
+     *   - level, tile column and row:
+     *       INT Level, X, Y;
+     * RETURNS:
+     *   (const pyramid_tile &) index entry.
+     */
+    const pyramid_tile & GetEntry( INT Level, INT X, INT Y ) const
+    {
+      return Index[LevelStart[Level] + Y * GetTilesX(Level) + X];
+    } /* End of 'GetEntry' function */
+
+    /* Obtain tile elements view function.
+     * Tile rows are stored contiguously ('GetTileW' elements per row),
+     * encoded (not 'PYRAMID_RAW') tiles should be read
+     * with 'DecodeTile'.
+     * ARGUMENTS:
+     *   - level, tile column and row:
+     *       INT Level, X, Y;
+     * RETURNS:
+     *   (const type *) pointer to tile elements in mapped memory.
+     */
+    template<class type>
+      const type * GetTile( INT Level, INT X, INT Y ) const
+      {
+        return (const type *)(File.GetView() + GetEntry(Level, X, Y).Offset);
+      } /* End of 'GetTile' function */
+
+    /* Decode height tile to floats function.
+     * ARGUMENTS:
+     *   - level, tile column and row:
+     *       INT Level, X, Y;
+     *   - result samples ('GetTileW' * 'GetTileH' elements):
+     *       FLOAT *Dst;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE if packed tile is broken.
+     */
+    BOOL DecodeTile( INT Level, INT X, INT Y, FLOAT *Dst ) const
+    {
+      const pyramid_tile &T = GetEntry(Level, X, Y);
+      const BYTE *Data = File.GetView() + T.Offset;
+      size_t Count = (size_t)GetTileW(Level, X) * GetTileH(Level, Y);
+      FLOAT Param[2];
+
+      switch (T.Codec)
+      {
+      case PYRAMID_RAW:
+        memcpy(Dst, Data, Count * sizeof(FLOAT));
+        break;
+      case PYRAMID_UINT16:
+        memcpy(Param, Data, sizeof(Param));
+        codec::Dequantize((const uint16_t *)(Data + sizeof(Param)), Param[0], Param[1], Dst, Count);
+        break;
+      case PYRAMID_HALF:
+        codec::DecodeHalf((const uint16_t *)Data, Dst, Count);
+        break;
+      case PYRAMID_PACKED:
+        return codec::Unpack(Data, T.Size, GetTileW(Level, X), GetTileH(Level, Y), MapPackLayout(MAP_FLOAT), Dst);
+      }
+      return TRUE;
+    } /* End of 'DecodeTile' function */
+
+    /* Check tile checksum function.
+     * ARGUMENTS:
+     *   - level, tile column and row:
+     *       INT Level, X, Y;
+     * RETURNS:
+     *   (BOOL) TRUE if tile data is intact, FALSE otherwise.
+     */
+    BOOL VerifyTile( INT Level, INT X, INT Y ) const
+    {
+      const pyramid_tile &T = GetEntry(Level, X, Y);
+      map_checksum Sum;
+
+      Sum.Add(File.GetView() + T.Offset, T.Size);
+      return Sum.Get() == T.Checksum;
+    } /* End of 'VerifyTile' function */
+
+    /* Check all tiles checksums function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if all tiles are intact, FALSE otherwise.
+     */
+    BOOL Verify( VOID ) const
+    {
+      if (Index == nullptr)
+        return FALSE;
+      for (INT l = 0; l < Header.Levels; l++)
+        for (INT y = 0; y < GetTilesY(l); y++)
+          for (INT x = 0; x < GetTilesX(l); x++)
+            if (!VerifyTile(l, x, y))
+              return FALSE;
+      return TRUE;
+    } /* End of 'Verify' function */
+
+    /* Build pyramid file from height map file function.
+     * Levels are 2x2 box filtered, every level and tiles encoding
+     * are evaluated in parallel.
+     * ARGUMENTS:
+     *   - source height map file name (see 'map_file', any height encoding):
+     *       const CHAR *Source;
+     *   - pyramid file name (written as '<name>.tmp' first, old file is kept on failure):
+     *       const CHAR *FileName;
+     *   - tile side:
+     *       INT TileSize;
+     *   - tiles encoding:
+     *       pyramid_codec Codec;
+     *   - maximal encoding error (may be nullptr):
+     *       FLOAT *MaxError;
+     * RETURNS:
+     *   (BOOL) TRUE if successful, FALSE otherwise.
+     */
+    static BOOL Build( const CHAR *Source, const CHAR *FileName, INT TileSize = 128,
+                       pyramid_codec Codec = PYRAMID_RAW, FLOAT *MaxError = nullptr )
+    {
+      map_file Src;
+
+      if (!Src.Open(Source, MAP_FLOAT) || !Src.Verify())
+        return FALSE;
+
+      thread_pool Pool;
+      map_pyramid P;   // Used for layout only
+      std::vector<std::vector<FLOAT>> Levels;
+      std::vector<const FLOAT *> Data;
+
+      P.Header.W = Src.GetW();
+      P.Header.H = Src.GetH();
+      P.Header.TileSize = TileSize;
+      P.Header.Levels = 1;
+      while (P.GetLevelW(P.Header.Levels - 1) > 1 || P.GetLevelH(P.Header.Levels - 1) > 1)
+        P.Header.Levels++;
+      Levels.resize(P.Header.Levels);
+
+      /* Level 0 is used in place if it is stored as floats */
+      if (Src.GetType() == MAP_FLOAT)
+        Data.push_back(Src.GetData<FLOAT>());
+      else
+      {
+        Levels[0].resize((size_t)P.Header.W * P.Header.H);
+        Src.Decode(0, Levels[0].size(), &Levels[0][0]);
+        Data.push_back(&Levels[0][0]);
+      }
+
+      /* Evaluate levels */
+      for (INT l = 1; l < P.Header.Levels; l++)
+      {
+        INT
+          w = P.GetLevelW(l), h = P.GetLevelH(l),
+          pw = P.GetLevelW(l - 1), ph = P.GetLevelH(l - 1);
+        const FLOAT *Prev = Data[l - 1];
+        FLOAT *Cur;
+
+        Levels[l].resize((size_t)w * h);
+        Data.push_back(Cur = &Levels[l][0]);
+        Pool.ParallelFor((h + 15) / 16, [&]( INT Band )
+          {
+            for (INT i = Band * 16; i < h && i < Band * 16 + 16; i++)
+            {
+              const FLOAT
+                *r0 = Prev + (size_t)(2 * i < ph ? 2 * i : ph - 1) * pw,
+                *r1 = Prev + (size_t)(2 * i + 1 < ph ? 2 * i + 1 : ph - 1) * pw;
+
+              for (INT j = 0; j < w; j++)
+              {
+                INT j0 = 2 * j < pw ? 2 * j : pw - 1, j1 = 2 * j + 1 < pw ? 2 * j + 1 : pw - 1;
+
+                Cur[(size_t)i * w + j] = (r0[j0] + r0[j1] + r1[j0] + r1[j1]) * 0.25f;
+              }
+            }
+          });
+      }
+
+      /* Encode tiles */
+      struct tile_ref
+      {
+        INT Level, X, Y;
+      };
+      std::vector<tile_ref> Refs;
+      std::vector<pyramid_tile> Index;
+      std::vector<std::vector<BYTE>> Tiles;
+      std::vector<FLOAT> Errors;
+      UINT64 Offset;
+
+      for (INT l = 0; l < P.Header.Levels; l++)
+        for (INT y = 0; y < P.GetTilesY(l); y++)
+          for (INT x = 0; x < P.GetTilesX(l); x++)
+          {
+            tile_ref R = {l, x, y};
+
+            Refs.push_back(R);
+          }
+      P.Header.NumOfTiles = (INT)Refs.size();
+      Index.resize(Refs.size());
+      Tiles.resize(Refs.size());
+      Errors.resize(Refs.size());
+      Pool.ParallelFor((INT)Refs.size(), [&]( INT t )
+        {
+          const tile_ref &R = Refs[t];
+          INT w = P.GetTileW(R.Level, R.X), h = P.GetTileH(R.Level, R.Y);
+          std::vector<FLOAT> Tile((size_t)w * h);
+          std::vector<BYTE> &Out = Tiles[t];
+          map_checksum Sum;
+          FLOAT Min = Tile.empty() ? 0 : FLT_MAX, Max = -FLT_MAX, Param[2];
+
+          for (INT i = 0; i < h; i++)
+            memcpy(&Tile[(size_t)i * w],
+              Data[R.Level] + (size_t)(R.Y * TileSize + i) * P.GetLevelW(R.Level) + R.X * TileSize, w * sizeof(FLOAT));
+          Out.resize(EncodedSize(Codec, Tile.size(), MAP_FLOAT));
+          Errors[t] = 0;
+          switch (Codec)
+          {
+          case PYRAMID_RAW:
+            memcpy(&Out[0], &Tile[0], Out.size());
+            break;
+          case PYRAMID_UINT16:
+            codec::Range(&Tile[0], Tile.size(), Min, Max);
+            codec::QuantizationParams(Min, Max, Param[0], Param[1]);
+            memcpy(&Out[0], Param, sizeof(Param));
+            Errors[t] = codec::Quantize(&Tile[0], Tile.size(), Param[0], Param[1], (uint16_t *)&Out[sizeof(Param)]);
+            break;
+          case PYRAMID_HALF:
+            Errors[t] = codec::EncodeHalf(&Tile[0], Tile.size(), (uint16_t *)&Out[0]);
+            break;
+          case PYRAMID_PACKED:
+            codec::Pack(&Tile[0], w, h, MapPackLayout(MAP_FLOAT), Out);
+            break;
+          }
+          Sum.Add(&Out[0], Out.size());
+          Index[t].Size = (UINT)Out.size();
+          Index[t].Codec = Codec;
+          Index[t].Checksum = Sum.Get();
+        });
+
+      /* Lay tiles out */
+      Offset = sizeof(pyramid_header) + sizeof(pyramid_tile) * Refs.size();
+      for (size_t t = 0; t < Refs.size(); t++)
+      {
+        Offset = (Offset + ALIGN - 1) / ALIGN * ALIGN;
+        Index[t].Offset = Offset;
+        Offset += Index[t].Size;
+        if (MaxError != nullptr && (t == 0 || Errors[t] > *MaxError))
+          *MaxError = Errors[t];
+      }
+
+      map_checksum IndexSum;
+      IndexSum.Add(&Index[0], sizeof(pyramid_tile) * Index.size());
+
+      P.Header.Magic = pyramid_header::MAGIC;
+      P.Header.Version = pyramid_header::VERSION;
+      P.Header.Type = MAP_FLOAT;
+      P.Header.IndexOffset = sizeof(pyramid_header);
+      P.Header.IndexChecksum = IndexSum.Get();
+
+      /* Store file (to temporary file, which replaces old pyramid when complete) */
+      FILE *F;
+      BOOL IsOk;
+      std::string Tmp = std::string(FileName) + ".tmp";
+      static const BYTE Zero[ALIGN] = {0};
+
+      if ((F = fopen(Tmp.c_str(), "wb")) == nullptr)
+        return FALSE;
+      IsOk = fwrite(&P.Header, sizeof(pyramid_header), 1, F) == 1 &&
+             fwrite(&Index[0], sizeof(pyramid_tile), Index.size(), F) == Index.size();
+      Offset = sizeof(pyramid_header) + sizeof(pyramid_tile) * Index.size();
+      for (size_t t = 0; IsOk && t < Refs.size(); t++)
+      {
+        size_t Pad = (size_t)(Index[t].Offset - Offset);
+
+        IsOk = fwrite(Zero, 1, Pad, F) == Pad &&
+               fwrite(&Tiles[t][0], 1, Tiles[t].size(), F) == Tiles[t].size();
+        Offset = Index[t].Offset + Index[t].Size;
+      }
+      if (fclose(F) != 0 || !IsOk)
+      {
+        remove(Tmp.c_str());
+        return FALSE;
+      }
+      remove(FileName);
+      if (rename(Tmp.c_str(), FileName) != 0)
+      {
+        remove(Tmp.c_str());
+        return FALSE;
+      }
+      return TRUE;
+    } /* End of 'Build' function */
+  }; /* End of 'map_pyramid' class */
+} /* end of 'tcg' namespace */
+
+#endif /* __map_pyramid_h_ */
+
+/* END OF 'map_pyramid.h' FILE */
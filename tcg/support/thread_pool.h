@@ -0,0 +1,198 @@
+/***************************************************************
+ * Copyright (C) 2016
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ ***************************************************************/
+
+/* FILE NAME   : thread_pool.h
+ * PURPOSE     : Computational geometry project.
+ *               Worker threads pool module.
+ * PROGRAMMER  : IR1.
+ * LAST UPDATE : 18.10.2026.
+ * NOTE        : Namespace 'tcg'.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __thread_pool_h_
+#define __thread_pool_h_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "../def.h"
+
+/* Computational geometry project namespace */
+namespace tcg
+{
+  /* Worker threads pool class.
+   * Jobs are split into independent items which are taken by workers
+   * in increasing order, so results must not depend on items order. */
+  class thread_pool
+  {
+  public:
+    /* Work item callback type (gets item index) */
+    typedef std::function<VOID ( INT )> job;
+    /* Progress callback type (gets done fraction, returns FALSE to cancel) */
+    typedef std::function<BOOL ( DBL )> progress;
+
+  private:
+    std::vector<std::thread> Workers;    // Worker threads
+    std::mutex Mutex;                    // Job state lock
+    std::condition_variable Wake, Done;  // Job start/finish signals
+    const job *Job;                      // Current job
+    INT Count;                           // Current job items count
+    std::atomic<INT> Next, Finished;     // Next item to take, finished items count
+    std::atomic<BOOL> IsCanceled;        // Job cancel flag
+    INT Active;                          // Number of busy workers
+    UINT Generation;                     // Job counter (wakes workers up)
+    BOOL IsExit;                         // Pool destruction flag
+
+    /* Take and run items of current job function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if item was run, FALSE if job is over.
+     */
+    BOOL RunItem( VOID )
+    {
+      INT i;
+
+      if (IsCanceled || (i = Next++) >= Count)
+        return FALSE;
+      (*Job)(i);
+      Finished++;
+      return TRUE;
+    } /* End of 'RunItem' function */
+
+    /* Worker thread function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Worker( VOID )
+    {
+      UINT Seen = 0;
+
+      while (TRUE)
+      {
+        {
+          std::unique_lock<std::mutex> Lock(Mutex);
+
+          Wake.wait(Lock, [&]{ return IsExit || Generation != Seen; });
+          if (IsExit)
+            return;
+          Seen = Generation;
+        }
+        while (RunItem())
+          ;
+        {
+          std::lock_guard<std::mutex> Lock(Mutex);
+
+          if (--Active == 0)
+            Done.notify_all();
+        }
+      }
+    } /* End of 'Worker' function */
+
+  public:
+    /* Class constructor.
+     * ARGUMENTS:
+     *   - total number of threads (including caller one, 0 - as many as processors):
+     *       INT NumOfThreads;
+     */
+    thread_pool( INT NumOfThreads = 0 ) :
+      Job(nullptr), Count(0), Next(0), Finished(0), IsCanceled(FALSE),
+      Active(0), Generation(0), IsExit(FALSE)
+    {
+      if (NumOfThreads <= 0)
+        NumOfThreads = std::thread::hardware_concurrency();
+      for (INT i = 1; i < NumOfThreads; i++)
+        Workers.push_back(std::thread([this]{ Worker(); }));
+    } /* End of 'thread_pool' constructor */
+
+    /* Class destructor.
+     * ARGUMENTS: None.
+     */
+    ~thread_pool( VOID )
+    {
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+
+        IsExit = TRUE;
+      }
+      Wake.notify_all();
+      for (auto &t : Workers)
+        t.join();
+    } /* End of '~thread_pool' destructor */
+
+    /* Obtain total number of threads function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (INT) number of worker threads plus caller one.
+     */
+    INT GetNumOfThreads( VOID ) const
+    {
+      return (INT)Workers.size() + 1;
+    } /* End of 'GetNumOfThreads' function */
+
+    /* Run job items in parallel function.
+     * Caller thread takes part in work; progress callback is invoked only
+     * from caller thread. If it returns FALSE, no new items are started,
+     * started ones are finished and function returns FALSE.
+     * ARGUMENTS:
+     *   - number of items:
+     *       INT NumOfItems;
+     *   - item callback:
+     *       const job &Func;
+     *   - progress callback (may be empty):
+     *       const progress &Progress;
+     * RETURNS:
+     *   (BOOL) TRUE if all items were done, FALSE if job was canceled.
+     */
+    BOOL ParallelFor( INT NumOfItems, const job &Func, const progress &Progress = nullptr )
+    {
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+
+        Job = &Func;
+        Count = NumOfItems;
+        Next = 0;
+        Finished = 0;
+        IsCanceled = FALSE;
+        Active = (INT)Workers.size();
+        Generation++;
+      }
+      Wake.notify_all();
+
+      auto Report = [&]( VOID )
+      {
+        if (Progress && !IsCanceled && !Progress(NumOfItems > 0 ? (DBL)Finished / NumOfItems : 1))
+          IsCanceled = TRUE;
+      };
+
+      while (RunItem())
+        Report();
+
+      std::unique_lock<std::mutex> Lock(Mutex);
+
+      /* Keep reporting while workers finish their items */
+      while (Active > 0)
+        if (!Done.wait_for(Lock, std::chrono::milliseconds(30), [this]{ return Active == 0; }))
+        {
+          Lock.unlock();
+          Report();
+          Lock.lock();
+        }
+      Job = nullptr;
+      return !IsCanceled;
+    } /* End of 'ParallelFor' function */
+  }; /* End of 'thread_pool' class */
+} /* end of 'tcg' namespace */
+
+#endif /* __thread_pool_h_ */
+
+/* END OF 'thread_pool.h' FILE */
@@ -21,6 +21,7 @@
 #include "../def.h"
 
 #include <vector>
+#include <string>
 #include <functional>
 
 /* Computational geometry project namespace */
@@ -352,6 +353,30 @@ namespace tcg
     {
       ShowWindow(hWnd, SW_HIDE);
     } /* End of 'Hide' function */
+
+    /* Set window caption function.
+     * ARGUMENTS:
+     *   - new caption text:
+     *       const char *Caption;
+     * RETURNS: None.
+     */
+    inline void SetCaption( const char *Caption )
+    {
+      SetWindowText(hWnd, Caption);
+    } /* End of 'SetCaption' function */
+
+    /* Obtain window caption function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (std::string) caption text.
+     */
+    inline std::string GetCaption( void )
+    {
+      char Buf[256];
+
+      GetWindowText(hWnd, Buf, sizeof(Buf));
+      return Buf;
+    } /* End of 'GetCaption' function */
   }; /* End of 'window' class */
 } /* end of 'tcg' namespace */
 
@@ -161,8 +161,9 @@ namespace tcg
      */
     VOID OnDestroy( VOID )
     {
-      OnClose();
+      /* Hide first: close callback may show window again */
       Hide();
+      OnClose();
     } /* End of 'tcg::window_list::OnDestroy' function */
   }; /* End of 'win' class */
 } /* end of 'tcg' namespace */